@@ -32,17 +32,22 @@
 #include "blt_exception.hh"
 #include "compat_util.hh"
 #include "gvcftools.hh"
+#include "output_buffer.hh"
 #include "parse_util.hh"
 #include "ref_util.hh"
 #include "stringer.hh"
+#include "tabix_line_splitter.hh"
+#include "thread_util.hh"
 #include "VcfHeaderHandler.hh"
 #include "vcf_util.hh"
 
 #include "boost/program_options.hpp"
 
+#include <cstdio>
 #include <unistd.h>
 
 #include <iostream>
+#include <memory>
 #include <string>
 
 
@@ -55,9 +60,10 @@ std::string cmdline;
 
 struct RefCheckOptions
 {
-    RefCheckOptions() : outfp(std::cout) {}
+    explicit
+    RefCheckOptions(output_buffer& out) : outfp(out) {}
 
-    std::ostream& outfp;
+    output_buffer& outfp;
     std::string refSeqFile;
 };
 
@@ -72,7 +78,7 @@ struct RefCheckVcfRecordHandler
     {}
 
     void
-    process_line(const istream_line_splitter& vparse)
+    process_line(const line_splitter& vparse)
     {
         const unsigned nw(vparse.n_word());
 
@@ -127,12 +133,15 @@ static
 void
 process_vcf_input(
     const RefCheckOptions& opt,
-    std::istream& infp)
+    const std::string& input_file,
+    const std::vector<std::string>& input_regions,
+    const std::string& input_region_file)
 {
     VcfHeaderHandler header(opt.outfp,gvcftools_version(),cmdline.c_str(),true);
     RefCheckVcfRecordHandler rec(opt);
 
-    istream_line_splitter vparse(infp);
+    std::auto_ptr<line_splitter> vparse_ptr(open_vcf_line_splitter(input_file,input_regions,input_region_file,get_default_worker_count()));
+    line_splitter& vparse(*vparse_ptr);
 
     while (vparse.parse_line()) {
         if (header.process_line(vparse)) continue;
@@ -154,12 +163,21 @@ try_main(int argc,char* argv[]) {
         cmdline += argv[i];
     }
 
-    std::istream& infp(std::cin);
-    RefCheckOptions opt;
+    std::string input_file;
+    std::vector<std::string> input_regions;
+    std::string input_region_file;
+    output_buffer outbuf(STDOUT_FILENO);
+    RefCheckOptions opt(outbuf);
 
     namespace po = boost::program_options;
     po::options_description req("configuration");
     req.add_options()
+    ("input", po::value(&input_file),
+     "Read input from the named file instead of stdin. Plain text, gzip and BGZF compressed input are accepted")
+    ("input-region", po::value<std::vector<std::string> >(&input_regions),
+     "Read only records overlapping the samtools style region from the tabix indexed input file (may be specified multiple times)")
+    ("input-regions-file", po::value(&input_region_file),
+     "Read only records overlapping the regions in the bed file from the tabix indexed input file")
     ("ref", po::value(&opt.refSeqFile),
      "samtools reference sequence (required)")
     ;
@@ -183,7 +201,7 @@ try_main(int argc,char* argv[]) {
 
     const bool isStdinTerminal(isatty(fileno(stdin)));
 
-    if ((argc<=1) || (vm.count("help")) || po_parse_fail || isStdinTerminal) {
+    if ((argc<=1) || (vm.count("help")) || po_parse_fail || (isStdinTerminal && input_file.empty())) {
         log_os << "\n" << progname << " check VCF reference fields.\n\n";
         log_os << "version: " << gvcftools_version() << "\n\n";
         log_os << "usage: " << progname << " [options] < (g)VCF\n\n";
@@ -196,7 +214,8 @@ try_main(int argc,char* argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    process_vcf_input(opt,infp);
+    process_vcf_input(opt,input_file,input_regions,input_region_file);
+    opt.outfp.flush();
 }
 
 
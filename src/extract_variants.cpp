@@ -31,6 +31,9 @@
 
 #include "compat_util.hh"
 #include "gvcftools.hh"
+#include "output_buffer.hh"
+#include "tabix_line_splitter.hh"
+#include "thread_util.hh"
 #include "VcfHeaderHandler.hh"
 #include "vcf_util.hh"
 
@@ -40,6 +43,7 @@
 #include <unistd.h>
 
 #include <iostream>
+#include <memory>
 #include <string>
 
 
@@ -53,13 +57,14 @@ std::string cmdline;
 
 struct VariantsVcfOptions {
 
-    VariantsVcfOptions()
-        : outfp(std::cout)
+    explicit
+    VariantsVcfOptions(output_buffer& out)
+        : outfp(out)
         , is_skip_header(false)
         , is_invert(false)
     {}
 
-    std::ostream& outfp;
+    output_buffer& outfp;
     bool is_skip_header;
     bool is_invert;
 };
@@ -73,7 +78,7 @@ struct VariantsVcfRecordHandler {
     {}
 
     void
-    process_line(const istream_line_splitter& vparse) {
+    process_line(const line_splitter& vparse) {
         const unsigned nw(vparse.n_word());
 
         if (nw != (VCFID::SAMPLE+1)) {
@@ -96,7 +101,7 @@ struct VariantsVcfRecordHandler {
 
 private:
     const VariantsVcfOptions& _opt;
-    std::vector<int> _gtparse;
+    vcf_genotype _gtparse;
 };
 
 
@@ -104,12 +109,15 @@ private:
 static
 void
 process_vcf_input(const VariantsVcfOptions& opt,
-                  std::istream& infp) {
+                  const std::string& input_file,
+                  const std::vector<std::string>& input_regions,
+                  const std::string& input_region_file) {
 
     VcfHeaderHandler header(opt.outfp,NULL,NULL,opt.is_skip_header);
     VariantsVcfRecordHandler rec(opt);
 
-    istream_line_splitter vparse(infp);
+    std::auto_ptr<line_splitter> vparse_ptr(open_vcf_line_splitter(input_file,input_regions,input_region_file,get_default_worker_count()));
+    line_splitter& vparse(*vparse_ptr);
 
     while (vparse.parse_line()) {
         if (header.process_line(vparse)) continue;
@@ -131,12 +139,21 @@ try_main(int argc,char* argv[]) {
         cmdline += argv[i];
     }
 
-    std::istream& infp(std::cin);
-    VariantsVcfOptions opt;
+    std::string input_file;
+    std::vector<std::string> input_regions;
+    std::string input_region_file;
+    output_buffer outbuf(STDOUT_FILENO);
+    VariantsVcfOptions opt(outbuf);
 
     namespace po = boost::program_options;
     po::options_description req("configuration");
     req.add_options()
+    ("input", po::value(&input_file),
+     "Read input from the named file instead of stdin. Plain text, gzip and BGZF compressed input are accepted")
+    ("input-region", po::value<std::vector<std::string> >(&input_regions),
+     "Read only records overlapping the samtools style region from the tabix indexed input file (may be specified multiple times)")
+    ("input-regions-file", po::value(&input_region_file),
+     "Read only records overlapping the regions in the bed file from the tabix indexed input file")
     ("skip-header", po::value(&opt.is_skip_header)->zero_tokens(),
      "Write gVCF output without header")
     ("invert", po::value(&opt.is_invert)->zero_tokens(),
@@ -161,7 +178,7 @@ try_main(int argc,char* argv[]) {
 
     const bool isStdinTerminal(isatty(fileno(stdin)));
 
-    if ((vm.count("help")) || po_parse_fail || isStdinTerminal) {
+    if ((vm.count("help")) || po_parse_fail || (isStdinTerminal && input_file.empty())) {
         log_os << "\n" << progname << " extracts variants from a VCF file\n\n";
         log_os << "version: " << gvcftools_version() << "\n\n";
         log_os << "usage: " << progname << " [options] < (g)VCF > variants_only_VCF\n\n";
@@ -169,7 +186,8 @@ try_main(int argc,char* argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    process_vcf_input(opt,infp);
+    process_vcf_input(opt,input_file,input_regions,input_region_file);
+    opt.outfp.flush();
 }
 
 
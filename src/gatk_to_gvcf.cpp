@@ -28,20 +28,37 @@
 /// \author Chris Saunders
 ///
 
+#include "bcf_streambuf.hh"
+#include "block_table_streambuf.hh"
 #include "BlockerOptions.hh"
 #include "BlockerVcfHeaderHandler.hh"
 #include "blt_exception.hh"
+#include "fd_line_splitter.hh"
 #include "gvcftools.hh"
-#include "istream_line_splitter.hh"
+#include "output_buffer.hh"
+#include "ParallelVcfRecordBlocker.hh"
+#include "PipelinedVcfRecordBlocker.hh"
 #include "parse_util.hh"
+#include "tabix_line_splitter.hh"
+#include "tabix_util.hh"
+#include "thread_util.hh"
 #include "VcfRecordBlocker.hh"
 
 #include "boost/program_options.hpp"
+#include "boost/shared_ptr.hpp"
 
 //#include <ctime>
+#include <unistd.h>
 
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -54,15 +71,38 @@ std::string cmdline;
 
 
 
+// with a thread_count above 1, records are blocked in chunks on a
+// thread pool, otherwise if is_pipeline is set parsing, blocking and
+// output run as separate pipeline stages. Output is identical to the
+// serial case
+//
 static
 void
 process_vcf_input(const BlockerOptions& opt,
-                  std::istream& infp) {
+                  const std::string& input_file,
+                  const std::string& input_stats_file,
+                  const unsigned thread_count,
+                  const bool is_pipeline) {
 
-    VcfRecordBlocker blocker(opt);
+    VcfKeyDictionary keys;
+    VcfRecordBlocker blocker(opt,keys);
     BlockerVcfHeaderHandler header(opt,gvcftools_version(),cmdline.c_str());
+    header.set_key_dictionary(keys);
+    GatkVcfRecord record(keys);
+
+    // each chunk blocker copies keys after the header is read:
+    std::auto_ptr<ParallelVcfRecordBlocker> pblocker;
+    if (thread_count > 1) {
+        pblocker.reset(new ParallelVcfRecordBlocker(opt,keys,thread_count));
+    }
+
+    std::auto_ptr<PipelinedVcfRecordBlocker> pipeline;
+    if (is_pipeline) {
+        pipeline.reset(new PipelinedVcfRecordBlocker(opt,keys));
+    }
 
-    istream_line_splitter vparse(infp);
+    std::auto_ptr<line_splitter> vparse_ptr(open_fd_line_splitter(input_file,get_default_worker_count()));
+    line_splitter& vparse(*vparse_ptr);
 
     while (vparse.parse_line()) {
         if (header.process_line(vparse)) continue;
@@ -74,8 +114,17 @@ process_vcf_input(const BlockerOptions& opt,
             throw blt_exception(oss.str().c_str());
         }
 
+        if (NULL != pblocker.get()) {
+            pblocker->Append(vparse);
+            continue;
+        }
+
         try {
-            GatkVcfRecord record(vparse);
+            if (NULL != pipeline.get()) {
+                pipeline->Append(vparse);
+                continue;
+            }
+            record.Assign(vparse);
             blocker.Append(record);
         } catch (const std::exception& e) {
             log_os << "ERROR: Exception thrown while processing vcf record: '" << e.what() << "'\n"
@@ -85,6 +134,202 @@ process_vcf_input(const BlockerOptions& opt,
             throw;
         }
     }
+
+    if (NULL != pblocker.get()) {
+        try {
+            pblocker->Flush();
+        } catch (const std::exception& e) {
+            log_os << "ERROR: " << e.what() << "\n";
+            throw;
+        }
+        blocker.MergeStats(pblocker->GetStats());
+    }
+
+    if (NULL != pipeline.get()) {
+        try {
+            pipeline->Flush();
+        } catch (const std::exception& e) {
+            log_os << "ERROR: " << e.what() << "\n";
+            throw;
+        }
+        blocker.MergeStats(pipeline->GetStats());
+    }
+
+    if (! input_stats_file.empty()) {
+        std::ofstream ofs(input_stats_file.c_str());
+        vparse.report_input_stats(ofs);
+        if (NULL != pipeline.get()) pipeline->GetPipelineStats().report(ofs);
+    }
+}
+
+
+
+// open an unnamed temporary file, which is removed when closed:
+static
+int
+open_spool_file() {
+    const char* tmpdir(getenv("TMPDIR"));
+    std::string name(((NULL == tmpdir) || ('\0' == *tmpdir)) ? "/tmp" : tmpdir);
+    name += "/gatk_to_gvcf.XXXXXX";
+    std::vector<char> tmpl(name.begin(),name.end());
+    tmpl.push_back('\0');
+    const int fd(mkstemp(&(tmpl[0])));
+    if (fd < 0) {
+        std::ostringstream oss;
+        oss << "ERROR: can't open temporary file: '" << name << "': " << strerror(errno) << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+    unlink(&(tmpl[0]));
+    return fd;
+}
+
+
+
+/// block the records of a single contig, output is spooled to a
+/// temporary file until it can be written in contig order
+///
+struct contig_block_task : public thread_task {
+
+    contig_block_task(const BlockerOptions& opt,
+                      const std::string& input_file,
+                      const std::string& chrom,
+                      const VcfKeyDictionary& keys)
+        : _opt(opt)
+        , _input_file(input_file)
+        , _chrom(chrom)
+        , _keys(keys)
+        , _fd(-1)
+    {}
+
+    ~contig_block_task() {
+        if (_fd >= 0) close(_fd);
+    }
+
+    void
+    run() {
+        _fd=open_spool_file();
+        output_buffer out(_fd);
+        VcfRecordBlocker blocker(_opt,_keys,out);
+        GatkVcfRecord record(_keys);
+
+        tabix_line_splitter vparse(_input_file,std::vector<std::string>(1,_chrom),"");
+
+        while (vparse.parse_line()) {
+            // the header has already been handled by the caller:
+            if ('#' == vparse.word[0][0]) continue;
+
+            try {
+                if (vparse.n_word() > VCFID::SIZE) {
+                    throw blt_exception("Unexpected format in vcf record");
+                }
+                record.Assign(vparse);
+                blocker.Append(record);
+            } catch (const std::exception& e) {
+                // report from the calling thread, where the error is rethrown:
+                std::ostringstream oss;
+                oss << "Exception thrown while processing vcf record: '" << e.what() << "'\n"
+                    << "\tVCF_INPUT_STATE:\n";
+                vparse.dump(oss);
+                throw blt_exception(oss.str().c_str());
+            }
+        }
+        blocker.Flush();
+        _stats=blocker.GetStats();
+    }
+
+    /// append the spooled output of the completed task to ob
+    void
+    copy_output(output_buffer& ob) {
+        if (lseek(_fd,0,SEEK_SET) < 0) {
+            throw blt_exception("ERROR: can't rewind temporary file\n");
+        }
+        std::vector<char> buf(output_buffer::DEFAULT_BUFFER_SIZE);
+        while (true) {
+            const ssize_t n(read(_fd,&(buf[0]),buf.size()));
+            if (n < 0) {
+                if (EINTR == errno) continue;
+                std::ostringstream oss;
+                oss << "ERROR: can't read temporary file: " << strerror(errno) << "\n";
+                throw blt_exception(oss.str().c_str());
+            }
+            if (0 == n) break;
+            ob.append(&(buf[0]),n);
+        }
+        close(_fd);
+        _fd=-1;
+    }
+
+    const BlockerStats&
+    stats() const { return _stats; }
+
+private:
+    const BlockerOptions& _opt;
+    const std::string _input_file;
+    const std::string _chrom;
+    VcfKeyDictionary _keys;
+    int _fd;
+    BlockerStats _stats;
+};
+
+
+
+// block each contig of a tabix indexed input file on a separate
+// thread. Output is identical to process_vcf_input
+//
+static
+void
+process_indexed_vcf_input(const BlockerOptions& opt,
+                          const std::string& input_file,
+                          const unsigned thread_count) {
+
+    // this blocker writes no records, but reports the merged block stats:
+    VcfKeyDictionary keys;
+    VcfRecordBlocker blocker(opt,keys);
+    BlockerVcfHeaderHandler header(opt,gvcftools_version(),cmdline.c_str());
+    header.set_key_dictionary(keys);
+
+    {
+        // with no regions only the header is read:
+        tabix_line_splitter vparse(input_file,std::vector<std::string>(),"");
+        while (vparse.parse_line()) {
+            header.process_line(vparse);
+        }
+    }
+
+    std::vector<std::string> chroms;
+    {
+        tabix_chrom_list clist(input_file.c_str());
+        const char* chrom;
+        while (NULL != (chrom=clist.next())) chroms.push_back(chrom);
+    }
+
+    // limit the number of spooled contigs waiting to be written:
+    const unsigned max_active(2*thread_count);
+
+    typedef boost::shared_ptr<contig_block_task> task_ptr;
+    std::deque<task_ptr> active;
+    thread_pool pool(thread_count);
+
+    const unsigned n_chrom(chroms.size());
+    unsigned chrom_index(0);
+    while (true) {
+        while ((chrom_index<n_chrom) && (active.size()<max_active)) {
+            active.push_back(task_ptr(new contig_block_task(opt,input_file,chroms[chrom_index++],keys)));
+            pool.submit(*(active.back()));
+        }
+        if (active.empty()) break;
+
+        contig_block_task& task(*(active.front()));
+        try {
+            task.wait();
+        } catch (const std::exception& e) {
+            log_os << "ERROR: " << e.what() << "\n";
+            throw;
+        }
+        task.copy_output(opt.outfp);
+        blocker.MergeStats(task.stats());
+        active.pop_front();
+    }
 }
 
 
@@ -151,13 +396,35 @@ try_main(int argc,char* argv[]) {
         cmdline += argv[i];
     }
 
-    std::istream& infp(std::cin);
-    BlockerOptions opt;
+    std::string input_file;
+    std::string output_file;
+    char output_type('v');
+    std::string block_table_file;
+    std::string input_stats_file;
+    unsigned thread_count(1);
+    bool is_pipeline(false);
+    output_buffer outbuf(STDOUT_FILENO);
+    BlockerOptions opt(outbuf);
     std::string chrom_depth_file;
+    std::vector<std::string> block_fields;
 
     namespace po = boost::program_options;
     po::options_description req("configuration");
     req.add_options()
+    ("input", po::value(&input_file),
+     "Read input from the named file instead of stdin. Plain text, gzip and BGZF compressed VCF and BCF input are accepted")
+    ("output", po::value(&output_file),
+     "Write BGZF compressed output to the named file instead of stdout, and index the output with tabix (VCF) or a CSI index (BCF)")
+    ("output-type", po::value(&output_type)->default_value(output_type),
+     "Output format: 'v' for VCF or 'b' for BGZF compressed BCF2")
+    ("block-table", po::value(&block_table_file),
+     "Also write the record ranges, genotypes, filters, GQX and DP of the output to the named block table file, which can be read by trio and twins in place of the gVCF")
+    ("input-stats", po::value(&input_stats_file),
+     "Write input queue stall counts, and the busy and idle time of each --pipeline stage, to the file, to show whether input or processing limits throughput")
+    ("threads", po::value(&thread_count)->default_value(thread_count),
+     "Block records in parallel on the given number of threads. Contigs of a bgzip compressed, tabix indexed --input file are blocked separately, any other input is cut into chunks of consecutive records. Output is identical to single threaded output")
+    ("pipeline", po::value(&is_pipeline)->zero_tokens(),
+     "Parse, block and write records on three separate threads. Output is identical to single threaded output, this can't be combined with threads > 1")
     ("min-blockable-nonref",po::value<print_double>(&opt.min_nonref_blockable)->default_value(opt.min_nonref_blockable),"If AD present, only compress non-variant site if 1-AD[0]/DP < value")
     ("skip-header", po::value(&opt.is_skip_header)->zero_tokens(),
      "Write gVCF output without header");
@@ -183,8 +450,12 @@ try_main(int argc,char* argv[]) {
      "Non-variant blocks are restricted to range [x,y], y <= max(x+3,x*(1+block-range-factor))")
     ("block-label",po::value(&opt.nvopt.BlockavgLabel)->default_value(opt.nvopt.BlockavgLabel),
      "VCF INFO key used to annotate compressed non-variant blocks")
+    ("block-field",po::value(&block_fields)->composing(),
+     "FORMAT field summarized in non-variant blocks, given as TAG[=SOURCE][:SUMMARY[:TOLERANCE]]. Values of SOURCE (default TAG) are printed as TAG in block records, SUMMARY is the printed value: min (default), mean or max. TOLERANCE restricts the values in a block: range (default, see block-range-factor), exact or none. The option may be repeated, and replaces the default fields DP, GQX and MQ")
     ("block-stats",po::value(&opt.block_stats_file),
      "Write non-variant block stats to the file")
+    ("block-lookahead",po::value(&opt.block_lookahead)->default_value(opt.block_lookahead),
+     "If non-zero, hold up to this many blockable sites and split them into the fewest non-variant blocks, instead of extending each block as far as possible. Blocks can differ from the default output, the block counts are added to block-stats")
     ("no-block-compression", po::value(&opt.is_skip_blocks)->zero_tokens(),
      "Turn off block compression");
 
@@ -215,11 +486,42 @@ try_main(int argc,char* argv[]) {
     }
 
 
+    if (thread_count < 1) {
+        log_os << "\nthreads must be >= 1\n\n";
+        exit(2);
+    }
+
+    if (is_pipeline && (thread_count > 1)) {
+        log_os << "\nERROR: pipeline can't be combined with threads > 1\n\n";
+        exit(2);
+    }
+
+    const bool is_indexed_input((thread_count > 1) &&
+                                (! input_file.empty()) &&
+                                is_tabix_index(input_file.c_str()));
+
+    if (is_indexed_input && (! input_stats_file.empty())) {
+        log_os << "\nERROR: input-stats can't be combined with threads > 1 for tabix indexed input\n\n";
+        exit(2);
+    }
+
     if (opt.nvopt.BlockFracTol.numval() < 0) {
         log_os << "\nblock-range-factor must be >= 0\n\n";
         exit(2);
     }
 
+    if (! block_fields.empty()) {
+        opt.nvopt.BlockFields.clear();
+        for (unsigned i(0); i<block_fields.size(); ++i) {
+            BlockFieldOption field("");
+            if (! parse_block_field(block_fields[i],field)) {
+                log_os << "\nERROR: invalid block-field: '" << block_fields[i] << "'\n\n";
+                exit(2);
+            }
+            opt.nvopt.BlockFields.push_back(field);
+        }
+    }
+
     if (vm.count("no-default-filters")) {
         if (vm["min-gqx"].defaulted()) opt.min_gqx.clear();
 
@@ -243,9 +545,25 @@ try_main(int argc,char* argv[]) {
         }
     }
 
+    if (! input_stats_file.empty()) {
+        std::ofstream ofs(input_stats_file.c_str());
+        if (! ofs) {
+            log_os << "ERROR: can't write stats file: " << input_stats_file << "\n";
+            exit(2);
+        }
+    }
+
     opt.finalize_filters();
 
-    process_vcf_input(opt,infp);
+    vcf_output_redirect output(opt.outfp,output_file,output_type,get_default_worker_count());
+    block_table_output table(opt.outfp,block_table_file);
+    if (is_indexed_input) {
+        process_indexed_vcf_input(opt,input_file,thread_count);
+    } else {
+        process_vcf_input(opt,input_file,input_stats_file,thread_count,is_pipeline);
+    }
+    table.close();
+    output.close();
 }
 
 
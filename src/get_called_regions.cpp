@@ -30,6 +30,9 @@
 
 #include "compat_util.hh"
 #include "gvcftools.hh"
+#include "output_buffer.hh"
+#include "tabix_line_splitter.hh"
+#include "thread_util.hh"
 #include "VcfHeaderHandler.hh"
 #include "vcf_util.hh"
 
@@ -39,6 +42,7 @@
 #include <unistd.h>
 
 #include <iostream>
+#include <memory>
 #include <string>
 
 
@@ -52,11 +56,12 @@ std::string cmdline;
 
 struct CallRegionOptions {
 
-    CallRegionOptions()
-        : outfp(std::cout)
+    explicit
+    CallRegionOptions(output_buffer& out)
+        : outfp(out)
     {}
 
-    std::ostream& outfp;
+    output_buffer& outfp;
 };
 
 
@@ -73,7 +78,7 @@ struct CallRegionVcfRecordHandler {
     }
 
     void
-    process_line(const istream_line_splitter& vparse) {
+    process_line(const line_splitter& vparse) {
         const unsigned nw(vparse.n_word());
 
         if (nw != (VCFID::SAMPLE+1)) {
@@ -111,10 +116,12 @@ private:
     void
     writeCurrent() {
         if (_currentChrom.empty()) return;
-        _opt.outfp << _currentChrom
-                   << '\t' << _currentBeginPos
-                   << '\t' << _currentEndPos
-                   << '\n';
+        _opt.outfp.append(_currentChrom);
+        _opt.outfp.append('\t');
+        _opt.outfp.append_uint(_currentBeginPos);
+        _opt.outfp.append('\t');
+        _opt.outfp.append_uint(_currentEndPos);
+        _opt.outfp.append('\n');
     }
 
     void
@@ -169,13 +176,16 @@ private:
 static
 void
 process_vcf_input(const CallRegionOptions& opt,
-                  std::istream& infp) {
+                  const std::string& input_file,
+                  const std::vector<std::string>& input_regions,
+                  const std::string& input_region_file) {
 
     static const bool is_skip_header(true);
     VcfHeaderHandler header(opt.outfp, NULL, NULL, is_skip_header);
     CallRegionVcfRecordHandler rec(opt);
 
-    istream_line_splitter vparse(infp);
+    std::auto_ptr<line_splitter> vparse_ptr(open_vcf_line_splitter(input_file,input_regions,input_region_file,get_default_worker_count()));
+    line_splitter& vparse(*vparse_ptr);
 
     while (vparse.parse_line()) {
         if (header.process_line(vparse)) continue;
@@ -197,17 +207,28 @@ try_main(int argc,char* argv[]) {
         cmdline += argv[i];
     }
 
-    std::istream& infp(std::cin);
-    CallRegionOptions opt;
+    std::string input_file;
+    std::vector<std::string> input_regions;
+    std::string input_region_file;
+    output_buffer outbuf(STDOUT_FILENO);
+    CallRegionOptions opt(outbuf);
 
     namespace po = boost::program_options;
+    po::options_description req("configuration");
+    req.add_options()
+    ("input", po::value(&input_file),
+     "Read input from the named file instead of stdin. Plain text, gzip and BGZF compressed input are accepted")
+    ("input-region", po::value<std::vector<std::string> >(&input_regions),
+     "Read only records overlapping the samtools style region from the tabix indexed input file (may be specified multiple times)")
+    ("input-regions-file", po::value(&input_region_file),
+     "Read only records overlapping the regions in the bed file from the tabix indexed input file");
 
     po::options_description help("help");
     help.add_options()
     ("help,h","print this message");
 
     po::options_description visible("options");
-    visible.add(help);
+    visible.add(req).add(help);
 
     bool po_parse_fail(false);
     po::variables_map vm;
@@ -221,7 +242,7 @@ try_main(int argc,char* argv[]) {
 
     const bool isStdinTerminal(isatty(fileno(stdin)));
 
-    if ((vm.count("help")) || po_parse_fail || isStdinTerminal) {
+    if ((vm.count("help")) || po_parse_fail || (isStdinTerminal && input_file.empty())) {
         log_os << "\n" << progname << " creates a bed file of called regions from a gVCF\n\n";
         log_os << "version: " << gvcftools_version() << "\n\n";
         log_os << "usage: " << progname << " [options] < gVCF > called.bed\n\n";
@@ -229,7 +250,8 @@ try_main(int argc,char* argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    process_vcf_input(opt,infp);
+    process_vcf_input(opt,input_file,input_regions,input_region_file);
+    opt.outfp.flush();
 }
 
 
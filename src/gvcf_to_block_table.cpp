@@ -0,0 +1,172 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// convert a single sample gVCF to a block table for trio and twins
+///
+
+#include "block_table.hh"
+#include "compat_util.hh"
+#include "gvcftools.hh"
+#include "tabix_line_splitter.hh"
+#include "thread_util.hh"
+
+#include "boost/program_options.hpp"
+
+#include <cstdio>
+#include <unistd.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace {
+std::ostream& log_os(std::cerr);
+}
+
+
+
+static
+void
+process_vcf_input(const std::string& input_file,
+                  const std::vector<std::string>& input_regions,
+                  const std::string& input_region_file,
+                  const std::string& output_file) {
+
+    block_table_writer writer(output_file);
+
+    std::auto_ptr<line_splitter> vparse_ptr(open_vcf_line_splitter(input_file,input_regions,input_region_file,get_default_worker_count()));
+    line_splitter& vparse(*vparse_ptr);
+
+    while (vparse.parse_line()) {
+        if ('#' == vparse.word[0][0]) {
+            writer.add_header_line(vparse.word,vparse.n_word());
+        } else {
+            writer.add_record(vparse.word,vparse.n_word());
+        }
+    }
+    writer.close();
+}
+
+
+
+static
+void
+try_main(int argc,char* argv[]) {
+
+    const char* progname(compat_basename(argv[0]));
+
+    std::string input_file;
+    std::vector<std::string> input_regions;
+    std::string input_region_file;
+    std::string output_file;
+
+    namespace po = boost::program_options;
+    po::options_description req("configuration");
+    req.add_options()
+    ("input", po::value(&input_file),
+     "Read input from the named file instead of stdin. Plain text, gzip and BGZF compressed VCF and BCF input are accepted")
+    ("input-region", po::value<std::vector<std::string> >(&input_regions),
+     "Read only records overlapping the samtools style region from the indexed input file (may be specified multiple times)")
+    ("input-regions-file", po::value(&input_region_file),
+     "Read only records overlapping the regions in the bed file from the indexed input file")
+    ("output", po::value(&output_file),
+     "Write the block table to the named file (required)");
+
+    po::options_description help("help");
+    help.add_options()
+    ("help,h","print this message");
+
+    po::options_description visible("options");
+    visible.add(req).add(help);
+
+    bool po_parse_fail(false);
+    po::variables_map vm;
+    try {
+        po::store(po::parse_command_line(argc, argv, visible), vm);
+        po::notify(vm);
+    } catch (const boost::program_options::error& e) { // todo:: find out what is the more specific exception class thrown by program options
+        log_os << "\nERROR: Exception thrown by option parser: " << e.what() << "\n";
+        po_parse_fail=true;
+    }
+
+    const bool isStdinTerminal(isatty(fileno(stdin)));
+
+    if ((vm.count("help")) || po_parse_fail || output_file.empty() || (isStdinTerminal && input_file.empty())) {
+        log_os << "\n" << progname << " writes the record ranges, genotypes, filters, GQX and DP of a single sample gVCF to a block table, which can be read by trio and twins in place of the gVCF\n\n";
+        log_os << "version: " << gvcftools_version() << "\n\n";
+        log_os << "usage: " << progname << " [options] --output sample.gbt < gVCF\n\n";
+        log_os << visible << "\n";
+        exit(EXIT_FAILURE);
+    }
+
+    process_vcf_input(input_file,input_regions,input_region_file,output_file);
+}
+
+
+
+static
+void
+dump_cl(int argc,
+        char* argv[],
+        std::ostream& os) {
+
+    os << "cmdline:";
+    for (int i(0); i<argc; ++i) {
+        os << ' ' << argv[i];
+    }
+    os << std::endl;
+}
+
+
+
+int
+main(int argc,char* argv[]) {
+
+    std::ios_base::sync_with_stdio(false);
+
+    // last chance to catch exceptions...
+    //
+    try {
+        try_main(argc,argv);
+
+    } catch (const std::exception& e) {
+        log_os << "FATAL:: EXCEPTION: " << e.what() << "\n"
+               << "...caught in main()\n";
+        dump_cl(argc,argv,log_os);
+        exit(EXIT_FAILURE);
+
+    } catch (...) {
+        log_os << "FATAL:: UNKNOWN EXCEPTION\n"
+               << "...caught in main()\n";
+        dump_cl(argc,argv,log_os);
+        exit(EXIT_FAILURE);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+
+#ifndef __BLOCK_VALUE_RANGE_HH
+#define __BLOCK_VALUE_RANGE_HH
+
+#include <cmath>
+
+
+/// running min, max and sum of one integer field over the records of a
+/// block
+///
+/// A block is within tolerance while:
+///
+///   max <= min + max(absTol, floor(min*fracTol))
+///
+/// The upper bound for the current minimum is cached when the minimum
+/// changes, so that a candidate value is tested in constant time.
+///
+struct BlockValueRange {
+
+    BlockValueRange(const double fracTol,
+                    const int absTol)
+        : _fracTol(fracTol)
+        , _absTol(absTol)
+        , _count(0)
+        , _min(0)
+        , _max(0)
+        , _maxBound(0)
+        , _sum(0.)
+    {}
+
+    void
+    Reset() {
+        _count=0;
+        _sum=0.;
+    }
+
+    bool
+    Empty() const { return (0 == _count); }
+
+    unsigned
+    Size() const { return _count; }
+
+    int
+    Min() const { return _min; }
+
+    int
+    Max() const { return _max; }
+
+    double
+    Mean() const { return (_sum/_count); }
+
+    /// true if val can be added without exceeding the block tolerance
+    bool
+    IsInTolerance(const int val) const {
+        if (0 == _count) return true;
+        if (val >= _min) return (val <= _maxBound);
+        return (_max <= GetMaxBound(val));
+    }
+
+    /// true if val can be added to a block with a single value
+    bool
+    IsEqual(const int val) const {
+        return ((0 == _count) || ((val == _min) && (val == _max)));
+    }
+
+    void
+    Add(const int val) {
+        if (0 == _count) {
+            _min=val;
+            _max=val;
+            _maxBound=GetMaxBound(val);
+        } else {
+            if (val > _max) _max=val;
+            if (val < _min) {
+                _min=val;
+                _maxBound=GetMaxBound(val);
+            }
+        }
+        _sum += val;
+        _count++;
+    }
+
+private:
+    int
+    GetMaxBound(const int min) const {
+        const int ftol(static_cast<int>(std::floor(min * _fracTol)));
+        return min + ((ftol > _absTol) ? ftol : _absTol);
+    }
+
+    double _fracTol;
+    int _absTol;
+    unsigned _count;
+    int _min;
+    int _max;
+    int _maxBound;
+    double _sum;
+};
+
+
+#endif
@@ -31,8 +31,155 @@
 
 #include "BlockVcfRecord.hh"
 
+#include <algorithm>
+
+
+
+BlockFieldInfo::
+BlockFieldInfo(const BlockFieldOption& field,
+               VcfKeyDictionary& keys)
+    : key(keys.format.GetId(field.tag.c_str()))
+    , sourceKey(keys.format.GetId(field.source.c_str()))
+    , GetValue(NULL)
+    , summary(field.summary)
+    , tolerance(field.tolerance)
+{
+    // use the values cached by the record where these exist:
+    if       (sourceKey == VCF_FORMAT_KEY::GQX) {
+        GetValue=&GatkVcfRecord::GetGQX;
+    } else if (sourceKey == VCF_FORMAT_KEY::GQ) {
+        GetValue=&GatkVcfRecord::GetGQ;
+    } else if (sourceKey == VCF_FORMAT_KEY::DP) {
+        GetValue=&GatkVcfRecord::GetDP;
+    } else if (sourceKey == VCF_FORMAT_KEY::MQ) {
+        GetValue=&GatkVcfRecord::GetMQ;
+    }
+}
+
+
+
+BlockVcfRecord::
+BlockVcfRecord(const BlockerOptions& opt,
+               VcfKeyDictionary& keys,
+               BlockerStats& stats)
+    : _opt(opt)
+    , _count(0)
+    , _stats(stats)
+    , _isStats(opt.is_block_stats())
+    , _isDefaultFields(opt.nvopt.IsDefaultBlockFields())
+    , _ranges(opt.nvopt.BlockFields.size(),BlockValueRange(opt.nvopt.BlockFracTol.numval(),opt.nvopt.BlockAbsTol))
+    , _fieldStats(_isStats ? opt.nvopt.BlockFields.size() : 0)
+    , _newValues(opt.nvopt.BlockFields.size())
+    , _baseValues(opt.nvopt.BlockFields.size())
+    , _maxBlockRanges(_ranges)
+{
+    const std::vector<BlockFieldOption>& fields(opt.nvopt.BlockFields);
+    const unsigned fs(fields.size());
+    for (unsigned i(0); i<fs; ++i) {
+        _fields.push_back(BlockFieldInfo(fields[i],keys));
+    }
+}
+
+
 
 // this is moved down the cpp file so that auto_ptr works correctly
 BlockVcfRecord::
 ~BlockVcfRecord() {}
 
+
+
+unsigned
+BlockVcfRecord::
+GetMaxBlockSize(const GatkVcfRecord* begin,
+                const GatkVcfRecord* end) const {
+    if (begin == end) return 0;
+
+    const unsigned fs(_fields.size());
+    for (unsigned i(0); i<fs; ++i) _maxBlockRanges[i].Reset();
+    AddFieldValues(*begin,_maxBlockRanges);
+
+    unsigned count(1);
+    for (const GatkVcfRecord* r(begin+1); r != end; ++r) {
+        if (! TestRecord(*begin,count,_maxBlockRanges,*r)) break;
+        AddFieldValues(*r,_maxBlockRanges);
+        count++;
+    }
+    return count;
+}
+
+
+
+void
+BlockVcfRecord::
+AddFieldValues(const GatkVcfRecord& record,
+               std::vector<BlockValueRange>& ranges) const {
+    const unsigned fs(_fields.size());
+    for (unsigned i(0); i<fs; ++i) {
+        const MaybeInt& val(GetFieldValue(record,i,_newValues[i]));
+        if (! val.IsInt) continue;
+        ranges[i].Add(val.IntVal);
+    }
+}
+
+
+
+void
+GetMinBlockSegmentation(const std::vector<unsigned>& max_block_size,
+                        std::vector<unsigned>& block_size,
+                        std::vector<unsigned>& block_count) {
+    const unsigned n(max_block_size.size());
+    block_size.resize(n);
+    block_count.resize(n+1);
+    block_count[n]=0;
+    for (unsigned i(n); i-- > 0;) {
+        const unsigned max_size(std::min(max_block_size[i],n-i));
+        unsigned best(max_size);
+        for (unsigned size(max_size); size>0; --size) {
+            if (block_count[i+size] < block_count[i+best]) best=size;
+        }
+        block_size[i]=best;
+        block_count[i]=1+block_count[i+best];
+    }
+}
+
+
+
+bool
+BlockVcfRecord::
+TestFields(const GatkVcfRecord& base,
+           const std::vector<BlockValueRange>& ranges,
+           const GatkVcfRecord& cvcfr) const {
+    const unsigned fs(_fields.size());
+    for (unsigned i(0); i<fs; ++i) {
+        const BlockFieldInfo& field(_fields[i]);
+        if (field.tolerance == BLOCK_TOLERANCE::NONE) continue;
+
+        const MaybeInt& newval(GetFieldValue(cvcfr,i,_newValues[i]));
+        const MaybeInt& oldval(GetFieldValue(base,i,_baseValues[i]));
+        if (!(newval.IsInt && oldval.IsInt)) {
+            if (! IsMissingValueBlockable(newval,oldval)) return false;
+            continue;
+        }
+
+        const BlockValueRange& block(ranges[i]);
+        if (field.tolerance == BLOCK_TOLERANCE::EXACT) {
+            if (! block.IsEqual(newval.IntVal)) return false;
+        } else {
+            if (! block.IsInTolerance(newval.IntVal)) return false;
+        }
+    }
+    return true;
+}
+
+
+
+const stream_stat&
+BlockVcfRecord::
+GetFieldStats(const VCF_FORMAT_KEY::index_t key) const {
+    static const stream_stat empty;
+    const unsigned fs(_fields.size());
+    for (unsigned i(0); i<fs; ++i) {
+        if (_fields[i].key == static_cast<unsigned>(key)) return _fieldStats[i];
+    }
+    return empty;
+}
@@ -34,99 +34,108 @@
 
 #include "BlockerOptions.hh"
 #include "BlockerStats.hh"
+#include "BlockValueRange.hh"
+#include "compat_util.hh"
+#include "format_util.hh"
 #include "GatkVcfRecord.hh"
+#include "GatkVcfRecordWriter.hh"
 #include "stream_stat.hh"
 #include "stringer.hh"
 
-#include <cassert>
-#include <cstdio>
+#include <cstring>
 
 #include <memory>
+#include <vector>
+
+
+/// a block field of BlockerOptions resolved against the key dictionary
+/// of the records being blocked
+///
+struct BlockFieldInfo {
+
+    BlockFieldInfo(const BlockFieldOption& field,
+                   VcfKeyDictionary& keys);
+
+    typedef const MaybeInt& (GatkVcfRecord::*getter_t)() const;
+
+    unsigned key; // FORMAT key id printed in block records
+    unsigned sourceKey; // FORMAT key id of the site values
+    getter_t GetValue; // cached record value of sourceKey, or NULL to parse the sample value
+    BLOCK_SUMMARY::index_t summary;
+    BLOCK_TOLERANCE::index_t tolerance;
+};
+
 
 
 /// stores vcf records representing contiguous blocks of non-variant sites
 ///
 struct BlockVcfRecord {
 
+    /// keys - key dictionary of the records added to the block
     BlockVcfRecord(const BlockerOptions& opt,
-                   BlockerStats& stats)
-        : _opt(opt)
-        , _fracTol(opt.nvopt.BlockFracTol.numval())
-        , _absTol(opt.nvopt.BlockAbsTol)
-        , _count(0)
-        , _stats(stats)
-    {}
+                   VcfKeyDictionary& keys,
+                   BlockerStats& stats);
 
     ~BlockVcfRecord();
 
+    /// the base record is kept to be recycled by the next block
     void Reset() {
-        _baseCvcfr.reset();
         _count=0;
-        _blockGQX.reset();
-        _blockDP.reset();
-        _blockMQ.reset();
+        const unsigned fs(_fields.size());
+        for (unsigned i(0); i<fs; ++i) {
+            _ranges[i].Reset();
+            if (_isStats) _fieldStats[i].reset();
+        }
     }
 
+    bool Empty() const { return (0 == _count); }
+
     /// determine if new record can be incorporated into the current block
+    ///
+    /// records must have block ids set, see GatkVcfRecord::SetBlockIds
     bool Test(GatkVcfRecord& cvcfr) const {
-
         if (_count == 0) return true;
-
-        // check if chrom matches and pos is +1 from end record:
-        if (cvcfr.GetChrom() != _baseCvcfr->GetChrom())
-            return false;
-        if (cvcfr.GetPos() != (_baseCvcfr->GetPos() + _count))
-            return false;
-
-        // does the filter field match?
-        if (cvcfr.GetFilter() != _baseCvcfr->GetFilter())
-            return false;
-
-        // does the gt field match?
-        if (cvcfr.GetGT() != _baseCvcfr->GetGT())
-            return false;
-
-        // special check for no-coverage regions:
-        if (_baseCvcfr->GetIsCovered() != cvcfr.GetIsCovered())
-            return false;
-
-        // none of the checks below apply to no-coverage regions
-        if (!_baseCvcfr->GetIsCovered())
-            return true;
-
-        // test gq
-        if (!IsNewValueBlockable(cvcfr.GetGQX(),_baseCvcfr->GetGQX(),
-                                 _blockGQX,_fracTol,_absTol))
-            return false;
-
-        if (!IsNewValueBlockable(cvcfr.GetDP(),_baseCvcfr->GetDP(),
-                                 _blockDP,_fracTol,_absTol))
-            return false;
-
-        if (!IsNewValueBlockable(cvcfr.GetMQ(),_baseCvcfr->GetMQ(),
-                                 _blockMQ,_fracTol,_absTol))
-            return false;
-
-        return true;
+        return TestRecord(*_baseCvcfr,_count,_ranges,cvcfr);
     }
 
+    /// size of the largest block which can be formed from the records
+    /// starting at begin, without changing this object or the records
+    ///
+    /// This is not always the position at which a later block could
+    /// start: a block starting at a site without GQX places no range
+    /// restriction on the GQX values of the sites which follow it.
+    unsigned
+    GetMaxBlockSize(const GatkVcfRecord* begin,
+                    const GatkVcfRecord* end) const;
+
+    /// add record to the current block
+    ///
+    /// the first record of a block is swapped into this object, leaving
+    /// the previous block's base record in cvcfr
     void
     Add(GatkVcfRecord& cvcfr) {
-        if (_count == 0)
-            _baseCvcfr.reset(new GatkVcfRecord(cvcfr));
+        const GatkVcfRecord* rec(&cvcfr);
+        if (_count == 0) {
+            if (NULL == _baseCvcfr.get()) {
+                _baseCvcfr.reset(new GatkVcfRecord(cvcfr.GetKeys()));
+            }
+            _baseCvcfr->swap(cvcfr);
+            rec=_baseCvcfr.get();
+        }
 
-        if (cvcfr.GetGQX().IsInt)
-            _blockGQX.add(cvcfr.GetGQX().IntVal);
-        if (cvcfr.GetDP().IsInt)
-            _blockDP.add(cvcfr.GetDP().IntVal);
-        if (cvcfr.GetMQ().IsInt)
-            _blockMQ.add(cvcfr.GetMQ().IntVal);
+        const unsigned fs(_fields.size());
+        for (unsigned i(0); i<fs; ++i) {
+            const MaybeInt& val(GetFieldValue(*rec,i,_newValues[i]));
+            if (! val.IsInt) continue;
+            _ranges[i].Add(val.IntVal);
+            if (_isStats) _fieldStats[i].add(val.IntVal);
+        }
 
         _count += 1;
     }
 
     void
-    Write(std::ostream& os) {
+    Write(GatkVcfRecordWriter& writer) {
 
         if (_count == 0) return;
 
@@ -141,15 +150,15 @@ struct BlockVcfRecord {
         _baseCvcfr->SetQual(NULL);
 
         // add some fields back:
-        _baseCvcfr->SetSampleVal("GT", gt.c_str());
+        _baseCvcfr->SetSampleVal(VCF_FORMAT_KEY::GT, gt.c_str());
 
         if (_count > 1) {
-            static const unsigned buff_size(32);
-            char buff[buff_size];
+            static const char endKey[] = "END=";
+            char buff[sizeof(endKey)+MAX_INT_FORMAT_SIZE];
+            memcpy(buff,endKey,sizeof(endKey)-1);
 
             const int end(_baseCvcfr->GetPos() + _count - 1);
-            const int write_size(snprintf(buff,buff_size,"END=%i",end));
-            assert((write_size>=0) && (write_size < static_cast<int>(buff_size)));
+            *format_int(end,buff+sizeof(endKey)-1) = '\0';
             _baseCvcfr->AppendInfo(buff);
         }
 
@@ -157,102 +166,161 @@ struct BlockVcfRecord {
         if (is_covered) {
             bool isAvg(false);
 
-            UpdateBlock("DP",_blockDP,isAvg);
-            UpdateBlock("GQX",_blockGQX,isAvg);
-            UpdateBlock("MQ",_blockMQ,isAvg);
+            const unsigned fs(_fields.size());
+            for (unsigned i(0); i<fs; ++i) {
+                UpdateBlock(_fields[i],_ranges[i],isAvg);
+            }
 
             if (isAvg) {
                 const std::string& label(_opt.nvopt.BlockavgLabel);
                 _baseCvcfr->AppendInfo(label.c_str());
             }
 
-            if (_opt.is_block_stats()) {
-                _stats.addBlock(_count,_blockGQX,_blockDP,_blockMQ);
+            if (_isStats) {
+                _stats.addBlock(_count,
+                                GetFieldStats(VCF_FORMAT_KEY::GQX),
+                                GetFieldStats(VCF_FORMAT_KEY::DP),
+                                GetFieldStats(VCF_FORMAT_KEY::MQ));
             }
         }
 
-        _baseCvcfr->WriteUnaltered(os);
+        writer.Write(*_baseCvcfr);
     }
 
 
 private:
 
+    // test cvcfr against the block of count records starting with base,
+    // with field value ranges ranges:
+    bool
+    TestRecord(const GatkVcfRecord& base,
+               const int count,
+               const std::vector<BlockValueRange>& ranges,
+               const GatkVcfRecord& cvcfr) const {
+
+        // check if chrom matches and pos is +1 from end record:
+        if (cvcfr.GetChromId() != base.GetChromId())
+            return false;
+        if (cvcfr.GetPos() != (base.GetPos() + count))
+            return false;
+
+        // does the filter field match?
+        if (cvcfr.GetFilterSetId() != base.GetFilterSetId())
+            return false;
+
+        // does the gt field match?
+        if (cvcfr.GetGTId() != base.GetGTId())
+            return false;
+
+        // special check for no-coverage regions:
+        if (base.GetIsCovered() != cvcfr.GetIsCovered())
+            return false;
+
+        // none of the checks below apply to no-coverage regions
+        if (!base.GetIsCovered())
+            return true;
+
+        if (_isDefaultFields) return TestDefaultFields(base,ranges,cvcfr);
+        return TestFields(base,ranges,cvcfr);
+    }
+
     void
-    UpdateBlock(const char* label,
-                stream_stat& block,
+    UpdateBlock(const BlockFieldInfo& field,
+                const BlockValueRange& block,
                 bool& isAvg) {
 
         static const char* unknown = ".";
         const char* printptr(unknown);
 
-        if (! block.empty()) {
-            if (block.size() > 1) isAvg = true;
-            const int min(static_cast<int>(compat_round(block.min())));
-            printptr=_intstr.get32(min);
+        if (! block.Empty()) {
+            if (block.Size() > 1) isAvg = true;
+            int val(block.Min());
+            if       (field.summary == BLOCK_SUMMARY::MEAN) {
+                val=static_cast<int>(compat_round(block.Mean()));
+            } else if (field.summary == BLOCK_SUMMARY::MAX) {
+                val=block.Max();
+            }
+            printptr=_intstr.get32(val);
         }
-        _baseCvcfr->SetSampleVal(label,printptr);
+        _baseCvcfr->SetSampleVal(field.key,printptr);
     }
 
-    static
-    bool
-    IsNewValueBlockable(const MaybeInt& newval,
-                        const MaybeInt& oldval,
-                        const stream_stat& ss,
-                        const double fracTol,
-                        const int absTol) {
-        if (!(newval.IsInt && oldval.IsInt)) {
-            return (newval.StrVal == oldval.StrVal);
-        }
-        return IsNewValueBlockableInternal(newval.IntVal, ss, fracTol, absTol);
+    // value of field i in record, val is used to hold parsed sample
+    // values:
+    const MaybeInt&
+    GetFieldValue(const GatkVcfRecord& record,
+                  const unsigned i,
+                  MaybeInt& val) const {
+        const BlockFieldInfo& field(_fields[i]);
+        if (NULL != field.GetValue) return (record.*field.GetValue)();
+        val.Set(record.GetSampleVal(field.sourceKey));
+        return val;
     }
 
-    // should be called only after new/old null state has been queried
-    static
+    // the default fields, with the value accessors and tolerance
+    // resolved at compile time:
     bool
-    IsNewValueBlockableInternal(const int newval,
-                                const stream_stat& ss,
-                                const double fracTol,
-                                const int absTol) {
-
-        stream_stat ss2(ss);
-        ss2.add(newval);
-        return CheckBlockTolerance(ss2, fracTol, absTol);
+    TestDefaultFields(const GatkVcfRecord& base,
+                      const std::vector<BlockValueRange>& ranges,
+                      const GatkVcfRecord& cvcfr) const {
+        return (IsFieldBlockable<&GatkVcfRecord::GetDP>(base,cvcfr,ranges[0]) &&
+                IsFieldBlockable<&GatkVcfRecord::GetGQX>(base,cvcfr,ranges[1]) &&
+                IsFieldBlockable<&GatkVcfRecord::GetMQ>(base,cvcfr,ranges[2]));
     }
 
-    static
+    template <BlockFieldInfo::getter_t GetValue>
     bool
-    CheckBlockSingleTolerance(const stream_stat& ss,
-                              const int min,
-                              const int tol) {
-        return ((min + tol) >= ss.max());
+    IsFieldBlockable(const GatkVcfRecord& base,
+                     const GatkVcfRecord& cvcfr,
+                     const BlockValueRange& block) const {
+        const MaybeInt& newval((cvcfr.*GetValue)());
+        const MaybeInt& oldval((base.*GetValue)());
+        if (!(newval.IsInt && oldval.IsInt)) return IsMissingValueBlockable(newval,oldval);
+        return block.IsInTolerance(newval.IntVal);
     }
 
-    /// <summary>
-    /// check that int(block_mean) is with either abs_tol of min/max or mean*frac_tol of min/max
-    /// </summary>
+    // fields configured in BlockerOptions:
+    bool
+    TestFields(const GatkVcfRecord& base,
+               const std::vector<BlockValueRange>& ranges,
+               const GatkVcfRecord& cvcfr) const;
+
+    // add the field values of record to ranges:
+    void
+    AddFieldValues(const GatkVcfRecord& record,
+                   std::vector<BlockValueRange>& ranges) const;
+
+    // mean and variance of a field over the current block, these are
+    // only accumulated when block stats are reported:
+    const stream_stat&
+    GetFieldStats(const VCF_FORMAT_KEY::index_t key) const;
+
+    // at least one value is missing. A missing value has no string, so
+    // this is equivalent to comparing the two value strings:
     static
     bool
-    CheckBlockTolerance(const stream_stat& ss,
-                        const double fracTol,
-                        const int absTol) {
-
-        const int min(static_cast<int>(compat_round(ss.min())));
-        if (CheckBlockSingleTolerance(ss, min, absTol)) return true;
-        const int ftol(static_cast<int>(std::floor(min * fracTol)));
-        if (ftol <= absTol) return false;
-        return CheckBlockSingleTolerance(ss, min, ftol);
+    IsMissingValueBlockable(const MaybeInt& newval,
+                            const MaybeInt& oldval) {
+        return (newval.StrVal.empty() && oldval.StrVal.empty());
     }
 
     const BlockerOptions& _opt;
-    const double _fracTol;
-    const int _absTol;
     std::auto_ptr<GatkVcfRecord> _baseCvcfr;
     int _count;
     BlockerStats& _stats;
+    const bool _isStats;
 
-    stream_stat _blockGQX;
-    stream_stat _blockDP;
-    stream_stat _blockMQ;
+    std::vector<BlockFieldInfo> _fields;
+    const bool _isDefaultFields;
+    std::vector<BlockValueRange> _ranges;
+    std::vector<stream_stat> _fieldStats;
+
+    // storage for parsed sample values:
+    mutable std::vector<MaybeInt> _newValues;
+    mutable std::vector<MaybeInt> _baseValues;
+
+    // field value ranges of the blocks tested by GetMaxBlockSize:
+    mutable std::vector<BlockValueRange> _maxBlockRanges;
 
     // fast int->str util:
     stringer<int> _intstr;
@@ -260,6 +328,19 @@ private:
 
 
 
+/// find the fewest blocks covering a run of records
+///
+/// max_block_size[i] is the size of the largest block starting at
+/// record i, see BlockVcfRecord::GetMaxBlockSize. For the records from
+/// i on, block_count[i] is set to the minimum number of blocks and
+/// block_size[i] to the size of the first of these blocks. The largest
+/// block is chosen on ties, so that extending each block as far as
+/// possible is kept wherever it gives the minimum.
+///
+void
+GetMinBlockSegmentation(const std::vector<unsigned>& max_block_size,
+                        std::vector<unsigned>& block_size,
+                        std::vector<unsigned>& block_count);
 
 
 #endif
@@ -30,6 +30,7 @@
 ///
 
 #include "BlockerOptions.hh"
+#include "string_util.hh"
 
 #include <iostream>
 
@@ -50,9 +51,92 @@ operator<<(std::ostream& os,const FilterInfo& fi) {
 
 
 
+static
+bool
+parse_summary(const std::string& str,
+              BLOCK_SUMMARY::index_t& val) {
+    for (int i(0); i<BLOCK_SUMMARY::SIZE; ++i) {
+        val=static_cast<BLOCK_SUMMARY::index_t>(i);
+        if (str == BLOCK_SUMMARY::label(val)) return true;
+    }
+    return false;
+}
+
+
+
+static
+bool
+parse_tolerance(const std::string& str,
+                BLOCK_TOLERANCE::index_t& val) {
+    for (int i(0); i<BLOCK_TOLERANCE::SIZE; ++i) {
+        val=static_cast<BLOCK_TOLERANCE::index_t>(i);
+        if (str == BLOCK_TOLERANCE::label(val)) return true;
+    }
+    return false;
+}
+
+
+
+bool
+parse_block_field(const std::string& str,
+                  BlockFieldOption& field) {
+    std::vector<std::string> words;
+    split_string(str,':',words);
+    if (words.empty() || (words.size() > 3)) return false;
+
+    const std::string& name(words[0]);
+    const std::string::size_type eq(name.find('='));
+    if (eq == std::string::npos) {
+        field.tag=name;
+        field.source=name;
+    } else {
+        field.tag=name.substr(0,eq);
+        field.source=name.substr(eq+1);
+    }
+    if (field.tag.empty() || field.source.empty()) return false;
+
+    field.summary=BLOCK_SUMMARY::MIN;
+    field.tolerance=BLOCK_TOLERANCE::RANGE;
+    if ((words.size() > 1) && (! parse_summary(words[1],field.summary))) return false;
+    if ((words.size() > 2) && (! parse_tolerance(words[2],field.tolerance))) return false;
+    return true;
+}
+
+
+
+static
+std::vector<BlockFieldOption>
+make_default_block_fields() {
+    std::vector<BlockFieldOption> fields;
+    fields.push_back(BlockFieldOption("DP"));
+    fields.push_back(BlockFieldOption("GQX"));
+    fields.push_back(BlockFieldOption("MQ"));
+    return fields;
+}
+
+
+
+NonvariantBlockOptions::
+NonvariantBlockOptions()
+    : BlockFracTol("0.3")
+    , BlockAbsTol(3)
+    , BlockavgLabel("BLOCKAVG_min30p3a")
+    , BlockFields(make_default_block_fields())
+{}
+
+
+
+bool
+NonvariantBlockOptions::
+IsDefaultBlockFields() const {
+    return (BlockFields == make_default_block_fields());
+}
+
+
+
 BlockerOptions::
-BlockerOptions()
-    : outfp(std::cout)
+BlockerOptions(output_buffer& out)
+    : outfp(out)
     , is_skip_header(false)
     , max_chrom_depth_filter_tag("MaxDepth")
     , max_chrom_depth_filter_factor("3.0")
@@ -61,6 +145,7 @@ BlockerOptions()
     , site_conflict_label("SiteConflict")
     , min_gqx("20.0")
     , is_skip_blocks(false)
+    , block_lookahead(0)
 {
     // set default filters:
     filters.push_back(FilterInfo("min-mq",FILTERTYPE::SITE,"LowMQ","MQ","20.0",false));
@@ -32,6 +32,7 @@
 #define __BLOCKER_OPTIONS_HH
 
 
+#include "output_buffer.hh"
 #include "print_double.hh"
 
 #include <iosfwd>
@@ -106,26 +107,106 @@ std::ostream& operator<<(std::ostream& os,const FilterInfo& fi);
 
 
 
-// gVCF nonvariant block settings, currently do not allow these to be set
-// but putting them in blocker_opt makes this straightforward
+/// value printed for a field over each non-variant block
+namespace BLOCK_SUMMARY {
+enum index_t {
+    MIN,
+    MEAN,
+    MAX,
+    SIZE
+};
+
+inline
+const char*
+label(const index_t x) {
+    static const char* label[] = {"min","mean","max"};
+    return label[x];
+}
+}
+
+
+/// rule restricting the field values of the sites in a non-variant block
+namespace BLOCK_TOLERANCE {
+enum index_t {
+    RANGE, // values in [x,y], y <= max(x+BlockAbsTol,x*(1+BlockFracTol))
+    EXACT, // all values are equal
+    NONE,  // no restriction
+    SIZE
+};
+
+inline
+const char*
+label(const index_t x) {
+    static const char* label[] = {"range","exact","none"};
+    return label[x];
+}
+}
+
+
+/// a FORMAT field which is summarized over each non-variant block
+struct BlockFieldOption {
+
+    /// source - FORMAT key the values are read from, same as tag if NULL
+    explicit
+    BlockFieldOption(const char* init_tag,
+                     const char* init_source=NULL,
+                     const BLOCK_SUMMARY::index_t init_summary=BLOCK_SUMMARY::MIN,
+                     const BLOCK_TOLERANCE::index_t init_tolerance=BLOCK_TOLERANCE::RANGE)
+        : tag(init_tag)
+        , source((NULL==init_source) ? init_tag : init_source)
+        , summary(init_summary)
+        , tolerance(init_tolerance)
+    {}
+
+    bool
+    operator==(const BlockFieldOption& rhs) const {
+        return ((tag == rhs.tag) &&
+                (source == rhs.source) &&
+                (summary == rhs.summary) &&
+                (tolerance == rhs.tolerance));
+    }
+
+    std::string tag; // FORMAT key printed in block records
+    std::string source; // FORMAT key of the site values, GQX is derived from QUAL and GQ as for site records
+    BLOCK_SUMMARY::index_t summary;
+    BLOCK_TOLERANCE::index_t tolerance;
+};
+
+
+/// parse a block field from TAG[=SOURCE][:SUMMARY[:TOLERANCE]]
+///
+/// \returns false if the string is not a valid block field
+///
+bool
+parse_block_field(const std::string& str,
+                  BlockFieldOption& field);
+
+
+
+// gVCF nonvariant block settings
 //
 struct NonvariantBlockOptions {
-    NonvariantBlockOptions()
-        : BlockFracTol("0.3")
-        , BlockAbsTol(3)
-        , BlockavgLabel("BLOCKAVG_min30p3a")
-    {}
+    NonvariantBlockOptions();
+
+    /// true if BlockFields is the default field set
+    bool
+    IsDefaultBlockFields() const;
 
     print_double BlockFracTol;
     int BlockAbsTol;
     std::string BlockavgLabel;
+
+    /// fields summarized in each block, in output order
+    std::vector<BlockFieldOption> BlockFields;
 };
 
 
 
 struct BlockerOptions {
 
-    BlockerOptions();
+    /// \param out record and header output sink
+    explicit
+    BlockerOptions(output_buffer& out);
 
     ~BlockerOptions();
 
@@ -147,7 +228,7 @@ struct BlockerOptions {
         FILTER_NONE
     };
 
-    std::ostream& outfp;
+    output_buffer& outfp;
     bool is_skip_header;
     std::string max_chrom_depth_filter_tag;
     print_double max_chrom_depth_filter_factor;
@@ -165,6 +246,7 @@ struct BlockerOptions {
 
     std::string block_stats_file;
     bool is_skip_blocks;
+    unsigned block_lookahead; // if non-zero, the size of the record window split into the fewest blocks
 };
 
 
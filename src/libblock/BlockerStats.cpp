@@ -45,4 +45,11 @@ report(std::ostream& os) const {
     os << "AVG_GQX_COV: " << _gqx_cov.mean() << "\n";
     os << "AVG_DP_COV: " << _dp_cov.mean() << "\n";
     os << "AVG_MQ_COV: " << _mq_cov.mean() << "\n";
+
+    if (_is_lookahead) {
+        os << "Block count of lookahead blocking, and of extending each block as far as possible:\n";
+        os << "LOOKAHEAD_BLOCK_COUNT: " << _lookahead_block_count << "\n";
+        os << "GREEDY_BLOCK_COUNT: " << _greedy_block_count << "\n";
+        os << "LOOKAHEAD_BLOCK_REDUCTION: " << (static_cast<long>(_greedy_block_count)-static_cast<long>(_lookahead_block_count)) << "\n";
+    }
 }
@@ -40,7 +40,11 @@
 
 struct BlockerStats {
 
-    BlockerStats() {}
+    BlockerStats()
+        : _lookahead_block_count(0)
+        , _greedy_block_count(0)
+        , _is_lookahead(false)
+    {}
 
     void
     addBlock(const unsigned size,
@@ -55,6 +59,33 @@ struct BlockerStats {
         if (mq.size()>=min_block_count()) _mq_cov.add(mq.stderror());
     }
 
+    /// count a block written by lookahead blocking
+    void
+    addLookaheadBlock() {
+        _lookahead_block_count++;
+        _is_lookahead = true;
+    }
+
+    /// count a block which extending each block as far as possible would
+    /// have written in place of the lookahead blocks
+    void
+    addGreedyBlock() {
+        _greedy_block_count++;
+        _is_lookahead = true;
+    }
+
+    /// add the blocks counted by another object
+    void
+    merge(const BlockerStats& rhs) {
+        _block_size.merge(rhs._block_size);
+        _gqx_cov.merge(rhs._gqx_cov);
+        _dp_cov.merge(rhs._dp_cov);
+        _mq_cov.merge(rhs._mq_cov);
+        _lookahead_block_count += rhs._lookahead_block_count;
+        _greedy_block_count += rhs._greedy_block_count;
+        _is_lookahead = (_is_lookahead || rhs._is_lookahead);
+    }
+
     void
     report(std::ostream& os) const;
 
@@ -69,6 +100,10 @@ private:
     stream_stat _gqx_cov;
     stream_stat _dp_cov;
     stream_stat _mq_cov;
+
+    unsigned long _lookahead_block_count;
+    unsigned long _greedy_block_count;
+    bool _is_lookahead;
 };
 
 
@@ -73,7 +73,7 @@ print_filter_header_set(const std::vector<FilterInfo>& filters,
 
 bool
 BlockerVcfHeaderHandler::
-is_skip_header_line(const istream_line_splitter& vparse) {
+is_skip_header_line(const line_splitter& vparse) {
 
     // remove some header lines:
     const unsigned nw(vparse.n_word());
@@ -95,16 +95,39 @@ BlockerVcfHeaderHandler::
 process_final_header_line() {
 
     _os << "##INFO=<ID=END,Number=1,Type=Integer,Description=\"End position of the region described in this record\">\n";
-    _os << "##INFO=<ID=" << _opt.nvopt.BlockavgLabel
-        << ",Number=0,Type=Flag,Description=\"Non-variant site block."
-        << " All sites in a block are constrained to be non-variant, have the same filter value,"
-        << " and have all sample values in range [x,y] , y <= max(x+3,(x*(1+" << _opt.nvopt.BlockFracTol << ")))."
-        << " All printed site block sample values are the minimum observed in the region spanned by the block\">\n";
+    const NonvariantBlockOptions& nvopt(_opt.nvopt);
+    _os << "##INFO=<ID=" << nvopt.BlockavgLabel
+        << ",Number=0,Type=Flag,Description=\"Non-variant site block.";
+    if (nvopt.IsDefaultBlockFields()) {
+        _os << " All sites in a block are constrained to be non-variant, have the same filter value,"
+            << " and have all sample values in range [x,y] , y <= max(x+3,(x*(1+" << nvopt.BlockFracTol << ")))."
+            << " All printed site block sample values are the minimum observed in the region spanned by the block\">\n";
+    } else {
+        _os << " All sites in a block are constrained to be non-variant and have the same filter value."
+            << " Block sample values are restricted to either range [x,y] , y <= max(x+3,(x*(1+" << nvopt.BlockFracTol << "))),"
+            << " an exact value, or none, and printed as the min, mean or max observed in the region spanned by the block:";
+        const unsigned fs(nvopt.BlockFields.size());
+        for (unsigned i(0); i<fs; ++i) {
+            const BlockFieldOption& field(nvopt.BlockFields[i]);
+            _os << " " << field.tag << "=" << BLOCK_SUMMARY::label(field.summary) << "(" << field.source << ")"
+                << "/" << BLOCK_TOLERANCE::label(field.tolerance);
+        }
+        _os << "\">\n";
+    }
 
     // new format tags:
     _os << "##FORMAT=<ID=MQ,Number=1,Type=Integer,Description=\"RMS Mapping Quality\">\n";
     _os << "##FORMAT=<ID=GQX,Number=1,Type=Integer,Description=\"Minimum of {Genotype quality assuming variant position,Genotype quality assuming non-variant position}\">\n";
 
+    // block fields which are not copied from a site value of the same name:
+    const unsigned fs(nvopt.BlockFields.size());
+    for (unsigned i(0); i<fs; ++i) {
+        const BlockFieldOption& field(nvopt.BlockFields[i]);
+        if (field.tag == field.source) continue;
+        _os << "##FORMAT=<ID=" << field.tag << ",Number=1,Type=Integer,Description=\"Non-variant site block "
+            << BLOCK_SUMMARY::label(field.summary) << " of " << field.source << "\">\n";
+    }
+
     // overlap tags:
     _os << "##FILTER=<ID=" << _opt.indel_conflict_label
         << ",Description=\"Locus is in region with conflicting indel calls.\">\n";
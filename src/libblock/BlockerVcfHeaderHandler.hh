@@ -59,15 +59,15 @@ struct BlockerVcfHeaderHandler : public VcfHeaderHandler {
 
 private:
     bool
-    is_skip_header_line(const istream_line_splitter& vparse);
+    is_skip_header_line(const line_splitter& vparse);
 
     void
     process_final_header_line();
 
     void
-    write_split_line(const istream_line_splitter& vparse) {
+    write_split_line(const line_splitter& vparse) {
         if (_opt.is_skip_header) return;
-        vparse.write_line(_os);
+        vparse.write_line(_ob);
     }
 
     const BlockerOptions& _opt;
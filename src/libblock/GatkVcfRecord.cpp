@@ -45,7 +45,6 @@ operator<<(std::ostream& os,const MaybeInt& mi) {
 }
 
 
-// this is moved down the cpp file so that auto_ptr works correctly
 GatkVcfRecord::
 ~GatkVcfRecord() {}
 
@@ -40,7 +40,6 @@
 
 #include <algorithm>
 #include <iosfwd>
-#include <memory>
 #include <sstream>
 
 
@@ -54,22 +53,51 @@
 ///
 struct MaybeInt {
 
-    MaybeInt(const char* s)
-        : IsInt((NULL != s) && ('\0' != *s) && (0 != strcmp(s,".")))
+    MaybeInt()
+        : IsInt(false)
         , IntVal(0)
         , DoubleVal(0.)
+    {}
+
+    MaybeInt(const char* s)
     {
+        Set(s);
+    }
+
+    MaybeInt(const int i)
+    {
+        Set(i);
+    }
+
+    /// reset value, reusing string storage
+    void
+    Set(const char* s) {
+        IsInt=((NULL != s) && ('\0' != *s) && (0 != strcmp(s,".")));
+        IntVal=0;
+        DoubleVal=0.;
+        StrVal.clear();
         if (! IsInt) return;
-        if (NULL != s) StrVal = std::string(s);
+        StrVal = s;
         DoubleVal = parse_double(s);
         IntVal = static_cast<int>(compat_round(DoubleVal));
     }
 
-    MaybeInt(const int i)
-        : IsInt(true)
-        , IntVal(i)
-        , DoubleVal(i)
-    {}
+    void
+    Set(const int i) {
+        IsInt=true;
+        IntVal=i;
+        DoubleVal=i;
+        StrVal.clear();
+    }
+
+    /// reset to the missing value, equivalent to Set("")
+    void
+    Clear() {
+        IsInt=false;
+        IntVal=0;
+        DoubleVal=0.;
+        StrVal.clear();
+    }
 
     bool IsNonZero() const {
         return (IsInt && (IntVal != 0));
@@ -87,54 +115,80 @@ std::ostream& operator<<(std::ostream& os,const MaybeInt& mi);
 
 struct GatkVcfRecord : public VcfRecord {
 
-    GatkVcfRecord(const istream_line_splitter& vparse)
-        : VcfRecord(vparse)
-        , _isgt(false)
-    { }
+    /// an empty record, which can be set with Assign()
+    explicit
+    GatkVcfRecord(VcfKeyDictionary& keys)
+        : VcfRecord(keys)
+        , _filterSetId(0)
+        , _gtId(0)
+    {
+        KillCache();
+    }
 
-    GatkVcfRecord(const GatkVcfRecord& orig)
-        : VcfRecord(orig)
-        , _isgt(orig._isgt)
-        , _gt(orig._gt)
-    {}
+    GatkVcfRecord(const line_splitter& vparse,
+                  VcfKeyDictionary& keys)
+        : VcfRecord(vparse,keys)
+        , _filterSetId(0)
+        , _gtId(0)
+    {
+        KillCache();
+    }
 
     virtual
     ~GatkVcfRecord();
 
+    /// exchange contents with another record, without copying
+    void
+    swap(GatkVcfRecord& rhs) {
+        VcfRecord::swap(rhs);
+        std::swap(_filterSetId,rhs._filterSetId);
+        std::swap(_gtId,rhs._gtId);
+        KillCache();
+        rhs.KillCache();
+    }
+
+    /// set the interned FILTER and GT values of the groomed record, ids
+    /// are assigned by the object which grooms the record
+    void
+    SetBlockIds(const unsigned filterSetId,
+                const unsigned gtId) {
+        _filterSetId=filterSetId;
+        _gtId=gtId;
+    }
+
+    unsigned GetFilterSetId() const { return _filterSetId; }
+
+    unsigned GetGTId() const { return _gtId; }
+
     const MaybeInt& GetGQX() const {
-        if (NULL == _gqx.get()) {
-            MaybeInt _qual(GetQual().c_str());
-            if (_qual.IsInt && GetGQ().IsInt) {
-                int val = std::min(_qual.IntVal, GetGQ().IntVal);
-                _gqx.reset(new MaybeInt(val));
+        if (! _isgqx) {
+            const MaybeInt& gq(GetGQ());
+            _qual.Set(GetQual().c_str());
+            if (_qual.IsInt && gq.IsInt) {
+                _gqx.Set(std::min(_qual.IntVal, gq.IntVal));
             } else {
-                _gqx.reset(new MaybeInt(""));
+                _gqx.Clear();
             }
+            _isgqx=true;
         }
-        return *_gqx;
+        return _gqx;
     }
 
     const MaybeInt& GetGQ() const {
-        if (NULL == _gq.get())
-            _gq.reset(new MaybeInt(GetSampleVal("GQ")));
-        return *_gq;
+        return GetCachedSampleVal(VCF_FORMAT_KEY::GQ,_isgq,_gq);
     }
 
     const MaybeInt& GetDP() const {
-        if (NULL == _dp.get())
-            _dp.reset(new MaybeInt(GetSampleVal("DP")));
-        return *_dp;
+        return GetCachedSampleVal(VCF_FORMAT_KEY::DP,_isdp,_dp);
     }
 
     const MaybeInt& GetMQ() const {
-        if (NULL == _mq.get())
-            _mq.reset(new MaybeInt(GetSampleVal("MQ")));
-        return *_mq;
+        return GetCachedSampleVal(VCF_FORMAT_KEY::MQ,_ismq,_mq);
     }
 
     const std::string& GetGT() const {
         if (!_isgt) {
-            GetSampleValStr("GT",_gt);
+            GetSampleValStr(VCF_FORMAT_KEY::GT,_gt);
             _isgt = true;
         }
         return _gt;
@@ -146,24 +200,44 @@ struct GatkVcfRecord : public VcfRecord {
 
 private:
 
+    const MaybeInt&
+    GetCachedSampleVal(const VCF_FORMAT_KEY::index_t key,
+                       bool& is_set,
+                       MaybeInt& val) const {
+        if (! is_set) {
+            val.Set(GetSampleVal(key));
+            is_set=true;
+        }
+        return val;
+    }
+
     void
     IsSampleModified() { KillCache(); }
 
     void
     KillCache() {
-        _gqx.reset();
-        _gq.reset();
-        _dp.reset();
-        _mq.reset();
+        _isgqx=false;
+        _isgq=false;
+        _isdp=false;
+        _ismq=false;
         _isgt=false;
     }
 
-    mutable std::auto_ptr<MaybeInt> _gqx;
-    mutable std::auto_ptr<MaybeInt> _gq;
-    mutable std::auto_ptr<MaybeInt> _dp;
-    mutable std::auto_ptr<MaybeInt> _mq;
+    // cached values are stored inline and reused between records:
+    mutable bool _isgqx;
+    mutable bool _isgq;
+    mutable bool _isdp;
+    mutable bool _ismq;
     mutable bool _isgt;
+    mutable MaybeInt _gqx;
+    mutable MaybeInt _gq;
+    mutable MaybeInt _dp;
+    mutable MaybeInt _mq;
+    mutable MaybeInt _qual;
     mutable std::string _gt;
+
+    unsigned _filterSetId;
+    unsigned _gtId;
 };
 
 
@@ -0,0 +1,73 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+
+#ifndef __GATK_VCF_RECORD_WRITER_HH
+#define __GATK_VCF_RECORD_WRITER_HH
+
+#include "GatkVcfRecord.hh"
+#include "output_buffer.hh"
+
+
+/// destination for the final records of a VcfRecordBlocker
+///
+struct GatkVcfRecordWriter {
+
+    virtual ~GatkVcfRecordWriter() {}
+
+    /// write record
+    ///
+    /// The contents of record may be exchanged with a recycled record
+    /// held by this object, so the caller must not rely on its contents
+    /// after this call.
+    ///
+    virtual void Write(GatkVcfRecord& record) = 0;
+
+    /// make all records written so far available to the consumer
+    virtual void Flush() = 0;
+};
+
+
+
+/// formats records as vcf text into an output_buffer
+struct GatkVcfRecordTextWriter : public GatkVcfRecordWriter {
+
+    explicit
+    GatkVcfRecordTextWriter(output_buffer& ob)
+        : _ob(ob)
+    {}
+
+    void Write(GatkVcfRecord& record) { record.WriteUnaltered(_ob); }
+
+    void Flush() { _ob.flush(); }
+
+private:
+    output_buffer& _ob;
+};
+
+
+#endif
@@ -0,0 +1,362 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+
+
+#include "blt_exception.hh"
+#include "GatkVcfRecord.hh"
+#include "output_buffer.hh"
+#include "ParallelVcfRecordBlocker.hh"
+#include "VcfRecordBlocker.hh"
+
+#include <cstring>
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+
+
+/// growable in-memory sink holding chunk output until it is printed
+struct SpoolStreambuf : public std::streambuf {
+
+    std::vector<char> data;
+
+protected:
+    int_type
+    overflow(int_type c) {
+        if (! traits_type::eq_int_type(c,traits_type::eof())) {
+            data.push_back(traits_type::to_char_type(c));
+        }
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize
+    xsputn(const char* s,
+           std::streamsize n) {
+        data.insert(data.end(),s,s+n);
+        return n;
+    }
+};
+
+
+
+/// a VcfRecordBlocker with its own key dictionary, record and output spool
+struct ChunkBlocker {
+
+    ChunkBlocker(const BlockerOptions& opt,
+                 const VcfKeyDictionary& initKeys)
+        : keys(initKeys)
+        , out(&spool)
+        , blocker(opt,keys,out)
+        , record(keys)
+    {}
+
+    /// print spooled output from offset on and clear the spool
+    void
+    WriteOutput(const size_t offset,
+                output_buffer& ob) {
+        out.flush();
+        if (offset < spool.data.size()) {
+            ob.append(&(spool.data[offset]),spool.data.size()-offset);
+        }
+        spool.data.clear();
+    }
+
+    VcfKeyDictionary keys;
+    SpoolStreambuf spool;
+    output_buffer out;
+    VcfRecordBlocker blocker;
+    GatkVcfRecord record;
+};
+
+
+
+/// a blocker state which is independent of all earlier records
+struct ChunkSyncPoint {
+
+    ChunkSyncPoint(const unsigned initRecordIndex,
+                   const size_t initOutputOffset,
+                   const BlockerStats& initStats)
+        : recordIndex(initRecordIndex)
+        , outputOffset(initOutputOffset)
+        , stats(initStats)
+    {}
+
+    unsigned recordIndex;
+    size_t outputOffset; // spool size after the record is printed
+    BlockerStats stats; // stats of blocks printed since the previous sync point
+};
+
+
+
+/// a run of consecutive input records, stored as null terminated words,
+/// and the blocker which processes them
+struct RecordChunk : public thread_task {
+
+    RecordChunk(const BlockerOptions& opt,
+                const VcfKeyDictionary& keys)
+        : blocker(new ChunkBlocker(opt,keys))
+        , outputOffset(0)
+    {}
+
+    void
+    AddRecord(const line_splitter& vparse) {
+        const unsigned n_word(vparse.n_word());
+        _recordStart.push_back(_text.size());
+        _wordCount.push_back(n_word);
+        _lineNo.push_back(vparse.line_no());
+        for (unsigned i(0); i<n_word; ++i) {
+            const char* w(vparse.word[i]);
+            _text.insert(_text.end(),w,w+strlen(w)+1);
+        }
+    }
+
+    unsigned
+    Size() const { return _recordStart.size(); }
+
+    /// point word at the words of record index, returns the word count
+    unsigned
+    GetRecord(const unsigned index,
+              char** word) {
+        char* p(&(_text[_recordStart[index]]));
+        const unsigned n_word(_wordCount[index]);
+        for (unsigned i(0); i<n_word; ++i) {
+            word[i]=p;
+            p += strlen(p)+1;
+        }
+        return n_word;
+    }
+
+    unsigned
+    GetLineNo(const unsigned index) const { return _lineNo[index]; }
+
+    /// block all records, and note the first sync points found
+    void
+    run();
+
+    enum { MAX_SYNC_POINTS = 64 };
+
+    std::auto_ptr<ChunkBlocker> blocker;
+
+    // sync points of blocker, stats of all sync points still in this list
+    // are counted when the chunk is printed:
+    std::vector<ChunkSyncPoint> syncPoints;
+
+    // chunk output is printed from this spool offset:
+    size_t outputOffset;
+
+private:
+    std::vector<char> _text;
+    std::vector<size_t> _recordStart;
+    std::vector<unsigned> _wordCount;
+    std::vector<unsigned> _lineNo;
+};
+
+
+
+/// line_splitter over the records of a RecordChunk
+struct ChunkLineSplitter : public line_splitter {
+
+    explicit
+    ChunkLineSplitter(RecordChunk& chunk)
+        : _chunk(chunk)
+        , _next(0)
+    {}
+
+    bool
+    parse_line() {
+        if (_next >= _chunk.Size()) return false;
+        SetLine(_next++);
+        return true;
+    }
+
+    void
+    SetLine(const unsigned index) {
+        _n_word=_chunk.GetRecord(index,word);
+        _line_no=_chunk.GetLineNo(index);
+    }
+
+private:
+    RecordChunk& _chunk;
+    unsigned _next;
+};
+
+
+
+static
+void
+AppendRecord(const line_splitter& vparse,
+             ChunkBlocker& cb) {
+    try {
+        cb.record.Assign(vparse);
+        cb.blocker.Append(cb.record);
+    } catch (const std::exception& e) {
+        // this may be run on a pool thread, so report through the exception:
+        std::ostringstream oss;
+        oss << "Exception thrown while processing vcf record: '" << e.what() << "'\n"
+            << "\tVCF_INPUT_STATE:\n";
+        vparse.dump(oss);
+        throw blt_exception(oss.str().c_str());
+    }
+}
+
+
+
+void
+RecordChunk::
+run() {
+    ChunkBlocker& cb(*blocker);
+    ChunkLineSplitter vparse(*this);
+    const unsigned n_record(Size());
+    for (unsigned i(0); i<n_record; ++i) {
+        vparse.SetLine(i);
+        AppendRecord(vparse,cb);
+        if (cb.blocker.IsSyncPoint() && (syncPoints.size() < MAX_SYNC_POINTS)) {
+            cb.out.flush();
+            syncPoints.push_back(ChunkSyncPoint(i,cb.spool.data.size(),cb.blocker.GetStats()));
+            cb.blocker.ResetStats();
+        }
+    }
+}
+
+
+
+ParallelVcfRecordBlocker::
+ParallelVcfRecordBlocker(const BlockerOptions& opt,
+                         const VcfKeyDictionary& keys,
+                         const unsigned thread_count,
+                         const unsigned chunk_size)
+    : _opt(opt)
+    , _keys(keys)
+    , _chunkSize(std::max(chunk_size,1u))
+    , _maxActiveChunks(2*std::max(thread_count,1u))
+    , _pool(thread_count)
+{}
+
+
+
+ParallelVcfRecordBlocker::
+~ParallelVcfRecordBlocker() {}
+
+
+
+void
+ParallelVcfRecordBlocker::
+Append(const line_splitter& vparse) {
+    if (NULL == _fillChunk.get()) {
+        _fillChunk.reset(new RecordChunk(_opt,_keys));
+    }
+    _fillChunk->AddRecord(vparse);
+    if (_fillChunk->Size() >= _chunkSize) SubmitChunk();
+}
+
+
+
+void
+ParallelVcfRecordBlocker::
+Flush() {
+    if (NULL != _fillChunk.get()) SubmitChunk();
+    while (! _activeChunks.empty()) WriteFrontChunk();
+    _opt.outfp.flush();
+}
+
+
+
+void
+ParallelVcfRecordBlocker::
+SubmitChunk() {
+    while (_activeChunks.size() >= _maxActiveChunks) WriteFrontChunk();
+    _activeChunks.push_back(_fillChunk);
+    _fillChunk.reset();
+    _pool.submit(*(_activeChunks.back()));
+}
+
+
+
+void
+ParallelVcfRecordBlocker::
+WriteFrontChunk() {
+    RecordChunk& front(*(_activeChunks.front()));
+    front.wait();
+    ChunkBlocker& cb(*(front.blocker));
+
+    RecordChunk* next(NULL);
+    bool is_sync(false);
+    if (_activeChunks.size() > 1) {
+        next=_activeChunks[1].get();
+        next->wait();
+
+        // continue the front blocker through the next chunk until both
+        // blockers are at a sync point on the same record:
+        const std::vector<ChunkSyncPoint>& syncPoints(next->syncPoints);
+        const unsigned n_sync(syncPoints.size());
+        unsigned sync_index(0);
+
+        ChunkLineSplitter vparse(*next);
+        const unsigned n_record(next->Size());
+        for (unsigned i(0); i<n_record; ++i) {
+            vparse.SetLine(i);
+            AppendRecord(vparse,cb);
+            if (! cb.blocker.IsSyncPoint()) continue;
+            while ((sync_index < n_sync) && (syncPoints[sync_index].recordIndex < i)) sync_index++;
+            if ((sync_index < n_sync) && (syncPoints[sync_index].recordIndex == i)) {
+                is_sync=true;
+                break;
+            }
+        }
+
+        if (is_sync) {
+            // the next chunk's own output and stats are used after the sync point:
+            next->outputOffset=syncPoints[sync_index].outputOffset;
+            next->syncPoints.erase(next->syncPoints.begin(),next->syncPoints.begin()+sync_index+1);
+        }
+    } else {
+        cb.blocker.Flush();
+    }
+
+    cb.WriteOutput(front.outputOffset,_opt.outfp);
+    const unsigned n_front_sync(front.syncPoints.size());
+    for (unsigned i(0); i<n_front_sync; ++i) {
+        _stats.merge(front.syncPoints[i].stats);
+    }
+    _stats.merge(cb.blocker.GetStats());
+    cb.blocker.ResetStats();
+
+    if ((NULL != next) && (! is_sync)) {
+        // the front blocker has processed the whole of the next chunk, so
+        // it replaces the next chunk's blocker:
+        next->blocker=front.blocker;
+        next->outputOffset=0;
+        next->syncPoints.clear();
+    }
+
+    _activeChunks.pop_front();
+}
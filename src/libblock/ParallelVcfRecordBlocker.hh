@@ -0,0 +1,107 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+
+#ifndef __PARALLEL_VCF_RECORD_BLOCKER_HH
+#define __PARALLEL_VCF_RECORD_BLOCKER_HH
+
+#include "BlockerOptions.hh"
+#include "BlockerStats.hh"
+#include "line_splitter.hh"
+#include "thread_util.hh"
+#include "VcfKeyDictionary.hh"
+
+#include "boost/shared_ptr.hpp"
+
+#include <deque>
+
+
+struct RecordChunk;
+
+
+/// Block a single ordered stream of vcf records on a thread pool
+///
+/// Input records are cut into chunks of consecutive records, and each
+/// chunk is blocked by its own VcfRecordBlocker starting from an empty
+/// state. To join chunk k to chunk k+1, the blocker which finished chunk k
+/// continues through the head of chunk k+1 until it reaches a sync point
+/// (see VcfRecordBlocker::IsSyncPoint) at a record which was also a sync
+/// point for the chunk k+1 blocker. Chunk k+1 output is used from that
+/// record on. This reproduces any block or indel overlap region which
+/// spans the chunk boundary, so that output is identical to a single
+/// VcfRecordBlocker.
+///
+struct ParallelVcfRecordBlocker {
+
+    /// keys - key dictionary after reading the vcf header, each chunk
+    ///        blocker uses a copy of this dictionary
+    ParallelVcfRecordBlocker(const BlockerOptions& opt,
+                             const VcfKeyDictionary& keys,
+                             const unsigned thread_count,
+                             const unsigned chunk_size = DEFAULT_CHUNK_SIZE);
+
+    /// records not written by Flush() are discarded
+    ~ParallelVcfRecordBlocker();
+
+    /// Submit the next vcf record
+    void Append(const line_splitter& vparse);
+
+    /// Block and print all submitted records
+    void Flush();
+
+    /// stats of all blocks printed so far
+    const BlockerStats& GetStats() const { return _stats; }
+
+    enum { DEFAULT_CHUNK_SIZE = 65536 };
+
+private:
+    ParallelVcfRecordBlocker(const ParallelVcfRecordBlocker&);
+    ParallelVcfRecordBlocker& operator=(const ParallelVcfRecordBlocker&);
+
+    void SubmitChunk();
+
+    // print the output of the first active chunk up to the sync point in
+    // the following chunk:
+    void WriteFrontChunk();
+
+    typedef boost::shared_ptr<RecordChunk> chunk_ptr;
+
+    const BlockerOptions& _opt;
+    const VcfKeyDictionary& _keys;
+    const unsigned _chunkSize;
+    const unsigned _maxActiveChunks;
+
+    BlockerStats _stats;
+    chunk_ptr _fillChunk;
+    std::deque<chunk_ptr> _activeChunks;
+
+    // declared last so that all tasks are complete before chunks are destroyed:
+    thread_pool _pool;
+};
+
+
+#endif
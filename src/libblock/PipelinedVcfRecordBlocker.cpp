@@ -0,0 +1,408 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+
+
+#include "blt_exception.hh"
+#include "GatkVcfRecord.hh"
+#include "GatkVcfRecordWriter.hh"
+#include "PipelinedVcfRecordBlocker.hh"
+#include "vcf_util.hh"
+#include "VcfRecordBlocker.hh"
+
+#include <cstring>
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <sstream>
+
+
+
+void
+PipelineStats::
+report(std::ostream& os) const {
+    os << "PIPELINE_BATCH_COUNT: " << batch_count << "\n";
+    os << "PIPELINE_CONTIG_WAIT_COUNT: " << contig_wait_count << "\n";
+    os << "PIPELINE_PARSE_BUSY_SECONDS: " << parse.busy << "\n";
+    os << "PIPELINE_PARSE_IDLE_SECONDS: " << parse.idle << "\n";
+    os << "PIPELINE_BLOCK_BUSY_SECONDS: " << block.busy << "\n";
+    os << "PIPELINE_BLOCK_IDLE_SECONDS: " << block.idle << "\n";
+    os << "PIPELINE_WRITE_BUSY_SECONDS: " << write.busy << "\n";
+    os << "PIPELINE_WRITE_IDLE_SECONDS: " << write.idle << "\n";
+}
+
+
+
+/// fixed capacity run of records passed between pipeline stages
+struct RecordBatch {
+
+    RecordBatch(VcfKeyDictionary& keys,
+                const unsigned capacity)
+        : records(capacity,GatkVcfRecord(keys))
+        , size(0)
+    {}
+
+    bool
+    IsFull() const { return (size >= records.size()); }
+
+    std::vector<GatkVcfRecord> records;
+    unsigned size;
+};
+
+
+
+typedef batch_queue<RecordBatch> queue_t;
+
+
+static
+RecordBatch*
+TimedPop(queue_t& queue,
+         double& idle) {
+    const double start(get_monotonic_seconds());
+    RecordBatch* batch(queue.pop());
+    idle += (get_monotonic_seconds()-start);
+    return batch;
+}
+
+
+
+static
+bool
+TimedPush(queue_t& queue,
+          RecordBatch* batch,
+          double& idle) {
+    const double start(get_monotonic_seconds());
+    const bool is_pushed(queue.push(batch));
+    idle += (get_monotonic_seconds()-start);
+    return is_pushed;
+}
+
+
+
+/// swaps the final records of the block stage into output batches
+///
+/// Records are discarded once the pipeline has been stopped, so that the
+/// block stage simply runs out of input.
+///
+struct BatchRecordWriter : public GatkVcfRecordWriter {
+
+    explicit
+    BatchRecordWriter(PipelinedVcfRecordBlocker& pipe)
+        : _pipe(pipe)
+        , _batch(NULL)
+    {}
+
+    void
+    Write(GatkVcfRecord& record) {
+        if (NULL == _batch) {
+            _batch=TimedPop(_pipe._freeOutput,_pipe._pipelineStats.block.idle);
+            if (NULL == _batch) return;
+        }
+        _batch->records[_batch->size++].swap(record);
+        if (_batch->IsFull()) Submit();
+    }
+
+    void
+    Flush() {
+        if ((NULL != _batch) && (_batch->size > 0)) Submit();
+    }
+
+private:
+    void
+    Submit() {
+        {
+            thread_lock lock(_pipe._progressMutex);
+            _pipe._outputSubmitCount++;
+        }
+        TimedPush(_pipe._fullOutput,_batch,_pipe._pipelineStats.block.idle);
+        _batch=NULL;
+    }
+
+    PipelinedVcfRecordBlocker& _pipe;
+    RecordBatch* _batch;
+};
+
+
+
+/// runs one stage of the pipeline on a pool thread
+struct PipelineStageTask : public thread_task {
+
+    typedef void (PipelinedVcfRecordBlocker::*stage_t)();
+
+    PipelineStageTask(PipelinedVcfRecordBlocker& pipe,
+                      stage_t stage)
+        : _pipe(pipe)
+        , _stage(stage)
+    {}
+
+    void
+    run() {
+        try {
+            (_pipe.*_stage)();
+        } catch (...) {
+            _pipe.Abort();
+            throw;
+        }
+    }
+
+private:
+    PipelinedVcfRecordBlocker& _pipe;
+    stage_t _stage;
+};
+
+
+
+PipelinedVcfRecordBlocker::
+PipelinedVcfRecordBlocker(const BlockerOptions& opt,
+                          VcfKeyDictionary& keys,
+                          const unsigned batch_size,
+                          const unsigned queue_size)
+    : _opt(opt)
+    , _keys(keys)
+    , _freeInput(queue_size+2)
+    , _fullInput(std::max(queue_size,1u))
+    , _freeOutput(queue_size+2)
+    , _fullOutput(std::max(queue_size,1u))
+    , _fillBatch(NULL)
+    , _isFlushed(false)
+    , _inputSubmitCount(0)
+    , _inputDoneCount(0)
+    , _outputSubmitCount(0)
+    , _outputDoneCount(0)
+    , _isAborted(false)
+    , _startTime(get_monotonic_seconds())
+    , _pool(2)
+{
+    // each side has a batch in use by both of its stages, in addition to
+    // the batches in the queue between them:
+    const unsigned capacity(std::max(batch_size,1u));
+    for (unsigned i(0); i<(2*(queue_size+2)); ++i) {
+        _batches.push_back(batch_ptr(new RecordBatch(_keys,capacity)));
+        queue_t& freeQueue((i%2) ? _freeOutput : _freeInput);
+        freeQueue.push(_batches.back().get());
+    }
+
+    _writer.reset(new BatchRecordWriter(*this));
+    _blocker.reset(new VcfRecordBlocker(_opt,_keys,*_writer));
+
+    _blockTask.reset(new PipelineStageTask(*this,&PipelinedVcfRecordBlocker::RunBlockStage));
+    _writeTask.reset(new PipelineStageTask(*this,&PipelinedVcfRecordBlocker::RunWriteStage));
+    _pool.submit(*_blockTask);
+    _pool.submit(*_writeTask);
+}
+
+
+
+PipelinedVcfRecordBlocker::
+~PipelinedVcfRecordBlocker() {
+    Abort();
+}
+
+
+
+const BlockerStats&
+PipelinedVcfRecordBlocker::
+GetStats() const {
+    return _blocker->GetStats();
+}
+
+
+
+void
+PipelinedVcfRecordBlocker::
+Append(const line_splitter& vparse) {
+
+    // the contig dictionary can only be extended while no other stage is
+    // reading contig names:
+    const char* chrom(vparse.word[VCFID::CHROM]);
+    if (0 != strcmp(chrom,_lastChrom.c_str())) {
+        if (! _keys.IsContig(chrom)) {
+            SubmitBatch();
+            WaitForIdle();
+            _pipelineStats.contig_wait_count++;
+        }
+        _lastChrom=chrom;
+    }
+
+    if (NULL == _fillBatch) {
+        _fillBatch=TimedPop(_freeInput,_pipelineStats.parse.idle);
+        if (NULL == _fillBatch) ThrowStageError();
+    }
+
+    _fillBatch->records[_fillBatch->size].Assign(vparse);
+    _fillBatch->size++;
+    if (_fillBatch->IsFull()) SubmitBatch();
+}
+
+
+
+void
+PipelinedVcfRecordBlocker::
+Flush() {
+    if (_isFlushed) return;
+    SubmitBatch();
+    _fullInput.close();
+    _blockTask->wait();
+    _writeTask->wait();
+    _isFlushed=true;
+    _pipelineStats.parse.busy=(get_monotonic_seconds()-_startTime)-_pipelineStats.parse.idle;
+}
+
+
+
+void
+PipelinedVcfRecordBlocker::
+SubmitBatch() {
+    if ((NULL == _fillBatch) || (0 == _fillBatch->size)) return;
+    {
+        thread_lock lock(_progressMutex);
+        _inputSubmitCount++;
+    }
+    if (! TimedPush(_fullInput,_fillBatch,_pipelineStats.parse.idle)) ThrowStageError();
+    _fillBatch=NULL;
+    _pipelineStats.batch_count++;
+}
+
+
+
+void
+PipelinedVcfRecordBlocker::
+WaitForIdle() {
+    const double start(get_monotonic_seconds());
+    {
+        thread_lock lock(_progressMutex);
+        while ((! _isAborted) &&
+               ((_inputDoneCount != _inputSubmitCount) ||
+                (_outputDoneCount != _outputSubmitCount))) {
+            _progressCond.wait(_progressMutex);
+        }
+    }
+    _pipelineStats.parse.idle += (get_monotonic_seconds()-start);
+    if (_isAborted) ThrowStageError();
+}
+
+
+
+void
+PipelinedVcfRecordBlocker::
+Abort() {
+    {
+        thread_lock lock(_progressMutex);
+        _isAborted=true;
+        _progressCond.broadcast();
+    }
+    _freeInput.abort();
+    _fullInput.abort();
+    _freeOutput.abort();
+    _fullOutput.abort();
+}
+
+
+
+void
+PipelinedVcfRecordBlocker::
+ThrowStageError() {
+    Abort();
+    _blockTask->wait();
+    _writeTask->wait();
+    throw blt_exception("ERROR: vcf record pipeline stopped unexpectedly\n");
+}
+
+
+
+void
+PipelinedVcfRecordBlocker::
+FinishBatch(unsigned long& count) {
+    thread_lock lock(_progressMutex);
+    count++;
+    _progressCond.broadcast();
+}
+
+
+
+void
+PipelinedVcfRecordBlocker::
+RunBlockStage() {
+    const double start(get_monotonic_seconds());
+    double& idle(_pipelineStats.block.idle);
+    while (true) {
+        RecordBatch* batch(TimedPop(_fullInput,idle));
+        if (NULL == batch) break;
+        for (unsigned i(0); i<batch->size; ++i) {
+            GatkVcfRecord& record(batch->records[i]);
+            const unsigned chromId(record.GetChromId());
+            const int pos(record.GetPos());
+            try {
+                _blocker->Append(record);
+            } catch (const std::exception& e) {
+                // this is run on a pool thread, so report through the exception:
+                std::ostringstream oss;
+                oss << "Exception thrown while processing vcf record: '" << e.what() << "'\n"
+                    << "\tVCF_RECORD_POSITION: " << _keys.contig.GetKey(chromId) << ":" << pos << "\n";
+                throw blt_exception(oss.str().c_str());
+            }
+        }
+        batch->size=0;
+        _freeInput.push(batch);
+        FinishBatch(_inputDoneCount);
+    }
+
+    {
+        thread_lock lock(_progressMutex);
+        if (_isAborted) return;
+    }
+    _blocker->Flush();
+    _fullOutput.close();
+    _pipelineStats.block.busy=(get_monotonic_seconds()-start)-idle;
+}
+
+
+
+void
+PipelinedVcfRecordBlocker::
+RunWriteStage() {
+    const double start(get_monotonic_seconds());
+    double& idle(_pipelineStats.write.idle);
+    while (true) {
+        RecordBatch* batch(TimedPop(_fullOutput,idle));
+        if (NULL == batch) break;
+        for (unsigned i(0); i<batch->size; ++i) {
+            batch->records[i].WriteUnaltered(_opt.outfp);
+        }
+        batch->size=0;
+        _freeOutput.push(batch);
+        FinishBatch(_outputDoneCount);
+    }
+
+    {
+        thread_lock lock(_progressMutex);
+        if (_isAborted) return;
+    }
+    _opt.outfp.flush();
+    _pipelineStats.write.busy=(get_monotonic_seconds()-start)-idle;
+}
@@ -0,0 +1,204 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+
+#ifndef __PIPELINED_VCF_RECORD_BLOCKER_HH
+#define __PIPELINED_VCF_RECORD_BLOCKER_HH
+
+#include "batch_queue.hh"
+#include "BlockerOptions.hh"
+#include "BlockerStats.hh"
+#include "line_splitter.hh"
+#include "thread_util.hh"
+#include "VcfKeyDictionary.hh"
+
+#include "boost/shared_ptr.hpp"
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+struct BatchRecordWriter;
+struct PipelineStageTask;
+struct RecordBatch;
+struct VcfRecordBlocker;
+
+
+/// wall time of one pipeline stage
+struct PipelineStageTime {
+
+    PipelineStageTime()
+        : busy(0.)
+        , idle(0.)
+    {}
+
+    /// seconds spent processing
+    double busy;
+
+    /// seconds spent waiting on the neighbouring stages
+    double idle;
+};
+
+
+
+/// per-stage times used to find which stage limits throughput
+struct PipelineStats {
+
+    PipelineStats()
+        : batch_count(0)
+        , contig_wait_count(0)
+    {}
+
+    void
+    report(std::ostream& os) const;
+
+    PipelineStageTime parse;
+    PipelineStageTime block;
+    PipelineStageTime write;
+
+    /// number of record batches passed from parse to block
+    unsigned long batch_count;
+
+    /// number of times the parse stage waited for the other stages to
+    /// finish before adding a contig to the key dictionary
+    unsigned long contig_wait_count;
+};
+
+
+
+/// Block a single ordered stream of vcf records in a three stage pipeline
+///
+/// Records are parsed on the calling thread, groomed and blocked by a
+/// VcfRecordBlocker on a second thread, and formatted into opt.outfp on a
+/// third thread. Stages exchange batches of records through bounded
+/// queues, and record storage is recycled between the stages rather than
+/// copied. Records pass through every stage in input order, so output is
+/// identical to a single VcfRecordBlocker.
+///
+/// All stages share one key dictionary. Contig names are read by the
+/// later stages, so the parse stage waits for the pipeline to empty
+/// before any contig which is not already in the dictionary is added.
+///
+struct PipelinedVcfRecordBlocker {
+
+    /// keys - key dictionary after reading the vcf header, this is
+    ///        updated by the pipeline until Flush() returns
+    PipelinedVcfRecordBlocker(const BlockerOptions& opt,
+                              VcfKeyDictionary& keys,
+                              const unsigned batch_size = DEFAULT_BATCH_SIZE,
+                              const unsigned queue_size = DEFAULT_QUEUE_SIZE);
+
+    /// stops the pipeline, records not written by Flush() are discarded
+    ~PipelinedVcfRecordBlocker();
+
+    /// Submit the next vcf record
+    void Append(const line_splitter& vparse);
+
+    /// Block and print all submitted records, and stop the pipeline
+    void Flush();
+
+    /// stats of all blocks printed, available after Flush()
+    const BlockerStats& GetStats() const;
+
+    /// stage times, available after Flush()
+    const PipelineStats& GetPipelineStats() const { return _pipelineStats; }
+
+    enum {
+        DEFAULT_BATCH_SIZE = 1024,
+        DEFAULT_QUEUE_SIZE = 4
+    };
+
+private:
+    PipelinedVcfRecordBlocker(const PipelinedVcfRecordBlocker&);
+    PipelinedVcfRecordBlocker& operator=(const PipelinedVcfRecordBlocker&);
+
+    friend struct BatchRecordWriter;
+    friend struct PipelineStageTask;
+
+    // pass the batch being filled to the block stage:
+    void SubmitBatch();
+
+    // wait until the block and write stages have finished all submitted
+    // batches:
+    void WaitForIdle();
+
+    // stop all stages
+    void Abort();
+
+    // throw the error which stopped the pipeline:
+    void ThrowStageError();
+
+    // run on the block and write stage threads:
+    void RunBlockStage();
+    void RunWriteStage();
+
+    // count a finished batch and wake the parse stage if it is waiting
+    // for the pipeline to empty:
+    void FinishBatch(unsigned long& count);
+
+    typedef batch_queue<RecordBatch> queue_t;
+    typedef boost::shared_ptr<RecordBatch> batch_ptr;
+
+    const BlockerOptions& _opt;
+    VcfKeyDictionary& _keys;
+
+    std::vector<batch_ptr> _batches;
+    queue_t _freeInput;
+    queue_t _fullInput;
+    queue_t _freeOutput;
+    queue_t _fullOutput;
+
+    RecordBatch* _fillBatch;
+    std::string _lastChrom;
+    bool _isFlushed;
+
+    std::auto_ptr<BatchRecordWriter> _writer;
+    std::auto_ptr<VcfRecordBlocker> _blocker;
+
+    thread_mutex _progressMutex;
+    thread_condition _progressCond;
+    unsigned long _inputSubmitCount;
+    unsigned long _inputDoneCount;
+    unsigned long _outputSubmitCount;
+    unsigned long _outputDoneCount;
+    bool _isAborted;
+
+    double _startTime;
+    PipelineStats _pipelineStats;
+
+    std::auto_ptr<PipelineStageTask> _blockTask;
+    std::auto_ptr<PipelineStageTask> _writeTask;
+
+    // declared last so that both stage threads are joined before any
+    // other member is destroyed:
+    thread_pool _pool;
+};
+
+
+#endif
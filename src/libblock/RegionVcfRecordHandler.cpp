@@ -46,8 +46,8 @@ std::ostream& log_os(std::cerr);
 
 
 RegionVcfOptions::
-RegionVcfOptions() :
-    outfp(std::cout),
+RegionVcfOptions(output_buffer& out) :
+    outfp(out),
     isExcludeOffTarget(false),
     isIncludeVariants(false)
 {}
@@ -56,7 +56,7 @@ RegionVcfOptions() :
 
 void
 RegionVcfRecordHandler::
-process_line(const istream_line_splitter& vparse) {
+process_line(const line_splitter& vparse) {
     const unsigned nw(vparse.n_word());
 
     if (nw != (VCFID::SAMPLE+1)) {
@@ -80,7 +80,7 @@ process_line(const istream_line_splitter& vparse) {
     // for the record region, untill it's completely classified into
     // intersetions with the target:
     //
-    VcfRecord vcfr(vparse);
+    VcfRecord vcfr(vparse,_keys);
 
     bool is_in_region;
     unsigned end;
@@ -97,7 +97,7 @@ process_line(const istream_line_splitter& vparse) {
 
 bool
 RegionVcfRecordHandler::
-is_record_in_region(const istream_line_splitter& vparse) {
+is_record_in_region(const line_splitter& vparse) {
     // determine if chromosome is new:
     if (_last_chrom.empty() || (0 != strcmp(_last_chrom.c_str(),vparse.word[0]))) {
         _last_chrom=vparse.word[VCFID::CHROM];
@@ -131,7 +131,7 @@ is_record_in_region(const istream_line_splitter& vparse) {
 
 bool
 RegionVcfRecordHandler::
-is_write_off_region_record(const istream_line_splitter& vparse) const {
+is_write_off_region_record(const line_splitter& vparse) const {
     if (! _opt.isExcludeOffTarget) return true;
 
     if (_opt.isIncludeVariants) {
@@ -31,7 +31,8 @@
 #pragma once
 
 
-#include "istream_line_splitter.hh"
+#include "line_splitter.hh"
+#include "output_buffer.hh"
 #include "ref_util.hh"
 #include "region_util.hh"
 #include "VcfRecord.hh"
@@ -43,9 +44,11 @@
 
 struct RegionVcfOptions {
 
-    RegionVcfOptions();
+    /// \param out record and header output sink
+    explicit
+    RegionVcfOptions(output_buffer& out);
 
-    std::ostream& outfp;
+    output_buffer& outfp;
     std::string refSeqFile;
     region_util::region_t regions;
     bool isExcludeOffTarget;
@@ -58,15 +61,17 @@ struct RegionVcfOptions {
 //
 struct RegionVcfRecordHandler {
 
-    RegionVcfRecordHandler(const RegionVcfOptions& opt)
+    RegionVcfRecordHandler(const RegionVcfOptions& opt,
+                           VcfKeyDictionary& keys)
         : _opt(opt)
         , _scp(opt.refSeqFile.c_str())
+        , _keys(keys)
     {}
 
     virtual ~RegionVcfRecordHandler() {}
 
     void
-    process_line(const istream_line_splitter& vparse);
+    process_line(const line_splitter& vparse);
 
 private:
 
@@ -78,7 +83,7 @@ private:
 
     /// \brief does the current vcf record overlap with any regions?
     bool
-    is_record_in_region(const istream_line_splitter& vparse);
+    is_record_in_region(const line_splitter& vparse);
 
     // if is_record_in_region is true, call this function repeatedly
     // to get the end position and the in/out region status of the
@@ -92,7 +97,7 @@ private:
 
     /// \brief do we output this record, assuming it is off-region
     bool
-    is_write_off_region_record(const istream_line_splitter& vparse) const;
+    is_write_off_region_record(const line_splitter& vparse) const;
 
 protected:
 
@@ -104,11 +109,12 @@ protected:
     samtools_char_picker _scp;
 
 private:
+    VcfKeyDictionary& _keys;
     std::string _last_chrom;
     bool _is_skip_chrom; // true when pos is past all regions in current chrom
     region_util::interval_group_t::const_iterator _rhead,_rend;
 
     unsigned _begin_pos,_end_pos; // used to provide the region intercept iterator
 
-    mutable std::vector<int> _gtparse; ///< cache variable to reduce total sys calls
+    mutable vcf_genotype _gtparse; ///< cache variable to reduce total sys calls
 };
@@ -38,7 +38,7 @@
 
 bool
 VcfHeaderHandler::
-process_line(const istream_line_splitter& vparse) {
+process_line(const line_splitter& vparse) {
     if (! _is_valid) return false;
 
     const unsigned nw(vparse.n_word());
@@ -51,6 +51,8 @@ process_line(const istream_line_splitter& vparse) {
     const bool is_last(0 == strcmp(vparse.word[0],"#CHROM"));
     if (is_last) _is_valid = false;
 
+    if (NULL != _keys) _keys->AddHeaderLine(vparse.word[0]);
+
     if (_is_skip_header) return true;
 
     if (! is_last) {
@@ -66,7 +68,7 @@ process_line(const istream_line_splitter& vparse) {
         process_final_header_line();
     }
 
-    vparse.write_line(_os);
+    vparse.write_line(_ob);
     return true;
 }
 
@@ -79,8 +81,13 @@ write_format(const char* tag,
              const char* type,
              const char* description) const {
 
-    _os << "##FORMAT=<ID=" << tag
-        << ",Number=" << number
-        << ",Type=" << type
-        << ",Description=\"" << description << "\">\n";
+    _ob.append("##FORMAT=<ID=");
+    _ob.append(tag);
+    _ob.append(",Number=");
+    _ob.append(number);
+    _ob.append(",Type=");
+    _ob.append(type);
+    _ob.append(",Description=\"");
+    _ob.append(description);
+    _ob.append("\">\n");
 }
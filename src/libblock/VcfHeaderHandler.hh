@@ -33,31 +33,41 @@
 #define __VCF_HEADER_HANLDER
 
 
-#include "istream_line_splitter.hh"
+#include "line_splitter.hh"
+#include "output_buffer.hh"
+#include "VcfKeyDictionary.hh"
 
-#include <iosfwd>
+#include <ostream>
 
 
 struct VcfHeaderHandler {
     /// version - version number to add add the end of the header (set to NULL to disable)
     /// cmdline - cmdline to add add the end of the header (set to NULL to disable)
     /// is_skip_header - if true, don't write out any header lines
-    VcfHeaderHandler(std::ostream& os,
+    VcfHeaderHandler(output_buffer& ob,
                      const char* version = NULL,
                      const char* cmdline = NULL,
                      const bool is_skip_header = false)
-        : _os(os)
+        : _ob(ob)
+        , _os(&ob)
         , _version(version)
         , _cmdline(cmdline)
         , _is_skip_header(is_skip_header)
         , _is_valid(true)
+        , _keys(NULL)
     {}
 
     virtual
     ~VcfHeaderHandler() {}
 
     bool
-    process_line(const istream_line_splitter& vparse);
+    process_line(const line_splitter& vparse);
+
+    /// add the INFO and FORMAT keys of all header lines to keys
+    void
+    set_key_dictionary(VcfKeyDictionary& keys) {
+        _keys = &keys;
+    }
 
     void
     write_format(const char* tag,
@@ -68,7 +78,7 @@ struct VcfHeaderHandler {
 protected:
     virtual
     bool
-    is_skip_header_line(const istream_line_splitter& /*vparse*/) {
+    is_skip_header_line(const line_splitter& /*vparse*/) {
         return false;
     }
 
@@ -77,13 +87,17 @@ protected:
     process_final_header_line() {}
 
 
-    std::ostream& _os;
+    output_buffer& _ob;
+
+    // formatted header output, written through _ob:
+    std::ostream _os;
 
 private:
     const char* _version;
     const char* _cmdline;
     bool _is_skip_header;
     bool _is_valid;
+    VcfKeyDictionary* _keys;
 };
 
 #endif
@@ -0,0 +1,86 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+
+
+#include "VcfKeyDictionary.hh"
+
+#include <cassert>
+#include <cstring>
+
+
+
+VcfKeyDictionary::
+VcfKeyDictionary()
+    : _lastContigId(0)
+{
+    static const char* infoKeys[] = { "END", "DP", "MQ", "AC", "AF", "AN" };
+    static const char* formatKeys[] = { "GT", "GQ", "GQX", "DP", "MQ", "PL", "AD" };
+    static const unsigned n_info(sizeof(infoKeys)/sizeof(char*));
+    static const unsigned n_format(sizeof(formatKeys)/sizeof(char*));
+
+    assert(n_info == VCF_INFO_KEY::SIZE);
+    assert(n_format == VCF_FORMAT_KEY::SIZE);
+
+    for (unsigned i(0); i<n_info; ++i) {
+        info.GetId(infoKeys[i]);
+    }
+    for (unsigned i(0); i<n_format; ++i) {
+        format.GetId(formatKeys[i]);
+    }
+}
+
+
+
+void
+VcfKeyDictionary::
+AddHeaderLine(const char* line) {
+    static const char infoPrefix[] = "##INFO=<ID=";
+    static const char formatPrefix[] = "##FORMAT=<ID=";
+    static const char contigPrefix[] = "##contig=<ID=";
+    static const unsigned infoPrefixSize(sizeof(infoPrefix)-1);
+    static const unsigned formatPrefixSize(sizeof(formatPrefix)-1);
+    static const unsigned contigPrefixSize(sizeof(contigPrefix)-1);
+
+    VcfKeySet* keys(NULL);
+    if       (0 == strncmp(line,infoPrefix,infoPrefixSize)) {
+        keys = &info;
+        line += infoPrefixSize;
+    } else if (0 == strncmp(line,formatPrefix,formatPrefixSize)) {
+        keys = &format;
+        line += formatPrefixSize;
+    } else if (0 == strncmp(line,contigPrefix,contigPrefixSize)) {
+        keys = &contig;
+        line += contigPrefixSize;
+    } else {
+        return;
+    }
+
+    const unsigned len(strcspn(line,",>"));
+    if (0 == len) return;
+    keys->GetId(line,len);
+}
@@ -0,0 +1,155 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+
+
+#pragma once
+
+#include "id_map.hh"
+
+#include <cstring>
+
+#include <string>
+
+
+/// INFO keys with fixed id numbers in every VcfKeyDictionary
+namespace VCF_INFO_KEY {
+enum index_t
+{
+    END,
+    DP,
+    MQ,
+    AC,
+    AF,
+    AN,
+    SIZE
+};
+}
+
+/// FORMAT keys with fixed id numbers in every VcfKeyDictionary
+namespace VCF_FORMAT_KEY {
+enum index_t
+{
+    GT,
+    GQ,
+    GQX,
+    DP,
+    MQ,
+    PL,
+    AD,
+    SIZE
+};
+}
+
+
+
+/// assigns sequential id numbers to the keys of one vcf field (INFO or FORMAT)
+///
+struct VcfKeySet {
+
+    /// return key id, adding the key if not already present
+    unsigned
+    GetId(const char* key) {
+        _tmp=key;
+        return _keys.insert_key(_tmp);
+    }
+
+    unsigned
+    GetId(const char* key,
+          const unsigned len) {
+        _tmp.assign(key,len);
+        return _keys.insert_key(_tmp);
+    }
+
+    /// true if key is present, without adding it
+    bool
+    IsKey(const char* key) const {
+        return _keys.test_key(key);
+    }
+
+    const std::string&
+    GetKey(const unsigned id) const {
+        return _keys.get_key(id);
+    }
+
+    unsigned
+    size() const {
+        return _keys.size();
+    }
+
+private:
+    id_set<std::string> _keys;
+    std::string _tmp;
+};
+
+
+
+/// key id dictionaries for the INFO and FORMAT fields and the contig
+/// names of one vcf input
+///
+/// keys are taken from the ##INFO, ##FORMAT and ##contig header lines,
+/// and any key found only in the records is added the first time it is
+/// seen. The dictionary is updated on lookup, so each input stream being
+/// parsed needs its own copy.
+///
+struct VcfKeyDictionary {
+
+    VcfKeyDictionary();
+
+    /// add key from a ##INFO, ##FORMAT or ##contig header line, all other
+    /// lines are ignored
+    void
+    AddHeaderLine(const char* line);
+
+    /// return contig id, adding the contig if not already present
+    ///
+    /// records arrive sorted by contig, so the last contig found is
+    /// checked before the full lookup
+    unsigned
+    GetContigId(const char* name) {
+        if ((! _lastContig.empty()) && (0 == strcmp(name,_lastContig.c_str()))) {
+            return _lastContigId;
+        }
+        _lastContigId=contig.GetId(name);
+        _lastContig=name;
+        return _lastContigId;
+    }
+
+    /// true if contig is present, without adding it
+    bool
+    IsContig(const char* name) const {
+        return contig.IsKey(name);
+    }
+
+    VcfKeySet info;
+    VcfKeySet format;
+    VcfKeySet contig;
+
+private:
+    std::string _lastContig;
+    unsigned _lastContigId;
+};
@@ -38,9 +38,64 @@
 #include <sstream>
 
 
+void
+VcfFieldList::
+Write(output_buffer& os) const {
+    if (_is_owned) {
+        if (_val.empty()) {
+            os.append('.');
+            return;
+        }
+        const unsigned vs(_val.size());
+        for (unsigned i(0); i<vs; ++i) {
+            if (i) os.append(_delimiter);
+            os.append(_val[i]);
+        }
+    } else if (_raw.empty()) {
+        os.append('.');
+    } else if (! _is_split) {
+        os.append(_raw);
+    } else {
+        // restore the delimiters removed by the in-place split:
+        const unsigned vs(_offset.size());
+        for (unsigned i(0); i<vs; ++i) {
+            const size_t end((i+1<vs) ? (_offset[i+1]-1) : _raw.size());
+            if (i) os.append(_delimiter);
+            os.append(_raw.data()+_offset[i],end-_offset[i]);
+        }
+    }
+}
+
+
+
 VcfRecord::
-VcfRecord(const istream_line_splitter& vparse)
+VcfRecord(VcfKeyDictionary& keys)
+    : _keys(&keys)
+    , _chromId(0)
+    , _pos(0)
+    , _info(';',&keys.info,true)
+    , _format(':',&keys.format)
+    , _sample(':')
+{}
+
+
+
+VcfRecord::
+VcfRecord(const line_splitter& vparse,
+          VcfKeyDictionary& keys)
+    : _keys(&keys)
+    , _info(';',&keys.info,true)
+    , _format(':',&keys.format)
+    , _sample(':')
 {
+    Assign(vparse);
+}
+
+
+
+void
+VcfRecord::
+Assign(const line_splitter& vparse) {
     const unsigned ws(vparse.n_word());
     if (static_cast<int>(ws) <= VCFID::INFO) {
         std::ostringstream oss;
@@ -49,7 +104,7 @@ VcfRecord(const istream_line_splitter& vparse)
         throw blt_exception(oss.str().c_str());
     }
 
-    _chrom = vparse.word[VCFID::CHROM];
+    _chromId = _keys->GetContigId(vparse.word[VCFID::CHROM]);
 
     const char* pos_ptr(vparse.word[VCFID::POS]);
     _pos = parse_unsigned(pos_ptr);
@@ -75,30 +130,21 @@ VcfRecord(const istream_line_splitter& vparse)
 
     Splitter(vparse.word[VCFID::FILT],';',_filt);
 
-    Splitter(vparse.word[VCFID::INFO],';',_info);
-
-    if (ws > VCFID::FORMAT) {
-        Splitter(vparse.word[VCFID::FORMAT],':',_format);
-    }
-
-    if (ws > VCFID::SAMPLE) {
-        Splitter(vparse.word[VCFID::SAMPLE],':',_sample);
-    }
+    _info.Assign(vparse.word[VCFID::INFO]);
 
-    // by the vcf spec, we can drop trailing fields in any sample:
-    if (_sample.size() < _format.size())
-    {
-        _sample.resize(_format.size(),".");
-    }
+    _format.Assign((ws > VCFID::FORMAT) ? vparse.word[VCFID::FORMAT] : NULL);
+    _sample.Assign((ws > VCFID::SAMPLE) ? vparse.word[VCFID::SAMPLE] : NULL);
 
-    if (_format.size() != _sample.size()) {
+    // by the vcf spec, we can drop trailing fields in any sample, these are
+    // filled in if the sample is modified:
+    if (_format.CountEntries() < _sample.CountEntries()) {
         std::ostringstream oss;
         oss << "FORMAT and SAMPLE fields do not agree for vcf record:\n";
         vparse.dump(oss);
         throw blt_exception(oss.str().c_str());
     }
 
-
+    IsSampleModified();
 }
 
 
@@ -107,25 +153,30 @@ VcfRecord::
 Write(const std::string& printChrom,
       const int printPos,
       const std::string& refPlaceholder,
-      std::ostream& os) const {
+      output_buffer& os) const {
 
-    os << printChrom << '\t'
-       << printPos << '\t'
-       << _id << '\t'
-       << refPlaceholder << '\t';
+    os.append(printChrom);
+    os.append('\t');
+    os.append_int(printPos);
+    os.append('\t');
+    os.append(_id);
+    os.append('\t');
+    os.append(refPlaceholder);
+    os.append('\t');
 
     DumpAltString(_alt,os);
-    os << '\t'
-       << _qual << '\t';
+    os.append('\t');
+    os.append(_qual);
+    os.append('\t');
 
     DumpInfoString(_filt,os);
-    os << '\t';
-    DumpInfoString(_info,os);
-    os << '\t';
-    DumpFormatString(_format,os);
-    os << '\t';
-    DumpFormatString(_sample,os);
-    os << '\n';
+    os.append('\t');
+    _info.Write(os);
+    os.append('\t');
+    _format.Write(os);
+    os.append('\t');
+    _sample.Write(os);
+    os.append('\n');
 }
 
 
@@ -134,15 +185,14 @@ void
 VcfRecord::
 DumpVectorString(const std::vector<std::string>& v,
                  const char delimiter,
-                 std::ostream& os) {
+                 output_buffer& os) {
     if (v.empty()) {
-        os << '.';
+        os.append('.');
         return;
     }
     const unsigned vs(v.size());
     for (unsigned i(0); i<vs; ++i) {
-        if (i) os << delimiter;
-        os << v[i];
+        if (i) os.append(delimiter);
+        os.append(v[i]);
     }
 }
-
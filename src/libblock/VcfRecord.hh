@@ -31,26 +31,314 @@
 #pragma once
 
 
-#include "istream_line_splitter.hh"
+#include "line_splitter.hh"
+#include "output_buffer.hh"
 #include "string_util.hh"
 #include "vcf_util.hh"
-
-#include "boost/foreach.hpp"
+#include "VcfKeyDictionary.hh"
 
 #include <cassert>
 #include <cstring>
 
+#include <algorithm>
 #include <iosfwd>
+#include <string>
+#include <vector>
+
+
+
+/// delimited list field of a vcf record (INFO, FORMAT or SAMPLE)
+///
+/// The field text is copied from the input line as is, and is only split
+/// into entries on first access. Entries are copied into separately owned
+/// strings only when the list is first modified, so an unmodified field is
+/// written back verbatim.
+///
+/// If a key set is provided, the entries are indexed by key id on first
+/// lookup, so that Find() is a direct slot lookup. Keys are either the
+/// full entry (FORMAT) or the entry text before '=' (INFO, if is_keyval
+/// is set, where entries without a value are not indexed).
+///
+struct VcfFieldList {
+
+    explicit
+    VcfFieldList(const char delimiter,
+                 VcfKeySet* keys = NULL,
+                 const bool is_keyval = false)
+        : _delimiter(delimiter)
+        , _keys(keys)
+        , _is_keyval(is_keyval)
+        , _is_split(false)
+        , _is_indexed(false)
+        , _is_owned(false)
+    {}
+
+    /// set field text, where "." or an empty string is an empty list
+    ///
+    /// storage from the previous field is kept for reuse
+    ///
+    void
+    Assign(const char* str) {
+        _is_split=false;
+        _is_indexed=false;
+        _is_owned=false;
+        _offset.clear();
+        ReleaseVal(0);
+        if ((NULL == str) || (0 == strcmp(str,"."))) str="";
+        _raw=str;
+    }
+
+    /// number of entries, without splitting the field
+    unsigned
+    CountEntries() const {
+        if (_is_owned) return _val.size();
+        if (_is_split) return _offset.size();
+        if (_raw.empty()) return 0;
+        return 1+std::count(_raw.begin(),_raw.end(),_delimiter);
+    }
+
+    unsigned
+    size() const {
+        if (_is_owned) return _val.size();
+        Split();
+        return _offset.size();
+    }
+
+    const char*
+    operator[](const unsigned i) const {
+        if (_is_owned) return _val[i].c_str();
+        Split();
+        return _raw.c_str()+_offset[i];
+    }
+
+    /// index of the entry with key id, or -1 if the key is not present
+    int
+    Find(const unsigned id) const {
+        if (! _is_indexed) Index();
+        return ((id < _slot.size()) ? _slot[id] : -1);
+    }
+
+    /// get owned entries for modification
+    ///
+    /// the original field text is retained, so values previously returned
+    /// from operator[] remain valid until the next Assign(). Entries may
+    /// be changed in place but must keep their key, use Append(), Erase()
+    /// or Replace() to change the set of keys.
+    ///
+    std::vector<std::string>&
+    Modify() {
+        if (! _is_owned) {
+            const unsigned vs(size());
+            _val.resize(vs);
+            for (unsigned i(0); i<vs; ++i) {
+                ReuseVal(_val[i]);
+                _val[i]=(*this)[i];
+            }
+            _is_owned=true;
+        }
+        return _val;
+    }
+
+    /// append an empty entry for key id, and return it so that the
+    /// client can set the entry text. It is the client's responsibility
+    /// to not insert repeats
+    std::string&
+    Append(const unsigned id) {
+        std::string& entry(PushBack());
+        if (_is_indexed) SetSlot(id,_val.size()-1);
+        return entry;
+    }
+
+    /// append an entry, it is the client's responsibility to not insert
+    /// repeats
+    void
+    Append(const char* entry) {
+        PushBack()=entry;
+        _is_indexed=false;
+    }
+
+    void
+    Erase(const unsigned i) {
+        std::vector<std::string>& val(Modify());
+        const unsigned vs(val.size());
+        for (unsigned j(i); (j+1)<vs; ++j) {
+            val[j].swap(val[j+1]);
+        }
+        ReleaseVal(vs-1);
+        if (! _is_indexed) return;
+        const int ii(i);
+        const unsigned ss(_slot.size());
+        for (unsigned id(0); id<ss; ++id) {
+            if       (_slot[id] == ii) {
+                _slot[id] = -1;
+            } else if (_slot[id] > ii) {
+                _slot[id]--;
+            }
+        }
+    }
+
+    /// replace entry i, which may change its key
+    void
+    Replace(const unsigned i,
+            const char* entry) {
+        Modify()[i] = entry;
+        _is_indexed=false;
+    }
+
+    void
+    Clear() {
+        ReleaseVal(0);
+        _is_owned=true;
+        _slot.clear();
+        _is_indexed=true;
+    }
+
+    void
+    Write(output_buffer& os) const;
+
+    void
+    swap(VcfFieldList& rhs) {
+        std::swap(_delimiter,rhs._delimiter);
+        std::swap(_keys,rhs._keys);
+        std::swap(_is_keyval,rhs._is_keyval);
+        _raw.swap(rhs._raw);
+        std::swap(_is_split,rhs._is_split);
+        _offset.swap(rhs._offset);
+        std::swap(_is_indexed,rhs._is_indexed);
+        _slot.swap(rhs._slot);
+        std::swap(_is_owned,rhs._is_owned);
+        _val.swap(rhs._val);
+        _spare.swap(rhs._spare);
+    }
+
+private:
+    // move owned entries from index i onward to the spare list:
+    void
+    ReleaseVal(const unsigned i) {
+        const unsigned vs(_val.size());
+        for (unsigned j(i); j<vs; ++j) {
+            _spare.push_back(std::string());
+            _spare.back().swap(_val[j]);
+        }
+        _val.resize(i);
+    }
+
+    std::string&
+    PushBack() {
+        std::vector<std::string>& val(Modify());
+        val.resize(val.size()+1);
+        ReuseVal(val.back());
+        val.back().clear();
+        return val.back();
+    }
+
+    // give an empty entry the storage of a spare entry:
+    void
+    ReuseVal(std::string& val) {
+        if (_spare.empty()) return;
+        val.swap(_spare.back());
+        _spare.pop_back();
+    }
+
+    // split the field text in place:
+    void
+    Split() const {
+        if (_is_split) return;
+        _is_split=true;
+        if (_raw.empty()) return;
+        char* p(&(_raw[0]));
+        char* start(p);
+        while (true) {
+            _offset.push_back(start-p);
+            char* next(strchr(start,_delimiter));
+            if (NULL == next) break;
+            *next='\0';
+            start=next+1;
+        }
+    }
+
+    // build the key id to entry index map:
+    void
+    Index() const {
+        _is_indexed=true;
+        _slot.clear();
+        if (NULL == _keys) return;
+        _slot.resize(_keys->size(),-1);
+        const unsigned vs(size());
+        for (unsigned i(0); i<vs; ++i) {
+            const char* entry((*this)[i]);
+            unsigned len(0);
+            if (_is_keyval) {
+                const char* val(strchr(entry,'='));
+                if (NULL == val) continue;
+                len=val-entry;
+            } else {
+                len=strlen(entry);
+            }
+            const unsigned id(_keys->GetId(entry,len));
+            if ((id < _slot.size()) && (_slot[id] >= 0)) continue;
+            SetSlot(id,i);
+        }
+    }
+
+    void
+    SetSlot(const unsigned id,
+            const unsigned i) const {
+        if (id >= _slot.size()) _slot.resize(id+1,-1);
+        _slot[id]=i;
+    }
+
+    char _delimiter;
+    VcfKeySet* _keys;
+    bool _is_keyval;
+    mutable std::string _raw;
+    mutable bool _is_split;
+    mutable std::vector<unsigned> _offset;
+    mutable bool _is_indexed;
+    mutable std::vector<int> _slot;
+    bool _is_owned;
+    std::vector<std::string> _val;
+    std::vector<std::string> _spare; // released entries, kept for their storage
+};
 
 
 
 struct VcfRecord {
 
-    VcfRecord(const istream_line_splitter& vparse);
+    /// an empty record, which can be set with Assign()
+    explicit
+    VcfRecord(VcfKeyDictionary& keys);
+
+    VcfRecord(const line_splitter& vparse,
+              VcfKeyDictionary& keys);
 
     virtual ~VcfRecord() {}
 
-    const std::string& GetChrom() const { return _chrom; }
+    /// set record from a new input line, reusing this record's storage
+    void
+    Assign(const line_splitter& vparse);
+
+    /// exchange contents with another record, without copying
+    void
+    swap(VcfRecord& rhs) {
+        std::swap(_keys,rhs._keys);
+        std::swap(_chromId,rhs._chromId);
+        std::swap(_pos,rhs._pos);
+        _id.swap(rhs._id);
+        _ref.swap(rhs._ref);
+        _alt.swap(rhs._alt);
+        _qual.swap(rhs._qual);
+        _filt.swap(rhs._filt);
+        _info.swap(rhs._info);
+        _format.swap(rhs._format);
+        _sample.swap(rhs._sample);
+        _gtparse.swap(rhs._gtparse);
+    }
+
+    const std::string& GetChrom() const { return _keys->contig.GetKey(_chromId); }
+
+    /// contig id of the chromosome in this record's dictionary
+    unsigned GetChromId() const { return _chromId; }
 
     unsigned GetPos() const { return _pos; }
 
@@ -96,14 +384,11 @@ struct VcfRecord {
     IsStrictVariant() const {
         if (GetAlt().empty()) return false;
 
-        const char* gtstr(GetSampleVal("GT"));
+        const char* gtstr(GetSampleVal(VCF_FORMAT_KEY::GT));
         if (NULL == gtstr) return false;
 
         parse_gt(gtstr, _gtparse);
-        BOOST_FOREACH(const int allele, _gtparse) {
-            if (allele>0) return true;
-        }
-        return false;
+        return _gtparse.is_any_alt();
     }
 
 
@@ -133,71 +418,82 @@ struct VcfRecord {
         _filt.push_back(val);
     }
 
+    VcfKeyDictionary& GetKeys() const { return *_keys; }
+
+    // INFO and SAMPLE values can be accessed by key or by key id from
+    // this record's dictionary, standard keys have fixed ids in
+    // VCF_INFO_KEY and VCF_FORMAT_KEY
+    //
     const char*
     GetInfoVal(const char* key) const {
-        assert(NULL != key);
-        const unsigned ic(_info.size());
-        for (unsigned i(0); i<ic; ++i) {
-            const size_t index(_info[i].find('='));
-            if (index == std::string::npos) continue;
-            if (0 == _info[i].compare(0,index,key)) {
-                return _info[i].c_str()+index+1;
-            }
-        }
-        return NULL;
+        return GetInfoVal(_keys->info.GetId(key));
+    }
+
+    const char*
+    GetInfoVal(const unsigned key_id) const {
+        const int i(_info.Find(key_id));
+        if (i < 0) return NULL;
+        return strchr(_info[i],'=')+1;
     }
 
     void
     SetInfoVal(const char* key,
                const char* val) {
-        assert(NULL != key);
+        SetInfoVal(_keys->info.GetId(key),val);
+    }
+
+    void
+    SetInfoVal(const unsigned key_id,
+               const char* val) {
         assert(NULL != val);
-        const unsigned ic(_info.size());
-        for (unsigned i(0); i<ic; ++i) {
-            const size_t index(_info[i].find('='));
-            if (index == std::string::npos) continue;
-            if (0 == _info[i].compare(0,index,key)) {
-                _info[i].replace(index+1,std::string::npos,val);
-                return;
-            }
+        const int i(_info.Find(key_id));
+        if (i >= 0) {
+            std::string& entry(_info.Modify()[i]);
+            entry.replace(entry.find('=')+1,std::string::npos,val);
+            return;
         }
-        _info.push_back(std::string(key)+"="+val);
+        std::string& entry(_info.Append(key_id));
+        entry=_keys->info.GetKey(key_id);
+        entry+='=';
+        entry+=val;
     }
 
     void DeleteInfoKeyVal(const char* key) {
-        const unsigned ic(_info.size());
-        for (unsigned i(0); i<ic; ++i) {
-            const size_t index(_info[i].find('='));
-            if (index == std::string::npos) continue;
-            if (0 == _info[i].compare(0,index,key)) {
-                _info.erase(_info.begin()+i);
-                return;
-            }
-        }
+        DeleteInfoKeyVal(_keys->info.GetId(key));
+    }
+
+    void DeleteInfoKeyVal(const unsigned key_id) {
+        const int i(_info.Find(key_id));
+        if (i < 0) return;
+        _info.Erase(i);
     }
 
     // client's responsibility to not insert repeats:
     void
     AppendInfo(const char* info) {
-        _info.push_back(std::string(info));
+        _info.Append(info);
     }
 
-    void ClearInfo() { _info.clear(); }
+    void ClearInfo() { _info.Clear(); }
 
     const char*
     GetSampleVal(const char* key) const {
+        return GetSampleVal(_keys->format.GetId(key));
+    }
 
-        const unsigned fs(_format.size());
-        for (unsigned i(0); i<fs; ++i) {
-            if (_format[i] == key ) {
-                return _sample[i].c_str();
-            }
-        }
-        return NULL;
+    const char*
+    GetSampleVal(const unsigned key_id) const {
+        const int i(_format.Find(key_id));
+        if (i < 0) return NULL;
+
+        // by the vcf spec, trailing sample fields may be dropped:
+        if (static_cast<unsigned>(i) >= _sample.size()) return ".";
+        return _sample[i];
     }
 
+    template <typename K>
     bool
-    GetSampleValStr(const char* key,
+    GetSampleValStr(const K key,
                     std::string& val) const {
 
         const char* s(GetSampleVal(key));
@@ -213,54 +509,54 @@ struct VcfRecord {
     void
     SetSampleVal(const char* key,
                  const char* val) {
+        SetSampleVal(_keys->format.GetId(key),val);
+    }
+
+    void
+    SetSampleVal(const unsigned key_id,
+                 const char* val) {
 
         IsSampleModified();
-        const unsigned fs(_format.size());
-        for (unsigned i(0); i<fs; ++i) {
-            if (_format[i] == key ) {
-                _sample[i] = val;
-                return;
-            }
+        const int i(_format.Find(key_id));
+        std::vector<std::string>& sample(ModifySample());
+        if (i >= 0) {
+            sample[i] = val;
+            return;
         }
         // add key if not found
-        _format.push_back(key);
-        _sample.push_back(val);
+        _format.Append(key_id)=_keys->format.GetKey(key_id);
+        sample.push_back(val);
     }
 
     void
-    DeleteSampleKeyVal(const char* key)
-    {
-        int deli = -1;
-        const unsigned fs(_format.size());
-        for (unsigned i(0); i<fs; ++i) {
-            if (_format[i] == key ) {
-                deli = i;
-                break;
-            }
-        }
+    DeleteSampleKeyVal(const char* key) {
+        DeleteSampleKeyVal(_keys->format.GetId(key));
+    }
 
+    void
+    DeleteSampleKeyVal(const unsigned key_id)
+    {
+        const int deli(_format.Find(key_id));
         if (deli < 0) return;
-        _format.erase(_format.begin()+deli);
-        _sample.erase(_sample.begin()+deli);
+
+        std::vector<std::string>& sample(ModifySample());
+        _format.Erase(deli);
+        sample.erase(sample.begin()+deli);
         IsSampleModified();
     }
 
     void
     ReplaceSampleKey(const char* oldval,
                      const char* newval) {
-        const unsigned fs(_format.size());
-        for (unsigned i(0); i<fs; ++i) {
-            if (_format[i] == oldval ) {
-                _format[i] = newval;
-                IsSampleModified();
-                return;
-            }
-        }
+        const int i(_format.Find(_keys->format.GetId(oldval)));
+        if (i < 0) return;
+        _format.Replace(i,newval);
+        IsSampleModified();
     }
 
     void ClearSample() {
-        _format.clear();
-        _sample.clear();
+        _format.Clear();
+        _sample.Clear();
         IsSampleModified();
     }
 
@@ -268,10 +564,10 @@ struct VcfRecord {
     Write(const std::string& printChrom,
           const int printPos,
           const std::string& refPlaceholder,
-          std::ostream& os) const;
+          output_buffer& os) const;
 
     void
-    Write(std::ostream& os) {
+    Write(output_buffer& os) {
         static const std::string RPH = "..";
         const std::string* refvalptr = &(GetRef());
 
@@ -284,7 +580,7 @@ struct VcfRecord {
     }
 
     void
-    WriteUnaltered(std::ostream& os) const {
+    WriteUnaltered(output_buffer& os) const {
         Write(GetChrom(), GetPos(), GetRef(), os);
     }
 
@@ -295,57 +591,60 @@ protected:
 
 private:
 
+    // get owned sample values, padded to the FORMAT size:
+    std::vector<std::string>&
+    ModifySample() {
+        std::vector<std::string>& sample(_sample.Modify());
+        const unsigned fs(_format.size());
+        if (sample.size() < fs) sample.resize(fs,".");
+        return sample;
+    }
 
     static
     void
     DumpVectorString(const std::vector<std::string>& v,
                      const char delimiter,
-                     std::ostream& os);
+                     output_buffer& os);
 
     static void
     DumpAltString(const std::vector<std::string>& v,
-                  std::ostream& os) {
+                  output_buffer& os) {
         DumpVectorString(v,',',os);
     }
 
     static void
     DumpInfoString(const std::vector<std::string>& v,
-                   std::ostream& os) {
+                   output_buffer& os) {
         DumpVectorString(v,';',os);
     }
 
-    static void
-    DumpFormatString(const std::vector<std::string>& v,
-                     std::ostream& os) {
-        DumpVectorString(v,':',os);
-    }
-
     static
     void
     Splitter(const char* str,
              const char delimiter,
              std::vector<std::string>& v) {
-        v.clear();
-        if (NULL==str) return;
-        if ('\0'==*str) return;
-        if (0==strcmp(str,".")) return;
+        if ((NULL==str) || ('\0'==*str) || (0==strcmp(str,"."))) {
+            v.clear();
+            return;
+        }
         split_string(str,delimiter,v);
     }
 
 private:
-    std::string _chrom;
+    VcfKeyDictionary* _keys;
+    unsigned _chromId;
     unsigned _pos;
     std::string _id;
     std::string _ref;
     std::vector<std::string> _alt;
     std::string _qual;
     std::vector<std::string> _filt;
-    std::vector<std::string> _info;
-    std::vector<std::string> _format;
-    std::vector<std::string> _sample;
+    VcfFieldList _info;
+    VcfFieldList _format;
+    VcfFieldList _sample;
 
 
-    mutable std::vector<int> _gtparse; ///< cache variable to reduce total sys calls
+    mutable vcf_genotype _gtparse; ///< cache variable to reduce total sys calls
 };
 
 //std::ostream& operator<<(std::ostream& os, const VcfRecord& vcfr);
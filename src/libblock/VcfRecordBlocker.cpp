@@ -30,6 +30,7 @@
 ///
 
 
+#include "format_util.hh"
 #include "parse_util.hh"
 #include "VcfRecordBlocker.hh"
 
@@ -53,13 +54,98 @@ checked_double_parse(const char* s,
 
 
 
+VcfRecordBlocker::
+VcfRecordBlocker(const BlockerOptions& opt,
+                 VcfKeyDictionary& keys)
+    : _opt(opt)
+    , _textWriter(opt.outfp)
+    , _writer(_textWriter)
+    , _is_report_stats(true)
+    , _blockCvcfr(opt,keys,_stats)
+    , _lastChromId(-1)
+    , _is_highDepth(false)
+    , _bufferStartPos(0)
+    , _bufferEndPos(0)
+    , _recordBufferSize(0)
+    , _lastNonindelPos(0)
+    , _isSyncPoint(false)
+    , _windowSize(0)
+    , _greedyCvcfr(opt,keys,_greedyStats)
+    , _greedyRecord(keys)
+{
+    Init(keys);
+}
+
+
+
+VcfRecordBlocker::
+VcfRecordBlocker(const BlockerOptions& opt,
+                 VcfKeyDictionary& keys,
+                 output_buffer& out)
+    : _opt(opt)
+    , _textWriter(out)
+    , _writer(_textWriter)
+    , _is_report_stats(false)
+    , _blockCvcfr(opt,keys,_stats)
+    , _lastChromId(-1)
+    , _is_highDepth(false)
+    , _bufferStartPos(0)
+    , _bufferEndPos(0)
+    , _recordBufferSize(0)
+    , _lastNonindelPos(0)
+    , _isSyncPoint(false)
+    , _windowSize(0)
+    , _greedyCvcfr(opt,keys,_greedyStats)
+    , _greedyRecord(keys)
+{
+    Init(keys);
+}
+
+
+
+VcfRecordBlocker::
+VcfRecordBlocker(const BlockerOptions& opt,
+                 VcfKeyDictionary& keys,
+                 GatkVcfRecordWriter& writer)
+    : _opt(opt)
+    , _textWriter(opt.outfp)
+    , _writer(writer)
+    , _is_report_stats(false)
+    , _blockCvcfr(opt,keys,_stats)
+    , _lastChromId(-1)
+    , _is_highDepth(false)
+    , _bufferStartPos(0)
+    , _bufferEndPos(0)
+    , _recordBufferSize(0)
+    , _lastNonindelPos(0)
+    , _isSyncPoint(false)
+    , _windowSize(0)
+    , _greedyCvcfr(opt,keys,_greedyStats)
+    , _greedyRecord(keys)
+{
+    Init(keys);
+}
+
+
+
+void
+VcfRecordBlocker::
+Init(VcfKeyDictionary& keys) {
+    const unsigned fs(_opt.filters.size());
+    for (unsigned i(0); i<fs; ++i) {
+        const FilterInfo& filter(_opt.filters[i]);
+        VcfKeySet& filterKeys(filter.is_sample_value ? keys.format : keys.info);
+        _filterKeyIds.push_back(filterKeys.GetId(filter.tag.c_str()));
+    }
+}
+
+
+
 VcfRecordBlocker::
 ~VcfRecordBlocker() {
-    ProcessRecordBuffer();
-    WriteBlockCvcfr();
-    _opt.outfp.flush();
+    Flush();
 
-    if (_opt.is_block_stats()) {
+    if (_is_report_stats && _opt.is_block_stats()) {
         // We check that this file can be written to at the
         // beginning of the run. If there's an error here at
         // the very end of the run, just power-through any
@@ -73,6 +159,56 @@ VcfRecordBlocker::
 
 
 
+void
+VcfRecordBlocker::
+Flush() {
+    ProcessRecordBuffer();
+    WriteBlockCvcfr();
+    _writer.Flush();
+}
+
+
+
+void
+VcfRecordBlocker::
+WriteWindow(const bool is_full) {
+    const unsigned n(_windowSize);
+    if (0 == n) return;
+
+    const GatkVcfRecord* records(&(_window[0]));
+    _maxBlockSize.resize(n);
+    for (unsigned i(0); i<n; ++i) {
+        _maxBlockSize[i]=_blockCvcfr.GetMaxBlockSize(records+i,records+n);
+    }
+    GetMinBlockSegmentation(_maxBlockSize,_minBlockSize,_minBlockCount);
+
+    const bool is_open_block(is_full && (_minBlockSize[0] == n));
+    unsigned end(n);
+    if (is_full && (! is_open_block)) {
+        end=0;
+        while ((end+_minBlockSize[end]) < n) end += _minBlockSize[end];
+    }
+
+    for (unsigned i(0); i<end; i+=_minBlockSize[i]) {
+        const unsigned block_end(i+_minBlockSize[i]);
+        for (unsigned j(i); j<block_end; ++j) {
+            JoinRecordToBlock(_window[j]);
+        }
+        _stats.addLookaheadBlock();
+        if (is_open_block) break;
+        _blockCvcfr.Write(_writer);
+        _blockCvcfr.Reset();
+    }
+
+    // move the records of the last block to the front of the window:
+    for (unsigned i(end); i<n; ++i) {
+        _window[i-end].swap(_window[i]);
+    }
+    _windowSize=(n-end);
+}
+
+
+
 void
 VcfRecordBlocker::
 GroomInputRecord(GatkVcfRecord& record) {
@@ -80,14 +216,14 @@ GroomInputRecord(GatkVcfRecord& record) {
     // Transfer MQ over to a sample value for block averaging. To
     // keep non-variant blocks consistent with variants we need to
     // round both INFO and SAMPLE MQ to an int.
-    MaybeInt mqVal(record.GetInfoVal("MQ"));
+    MaybeInt mqVal(record.GetInfoVal(VCF_INFO_KEY::MQ));
     if (! mqVal.StrVal.empty()) {
         if (mqVal.IsInt) {
             const char* mqintstr( _intstr.get32(mqVal.IntVal));
-            record.SetInfoVal("MQ", mqintstr);
-            record.SetSampleVal("MQ", mqintstr);
+            record.SetInfoVal(VCF_INFO_KEY::MQ, mqintstr);
+            record.SetSampleVal(VCF_FORMAT_KEY::MQ, mqintstr);
         } else {
-            record.SetSampleVal("MQ", mqVal.StrVal.c_str());
+            record.SetSampleVal(VCF_FORMAT_KEY::MQ, mqVal.StrVal.c_str());
         }
     }
 
@@ -102,37 +238,43 @@ GroomInputRecord(GatkVcfRecord& record) {
         }
     }
 
-    // high depth filter:
-    if (_opt.is_chrom_depth()) {
-        // filter for high depth:
-        const std::string& thisChrom(record.GetChrom());
-        if ((_lastDepthChrom.empty()) || (_lastDepthChrom != thisChrom)) {
-
-            _is_highDepth=(0 != _opt.ChromDepth.count(thisChrom));
-            if (_is_highDepth) {
-                _highDepth = _opt.ChromDepth.find(thisChrom)->second * _opt.max_chrom_depth_filter_factor.numval();
-            }
-            _lastDepthChrom = thisChrom;
-        }
-
-        if (_is_highDepth) {
-            const char* dp(record.GetSampleVal("DP"));
-            if ((NULL != dp) && (parse_double(dp) > _highDepth)) {
-                record.AppendFilter(_opt.max_chrom_depth_filter_tag.c_str());
-            }
+    // high depth filter, the threshold is set for each chromosome in Append():
+    if (_is_highDepth) {
+        const char* dp(record.GetSampleVal(VCF_FORMAT_KEY::DP));
+        if ((NULL != dp) && (parse_double(dp) > _highDepth)) {
+            record.AppendFilter(_opt.max_chrom_depth_filter_tag.c_str());
         }
     }
 
     // handle all other filters:
-    AddFilterSet(record,_opt.filters);
+    AddFilterSet(record);
 
     // handle newer GATK-input case where "." is used for filter field instead of "PASS"
     if (record.GetFilter().empty()) { record.PassFilter(); }
 
     // remove standard pop-gen info tags from variant and non-variant records:
-    record.DeleteInfoKeyVal("AC");
-    record.DeleteInfoKeyVal("AF");
-    record.DeleteInfoKeyVal("AN");
+    record.DeleteInfoKeyVal(VCF_INFO_KEY::AC);
+    record.DeleteInfoKeyVal(VCF_INFO_KEY::AF);
+    record.DeleteInfoKeyVal(VCF_INFO_KEY::AN);
+
+    SetBlockIds(record);
+}
+
+
+
+void
+VcfRecordBlocker::
+SetBlockIds(GatkVcfRecord& record) {
+    bool is_new(false);
+    const unsigned filterSetId(_filterSetIds.GetId(record.GetFilter(),is_new));
+
+    const std::string& gt(record.GetGT());
+    const unsigned gtId(_gtIds.GetId(gt,is_new));
+    if (is_new) {
+        _isBlockableGT.push_back(gt.empty() || (gt == "./.") || (gt == ".") || (gt == "0/0") || (gt == "0"));
+    }
+
+    record.SetBlockIds(filterSetId,gtId);
 }
 
 
@@ -140,14 +282,15 @@ GroomInputRecord(GatkVcfRecord& record) {
 void
 VcfRecordBlocker::
 AddFilter(GatkVcfRecord& record,
-          const FilterInfo& filter) {
+          const FilterInfo& filter,
+          const unsigned key_id) {
 
     bool is_filter(false);
     const char* tagval(NULL);
     if (filter.is_sample_value) {
-        tagval = record.GetSampleVal(filter.tag.c_str());
+        tagval = record.GetSampleVal(key_id);
     } else {
-        tagval = record.GetInfoVal(filter.tag.c_str());
+        tagval = record.GetInfoVal(key_id);
     }
     const MaybeInt val(tagval);
     if (!val.IsInt) {
@@ -214,10 +357,10 @@ static
 void
 set_record_to_unknown_gt(GatkVcfRecord& record) {
     record.SetQual(".");
-    record.DeleteSampleKeyVal("PL");
-    record.DeleteSampleKeyVal("GQ");
-    record.DeleteSampleKeyVal("GQX");
-    record.SetSampleVal("GT",".");
+    record.DeleteSampleKeyVal(VCF_FORMAT_KEY::PL);
+    record.DeleteSampleKeyVal(VCF_FORMAT_KEY::GQ);
+    record.DeleteSampleKeyVal(VCF_FORMAT_KEY::GQX);
+    record.SetSampleVal(VCF_FORMAT_KEY::GT,".");
 }
 
 
@@ -251,9 +394,9 @@ adjust_overlap_record(const BlockerOptions& opt,
 
     if (rinfo.gq.is_valid) {
         double record_gq(0.);
-        const bool is_valid(checked_double_parse(record.GetSampleVal("GQ"),record_gq));
+        const bool is_valid(checked_double_parse(record.GetSampleVal(VCF_FORMAT_KEY::GQ),record_gq));
         if (is_valid && (rinfo.gq.val<record_gq)) {
-            record.SetSampleVal("GQ",rinfo.gq.str);
+            record.SetSampleVal(VCF_FORMAT_KEY::GQ,rinfo.gq.str);
         }
     }
 
@@ -261,7 +404,7 @@ adjust_overlap_record(const BlockerOptions& opt,
     assert(rinfo.copyn<2);
 
     if (rinfo.copyn==1) {
-        std::vector<int> gti;
+        vcf_genotype gti;
         if (! record.GetGT().empty()) {
             parse_gt(record.GetGT().c_str(),gti);
         }
@@ -269,10 +412,10 @@ adjust_overlap_record(const BlockerOptions& opt,
         if (gti.size() == 2) {
             if (gti[0]==gti[1]) {
                 if       (gti[0]>=0) {
-                    std::ostringstream oss;
-                    oss << gti[0];
-                    record.SetSampleVal("GT",oss.str().c_str());
-                    record.DeleteSampleKeyVal("PL");
+                    char gt[MAX_INT_FORMAT_SIZE+1];
+                    *format_int(gti[0],gt) = '\0';
+                    record.SetSampleVal(VCF_FORMAT_KEY::GT,gt);
+                    record.DeleteSampleKeyVal(VCF_FORMAT_KEY::PL);
                 } else {
                     set_record_to_unknown_gt(record);
                 }
@@ -295,13 +438,14 @@ void
 VcfRecordBlocker::
 GroomRecordBuffer() {
 
-    const unsigned n_records(_recordBuffer.size());
+    const unsigned n_records(_recordBufferSize);
 
 #ifdef VDEBUG
     if (true) {
         std::cerr << "VDEBUG input: indel count: " << _indelIndex.size() << "\n";
+        output_buffer ob(std::cerr.rdbuf());
         for (unsigned i(0); i<n_records; ++i) {
-            _recordBuffer[i].WriteUnaltered(std::cerr);
+            _recordBuffer[i].WriteUnaltered(ob);
         }
     }
 #endif
@@ -325,7 +469,7 @@ GroomRecordBuffer() {
         // set additional minq:
         rinfo.qual.str=record.GetQual().c_str();
         rinfo.qual.is_valid=checked_double_parse(rinfo.qual.str,rinfo.qual.val);
-        rinfo.gq.str=record.GetSampleVal("GQ");
+        rinfo.gq.str=record.GetSampleVal(VCF_FORMAT_KEY::GQ);
         rinfo.gq.is_valid=checked_double_parse(rinfo.gq.str,rinfo.gq.val);
 
         _gti.clear();
@@ -375,7 +519,7 @@ GroomRecordBuffer() {
             // 3) modify or delete all other allele dependent tags (this might just be AD in practice)
             std::vector<std::string>& alt(record.GetAlt());
             alt.insert(alt.begin(),allele);
-            record.SetSampleVal("GT","1/2");
+            record.SetSampleVal(VCF_FORMAT_KEY::GT,"1/2");
         }
     }
 #endif
@@ -384,8 +528,9 @@ GroomRecordBuffer() {
 #ifdef VDEBUG
     if (true) {
         std::cerr << "VDEBUG output: indel count: " << _indelIndex.size() << "\n";
+        output_buffer ob(std::cerr.rdbuf());
         for (unsigned i(0); i<n_records; ++i) {
-            _recordBuffer[i].WriteUnaltered(std::cerr);
+            _recordBuffer[i].WriteUnaltered(ob);
         }
     }
 #endif
@@ -397,12 +542,12 @@ void
 VcfRecordBlocker::
 ProcessRecordBuffer() {
 
-    if (_recordBuffer.empty()) return;
+    if (0 == _recordBufferSize) return;
 
     // every record buffer should contain an indel:
     assert(_indelIndex.size() > 0);
 
-    const unsigned n_records(_recordBuffer.size());
+    const unsigned n_records(_recordBufferSize);
 
     // if there's only one record, assume this is a simple insertion and don't process
     // it for overlap information:
@@ -411,5 +556,5 @@ ProcessRecordBuffer() {
     // send recordbuffer on for printing/blocking:
     for (unsigned i(0); i<n_records; ++i) ProcessRecord(_recordBuffer[i]);
     _indelIndex.clear();
-    _recordBuffer.clear();
+    _recordBufferSize=0;
 }
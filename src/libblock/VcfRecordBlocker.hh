@@ -33,8 +33,47 @@
 
 #include "BlockerOptions.hh"
 #include "BlockVcfRecord.hh"
+#include "GatkVcfRecordWriter.hh"
+#include "id_map.hh"
 
 #include <string>
+#include <vector>
+
+
+
+/// assigns sequential ids to the distinct values of a record field
+///
+/// consecutive records usually share the same value, so the last value
+/// found is checked before the full lookup
+///
+template <typename T>
+struct FieldValueIdSet {
+
+    FieldValueIdSet()
+        : _lastId(0)
+        , _isLast(false)
+    {}
+
+    /// return value id, and set is_new if the value was added
+    unsigned
+    GetId(const T& val,
+          bool& is_new) {
+        is_new=false;
+        if (_isLast && (val == _last)) return _lastId;
+        const unsigned size(_ids.size());
+        _lastId=_ids.insert_key(val);
+        is_new=(_lastId == size);
+        _last=val;
+        _isLast=true;
+        return _lastId;
+    }
+
+private:
+    id_set<T> _ids;
+    T _last;
+    unsigned _lastId;
+    bool _isLast;
+};
 
 
 
@@ -42,32 +81,62 @@
 ///
 struct VcfRecordBlocker {
 
-    VcfRecordBlocker(const BlockerOptions& opt)
-        : _opt(opt)
-        , _blockCvcfr(opt,_stats)
-        , _is_highDepth(false)
-        , _bufferStartPos(0)
-        , _bufferEndPos(0)
-        , _lastNonindelPos(0)
-    {}
+    /// keys - key dictionary of the records submitted to this object
+    VcfRecordBlocker(const BlockerOptions& opt,
+                     VcfKeyDictionary& keys);
+
+    /// write records to out instead of opt.outfp, block stats are not
+    /// reported by this object
+    VcfRecordBlocker(const BlockerOptions& opt,
+                     VcfKeyDictionary& keys,
+                     output_buffer& out);
+
+    /// submit final records to writer instead of printing them, block
+    /// stats are not reported by this object
+    VcfRecordBlocker(const BlockerOptions& opt,
+                     VcfKeyDictionary& keys,
+                     GatkVcfRecordWriter& writer);
 
     /// Process and print any remaining blocks
     ~VcfRecordBlocker();
 
+    /// Process and print all buffered records and blocks
+    void Flush();
+
+    /// true if the last record submitted was written directly, leaving
+    /// no buffered record, block or indel region which could affect the
+    /// handling of any later record. Any two blockers at a sync point on
+    /// the same record produce the same output from the remaining records
+    bool IsSyncPoint() const { return _isSyncPoint; }
+
+    const BlockerStats& GetStats() const { return _stats; }
+
+    void ResetStats() { _stats = BlockerStats(); }
+
+    /// add stats from blocks written by another object
+    void MergeStats(const BlockerStats& stats) { _stats.merge(stats); }
+
     /// Submit next vcf record for printing or blocking
     ///
+    /// The contents of record may be exchanged with a recycled record
+    /// held by this object, so that storage is reused rather than
+    /// copied. record should be reset with Assign() before reuse.
+    ///
     void Append(GatkVcfRecord& record)
     {
+        _isSyncPoint=false;
+
         // tack-on a handler for chromosome switch:
-        const std::string& thisChrom(record.GetChrom());
-        if ((_lastChrom.empty()) || (_lastChrom != thisChrom)) {
+        const int thisChromId(record.GetChromId());
+        if (_lastChromId != thisChromId) {
             ProcessRecordBuffer();
             WriteBlockCvcfr();
             _bufferStartPos=0;
             _bufferEndPos=0;
             _lastNonindelPos=0;
 
-            _lastChrom=thisChrom;
+            _lastChromId=thisChromId;
+            SetChromDepth(record.GetChrom());
         }
 
         if (IsSkipRecord(record)) return;
@@ -78,18 +147,24 @@ struct VcfRecordBlocker {
 
 private:
 
+    void Init(VcfKeyDictionary& keys);
+
     void WriteBlockCvcfr() {
-        _blockCvcfr.Write(_opt.outfp);
+        if (0 != _opt.block_lookahead) {
+            WriteWindow(false);
+            _greedyCvcfr.Reset();
+        }
+        _blockCvcfr.Write(_writer);
         _blockCvcfr.Reset();
     }
 
     // write a single non-blockable record:
     void WriteThisCvcfr(GatkVcfRecord& record) {
         if (record.GetGQX().IsInt) {
-            record.SetSampleVal("GQX",_intstr.get32(record.GetGQX().IntVal));
+            record.SetSampleVal(VCF_FORMAT_KEY::GQX,_intstr.get32(record.GetGQX().IntVal));
         }
 
-        record.WriteUnaltered(_opt.outfp);
+        _writer.Write(record);
     }
 
     bool IsRecordInCurrentBlock(GatkVcfRecord& record) {
@@ -119,8 +194,23 @@ private:
         return false;
     }
 
+    // set high depth filter threshold for a new chromosome:
+    void
+    SetChromDepth(const std::string& chrom) {
+        if (! _opt.is_chrom_depth()) return;
+        const BlockerOptions::cdmap_t::const_iterator i(_opt.ChromDepth.find(chrom));
+        _is_highDepth=(i != _opt.ChromDepth.end());
+        if (_is_highDepth) {
+            _highDepth = i->second * _opt.max_chrom_depth_filter_factor.numval();
+        }
+    }
+
     void GroomInputRecord(GatkVcfRecord& record);
 
+    // intern the final FILTER and GT values of a groomed record, so
+    // that block membership is tested on integer ids:
+    void SetBlockIds(GatkVcfRecord& record);
+
     // accumulate all contiguous regions where sites or indels overlap with other indels:
     //
     void AccumulateRecords(GatkVcfRecord& record) {
@@ -148,24 +238,36 @@ private:
 
             _bufferEndPos=std::max(_bufferEndPos,endPos);
 
-            if (!(_recordBuffer.empty() || is_in_indel)) {
+            if (!((0 == _recordBufferSize) || is_in_indel)) {
                 ProcessRecordBuffer();
             }
-            _indelIndex.push_back(_recordBuffer.size());
-            _recordBuffer.push_back(record);
+            _indelIndex.push_back(_recordBufferSize);
+            BufferRecord(record);
         } else {
             const bool is_in_indel((pos>=_bufferStartPos) && (pos<=_bufferEndPos));
             if (is_in_indel) {
-                _recordBuffer.push_back(record);
+                BufferRecord(record);
             } else {
-                if (!_recordBuffer.empty()) {
+                if (0 != _recordBufferSize) {
                     ProcessRecordBuffer();
                 }
                 ProcessRecord(record);
+                _isSyncPoint=((pos > _bufferEndPos) && _blockCvcfr.Empty() && (0 == _windowSize));
             }
         }
     }
 
+    // swap record into the next record buffer slot, the buffer
+    // only grows when a larger indel region is found than any
+    // previous region:
+    void
+    BufferRecord(GatkVcfRecord& record) {
+        if (_recordBufferSize == _recordBuffer.size()) {
+            _recordBuffer.push_back(GatkVcfRecord(record.GetKeys()));
+        }
+        _recordBuffer[_recordBufferSize++].swap(record);
+    }
+
     void GroomRecordBuffer();
 
     // make changes to records in the record buffer according to
@@ -176,7 +278,12 @@ private:
 
 
     // After all input modifications are finished, send record on to
-    // be joined to a block or printed:
+    // be joined to a block or printed.
+    //
+    // Each block is extended as far as possible. This does not always
+    // give the fewest blocks (see BlockVcfRecord::GetMaxBlockSize), so
+    // if opt.block_lookahead is set blockable records are held in a
+    // window instead, see WriteWindow:
     void ProcessRecord(GatkVcfRecord& record) {
 
         if (!IsVcfRecordBlockable(record)) {
@@ -185,17 +292,62 @@ private:
             return;
         }
 
+        if (0 != _opt.block_lookahead) {
+            if (_opt.is_block_stats()) CountGreedyBlock(record);
+
+            // a block which filled the window is extended as far as possible:
+            if (! _blockCvcfr.Empty()) {
+                if (IsRecordInCurrentBlock(record)) {
+                    JoinRecordToBlock(record);
+                    return;
+                }
+                _blockCvcfr.Write(_writer);
+                _blockCvcfr.Reset();
+            }
+            WindowRecord(record);
+            return;
+        }
+
         if (!IsRecordInCurrentBlock(record)) {
             WriteBlockCvcfr();
         }
         JoinRecordToBlock(record);
     }
 
-    static
+    // follow the blocks which extending each block as far as possible
+    // would give, to count these in the block stats:
     void
-    AddFilterSet(GatkVcfRecord& record,
-                 const std::vector<FilterInfo>& filters) {
+    CountGreedyBlock(GatkVcfRecord& record) {
+        if (! _greedyCvcfr.Test(record)) _greedyCvcfr.Reset();
+        if (_greedyCvcfr.Empty()) {
+            _greedyRecord=record;
+            _greedyCvcfr.Add(_greedyRecord);
+            _stats.addGreedyBlock();
+        } else {
+            _greedyCvcfr.Add(record);
+        }
+    }
+
+    // swap record into the lookahead window, as for BufferRecord:
+    void
+    WindowRecord(GatkVcfRecord& record) {
+        if (_windowSize == _window.size()) {
+            _window.push_back(GatkVcfRecord(record.GetKeys()));
+        }
+        _window[_windowSize++].swap(record);
+        if (_windowSize >= _opt.block_lookahead) WriteWindow(true);
+    }
 
+    // write the records of the lookahead window in the fewest blocks.
+    // If is_full, the last block is kept in the window to be joined by
+    // later records, unless the whole window is one block, in which
+    // case this is left open in _blockCvcfr:
+    void WriteWindow(const bool is_full);
+
+    void
+    AddFilterSet(GatkVcfRecord& record) {
+
+        const std::vector<FilterInfo>& filters(_opt.filters);
         const bool is_indel(record.IsIndel());
         const unsigned fs(filters.size());
         for (unsigned i(0); i<fs; ++i) {
@@ -205,14 +357,15 @@ private:
             } else if (ft == FILTERTYPE::INDEL) {
                 if (! is_indel) continue;
             }
-            AddFilter(record,filters[i]);
+            AddFilter(record,filters[i],_filterKeyIds[i]);
         }
     }
 
     static
     void
     AddFilter(GatkVcfRecord& record,
-              const FilterInfo& filter);
+              const FilterInfo& filter,
+              const unsigned key_id);
 
     /// Certain vcf records can *never* be compressed -- such as variants
     /// and annotated sites
@@ -225,13 +378,12 @@ private:
         //if (record.GetInfo().Count != 0)
         //    return false; // might have to take this one out eventually
 
-        const std::string& gt = record.GetGT();
-        if ((!gt.empty()) && (gt != "./.") && (gt != ".") && (gt != "0/0") && (gt != "0")) return false;
+        if (! _isBlockableGT[record.GetGTId()]) return false;
 
         // AD from GATK uses unfiltered counts, for this reason we use
         // info DP (unfiltered) instead of sample DP (filtered)
-        const MaybeInt info_dp(record.GetInfoVal("DP"));
-        const MaybeInt ad(record.GetSampleVal("AD"));
+        const MaybeInt info_dp(record.GetInfoVal(VCF_INFO_KEY::DP));
+        const MaybeInt ad(record.GetSampleVal(VCF_FORMAT_KEY::AD));
         if (ad.IsInt && info_dp.IsInt) {
             const double reffrac(static_cast<double>(ad.IntVal)/static_cast<double>(info_dp.IntVal));
             if ((reffrac+_opt.min_nonref_blockable.numval()) <= 1.0) return false;
@@ -242,21 +394,41 @@ private:
 
 private:
     const BlockerOptions& _opt;
+    GatkVcfRecordTextWriter _textWriter;
+    GatkVcfRecordWriter& _writer;
+    bool _is_report_stats;
     BlockVcfRecord _blockCvcfr;
 
-    std::string _lastChrom;
-    std::string _lastDepthChrom;
+    // INFO or FORMAT key id of each filter in _opt.filters:
+    std::vector<unsigned> _filterKeyIds;
+
+    FieldValueIdSet<std::vector<std::string> > _filterSetIds;
+    FieldValueIdSet<std::string> _gtIds;
+    std::vector<bool> _isBlockableGT; // indexed on GT id
+
+    int _lastChromId;
     bool _is_highDepth;
     double _highDepth;
 
     int _bufferStartPos,_bufferEndPos; // buffer all records on [Start,End]
     std::vector<GatkVcfRecord> _recordBuffer; // buffer positions crossed by deletions or other indel events
+    unsigned _recordBufferSize; // records in use at the front of _recordBuffer, the remainder are recycled
     std::vector<unsigned> _indelIndex; // record index of records in buffer which are indels
 
     unsigned _lastNonindelPos;
+    bool _isSyncPoint;
+
+    std::vector<GatkVcfRecord> _window; // blockable records held for lookahead blocking
+    unsigned _windowSize; // records in use at the front of _window, the remainder are recycled
+    std::vector<unsigned> _maxBlockSize; // largest block starting at each window record
+    std::vector<unsigned> _minBlockSize; // first block of the fewest blocks from each window record
+    std::vector<unsigned> _minBlockCount;
+    BlockerStats _greedyStats; // _greedyCvcfr is never written, so nothing is added here
+    BlockVcfRecord _greedyCvcfr; // the block which _blockCvcfr would hold without lookahead
+    GatkVcfRecord _greedyRecord; // copy of the first record of _greedyCvcfr
 
     //tmp catch for gt parsing:
-    std::vector<int> _gti;
+    vcf_genotype _gti;
     //obj for fast int->str
     stringer<int> _intstr;
 
@@ -0,0 +1,140 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+/// \file
+///
+/// count heap allocations made while blocking a gatk all-sites vcf
+///
+/// usage: record_alloc_bench file.vcf
+///
+/// input is read and blocked as in gatk_to_gvcf with default options,
+/// and output is discarded. The number of operator new calls is reported
+/// for the first 10% of records, where buffers are still growing, and per
+/// record for the remainder.
+///
+
+#include "BlockerOptions.hh"
+#include "fd_line_splitter.hh"
+#include "GatkVcfRecord.hh"
+#include "VcfHeaderHandler.hh"
+#include "VcfKeyDictionary.hh"
+#include "VcfRecordBlocker.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdlib>
+
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+
+
+static unsigned long alloc_count(0);
+
+
+void*
+operator new(size_t size) {
+    alloc_count++;
+    void* p(malloc(size ? size : 1));
+    if (NULL == p) throw std::bad_alloc();
+    return p;
+}
+
+void
+operator delete(void* p) throw() {
+    free(p);
+}
+
+void
+operator delete(void* p, size_t) throw() {
+    free(p);
+}
+
+
+
+static
+unsigned
+count_records(const std::string& filename) {
+    std::auto_ptr<line_splitter> vparse(open_fd_line_splitter(filename,0));
+    unsigned n_record(0);
+    while (vparse->parse_line()) {
+        if ((vparse->n_word() > 0) && (vparse->word[0][0] != '#')) n_record++;
+    }
+    return n_record;
+}
+
+
+
+int
+main(int argc, char* argv[]) {
+
+    if (argc != 2) {
+        std::cerr << "usage: " << argv[0] << " file.vcf\n";
+        exit(EXIT_FAILURE);
+    }
+    const std::string filename(argv[1]);
+
+    const unsigned n_record(count_records(filename));
+    const unsigned n_warmup(n_record/10);
+
+    const int nullfd(open("/dev/null",O_WRONLY));
+    output_buffer ob(nullfd);
+    BlockerOptions opt(ob);
+    opt.finalize_filters();
+
+    unsigned long warmup_count(0);
+    unsigned long total_count(0);
+    {
+        std::auto_ptr<line_splitter> vparse_ptr(open_fd_line_splitter(filename,0));
+        line_splitter& vparse(*vparse_ptr);
+
+        VcfKeyDictionary keys;
+        VcfRecordBlocker blocker(opt,keys);
+        VcfHeaderHandler header(ob);
+        header.set_key_dictionary(keys);
+        GatkVcfRecord record(keys);
+
+        unsigned record_index(0);
+        const unsigned long start_count(alloc_count);
+        while (vparse.parse_line()) {
+            if (header.process_line(vparse)) continue;
+            if (record_index++ == n_warmup) warmup_count = alloc_count-start_count;
+            record.Assign(vparse);
+            blocker.Append(record);
+        }
+        total_count = alloc_count-start_count;
+    }
+    close(nullfd);
+
+    const unsigned n_steady(n_record-n_warmup);
+    const unsigned long steady_count(total_count-warmup_count);
+    std::cout << "records: " << n_record << "\n"
+              << "warmup allocations (" << n_warmup << " records): " << warmup_count << "\n"
+              << "steady state allocations (" << n_steady << " records): " << steady_count << "\n"
+              << "steady state allocations per record: "
+              << (n_steady ? static_cast<double>(steady_count)/n_steady : 0.) << "\n";
+}
@@ -0,0 +1,86 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+
+#include "boost/test/unit_test.hpp"
+
+#include "BlockValueRange.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+BOOST_AUTO_TEST_SUITE( BlockValueRange_test )
+
+
+// block tolerance recomputed from all values of the block:
+static
+bool
+is_in_tolerance(const std::vector<int>& vals,
+                const double fracTol,
+                const int absTol) {
+    const int min(*std::min_element(vals.begin(),vals.end()));
+    const int max(*std::max_element(vals.begin(),vals.end()));
+    if ((min + absTol) >= max) return true;
+    const int ftol(static_cast<int>(std::floor(min * fracTol)));
+    if (ftol <= absTol) return false;
+    return ((min + ftol) >= max);
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_block_value_range_tolerance ) {
+
+    static const double fracTol[] = {0.,0.3,1.};
+    static const int vals[] = {30,31,33,34,29,27,40,38,20,26,60,0,3,2,100,130};
+    static const unsigned n_val(sizeof(vals)/sizeof(int));
+
+    for (unsigned f(0); f<3; ++f) {
+        for (int absTol(0); absTol<5; ++absTol) {
+            // start a block at each value, and grow it while values are
+            // in tolerance:
+            for (unsigned start(0); start<n_val; ++start) {
+                BlockValueRange range(fracTol[f],absTol);
+                std::vector<int> block;
+                for (unsigned i(start); i<n_val; ++i) {
+                    std::vector<int> next(block);
+                    next.push_back(vals[i]);
+                    const bool expect(is_in_tolerance(next,fracTol[f],absTol));
+                    BOOST_CHECK_EQUAL(range.IsInTolerance(vals[i]),expect);
+                    if (! expect) break;
+                    range.Add(vals[i]);
+                    block.swap(next);
+                    BOOST_CHECK_EQUAL(range.Size(),block.size());
+                    BOOST_CHECK_EQUAL(range.Min(),*std::min_element(block.begin(),block.end()));
+                    BOOST_CHECK_EQUAL(range.Max(),*std::max_element(block.begin(),block.end()));
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,198 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+
+#include "boost/test/unit_test.hpp"
+
+#include "BlockVcfRecord.hh"
+#include "istream_line_splitter.hh"
+#include "output_buffer.hh"
+
+#include <cstdlib>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+BOOST_AUTO_TEST_SUITE( BlockVcfRecord_test )
+
+
+// random non-variant sites with noisy coverage, zero depth, filter
+// changes and occasional missing values, including GQX missing from
+// either QUAL or GQ:
+static
+std::vector<std::string>
+random_sites(const unsigned n_site) {
+    std::vector<std::string> sites;
+    for (unsigned i(0); i<n_site; ++i) {
+        const int dp((rand()%10) ? (20+rand()%20) : 0);
+        std::ostringstream oss;
+        oss << "chr1\t" << (100+i) << "\t.\tA\t.\t" << ((rand()%10) ? "50.0" : ".") << '\t'
+            << ((rand()%8) ? "PASS" : "LowGQX") << "\t.\tGT:DP:GQ:MQ:XQ\t0/0:" << dp << ':';
+        if (rand()%10) {
+            oss << (30+rand()%30);
+        } else {
+            oss << '.';
+        }
+        oss << ':' << (50+rand()%10) << ':';
+        if (rand()%8) {
+            oss << (rand()%10);
+        } else {
+            oss << '.';
+        }
+        sites.push_back(oss.str());
+    }
+    return sites;
+}
+
+
+
+static
+void
+set_record(const std::string& line,
+           GatkVcfRecord& record) {
+    std::istringstream iss(line+"\n");
+    istream_line_splitter vparse(iss);
+    vparse.parse_line();
+    record.Assign(vparse);
+    record.SetBlockIds((record.GetFilter().front()=="PASS" ? 0 : 1),0);
+}
+
+
+
+// end of the longest block starting at each site, and check that
+// BlockVcfRecord::GetMaxBlockSize finds the same blocks:
+static
+std::vector<unsigned>
+get_block_ends(const BlockerOptions& opt,
+               const std::vector<std::string>& sites) {
+    VcfKeyDictionary keys;
+    BlockerStats stats;
+    BlockVcfRecord block(opt,keys,stats);
+    GatkVcfRecord record(keys);
+    const unsigned n_site(sites.size());
+    std::vector<GatkVcfRecord> records(n_site,record);
+    for (unsigned i(0); i<n_site; ++i) {
+        set_record(sites[i],records[i]);
+    }
+
+    std::vector<unsigned> ends(n_site);
+    for (unsigned i(0); i<n_site; ++i) {
+        block.Reset();
+        unsigned j(i);
+        for (; j<n_site; ++j) {
+            set_record(sites[j],record);
+            if (! block.Test(record)) break;
+            block.Add(record);
+        }
+        ends[i]=j;
+    }
+
+    block.Reset();
+    for (unsigned i(0); i<n_site; ++i) {
+        BOOST_CHECK_EQUAL(block.GetMaxBlockSize(&records[i],&records[0]+n_site),(ends[i]-i));
+    }
+    return ends;
+}
+
+
+
+// greedy blocking from the first site, and GetMinBlockSegmentation,
+// against the minimum block count over all segmentations in which each
+// block is accepted by BlockVcfRecord::Test
+//
+// returns true if greedy blocking does not give the minimum
+static
+bool
+check_block_count(const BlockerOptions& opt,
+                  const std::vector<std::string>& sites) {
+    const std::vector<unsigned> ends(get_block_ends(opt,sites));
+    const unsigned n_site(sites.size());
+
+    unsigned n_greedy(0);
+    for (unsigned i(0); i<n_site; i=ends[i]) n_greedy++;
+
+    // min_count[j] is the minimum number of blocks covering sites [0,j):
+    std::vector<unsigned> min_count(n_site+1,n_site+1);
+    min_count[0]=0;
+    for (unsigned i(0); i<n_site; ++i) {
+        for (unsigned j(i+1); j<=ends[i]; ++j) {
+            if (min_count[i]+1 < min_count[j]) min_count[j]=min_count[i]+1;
+        }
+    }
+
+    std::vector<unsigned> max_block_size(n_site);
+    for (unsigned i(0); i<n_site; ++i) max_block_size[i]=ends[i]-i;
+    std::vector<unsigned> block_size,block_count;
+    GetMinBlockSegmentation(max_block_size,block_size,block_count);
+
+    unsigned n_min(0);
+    for (unsigned i(0); i<n_site; i+=block_size[i]) {
+        BOOST_REQUIRE(block_size[i] > 0);
+        BOOST_REQUIRE(block_size[i] <= max_block_size[i]);
+        n_min++;
+    }
+
+    BOOST_CHECK(n_greedy > 1);
+    BOOST_CHECK(n_greedy >= min_count[n_site]);
+    BOOST_CHECK_EQUAL(n_min,min_count[n_site]);
+    BOOST_CHECK_EQUAL(block_count[0],min_count[n_site]);
+    return (n_greedy != min_count[n_site]);
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_min_block_count ) {
+
+    std::stringbuf sb;
+    output_buffer ob(&sb);
+    BlockerOptions opt(ob);
+
+    // a block starting at a site without GQX accepts any GQX values
+    // after it, so extending each block as far as possible is not
+    // always minimal:
+    srand(31);
+    bool is_greedy_above_min(false);
+    for (unsigned i(0); i<20; ++i) {
+        if (check_block_count(opt,random_sites(200))) is_greedy_above_min=true;
+    }
+    BOOST_CHECK(is_greedy_above_min);
+
+    // configured fields, with each tolerance and a parsed sample value:
+    opt.nvopt.BlockFields.clear();
+    opt.nvopt.BlockFields.push_back(BlockFieldOption("GQX",NULL,BLOCK_SUMMARY::MEAN));
+    opt.nvopt.BlockFields.push_back(BlockFieldOption("DP",NULL,BLOCK_SUMMARY::MAX,BLOCK_TOLERANCE::NONE));
+    opt.nvopt.BlockFields.push_back(BlockFieldOption("MQ",NULL,BLOCK_SUMMARY::MIN,BLOCK_TOLERANCE::EXACT));
+    opt.nvopt.BlockFields.push_back(BlockFieldOption("MIN_XQ","XQ"));
+    for (unsigned i(0); i<20; ++i) {
+        check_block_count(opt,random_sites(200));
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
+
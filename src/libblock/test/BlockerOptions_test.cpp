@@ -0,0 +1,73 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+
+#include "boost/test/unit_test.hpp"
+
+#include "BlockerOptions.hh"
+
+
+BOOST_AUTO_TEST_SUITE( BlockerOptions_test )
+
+
+BOOST_AUTO_TEST_CASE( test_parse_block_field ) {
+
+    BlockFieldOption field("");
+
+    BOOST_REQUIRE(parse_block_field("DP",field));
+    BOOST_CHECK(field == BlockFieldOption("DP"));
+
+    BOOST_REQUIRE(parse_block_field("GQX:mean",field));
+    BOOST_CHECK(field == BlockFieldOption("GQX",NULL,BLOCK_SUMMARY::MEAN));
+
+    BOOST_REQUIRE(parse_block_field("MIN_DP=DP:max:none",field));
+    BOOST_CHECK(field == BlockFieldOption("MIN_DP","DP",BLOCK_SUMMARY::MAX,BLOCK_TOLERANCE::NONE));
+
+    BOOST_REQUIRE(parse_block_field("MQ:min:exact",field));
+    BOOST_CHECK(field == BlockFieldOption("MQ",NULL,BLOCK_SUMMARY::MIN,BLOCK_TOLERANCE::EXACT));
+
+    BOOST_CHECK(! parse_block_field("",field));
+    BOOST_CHECK(! parse_block_field("DP:median",field));
+    BOOST_CHECK(! parse_block_field("DP:min:loose",field));
+    BOOST_CHECK(! parse_block_field("DP:min:range:x",field));
+    BOOST_CHECK(! parse_block_field("=DP",field));
+    BOOST_CHECK(! parse_block_field("MIN_DP=",field));
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_default_block_fields ) {
+
+    NonvariantBlockOptions nvopt;
+    BOOST_CHECK(nvopt.IsDefaultBlockFields());
+
+    nvopt.BlockFields.push_back(BlockFieldOption("MIN_DP","DP"));
+    BOOST_CHECK(! nvopt.IsDefaultBlockFields());
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
+
@@ -0,0 +1,157 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+
+/// \file
+///
+/// test records and serial blocking shared by the blocker unit tests
+///
+
+#ifndef __BLOCKER_TEST_UTIL_HH
+#define __BLOCKER_TEST_UTIL_HH
+
+#include "BlockerOptions.hh"
+#include "istream_line_splitter.hh"
+#include "output_buffer.hh"
+#include "VcfRecordBlocker.hh"
+
+#include <sstream>
+#include <string>
+
+
+inline
+std::string
+site(const char* chrom,
+     const int pos,
+     const char* ref,
+     const int dp,
+     const char* gq,
+     const char* gt="0/0") {
+    std::ostringstream oss;
+    oss << chrom << '\t' << pos << "\t.\t" << ref << "\t.\t50.0\tPASS\tAC=0;AF=0.00;AN=2;DP=" << dp
+        << ";MQ=60.00\tGT:DP:GQ\t" << gt << ':' << dp << ':' << gq << "\n";
+    return oss.str();
+}
+
+
+inline
+std::string
+variant(const char* chrom,
+        const int pos,
+        const char* ref,
+        const char* alt,
+        const char* gt) {
+    std::ostringstream oss;
+    oss << chrom << '\t' << pos << "\t.\t" << ref << '\t' << alt << "\t400.0\tPASS\tAC=1;AF=0.50;AN=2;DP=40"
+        << ";FS=0.000;MQ=60.00;QD=10.00\tGT:AD:DP:GQ:PL\t" << gt << ":20,20:40:99:400,0,400\n";
+    return oss.str();
+}
+
+
+
+// records in GATK all-sites order, with non-variant blocks, sites inside
+// of het and hom deletions, overlapping deletions, a repeated site and
+// a contig change:
+inline
+std::string
+get_test_records() {
+    std::string s;
+    int pos(100);
+    for (; pos<=112; ++pos) s += site("chr1",pos,"A",30+(pos%3),"60.00");
+    s += variant("chr1",112,"ACGT","A","0/1");
+    for (; pos<116; ++pos) s += site("chr1",pos,"C",30,"60.00");
+    for (; pos<124; ++pos) s += site("chr1",pos,"G",(pos<120 ? 30 : 90),"60.00");
+    s += variant("chr1",pos,"G","T","0/1");
+    s += site("chr1",pos,"G",30,"60.00");
+    for (++pos; pos<=130; ++pos) s += site("chr1",pos,"T",30,"60.00");
+    s += variant("chr1",130,"TAAAAA","T","1/1");
+    for (; pos<=132; ++pos) s += site("chr1",pos,"A",30,"60.00");
+    s += variant("chr1",132,"AA","A","0/1");
+    for (; pos<=140; ++pos) s += site("chr1",pos,"A",30,(pos%4 ? "60.00" : "5.00"));
+    s += variant("chr1",140,"A","AT","0/1");
+    for (; pos<150; ++pos) s += site("chr1",pos,"A",30,"60.00");
+    for (pos=10; pos<20; ++pos) s += site("chr2",pos,"C",(pos%2 ? 10 : 30),"60.00");
+    s += variant("chr2",pos,"C","A","1/1");
+    for (++pos; pos<30; ++pos) s += site("chr2",pos,"C",30,"60.00");
+    return s;
+}
+
+
+
+// filtered sites, where a site without GQX starts a block which accepts
+// any GQX values after it, so that lookahead blocking writes fewer
+// blocks than extending each block as far as possible:
+inline
+std::string
+get_missing_gqx_records() {
+    static const char* const gq[] = { "15", ".", "2", "15", "2" };
+    std::string s;
+    for (int rep(0); rep<4; ++rep) {
+        int pos(100*(rep+1));
+        for (unsigned i(0); i<5; ++i,++pos) s += site("chr1",pos,"A",30,gq[i]);
+        s += variant("chr1",pos,"A","T","0/1");
+    }
+    return s;
+}
+
+
+
+// block stats are only accumulated when a stats file is set:
+static const char* const stats_file("/dev/null");
+
+
+
+inline
+std::string
+block_serial(const std::string& records,
+             std::string& stats,
+             const unsigned block_lookahead=0) {
+    std::stringbuf sb;
+    {
+        output_buffer ob(&sb);
+        BlockerOptions opt(ob);
+        opt.block_stats_file=stats_file;
+        opt.block_lookahead=block_lookahead;
+        opt.finalize_filters();
+        VcfKeyDictionary keys;
+        GatkVcfRecord record(keys);
+        VcfRecordBlocker blocker(opt,keys);
+        std::istringstream iss(records);
+        istream_line_splitter vparse(iss);
+        while (vparse.parse_line()) {
+            record.Assign(vparse);
+            blocker.Append(record);
+        }
+        blocker.Flush();
+        std::ostringstream oss;
+        blocker.GetStats().report(oss);
+        stats=oss.str();
+    }
+    return sb.str();
+}
+
+
+#endif
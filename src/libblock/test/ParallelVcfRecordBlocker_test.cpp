@@ -0,0 +1,134 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+
+#include "boost/test/unit_test.hpp"
+
+#include "BlockerTestUtil.hh"
+#include "ParallelVcfRecordBlocker.hh"
+
+#include <sstream>
+#include <string>
+
+
+BOOST_AUTO_TEST_SUITE( ParallelVcfRecordBlocker_test )
+
+
+static
+std::string
+block_parallel(const std::string& records,
+               const unsigned thread_count,
+               const unsigned chunk_size,
+               std::string& stats,
+               const unsigned block_lookahead=0) {
+    std::stringbuf sb;
+    {
+        output_buffer ob(&sb);
+        BlockerOptions opt(ob);
+        opt.block_stats_file=stats_file;
+        opt.block_lookahead=block_lookahead;
+        opt.finalize_filters();
+        VcfKeyDictionary keys;
+        ParallelVcfRecordBlocker blocker(opt,keys,thread_count,chunk_size);
+        std::istringstream iss(records);
+        istream_line_splitter vparse(iss);
+        while (vparse.parse_line()) {
+            blocker.Append(vparse);
+        }
+        blocker.Flush();
+        std::ostringstream oss;
+        blocker.GetStats().report(oss);
+        stats=oss.str();
+    }
+    return sb.str();
+}
+
+
+
+// every chunk size up to the record count places a chunk boundary on
+// each record, including boundaries inside of deletions and blocks:
+BOOST_AUTO_TEST_CASE( test_parallel_blocker_matches_serial ) {
+
+    const std::string records(get_test_records());
+    std::string expect_stats;
+    const std::string expect(block_serial(records,expect_stats));
+
+    unsigned n_record(0);
+    for (unsigned i(0); i<records.size(); ++i) {
+        if ('\n' == records[i]) n_record++;
+    }
+
+    // the test input must produce blocks:
+    BOOST_REQUIRE(expect.find("BLOCKAVG") != std::string::npos);
+
+    for (unsigned thread_count(0); thread_count<3; thread_count+=2) {
+        for (unsigned chunk_size(1); chunk_size<=(n_record+1); ++chunk_size) {
+            std::string stats;
+            BOOST_CHECK_EQUAL(block_parallel(records,thread_count,chunk_size,stats),expect);
+            BOOST_CHECK_EQUAL(stats,expect_stats);
+        }
+    }
+}
+
+
+
+// a chunk which is one block throughout has no sync point, so the
+// previous chunk's blocker must continue through all of it:
+BOOST_AUTO_TEST_CASE( test_parallel_blocker_no_sync_point ) {
+
+    std::string records;
+    for (int pos(1); pos<40; ++pos) records += site("chr1",pos,"A",30,"60.00");
+    records += variant("chr1",40,"A","T","0/1");
+    for (int pos(41); pos<60; ++pos) records += site("chr1",pos,"A",30,"60.00");
+
+    std::string expect_stats;
+    const std::string expect(block_serial(records,expect_stats));
+    for (unsigned chunk_size(1); chunk_size<25; ++chunk_size) {
+        std::string stats;
+        BOOST_CHECK_EQUAL(block_parallel(records,2,chunk_size,stats),expect);
+        BOOST_CHECK_EQUAL(stats,expect_stats);
+    }
+}
+
+
+
+// lookahead windows are only cut at sync points:
+BOOST_AUTO_TEST_CASE( test_parallel_blocker_lookahead ) {
+
+    const std::string records(get_missing_gqx_records()+get_test_records());
+    for (unsigned block_lookahead(1); block_lookahead<8; block_lookahead+=2) {
+        std::string expect_stats;
+        const std::string expect(block_serial(records,expect_stats,block_lookahead));
+        for (unsigned chunk_size(1); chunk_size<30; ++chunk_size) {
+            std::string stats;
+            BOOST_CHECK_EQUAL(block_parallel(records,2,chunk_size,stats,block_lookahead),expect);
+            BOOST_CHECK_EQUAL(stats,expect_stats);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
@@ -0,0 +1,149 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+
+#include "boost/test/unit_test.hpp"
+
+#include "BlockerTestUtil.hh"
+#include "PipelinedVcfRecordBlocker.hh"
+
+#include <sstream>
+#include <string>
+
+
+BOOST_AUTO_TEST_SUITE( PipelinedVcfRecordBlocker_test )
+
+
+static
+std::string
+block_pipelined(const std::string& records,
+                const unsigned batch_size,
+                const unsigned queue_size,
+                const bool is_contig_header,
+                std::string& stats,
+                unsigned long& contig_wait_count) {
+    std::stringbuf sb;
+    {
+        output_buffer ob(&sb);
+        BlockerOptions opt(ob);
+        opt.block_stats_file=stats_file;
+        opt.finalize_filters();
+        VcfKeyDictionary keys;
+        if (is_contig_header) {
+            keys.AddHeaderLine("##contig=<ID=chr1,length=1000>");
+            keys.AddHeaderLine("##contig=<ID=chr2,length=1000>");
+        }
+        PipelinedVcfRecordBlocker blocker(opt,keys,batch_size,queue_size);
+        std::istringstream iss(records);
+        istream_line_splitter vparse(iss);
+        while (vparse.parse_line()) {
+            blocker.Append(vparse);
+        }
+        blocker.Flush();
+        std::ostringstream oss;
+        blocker.GetStats().report(oss);
+        stats=oss.str();
+        contig_wait_count=blocker.GetPipelineStats().contig_wait_count;
+    }
+    return sb.str();
+}
+
+
+
+// every batch size up to the record count places a batch boundary on
+// each record:
+BOOST_AUTO_TEST_CASE( test_pipelined_blocker_matches_serial ) {
+
+    const std::string records(get_test_records());
+    std::string expect_stats;
+    const std::string expect(block_serial(records,expect_stats));
+
+    unsigned n_record(0);
+    for (unsigned i(0); i<records.size(); ++i) {
+        if ('\n' == records[i]) n_record++;
+    }
+
+    BOOST_REQUIRE(expect.find("BLOCKAVG") != std::string::npos);
+
+    for (unsigned queue_size(1); queue_size<3; ++queue_size) {
+        for (unsigned batch_size(1); batch_size<=(n_record+1); ++batch_size) {
+            std::string stats;
+            unsigned long contig_wait_count(0);
+            BOOST_CHECK_EQUAL(block_pipelined(records,batch_size,queue_size,false,stats,contig_wait_count),expect);
+            BOOST_CHECK_EQUAL(stats,expect_stats);
+        }
+    }
+}
+
+
+
+// the parse stage only waits for the pipeline to empty at contigs which
+// are missing from the vcf header:
+BOOST_AUTO_TEST_CASE( test_pipelined_blocker_contig_wait ) {
+
+    const std::string records(get_test_records());
+    std::string expect_stats;
+    const std::string expect(block_serial(records,expect_stats));
+
+    for (unsigned i(0); i<2; ++i) {
+        const bool is_contig_header(i==1);
+        std::string stats;
+        unsigned long contig_wait_count(0);
+        BOOST_CHECK_EQUAL(block_pipelined(records,4,2,is_contig_header,stats,contig_wait_count),expect);
+        BOOST_CHECK_EQUAL(contig_wait_count,(is_contig_header ? 0u : 2u));
+    }
+}
+
+
+
+// a pipeline which is destroyed without Flush() must stop all stages,
+// leaving any output which was already written in order:
+BOOST_AUTO_TEST_CASE( test_pipelined_blocker_no_flush ) {
+
+    const std::string records(get_test_records());
+    std::string expect_stats;
+    const std::string expect(block_serial(records,expect_stats));
+
+    std::stringbuf sb;
+    output_buffer ob(&sb);
+    BlockerOptions opt(ob);
+    opt.finalize_filters();
+    VcfKeyDictionary keys;
+    {
+        PipelinedVcfRecordBlocker blocker(opt,keys,2,1);
+        std::istringstream iss(records);
+        istream_line_splitter vparse(iss);
+        while (vparse.parse_line()) {
+            blocker.Append(vparse);
+        }
+    }
+    ob.flush();
+    const std::string result(sb.str());
+    BOOST_CHECK(result.size() <= expect.size());
+    BOOST_CHECK_EQUAL(result,expect.substr(0,result.size()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
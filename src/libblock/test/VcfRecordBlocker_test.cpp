@@ -0,0 +1,86 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+
+#include "boost/test/unit_test.hpp"
+
+#include "BlockerTestUtil.hh"
+
+#include <string>
+
+
+BOOST_AUTO_TEST_SUITE( VcfRecordBlocker_test )
+
+
+static
+unsigned
+count_records(const std::string& output) {
+    unsigned n(0);
+    for (unsigned i(0); i<output.size(); ++i) {
+        if ('\n' == output[i]) n++;
+    }
+    return n;
+}
+
+
+
+// every block of the test records ends where the next site fails
+// BlockVcfRecord::Test, so no window size changes the output:
+BOOST_AUTO_TEST_CASE( test_block_lookahead_matches_default ) {
+
+    const std::string records(get_test_records());
+    std::string default_stats;
+    const std::string expect(block_serial(records,default_stats));
+    BOOST_REQUIRE(expect.find("BLOCKAVG") != std::string::npos);
+    BOOST_CHECK(default_stats.find("LOOKAHEAD") == std::string::npos);
+
+    for (unsigned block_lookahead(1); block_lookahead<=count_records(records); ++block_lookahead) {
+        std::string stats;
+        BOOST_CHECK_EQUAL(block_serial(records,stats,block_lookahead),expect);
+        BOOST_CHECK_EQUAL(stats.find(default_stats),0u);
+        BOOST_CHECK(stats.find("LOOKAHEAD_BLOCK_REDUCTION: 0\n") != std::string::npos);
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_block_lookahead_missing_gqx ) {
+
+    const std::string records(get_missing_gqx_records());
+    std::string stats;
+
+    // each repeat is four blocks and a variant by default, and two
+    // blocks and a variant once the window holds the first four sites:
+    BOOST_CHECK_EQUAL(count_records(block_serial(records,stats)),20u);
+    BOOST_CHECK_EQUAL(count_records(block_serial(records,stats,3)),20u);
+    BOOST_CHECK_EQUAL(count_records(block_serial(records,stats,4)),12u);
+    BOOST_CHECK(stats.find("LOOKAHEAD_BLOCK_COUNT: 8\n") != std::string::npos);
+    BOOST_CHECK(stats.find("GREEDY_BLOCK_COUNT: 16\n") != std::string::npos);
+    BOOST_CHECK(stats.find("LOOKAHEAD_BLOCK_REDUCTION: 8\n") != std::string::npos);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -30,9 +30,14 @@
 ///
 
 
+#include "bcf_line_splitter.hh"
+#include "block_table.hh"
+#include "region_util.hh"
 #include "related_sample_util.hh"
 #include "string_util.hh"
 #include "tabix_streamer.hh"
+#include "tabix_util.hh"
+#include "tokenize_util.hh"
 #include "vcf_util.hh"
 
 #include "boost/algorithm/string/predicate.hpp"
@@ -43,6 +48,7 @@
 #include <climits>
 #include <cstdlib>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -66,7 +72,7 @@ operator<<(std::ostream& os, const vcf_pos& vpos)
 static
 bool
 get_digt_code(const char* const* word,
-              std::vector<int>& digt_code) {
+              vcf_genotype& digt_code) {
 
     const char* gtstr(get_format_string_nocopy(word,"GT"));
     if (gtstr == NULL)
@@ -78,7 +84,7 @@ get_digt_code(const char* const* word,
     {
         parse_gt(gtstr,digt_code,true);
     }
-    return (digt_code.size()==2 && digt_code[0]>=0 && digt_code[1]>=0);
+    return (digt_code.size()==2 && digt_code.is_known());
 }
 
 
@@ -164,6 +170,25 @@ get_site_allele(
 
 
 
+bool
+snp_type_info::
+get_site_allele(
+    std::vector<char>& allele,
+    const unsigned gt,
+    const char ref_base) const
+{
+    allele.clear();
+    if (gt == BLOCK_TABLE_NO_GT) return false;
+
+    for (unsigned i(0); i<2; ++i) {
+        const char code((gt >> (i*8)) & 0xff);
+        allele.push_back(code ? code : ref_base);
+    }
+    return true;
+}
+
+
+
 // extract unsigned value for key from the vcf info field
 bool
 snp_type_info::
@@ -238,6 +263,33 @@ get_format_unsigned(const char* const* word,
 
 
 
+void
+sample_info::
+open_file() {
+    is_block_table=is_block_table_file(file);
+    if (is_block_table) {
+        table.reset(new block_table(file));
+        return;
+    }
+    is_bcf=is_bcf_file(file);
+    if (! is_bcf) tfile.reset(new tabix_file(file.c_str()));
+}
+
+
+
+bool
+sample_info::
+parse_region(const char* region,
+             int& begin,
+             int& end) const {
+    if (! (is_bcf || is_block_table)) return parse_tabix_region(file.c_str(),region,begin,end);
+
+    std::string chrom;
+    return region_util::parse_region_string(region,chrom,begin,end);
+}
+
+
+
 site_crawler::
 site_crawler(const sample_info& si,
              const unsigned /*sample_id*/,
@@ -254,6 +306,12 @@ site_crawler(const sample_info& si,
     , _chr_region(chr_region)
     , _is_return_indels(is_return_indels)
     , _tabs(NULL)
+    , _batch_index(0)
+    , _bcf(NULL)
+    , _table(NULL)
+    , _table_row(0)
+    , _row(0)
+    , _row_end(0)
     , _is_sample_begin_state(true)
     , _is_sample_end_state(false)
     , _next_file(0)
@@ -266,6 +324,17 @@ site_crawler(const sample_info& si,
     , _is_site_allele_current(false)
     , _is_indel_allele_current(false)
 {
+    if (_si.is_block_table) {
+        // the table only holds the fields needed for site comparison:
+        if (is_store_header || is_return_indels) {
+            log_os << "ERROR: block table file can't be used as input to this tool: '" << _si.file << "'\n";
+            exit(EXIT_FAILURE);
+        }
+        if (_opt.sti().is_info_filter()) {
+            log_os << "ERROR: INFO field filters can't be applied to block table file: '" << _si.file << "'\n";
+            exit(EXIT_FAILURE);
+        }
+    }
     update(is_store_header);
 }
 
@@ -274,6 +343,7 @@ site_crawler(const sample_info& si,
 site_crawler::
 ~site_crawler() {
     if (NULL != _tabs) delete _tabs;
+    if (NULL != _bcf) delete _bcf;
 }
 
 
@@ -301,13 +371,25 @@ site_crawler::
 update_site_allele() const
 {
     const char ref_base(_ref_seg.get_base(pos()-1));
-    const bool retval(_opt.sti().get_site_allele(_site_allele,_word,_locus_offset,ref_base));
+    const bool retval(get_site_allele(ref_base));
     _is_site_allele_current=true;
     return retval;
 }
 
 
 
+bool
+site_crawler::
+get_site_allele(const char ref_base) const
+{
+    if (NULL != _table) {
+        return _opt.sti().get_site_allele(_site_allele,_table->gt[_table_row],ref_base);
+    }
+    return _opt.sti().get_site_allele(_site_allele,_word,_locus_offset,ref_base);
+}
+
+
+
 bool
 site_crawler::
 update_indel_allele() const
@@ -339,38 +421,40 @@ bool
 site_crawler::
 process_record_line(char* line)
 {
-    static const unsigned MAX_WORD(50);
-
     // do a low-level tab parse:
-    {
-        char* p(line);
-        _word[0]=p;
-        _n_word=1;
-        while (true) {
-            if ((*p == '\n') || (*p == '\0')) break;
-            if (*p == sep) {
-                *p = '\0';
-                _word[_n_word++] = p+1;
-                if (_n_word == MAX_WORD) break;
-            }
-            ++p;
-        }
-        // allow for optional extra columns in each file format:
-        if (_n_word<_opt.sti().col_count()) {
-            log_os << "ERROR: Consensus record has " << _n_word << " column(s) but expecting at least " << _opt.sti().col_count() << "\n";
-            dump_state(log_os);
-            exit(EXIT_FAILURE);
-        }
+    _n_word=tokenize_line(line,sep,_word,MAX_WORD);
+    return process_record();
+}
+
+
+
+bool
+site_crawler::
+process_record()
+{
+    const bool is_table(NULL != _table);
+
+    // allow for optional extra columns in each file format:
+    if ((! is_table) && (_n_word<_opt.sti().col_count())) {
+        log_os << "ERROR: Consensus record has " << _n_word << " column(s) but expecting at least " << _opt.sti().col_count() << "\n";
+        dump_state(log_os);
+        exit(EXIT_FAILURE);
     }
 
     const vcf_pos last_vpos(vpos());
-    _chrom=_opt.sti().chrom(_word);
-    _vpos.pos=_opt.sti().pos(_word);
+    if (is_table) {
+        _chrom=_table->name.c_str();
+        _vpos.pos=_table->start[_table_row];
+    } else {
+        _chrom=_opt.sti().chrom(_word);
+        _vpos.pos=_opt.sti().pos(_word);
+    }
 
     _is_site_allele_current=false;
     _is_indel_allele_current=false;
 
-    _vpos.is_indel=(_opt.sti().get_is_indel(_word));
+    // indel records are not stored in block tables:
+    _vpos.is_indel=((! is_table) && _opt.sti().get_is_indel(_word));
 
     if (pos()<1) {
         log_os << "ERROR: gvcf record position less than 1. position: " << pos() << " ";
@@ -394,7 +478,9 @@ process_record_line(char* line)
         }
     }
 
-    if (! _opt.sti().get_nonindel_ref_length(pos(),is_indel(),_word,_locus_size)) {
+    if (is_table) {
+        _locus_size=(_table->end[_table_row]-pos())+1;
+    } else if (! _opt.sti().get_nonindel_ref_length(pos(),is_indel(),_word,_locus_size)) {
         //log_os << "ERROR: failed to parse locus at pos: "  << pos << "\n";
         log_os << "WARNING: failed to parse locus at: "  << vpos() << "\n";
         dump_state(log_os);
@@ -410,9 +496,13 @@ process_record_line(char* line)
     }
 
     //const bool last_is_call(is_call);
-    _is_call = _opt.sti().get_is_call(_word,pos(),_skip_call_begin_pos,_skip_call_end_pos);
-
-    _n_total = _opt.sti().total(_word);
+    if (is_table) {
+        _is_call = _opt.sti().get_is_call(*_si.table,*_table,_table_row,pos(),_skip_call_begin_pos,_skip_call_end_pos);
+        _n_total = _table->dp[_table_row];
+    } else {
+        _is_call = _opt.sti().get_is_call(_word,pos(),_skip_call_begin_pos,_skip_call_end_pos);
+        _n_total = _opt.sti().total(_word);
+    }
 
     if (is_indel()) {
         if (! _is_return_indels)
@@ -519,7 +609,7 @@ update(bool is_store_header) {
 
             if (is_site_call()) {
                 const char ref_base=_ref_seg.get_base(pos()-1);
-                if (! _opt.sti().get_site_allele(_site_allele,_word,_locus_offset,ref_base)) {
+                if (! get_site_allele(ref_base)) {
                     log_os << "ERROR: Failed to read site genotype from record:\n";
                     dump_state(log_os);
                     exit(EXIT_FAILURE);
@@ -529,23 +619,32 @@ update(bool is_store_header) {
         }
 
         // start new/next file:
-        if (NULL == _tabs) {
+        if ((NULL == _tabs) && (NULL == _bcf) && (NULL == _table)) {
             if (_next_file >= 1) {
                 _is_sample_begin_state = false;
                 _is_sample_end_state = true;
                 return;
             }
             const std::string& afile(_si.file);
-            if (0 == _next_file) {
-                // open a separate header streamer to get sample_name and optional header capture:
-                tabix_header_streamer ths(afile.c_str());
-                while (ths.next()) {
-                    const char* line(ths.getline());
-                    if (NULL == line) break;
-                    if (is_store_header) {
-                        _header.push_back(line);
-                    }
-                    if (_sample_name.empty() && boost::starts_with(line,"#CHROM")) {
+            if (_si.is_block_table) {
+                _sample_name = _si.table->sample_name();
+                open_table();
+            } else if (0 == _next_file) {
+                if (_si.is_bcf) {
+                    const std::vector<std::string> regions(1,_chr_region);
+                    _bcf=new bcf_line_splitter(afile,regions,"",0,false);
+                } else {
+                    _tfile=_si.tfile;
+                    if (! _tfile) _tfile.reset(new tabix_file(afile.c_str()));
+                }
+
+                // get sample_name and optional header capture from the cached header:
+                const std::vector<std::string>& header(_si.is_bcf ? _bcf->header().lines() : _tfile->header());
+                if (is_store_header) {
+                    _header=header;
+                }
+                BOOST_FOREACH(const std::string& line, header) {
+                    if (boost::starts_with(line,"#CHROM")) {
                         std::vector<std::string> words;
                         split_string(line,'\t',words);
                         if (words.size()>VCFID::SAMPLE) {
@@ -553,30 +652,48 @@ update(bool is_store_header) {
                         } else {
                             _sample_name = "UNKNOWN";
                         }
+                        break;
                     }
                 }
             }
-            _tabs=new tabix_streamer(afile.c_str(),_chr_region);
-            if (! _tabs) {
-                log_os << "ERROR:: Can't open gvcf file: " << afile << "\n";
-                exit(EXIT_FAILURE);
-            }
+            if (! (_si.is_bcf || _si.is_block_table)) _tabs=new tabix_streamer(*_tfile,_chr_region);
+            _batch_index=0;
             _next_file++;
         }
 
-        // read through file to get to a data line:
-        bool is_eof(true);
-        char* line(NULL);
-        while (_tabs->next()) {
-            line=_tabs->getline();
-            if (NULL == line) break;
-            assert(strlen(line));
-            if (line[0] == '#') continue;
-            is_eof=false;
-            break;
+        if (_si.is_block_table) {
+            if ((NULL != _table) && (_row < _row_end)) {
+                _table_row=_row++;
+                const bool is_valid=process_record();
+                if (is_valid) return;
+            } else {
+                _table=NULL;
+            }
+            continue;
         }
 
-        if (! is_eof) {
+        if (NULL != _bcf) {
+            if (_bcf->parse_line()) {
+                _n_word=std::min(_bcf->n_word(),static_cast<unsigned>(MAX_WORD));
+                for (unsigned i(0); i<_n_word; ++i) _word[i]=_bcf->word[i];
+                const bool is_valid=process_record();
+                if (is_valid) return;
+            } else {
+                delete _bcf;
+                _bcf=NULL;
+            }
+            continue;
+        }
+
+        // get the next data line, header lines are skipped by the batch read:
+        if (_batch_index >= _tabs->batch_size()) {
+            _tabs->next_batch(RECORD_BATCH_SIZE);
+            _batch_index=0;
+        }
+
+        if (_batch_index < _tabs->batch_size()) {
+            char* line(_tabs->batch_line(_batch_index++));
+            assert(strlen(line));
             const bool is_valid=process_record_line(line);
             if (is_valid) return;
         } else {
@@ -589,10 +706,44 @@ update(bool is_store_header) {
 
 
 
+void
+site_crawler::
+open_table() {
+    _table=NULL;
+    std::string chrom;
+    int begin,end;
+    if (! region_util::parse_region_string(_chr_region,chrom,begin,end)) {
+        log_os << "ERROR: can't parse region: '" << _chr_region << "'\n";
+        exit(EXIT_FAILURE);
+    }
+    const block_table_contig* ctg(_si.table->get_contig(chrom));
+    if (NULL == ctg) return;
+
+    _row=ctg->get_first_row(begin+1);
+    _row_end=std::upper_bound(ctg->start,ctg->start+ctg->size,end)-ctg->start;
+    if (_row < _row_end) _table=ctg;
+}
+
+
+
 void
 site_crawler::
 dump_line(std::ostream& os) const {
     if (_is_sample_end_state) return;
+    if (NULL != _table) {
+        // block table rows are written as a minimal VCF record:
+        os << _table->name << sep << _table->start[_table_row]
+           << "\t.\t.\t.\t.\t" << _si.table->get_filter(_table->filter[_table_row])
+           << "\tEND=" << _table->end[_table_row] << "\tGQX:DP\t";
+        const float gqx(_table->gqx[_table_row]);
+        if (gqx == gqx) {
+            os << gqx;
+        } else {
+            os << '.';
+        }
+        os << ':' << _table->dp[_table_row];
+        return;
+    }
     for (unsigned i(0); i<_n_word; ++i) {
         if (i) os << sep;
         os << _word[i];
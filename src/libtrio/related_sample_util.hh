@@ -31,6 +31,7 @@
 
 #pragma once
 
+#include "block_table.hh"
 #include "compat_util.hh"
 #include "parse_util.hh"
 #include "pos_type.hh"
@@ -38,6 +39,8 @@
 #include "trio_option_util.hh"
 #include "vcf_util.hh"
 
+#include "boost/shared_ptr.hpp"
+
 #include <cassert>
 #include <cstdio>
 #include <cstring>
@@ -186,12 +189,42 @@ struct snp_type_info {
         return (pos<skip_call_begin_pos || pos>=skip_call_end_pos);
     }
 
+    /// as above for a block table row. INFO field filters can't be
+    /// applied to table input, see is_info_filter()
+    bool
+    get_is_call(const block_table& table,
+                const block_table_contig& ctg,
+                const unsigned row,
+                const pos_t pos,
+                pos_t& skip_call_begin_pos,
+                pos_t& skip_call_end_pos) const {
+
+        if (! table.is_pass(ctg.filter[row])) return false;
+        if (_sp.min_gqx > 0) {
+            // missing GQX is stored as NaN, which is never filtered:
+            if (ctg.gqx[row]<_sp.min_gqx) return false;
+        }
+        return (pos<skip_call_begin_pos || pos>=skip_call_end_pos);
+    }
+
+    /// true if any call filter reads the INFO field
+    bool
+    is_info_filter() const {
+        return (_sp.is_min_qd || _sp.is_min_pos_rank_sum || (! _sp.infof.empty()));
+    }
+
     bool
     get_site_allele(std::vector<char>& allele,
                     const char* const* word,
                     const unsigned offset,
                     const char ref_base) const;
 
+    /// as above for a block table genotype code
+    bool
+    get_site_allele(std::vector<char>& allele,
+                    const unsigned gt,
+                    const char ref_base) const;
+
     bool
     get_indel_allele(
         std::string& indel_ref,
@@ -241,26 +274,9 @@ struct snp_type_info {
     // this detects both indels and unequal or equal length 'block-subsitutions'
     bool
     get_is_indel(const char* const* word) const {
-        const char* alt(word[VCFID::ALT]);
-        const char* tmp_ptr;
-        // no alternate:
-        if (0==strcmp(alt,".")) return false;
-        // breakend:
-        if (NULL != (tmp_ptr=strchr(alt,'.'))) return true;
-        const unsigned reflen(strlen(word[VCFID::REF]));
-        // if alt is not '.' and reflen > 1, then this must be some sort of indel/subst:
-        // pathological case is alt=".,." ... don't worry about that one.
-        if (reflen>1) return true;
-        // after the above test, we're essentially just looking for an alt with
-        // length greater than one, indicating an insertion:
-        while (NULL != (tmp_ptr=strchr(alt,','))) {
-            if ((tmp_ptr-alt)!=static_cast<pos_t>(reflen)) return true;
-            alt = tmp_ptr+1;
-        }
-        return (strlen(alt)!=reflen);
+        return is_indel_record(word);
     }
 
-
 private:
     static
     bool
@@ -322,14 +338,45 @@ private:
     const unsigned _poscol;
 
     // cache this to avoid malloc cost:
-    mutable std::vector<int> _gtcode;
+    mutable vcf_genotype _gtcode;
 };
 
 
 
+struct tabix_file;
+
+
 // used to be a big struct!!
 struct sample_info {
+
+    sample_info() : is_bcf(false), is_block_table(false) {}
+
+    /// detect the format of this sample's file, and open the tabix file
+    /// for VCF input or the block table, which is then shared by all
+    /// crawlers created from this sample_info
+    void
+    open_file();
+
+    /// parse a samtools style region string for this sample's file into
+    /// the zero-indexed half-open interval [begin,end). open_file() must
+    /// be called first
+    bool
+    parse_region(const char* region,
+                 int& begin,
+                 int& end) const;
+
     std::string file;
+
+    // set by open_file() for a CSI indexed BCF2 file:
+    bool is_bcf;
+
+    // set by open_file() for a block table file:
+    bool is_block_table;
+
+    // if not set, each crawler opens its own handle to file
+    boost::shared_ptr<tabix_file> tfile;
+
+    boost::shared_ptr<block_table> table;
 };
 
 
@@ -360,10 +407,9 @@ private:
 
 
 
+struct bcf_line_splitter;
 struct tabix_streamer;
 
-
-
 // Extend the concept of pos to include indel status, so that positions with
 // the same number sort with site record first, followed by indel record.
 // This is the same ordering that's in the vcf already
@@ -525,9 +571,21 @@ private:
     bool
     update_indel_allele() const;
 
+    // get the site alleles of the current record at _locus_offset:
+    bool
+    get_site_allele(const char ref_base) const;
+
+    // set the rows of the block table contig overlapping _chr_region:
+    void
+    open_table();
+
     bool
     process_record_line(char* line);
 
+    // process the record in _word:
+    bool
+    process_record();
+
     vcf_pos _vpos;
     bool _is_call;
     unsigned _n_total;
@@ -544,7 +602,22 @@ private:
 
     bool _is_return_indels;
 
+    // records are read from _tabs in batches, _batch_index is the next
+    // unprocessed record of the current batch:
+    enum { RECORD_BATCH_SIZE=256 };
+    boost::shared_ptr<tabix_file> _tfile;
     tabix_streamer* _tabs;
+    unsigned _batch_index;
+
+    // BCF2 records are decoded directly into words by _bcf instead:
+    bcf_line_splitter* _bcf;
+
+    // block table records are read from rows [_row,_row_end) of _table,
+    // _table_row is the row of the current record:
+    const block_table_contig* _table;
+    unsigned _table_row;
+    unsigned _row;
+    unsigned _row_end;
     bool _is_sample_begin_state;
     bool _is_sample_end_state;
     unsigned _next_file;
@@ -0,0 +1,115 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// bounded queue passing batches between the threads of a pipeline
+///
+
+#ifndef __BATCH_QUEUE_HH
+#define __BATCH_QUEUE_HH
+
+#include "thread_util.hh"
+
+#include <deque>
+
+
+/// bounded fifo of batch pointers, which are not owned by the queue
+///
+/// Either end may abort the queue, after which all blocked and future
+/// calls on both ends return immediately, so that an error in one stage
+/// of a pipeline stops all other stages.
+///
+template <typename T>
+struct batch_queue {
+
+    explicit
+    batch_queue(const unsigned max_size)
+        : _max_size(max_size)
+        , _is_closed(false)
+        , _is_aborted(false)
+    {}
+
+    /// add batch, blocking while the queue is full
+    ///
+    /// \returns false if the queue has been aborted
+    ///
+    bool
+    push(T* batch) {
+        thread_lock lock(_mutex);
+        while ((_queue.size() >= _max_size) && (! _is_aborted)) _pop_cond.wait(_mutex);
+        if (_is_aborted) return false;
+        _queue.push_back(batch);
+        _push_cond.signal();
+        return true;
+    }
+
+    /// remove the next batch, blocking while the queue is empty
+    ///
+    /// \returns NULL if the queue has been aborted, or is closed and empty
+    ///
+    T*
+    pop() {
+        thread_lock lock(_mutex);
+        while (_queue.empty() && (! _is_closed) && (! _is_aborted)) _push_cond.wait(_mutex);
+        if (_is_aborted || _queue.empty()) return NULL;
+        T* batch(_queue.front());
+        _queue.pop_front();
+        _pop_cond.signal();
+        return batch;
+    }
+
+    /// no further batches will be pushed
+    void
+    close() {
+        thread_lock lock(_mutex);
+        _is_closed=true;
+        _push_cond.broadcast();
+    }
+
+    void
+    abort() {
+        thread_lock lock(_mutex);
+        _is_aborted=true;
+        _push_cond.broadcast();
+        _pop_cond.broadcast();
+    }
+
+private:
+    batch_queue(const batch_queue&);
+    batch_queue& operator=(const batch_queue&);
+
+    const unsigned _max_size;
+    thread_mutex _mutex;
+    thread_condition _push_cond;
+    thread_condition _pop_cond;
+    std::deque<T*> _queue;
+    bool _is_closed;
+    bool _is_aborted;
+};
+
+
+#endif
@@ -0,0 +1,783 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// line splitter decoding BCF2 input
+///
+
+#include "bcf_line_splitter.hh"
+#include "bgzf_reader.hh"
+#include "blt_exception.hh"
+#include "format_util.hh"
+#include "region_util.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+
+
+static
+void
+format_exception(const std::string& filename,
+                 const char* msg) {
+    std::ostringstream oss;
+    oss << "ERROR: " << msg << " in BCF input";
+    if (! filename.empty()) oss << " file: '" << filename << "'";
+    oss << "\n";
+    throw blt_exception(oss.str().c_str());
+}
+
+
+
+static
+int
+open_input_file(const std::string& filename) {
+    const int fd(open(filename.c_str(),O_RDONLY));
+    if (fd<0) {
+        std::ostringstream oss;
+        oss << "ERROR: can't open input file: '" << filename << "': " << strerror(errno) << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+    return fd;
+}
+
+
+
+// read all of src:
+static
+void
+read_all(byte_source& src,
+         std::vector<char>& data) {
+    data.clear();
+    size_t size(0);
+    while (true) {
+        data.resize(size+65536);
+        const size_t n(src.read(&(data[size]),65536));
+        if (0 == n) break;
+        size += n;
+    }
+    data.resize(size);
+}
+
+
+
+// bounds checked reads of binary data:
+//
+struct bcf_cursor {
+
+    bcf_cursor(const char* b,
+               const char* e,
+               const std::string& filename)
+        : p(b), end(e), _filename(filename)
+    {}
+
+    void
+    need(const size_t size) const {
+        if (static_cast<size_t>(end-p) < size) format_exception(_filename,"unexpected end of data");
+    }
+
+    uint32_t
+    get_uint32() {
+        need(4);
+        const uint32_t val(bcf_get_uint32(p));
+        p += 4;
+        return val;
+    }
+
+    uint64_t
+    get_uint64() {
+        const uint64_t low(get_uint32());
+        return (low | (static_cast<uint64_t>(get_uint32()) << 32));
+    }
+
+    // read a typed value descriptor:
+    void
+    get_type(unsigned& type,
+             unsigned& count) {
+        need(1);
+        const unsigned char d(static_cast<unsigned char>(*p++));
+        type = d & 0xf;
+        count = d >> 4;
+        if (BCF_LONG_COUNT == count) {
+            unsigned count_type,count_count;
+            get_type(count_type,count_count);
+            if ((1 != count_count) ||
+                (count_type < BCF_TYPE::INT8) ||
+                (count_type > BCF_TYPE::INT32)) {
+                format_exception(_filename,"invalid typed value count");
+            }
+            need(bcf_get_type_size(count_type));
+            const int val(bcf_get_int(p,count_type,0));
+            if (val<0) format_exception(_filename,"invalid typed value count");
+            count = val;
+            p += bcf_get_type_size(count_type);
+        }
+    }
+
+    // return the next size bytes
+    const char*
+    get_data(const size_t size) {
+        need(size);
+        const char* data(p);
+        p += size;
+        return data;
+    }
+
+    // read a typed integer, which must be a single value
+    int
+    get_typed_int() {
+        unsigned type,count;
+        get_type(type,count);
+        if ((1 != count) || (type < BCF_TYPE::INT8) || (type > BCF_TYPE::INT32)) {
+            format_exception(_filename,"invalid typed integer");
+        }
+        return bcf_get_int(get_data(bcf_get_type_size(type)),type,0);
+    }
+
+    const char* p;
+    const char* end;
+private:
+    const std::string& _filename;
+};
+
+
+
+/// the bins of a CSI index, as used to find the start of a region query
+///
+struct csi_index {
+
+    csi_index(const std::string& filename,
+              const std::string& bcf_filename);
+
+    /// find the virtual file offset from which to read records
+    /// overlapping the zero-indexed interval [begin,end) of tid, returns
+    /// false if no records overlap
+    bool
+    get_query_offset(const int tid,
+                     const int begin,
+                     const int end,
+                     uint64_t& offset) const;
+
+private:
+    typedef std::pair<uint64_t,uint64_t> chunk_t;
+
+    struct bin_info {
+        uint64_t loffset;
+        std::vector<chunk_t> chunks;
+    };
+
+    typedef std::map<unsigned,bin_info> bin_map_t;
+
+    int _min_shift;
+    int _depth;
+    std::vector<bin_map_t> _refs;
+};
+
+
+
+csi_index::
+csi_index(const std::string& filename,
+          const std::string& bcf_filename)
+{
+    const int fd(open(filename.c_str(),O_RDONLY));
+    if (fd<0) {
+        std::ostringstream oss;
+        oss << "ERROR: region input requires a CSI indexed BCF file, can't open index: '" << filename << "': " << strerror(errno) << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+    std::vector<char> data;
+    {
+        bgzf_reader src(fd,0,true);
+        read_all(src,data);
+    }
+
+    const char* b(data.empty() ? NULL : &(data[0]));
+    bcf_cursor c(b,b+data.size(),filename);
+    c.need(4);
+    if (0 != memcmp(c.get_data(4),"CSI\1",4)) {
+        std::ostringstream oss;
+        oss << "ERROR: unexpected index format in file: '" << filename << "'\n";
+        throw blt_exception(oss.str().c_str());
+    }
+    _min_shift = c.get_uint32();
+    _depth = c.get_uint32();
+    const uint32_t l_aux(c.get_uint32());
+    c.get_data(l_aux);
+    if ((_min_shift < 1) || (_depth < 1) || ((_min_shift + 3*_depth) > 62)) {
+        format_exception(bcf_filename,"unexpected CSI index parameters");
+    }
+
+    const uint32_t n_ref(c.get_uint32());
+    _refs.resize(n_ref);
+    for (unsigned tid(0); tid<n_ref; ++tid) {
+        const uint32_t n_bin(c.get_uint32());
+        for (unsigned i(0); i<n_bin; ++i) {
+            const uint32_t bin(c.get_uint32());
+            bin_info& bi(_refs[tid][bin]);
+            bi.loffset = c.get_uint64();
+            const uint32_t n_chunk(c.get_uint32());
+            for (unsigned j(0); j<n_chunk; ++j) {
+                const uint64_t chunk_beg(c.get_uint64());
+                bi.chunks.push_back(std::make_pair(chunk_beg,c.get_uint64()));
+            }
+        }
+    }
+}
+
+
+
+bool
+csi_index::
+get_query_offset(const int tid,
+                 const int begin,
+                 const int end_pos,
+                 uint64_t& offset) const {
+
+    if ((tid < 0) || (tid >= static_cast<int>(_refs.size()))) return false;
+    const bin_map_t& bins(_refs[tid]);
+    if (begin >= end_pos) return false;
+
+    // the minimum offset of any record overlapping begin, from the
+    // smallest bin containing begin which is in the index:
+    unsigned bin((((1u<<(3*_depth))-1)/7) + (begin >> _min_shift));
+    uint64_t min_offset(0);
+    while (true) {
+        const bin_map_t::const_iterator i(bins.find(bin));
+        if (i != bins.end()) {
+            min_offset = i->second.loffset;
+            break;
+        }
+        if (0 == bin) break;
+        bin = (bin-1) >> 3;
+    }
+
+    // search all bins overlapping [begin,end), as hts_reg2bins:
+    bool is_found(false);
+    int s(_min_shift + 3*_depth);
+    const int64_t max_end(static_cast<int64_t>(1)<<s);
+    int64_t end(std::min(static_cast<int64_t>(end_pos),max_end));
+    --end;
+    unsigned t(0);
+    for (int l(0); l<=_depth; ++l) {
+        const uint64_t bin_begin(t + (static_cast<int64_t>(begin) >> s));
+        const uint64_t bin_end(t + (end >> s));
+        for (uint64_t b(bin_begin); b<=bin_end; ++b) {
+            const bin_map_t::const_iterator i(bins.find(static_cast<unsigned>(b)));
+            if (i == bins.end()) continue;
+            const std::vector<chunk_t>& chunks(i->second.chunks);
+            for (unsigned j(0); j<chunks.size(); ++j) {
+                if (chunks[j].second <= min_offset) continue;
+                if ((! is_found) || (chunks[j].first < offset)) offset = chunks[j].first;
+                is_found=true;
+            }
+        }
+        s -= 3;
+        t += 1u<<(3*l);
+    }
+    return is_found;
+}
+
+
+
+bcf_line_splitter::
+bcf_line_splitter(std::auto_ptr<byte_source> src,
+                  const bool is_header)
+    : _fd(-1)
+    , _worker_count(0)
+    , _src(src)
+    , _in(INPUT_CHUNK_SIZE)
+    , _in_start(0)
+    , _in_end(0)
+    , _is_header(is_header)
+    , _header_index(0)
+    , _is_region(false)
+    , _region_index(0)
+    , _is_region_active(false)
+    , _last_tid(-1)
+    , _last_pos(0)
+    , _skip_pos(0)
+{
+    read_header();
+}
+
+
+
+bcf_line_splitter::
+bcf_line_splitter(const std::string& filename,
+                  const std::vector<std::string>& regions,
+                  const std::string& region_file,
+                  const unsigned worker_count,
+                  const bool is_header)
+    : _filename(filename)
+    , _fd(-1)
+    , _worker_count(worker_count)
+    , _in(INPUT_CHUNK_SIZE)
+    , _in_start(0)
+    , _in_end(0)
+    , _is_header(is_header)
+    , _header_index(0)
+    , _is_region(true)
+    , _region_index(0)
+    , _is_region_active(false)
+    , _last_tid(-1)
+    , _last_pos(0)
+    , _skip_pos(0)
+{
+    _fd=open_input_file(filename);
+    _src.reset(new bgzf_reader(_fd,_worker_count));
+    read_header();
+    _index.reset(new csi_index(filename+".csi",filename));
+
+    std::vector<query_region> qr;
+    query_region r;
+    std::string chrom;
+    const unsigned rs(regions.size());
+    for (unsigned i(0); i<rs; ++i) {
+        if (! region_util::parse_region_string(regions[i],chrom,r.begin,r.end)) continue;
+        r.tid=_header.get_contig_index(chrom);
+        if (r.tid < 0) continue;
+        qr.push_back(r);
+    }
+
+    region_util::region_t bed_regions;
+    region_util::get_regions(region_file,bed_regions);
+    region_util::region_t::const_iterator i(bed_regions.begin()), i_end(bed_regions.end());
+    for (; i!=i_end; ++i) {
+        r.tid=_header.get_contig_index(i->first);
+        if (r.tid < 0) continue;
+        const region_util::interval_group_t& ig(i->second);
+        const unsigned is(ig.size());
+        for (unsigned j(0); j<is; ++j) {
+            r.begin=ig[j].first;
+            r.end=ig[j].second;
+            qr.push_back(r);
+        }
+    }
+
+    // sort and merge overlapping regions:
+    std::sort(qr.begin(),qr.end());
+    const unsigned qs(qr.size());
+    for (unsigned j(0); j<qs; ++j) {
+        if (_regions.empty() ||
+            (_regions.back().tid != qr[j].tid) ||
+            (_regions.back().end < qr[j].begin)) {
+            _regions.push_back(qr[j]);
+        } else {
+            _regions.back().end=std::max(_regions.back().end,qr[j].end);
+        }
+    }
+}
+
+
+
+bcf_line_splitter::
+~bcf_line_splitter() {
+    // stop reading before the descriptor is closed:
+    _src.reset();
+    if (_fd>=0) ::close(_fd);
+}
+
+
+
+bool
+bcf_line_splitter::
+fill(const size_t size) {
+    if ((_in_end-_in_start) >= size) return true;
+
+    if (_in_start>0) {
+        memmove(&(_in[0]),&(_in[_in_start]),_in_end-_in_start);
+        _in_end -= _in_start;
+        _in_start = 0;
+    }
+    if (_in.size() < size) _in.resize(std::max(size,_in.size()*2));
+    while (_in_end < size) {
+        const size_t n(_src->read(&(_in[_in_end]),_in.size()-_in_end));
+        if (0 == n) return false;
+        _in_end += n;
+    }
+    return true;
+}
+
+
+
+void
+bcf_line_splitter::
+read_header() {
+    static const size_t head_size(BCF_MAGIC_SIZE+4);
+    if ((! fill(head_size)) ||
+        (! is_bcf_magic(&(_in[_in_start]),head_size)) ||
+        (2 != _in[_in_start+3])) {
+        format_exception(_filename,"unexpected file format");
+    }
+    const uint32_t l_text(bcf_get_uint32(&(_in[_in_start+BCF_MAGIC_SIZE])));
+    if (! fill(head_size+l_text)) format_exception(_filename,"unexpected end of header");
+
+    const char* text(&(_in[_in_start+head_size]));
+    const char* text_end(text+l_text);
+    text_end=std::find(text,text_end,'\0');
+    std::string line;
+    while (text < text_end) {
+        const char* nl(std::find(text,text_end,'\n'));
+        line.assign(text,nl);
+        if ((! line.empty()) && ('\r' == line[line.size()-1])) line.resize(line.size()-1);
+        if (! line.empty()) _header.add_line(line.c_str());
+        text = (nl == text_end) ? nl : (nl+1);
+    }
+    _in_start += head_size+l_text;
+
+    if (! _is_header) _header_index=_header.lines().size();
+}
+
+
+
+bool
+bcf_line_splitter::
+next_region() {
+    while (_region_index < _regions.size()) {
+        const query_region& r(_regions[_region_index++]);
+        if (r.tid != _last_tid) {
+            _last_tid=r.tid;
+            _last_pos=0;
+        }
+        _skip_pos=_last_pos;
+
+        uint64_t offset(0);
+        if (! _index->get_query_offset(r.tid,r.begin,r.end,offset)) continue;
+
+        // restart BGZF input at the query offset:
+        _src.reset();
+        if (lseek(_fd,static_cast<off_t>(offset>>16),SEEK_SET) < 0) {
+            format_exception(_filename,"can't seek to region");
+        }
+        _src.reset(new bgzf_reader(_fd,_worker_count));
+        _in_start=_in_end=0;
+        const size_t block_offset(offset & 0xffff);
+        if (! fill(block_offset)) format_exception(_filename,"invalid index offset");
+        _in_start=block_offset;
+        _is_region_active=true;
+        return true;
+    }
+    return false;
+}
+
+
+
+bool
+bcf_line_splitter::
+parse_line() {
+    _line_no++;
+
+    const std::vector<std::string>& header(_header.lines());
+    if (_header_index < header.size()) {
+        _line=header[_header_index++];
+        split_line(&(_line[0]));
+        return true;
+    }
+
+    while (true) {
+        if (_is_region && (! _is_region_active)) {
+            if (! next_region()) return false;
+        }
+
+        if (! fill(8)) {
+            if (_in_end != _in_start) format_exception(_filename,"unexpected end of record");
+            if (! _is_region) return false;
+            _is_region_active=false;
+            continue;
+        }
+        const char* rec(&(_in[_in_start]));
+        const uint32_t l_shared(bcf_get_uint32(rec));
+        const uint32_t l_indiv(bcf_get_uint32(rec+4));
+        const size_t rec_size(static_cast<size_t>(l_shared)+l_indiv+8);
+        if (l_shared < 24) format_exception(_filename,"invalid record");
+        if (! fill(rec_size)) format_exception(_filename,"unexpected end of record");
+        rec=&(_in[_in_start]);
+        _in_start += rec_size;
+
+        if (_is_region) {
+            const query_region& r(_regions[_region_index-1]);
+            const int tid(bcf_get_int32(rec+8));
+            const int pos(bcf_get_int32(rec+12));
+            const int rlen(std::max(bcf_get_int32(rec+16),1));
+            if ((tid > r.tid) || ((tid == r.tid) && (pos >= r.end))) {
+                _is_region_active=false;
+                continue;
+            }
+            if ((tid < r.tid) || ((pos+rlen) <= r.begin)) continue;
+            if ((pos+1) <= _skip_pos) continue;
+            _last_pos=pos+1;
+        }
+
+        decode_record(rec+8,l_shared,l_indiv);
+        return true;
+    }
+}
+
+
+
+void
+bcf_line_splitter::
+start_word() {
+    if (_n_word < _max_word) {
+        if (_n_word > 0) _line.push_back('\0');
+        _word_offset[_n_word++]=_line.size();
+    } else {
+        // all further words are kept in the final word, as split_line:
+        _line.push_back(_sep);
+    }
+}
+
+
+
+static
+void
+append_int(std::string& s,
+           const int val) {
+    char buf[MAX_INT_FORMAT_SIZE];
+    s.append(buf,format_int(val,buf));
+}
+
+
+
+static
+void
+append_float_bits(std::string& s,
+                  const uint32_t bits) {
+    if (BCF_FLOAT_MISSING_BITS == bits) {
+        s.push_back('.');
+    } else {
+        char buf[MAX_GENERAL_FORMAT_SIZE];
+        s.append(buf,format_general(bcf_bits_to_float(bits),buf));
+    }
+}
+
+
+
+// append a vector of typed values in VCF text form, returns false if
+// nothing was appended:
+static
+bool
+append_values(std::string& s,
+              const unsigned type,
+              const unsigned count,
+              const char* data) {
+    const size_t start(s.size());
+    if        (BCF_TYPE::CHAR == type) {
+        s.append(data,std::find(data,data+count,'\0'));
+    } else if (BCF_TYPE::FLOAT == type) {
+        for (unsigned i(0); i<count; ++i) {
+            const uint32_t bits(bcf_get_float_bits(data,i));
+            if (BCF_FLOAT_VECTOR_END_BITS == bits) break;
+            if (i) s.push_back(',');
+            append_float_bits(s,bits);
+        }
+    } else {
+        for (unsigned i(0); i<count; ++i) {
+            const int val(bcf_get_int(data,type,i));
+            if (BCF_INT_VECTOR_END == val) break;
+            if (i) s.push_back(',');
+            if (BCF_INT_MISSING == val) {
+                s.push_back('.');
+            } else {
+                append_int(s,val);
+            }
+        }
+    }
+    return (s.size() > start);
+}
+
+
+
+// append genotype values in VCF text form:
+static
+bool
+append_gt(std::string& s,
+          const unsigned type,
+          const unsigned count,
+          const char* data) {
+    const size_t start(s.size());
+    for (unsigned i(0); i<count; ++i) {
+        const int val(bcf_get_int(data,type,i));
+        if (BCF_INT_VECTOR_END == val) break;
+        if (i) s.push_back((val & 1) ? '|' : '/');
+        const int allele((val>>1)-1);
+        if (allele < 0) {
+            s.push_back('.');
+        } else {
+            append_int(s,allele);
+        }
+    }
+    return (s.size() > start);
+}
+
+
+
+void
+bcf_line_splitter::
+decode_record(const char* rec,
+              const uint32_t l_shared,
+              const uint32_t l_indiv) {
+
+    bcf_cursor c(rec,rec+l_shared,_filename);
+    const int tid(c.get_uint32());
+    const int pos(c.get_uint32());
+    c.get_uint32();
+    const uint32_t qual_bits(c.get_uint32());
+    const uint32_t n_allele_info(c.get_uint32());
+    const uint32_t n_fmt_sample(c.get_uint32());
+    const unsigned n_allele(n_allele_info >> 16);
+    const unsigned n_info(n_allele_info & 0xffff);
+    const unsigned n_fmt(n_fmt_sample >> 24);
+    const unsigned n_sample(n_fmt_sample & 0xffffff);
+
+    _line.clear();
+    _n_word=0;
+    unsigned type,count;
+
+    // CHROM,POS,ID:
+    start_word();
+    _line += _header.get_contig(tid);
+    start_word();
+    append_int(_line,pos+1);
+    start_word();
+    c.get_type(type,count);
+    if (! append_values(_line,type,count,c.get_data(count*bcf_get_type_size(type)))) _line.push_back('.');
+
+    // REF,ALT:
+    for (unsigned i(0); i<n_allele; ++i) {
+        if (i<2) {
+            start_word();
+        } else {
+            _line.push_back(',');
+        }
+        c.get_type(type,count);
+        if (BCF_TYPE::CHAR != type) format_exception(_filename,"invalid allele");
+        _line.append(c.get_data(count),count);
+    }
+    if (n_allele < 1) format_exception(_filename,"record without reference allele");
+    if (n_allele < 2) {
+        start_word();
+        _line.push_back('.');
+    }
+
+    // QUAL,FILTER:
+    start_word();
+    append_float_bits(_line,qual_bits);
+    start_word();
+    c.get_type(type,count);
+    {
+        const char* data(c.get_data(count*bcf_get_type_size(type)));
+        if ((BCF_TYPE::MISSING == type) || (0 == count)) {
+            _line.push_back('.');
+        } else {
+            for (unsigned i(0); i<count; ++i) {
+                if (i) _line.push_back(';');
+                _line += _header.get_key(bcf_get_int(data,type,i));
+            }
+        }
+    }
+
+    // INFO:
+    start_word();
+    for (unsigned i(0); i<n_info; ++i) {
+        if (i) _line.push_back(';');
+        _line += _header.get_key(c.get_typed_int());
+        c.get_type(type,count);
+        const char* data(c.get_data(count*bcf_get_type_size(type)));
+        if ((BCF_TYPE::MISSING == type) || (0 == count)) continue;
+        _line.push_back('=');
+        append_values(_line,type,count,data);
+    }
+    if (0 == n_info) _line.push_back('.');
+
+    // FORMAT and samples:
+    if (n_fmt > 0) {
+        bcf_cursor ic(rec+l_shared,rec+l_shared+l_indiv,_filename);
+
+        struct fmt_info {
+            unsigned type;
+            unsigned count;
+            unsigned size;
+            bool is_gt;
+            const char* data;
+        };
+        fmt_info fmt[256];
+
+        start_word();
+        for (unsigned j(0); j<n_fmt; ++j) {
+            if (j) _line.push_back(':');
+            const std::string& key(_header.get_key(ic.get_typed_int()));
+            _line += key;
+            fmt_info& f(fmt[j]);
+            ic.get_type(f.type,f.count);
+            f.size = f.count*bcf_get_type_size(f.type);
+            f.is_gt = (key == "GT");
+            f.data = ic.get_data(static_cast<size_t>(f.size)*n_sample);
+        }
+
+        for (unsigned s(0); s<n_sample; ++s) {
+            start_word();
+            for (unsigned j(0); j<n_fmt; ++j) {
+                if (j) _line.push_back(':');
+                const fmt_info& f(fmt[j]);
+                const char* data(f.data+(s*f.size));
+                const bool is_value(f.is_gt ?
+                                    append_gt(_line,f.type,f.count,data) :
+                                    append_values(_line,f.type,f.count,data));
+                if (! is_value) _line.push_back('.');
+            }
+        }
+    }
+
+    char* line(&(_line[0]));
+    for (unsigned i(0); i<_n_word; ++i) {
+        word[i]=line+_word_offset[i];
+    }
+}
+
+
+
+bool
+is_bcf_file(const std::string& filename) {
+    const int fd(open_input_file(filename));
+    bgzf_reader src(fd,0,true);
+    char h[BCF_MAGIC_SIZE];
+    size_t size(0);
+    while (size < BCF_MAGIC_SIZE) {
+        const size_t n(src.read(h+size,BCF_MAGIC_SIZE-size));
+        if (0 == n) break;
+        size += n;
+    }
+    return is_bcf_magic(h,size);
+}
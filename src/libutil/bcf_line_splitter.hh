@@ -0,0 +1,164 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// line splitter decoding BCF2 input
+///
+
+#ifndef BCF_LINE_SPLITTER_HH__
+#define BCF_LINE_SPLITTER_HH__
+
+#include "bcf_util.hh"
+#include "byte_source.hh"
+#include "line_splitter.hh"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+struct csi_index;
+
+
+/// reads BCF2 input, presenting each header line and record as the
+/// words of the equivalent VCF line
+///
+/// records are decoded directly from their binary form into the word[]
+/// fields, without forming or tokenizing a VCF text line. Float values are
+/// written in the shortest '%g' form, as by other BCF2 readers.
+///
+/// Input is either a complete BCF2 stream (plain or BGZF compressed) read
+/// from any byte_source, or all records overlapping a set of regions from
+/// a BGZF compressed BCF2 file with a CSI index. Region handling follows
+/// tabix_line_splitter: regions are merged and queried in index order, a
+/// record overlapping more than one region is returned once, and regions
+/// on contigs which are not in the header are ignored.
+///
+struct bcf_line_splitter : public line_splitter {
+
+    /// read a complete BCF2 stream from src, the header lines are returned
+    /// before the first record only if is_header is set
+    explicit
+    bcf_line_splitter(std::auto_ptr<byte_source> src,
+                      const bool is_header = true);
+
+    /// read all records overlapping regions and/or the bed region_file
+    /// from filename, using the index in filename.csi
+    bcf_line_splitter(const std::string& filename,
+                      const std::vector<std::string>& regions,
+                      const std::string& region_file,
+                      const unsigned worker_count,
+                      const bool is_header = true);
+
+    ~bcf_line_splitter();
+
+    bool
+    parse_line();
+
+    const bcf_header&
+    header() const { return _header; }
+
+private:
+    bcf_line_splitter(const bcf_line_splitter&);
+    bcf_line_splitter& operator=(const bcf_line_splitter&);
+
+    void
+    read_header();
+
+    // make at least size bytes of input available from _in_start, returns
+    // false if the input ends first
+    bool
+    fill(const size_t size);
+
+    // set the next decoded word to start at the end of _line:
+    void
+    start_word();
+
+    void
+    decode_record(const char* rec,
+                  const uint32_t l_shared,
+                  const uint32_t l_indiv);
+
+    // start reading the next region, returns false after the last region
+    bool
+    next_region();
+
+    struct query_region {
+
+        bool
+        operator<(const query_region& rhs) const {
+            if (tid != rhs.tid) return (tid < rhs.tid);
+            return (begin < rhs.begin);
+        }
+
+        int tid;
+        int begin;
+        int end;
+    };
+
+    enum { INPUT_CHUNK_SIZE = 1024*1024 };
+
+    std::string _filename;
+    int _fd;
+    unsigned _worker_count;
+    std::auto_ptr<byte_source> _src;
+
+    // unparsed input is [_in_start,_in_end) in _in:
+    std::vector<char> _in;
+    size_t _in_start;
+    size_t _in_end;
+
+    bcf_header _header;
+    bool _is_header;
+    unsigned _header_index;
+
+    // the current line, with words separated by nulls:
+    std::string _line;
+    size_t _word_offset[MAX_WORD_COUNT];
+
+    // region state:
+    bool _is_region;
+    std::auto_ptr<csi_index> _index;
+    std::vector<query_region> _regions;
+    unsigned _region_index;
+    bool _is_region_active;
+
+    // records in the current region at or before _skip_pos were already
+    // returned for a previous region on the same sequence:
+    int _last_tid;
+    int _last_pos;
+    int _skip_pos;
+};
+
+
+
+/// true if filename is a BCF2 file, either plain or compressed
+bool
+is_bcf_file(const std::string& filename);
+
+
+#endif
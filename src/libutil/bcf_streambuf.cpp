@@ -0,0 +1,607 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// stream buffer encoding VCF text output as BCF2
+///
+
+#include "bcf_streambuf.hh"
+#include "blt_exception.hh"
+#include "csi_index_builder.hh"
+#include "parse_util.hh"
+#include "vcf_util.hh"
+
+#include <unistd.h>
+
+#include <cstring>
+
+#include <algorithm>
+#include <sstream>
+
+
+
+// overwrite a previously appended uint32:
+static
+void
+set_uint32(std::string& buf,
+           const unsigned offset,
+           const uint32_t val) {
+    std::string tmp;
+    bcf_put_uint32(tmp,val);
+    buf.replace(offset,4,tmp);
+}
+
+
+
+// split field at each sep:
+template <typename F>
+static
+void
+split_field(const F& field,
+            const char sep,
+            std::vector<F>& split) {
+    split.clear();
+    const char* p(field.b);
+    while (true) {
+        const char* next(static_cast<const char*>(memchr(p,sep,field.e-p)));
+        if (NULL == next) {
+            split.push_back(F(p,field.e));
+            return;
+        }
+        split.push_back(F(p,next));
+        p=next+1;
+    }
+}
+
+
+
+static
+void
+value_exception(const char* type_label,
+                const char* b,
+                const char* e) {
+    std::ostringstream oss;
+    oss << "ERROR: can't parse BCF " << type_label << " value from: '" << std::string(b,e) << "'\n";
+    throw blt_exception(oss.str().c_str());
+}
+
+
+
+// parse a comma separated integer list, where '.' is a missing value:
+static
+void
+parse_int_list(const char* b,
+               const char* e,
+               std::vector<int>& vals) {
+    const char* s(b);
+    while (true) {
+        if (('.' == *s) && (((s+1) == e) || (',' == s[1]))) {
+            vals.push_back(BCF_INT_MISSING);
+            s++;
+        } else {
+            if (s == e) value_exception("integer",b,e);
+            vals.push_back(parse_int(s));
+        }
+        if (s == e) return;
+        if (',' != *s) value_exception("integer",b,e);
+        s++;
+    }
+}
+
+
+
+// parse a comma separated float list, where '.' is a missing value:
+static
+void
+parse_float_list(const char* b,
+                 const char* e,
+                 std::vector<uint32_t>& vals) {
+    const char* s(b);
+    while (true) {
+        if (('.' == *s) && (((s+1) == e) || (',' == s[1]))) {
+            vals.push_back(BCF_FLOAT_MISSING_BITS);
+            s++;
+        } else {
+            if (s == e) value_exception("float",b,e);
+            const float val(parse_double(s,e));
+            uint32_t bits;
+            memcpy(&bits,&val,sizeof(bits));
+            vals.push_back(bits);
+        }
+        if (s == e) return;
+        if (',' != *s) value_exception("float",b,e);
+        s++;
+    }
+}
+
+
+
+// parse GT into BCF2 genotype values: ((allele+1)<<1 | phased), with
+// zero for a missing allele:
+static
+void
+parse_gt_list(const char* b,
+              const char* e,
+              std::vector<int>& vals) {
+    if (b == e) {
+        vals.push_back(0);
+        return;
+    }
+    const char* s(b);
+    int phase(0);
+    while (true) {
+        if ('.' == *s) {
+            vals.push_back(phase);
+            s++;
+        } else {
+            if ((s == e) || (static_cast<unsigned>(*s-'0') > 9)) value_exception("genotype",b,e);
+            vals.push_back(static_cast<int>(((parse_unsigned(s)+1)<<1) | phase));
+        }
+        if (s == e) return;
+        if      ('|' == *s) phase=1;
+        else if ('/' == *s) phase=0;
+        else value_exception("genotype",b,e);
+        s++;
+    }
+}
+
+
+
+bcf_streambuf::
+bcf_streambuf(std::streambuf* sink)
+    : _sink(sink)
+    , _is_header_complete(false)
+    , _is_closed(false)
+    , _line_no(0)
+{}
+
+
+
+bcf_streambuf::int_type
+bcf_streambuf::
+overflow(int_type c) {
+    if (traits_type::eq_int_type(c,traits_type::eof())) return traits_type::not_eof(c);
+    const char ch(traits_type::to_char_type(c));
+    xsputn(&ch,1);
+    return c;
+}
+
+
+
+std::streamsize
+bcf_streambuf::
+xsputn(const char* s,
+       std::streamsize n) {
+    const char* p(s);
+    const char* end(s+n);
+    while (p<end) {
+        const char* nl(static_cast<const char*>(memchr(p,'\n',end-p)));
+        if (NULL == nl) {
+            _line.append(p,end-p);
+            break;
+        }
+        _line.append(p,(nl+1)-p);
+        const char* line(_line.c_str());
+        process_line(line,line+_line.size()-1);
+        _line.clear();
+        p=nl+1;
+    }
+    return n;
+}
+
+
+
+void
+bcf_streambuf::
+write_sink(const char* s,
+           const size_t size) {
+    if (static_cast<std::streamsize>(size) != _sink->sputn(s,size)) {
+        throw blt_exception("ERROR: failed to write BCF output\n");
+    }
+}
+
+
+
+void
+bcf_streambuf::
+process_line(const char* line,
+             const char* line_end) {
+    _line_no++;
+    if (line == line_end) return;
+
+    if (_is_header_complete) {
+        encode_record(line,line_end);
+        return;
+    }
+
+    if ('#' != *line) {
+        throw blt_exception("ERROR: BCF output requires a complete VCF header before the first record\n");
+    }
+
+    _header.add_line(std::string(line,line_end).c_str());
+    if (0 != strncmp(line,"#CHROM",6)) return;
+
+    // write the BCF2 file header:
+    const std::string text(_header.get_text());
+    std::string buf(BCF_MAGIC,BCF_MAGIC_SIZE);
+    bcf_put_uint32(buf,text.size()+1);
+    write_sink(buf.c_str(),buf.size());
+    write_sink(text.c_str(),text.size()+1);
+    _is_header_complete=true;
+}
+
+
+
+int
+bcf_streambuf::
+get_key_index(const field_t& key,
+              const char* label) {
+    _name.assign(key.b,key.e);
+    const int index(_header.get_key_index(_name));
+    if (index < 0) {
+        std::ostringstream oss;
+        oss << "ERROR: BCF output requires a header definition for " << label << " ID '" << _name << "'\n";
+        throw blt_exception(oss.str().c_str());
+    }
+    return index;
+}
+
+
+
+void
+bcf_streambuf::
+encode_record(const char* line,
+              const char* line_end) {
+
+    split_field(field_t(line,line_end),'\t',_fields);
+    const unsigned n_field(_fields.size());
+    if (n_field <= VCFID::INFO) {
+        std::ostringstream oss;
+        oss << "ERROR: unexpected VCF record format at output line " << _line_no << ": '" << std::string(line,line_end) << "'\n";
+        throw blt_exception(oss.str().c_str());
+    }
+
+    _shared.clear();
+    _indiv.clear();
+
+    // CHROM,POS,rlen,QUAL:
+    _name.assign(_fields[VCFID::CHROM].b,_fields[VCFID::CHROM].e);
+    const int tid(_header.get_contig_index(_name));
+    if (tid < 0) {
+        std::ostringstream oss;
+        oss << "ERROR: BCF output requires a ##contig header line for chromosome '" << _name << "'\n";
+        throw blt_exception(oss.str().c_str());
+    }
+    bcf_put_int32(_shared,tid);
+
+    const field_t& pos_field(_fields[VCFID::POS]);
+    const char* s(pos_field.b);
+    const int pos((s == pos_field.e) ? 0 : parse_int(s));
+    if ((s != pos_field.e) || (pos < 1)) value_exception("position",pos_field.b,pos_field.e);
+    bcf_put_int32(_shared,pos-1);
+    bcf_put_int32(_shared,0);
+
+    const field_t& qual_field(_fields[VCFID::QUAL]);
+    if (qual_field.is_missing()) {
+        bcf_put_uint32(_shared,BCF_FLOAT_MISSING_BITS);
+    } else {
+        _float_bits.clear();
+        parse_float_list(qual_field.b,qual_field.e,_float_bits);
+        bcf_put_uint32(_shared,_float_bits[0]);
+    }
+
+    // counts are set below:
+    bcf_put_uint32(_shared,0);
+    bcf_put_uint32(_shared,0);
+
+    // ID, alleles, FILTER:
+    const field_t& id_field(_fields[VCFID::ID]);
+    if (id_field.is_missing()) {
+        bcf_put_type(_shared,BCF_TYPE::CHAR,0);
+    } else {
+        bcf_put_typed_string(_shared,id_field.b,id_field.size());
+    }
+
+    const field_t& ref_field(_fields[VCFID::REF]);
+    bcf_put_typed_string(_shared,ref_field.b,ref_field.size());
+    unsigned n_allele(1);
+    const field_t& alt_field(_fields[VCFID::ALT]);
+    if (! alt_field.is_missing()) {
+        split_field(alt_field,',',_format_keys);
+        const unsigned n_alt(_format_keys.size());
+        for (unsigned i(0); i<n_alt; ++i) {
+            bcf_put_typed_string(_shared,_format_keys[i].b,_format_keys[i].size());
+        }
+        n_allele += n_alt;
+    }
+
+    const field_t& filter_field(_fields[VCFID::FILT]);
+    if (filter_field.is_missing()) {
+        bcf_put_type(_shared,BCF_TYPE::MISSING,0);
+    } else {
+        split_field(filter_field,';',_format_keys);
+        _ints.clear();
+        const unsigned n_filter(_format_keys.size());
+        for (unsigned i(0); i<n_filter; ++i) {
+            _ints.push_back(get_key_index(_format_keys[i],"FILTER"));
+        }
+        bcf_put_typed_ints(_shared,&(_ints[0]),_ints.size());
+    }
+
+    int end_pos(-1);
+    const unsigned n_info(encode_info(_fields[VCFID::INFO].b,_fields[VCFID::INFO].e,end_pos));
+    const int rlen((end_pos >= pos) ? ((end_pos-pos)+1) : static_cast<int>(ref_field.size()));
+    set_uint32(_shared,8,rlen);
+    set_uint32(_shared,16,(n_allele<<16) | n_info);
+
+    const unsigned n_sample(_header.samples().size());
+    unsigned n_fmt(0);
+    if ((n_field > VCFID::FORMAT) && (n_sample > 0) && (! _fields[VCFID::FORMAT].is_missing())) {
+        n_fmt=encode_format(n_field);
+    }
+    set_uint32(_shared,20,(n_fmt<<24) | n_sample);
+
+    std::string head;
+    bcf_put_uint32(head,_shared.size());
+    bcf_put_uint32(head,_indiv.size());
+    write_sink(head.c_str(),head.size());
+    write_sink(_shared.c_str(),_shared.size());
+    write_sink(_indiv.c_str(),_indiv.size());
+}
+
+
+
+unsigned
+bcf_streambuf::
+encode_info(const char* info,
+            const char* info_end,
+            int& end_pos) {
+
+    if (field_t(info,info_end).is_missing()) return 0;
+
+    unsigned n_info(0);
+    const char* p(info);
+    while (p < info_end) {
+        const char* item_end(static_cast<const char*>(memchr(p,';',info_end-p)));
+        if (NULL == item_end) item_end=info_end;
+        const char* eq(static_cast<const char*>(memchr(p,'=',item_end-p)));
+        const field_t key(p,(NULL == eq) ? item_end : eq);
+        p=item_end+1;
+        if (0 == key.size()) continue;
+
+        const int index(get_key_index(key,"INFO"));
+        bcf_put_typed_int(_shared,index);
+        n_info++;
+
+        const bcf_header::value_t type(_header.get_info_type(index));
+        if ((NULL == eq) || (bcf_header::FLAG == type)) {
+            bcf_put_type(_shared,BCF_TYPE::MISSING,0);
+            continue;
+        }
+
+        const char* val(eq+1);
+        if        (bcf_header::INTEGER == type) {
+            _ints.clear();
+            parse_int_list(val,item_end,_ints);
+            bcf_put_typed_ints(_shared,&(_ints[0]),_ints.size());
+            if ((1 == _ints.size()) && (BCF_INT_MISSING != _ints[0]) && (0 == _name.compare("END"))) {
+                end_pos=_ints[0];
+            }
+        } else if (bcf_header::FLOAT == type) {
+            _float_bits.clear();
+            parse_float_list(val,item_end,_float_bits);
+            const unsigned n_val(_float_bits.size());
+            bcf_put_type(_shared,BCF_TYPE::FLOAT,n_val);
+            for (unsigned i(0); i<n_val; ++i) bcf_put_uint32(_shared,_float_bits[i]);
+        } else {
+            bcf_put_typed_string(_shared,val,item_end-val);
+        }
+    }
+    return n_info;
+}
+
+
+
+unsigned
+bcf_streambuf::
+encode_format(const unsigned n_field) {
+
+    split_field(_fields[VCFID::FORMAT],':',_format_keys);
+    const unsigned n_fmt(_format_keys.size());
+
+    const unsigned n_sample(_header.samples().size());
+    _sample_fields.resize(n_sample);
+    for (unsigned s(0); s<n_sample; ++s) {
+        const unsigned col(VCFID::SAMPLE+s);
+        if (col < n_field) {
+            split_field(_fields[col],':',_sample_fields[s]);
+        } else {
+            _sample_fields[s].clear();
+        }
+    }
+
+    static const field_t missing_field;
+    for (unsigned k(0); k<n_fmt; ++k) {
+        const int index(get_key_index(_format_keys[k],"FORMAT"));
+        bcf_put_typed_int(_indiv,index);
+        const bool is_gt(0 == _name.compare("GT"));
+        const bcf_header::value_t type(_header.get_format_type(index));
+
+        // collect the values of all samples, and the size of each:
+        _sizes.clear();
+        _ints.clear();
+        _float_bits.clear();
+        unsigned max_size(1);
+        for (unsigned s(0); s<n_sample; ++s) {
+            const field_t& val((k < _sample_fields[s].size()) ? _sample_fields[s][k] : missing_field);
+            unsigned size(1);
+            if        (is_gt) {
+                const unsigned start(_ints.size());
+                parse_gt_list(val.b,val.e,_ints);
+                size=_ints.size()-start;
+            } else if (bcf_header::INTEGER == type) {
+                const unsigned start(_ints.size());
+                if (val.is_missing()) {
+                    _ints.push_back(BCF_INT_MISSING);
+                } else {
+                    parse_int_list(val.b,val.e,_ints);
+                }
+                size=_ints.size()-start;
+            } else if (bcf_header::FLOAT == type) {
+                const unsigned start(_float_bits.size());
+                if (val.is_missing()) {
+                    _float_bits.push_back(BCF_FLOAT_MISSING_BITS);
+                } else {
+                    parse_float_list(val.b,val.e,_float_bits);
+                }
+                size=_float_bits.size()-start;
+            } else {
+                size=(val.b == val.e) ? 1 : val.size();
+            }
+            _sizes.push_back(size);
+            max_size=std::max(max_size,size);
+        }
+
+        // write each sample's values padded to the max size:
+        if (is_gt || (bcf_header::INTEGER == type)) {
+            static const int vector_end(BCF_INT_VECTOR_END);
+            const BCF_TYPE::index_t int_type(bcf_get_int_type(&(_ints[0]),_ints.size()));
+            bcf_put_type(_indiv,int_type,max_size);
+            unsigned offset(0);
+            for (unsigned s(0); s<n_sample; ++s) {
+                bcf_put_int_values(_indiv,int_type,&(_ints[offset]),_sizes[s]);
+                for (unsigned i(_sizes[s]); i<max_size; ++i) {
+                    bcf_put_int_values(_indiv,int_type,&vector_end,1);
+                }
+                offset += _sizes[s];
+            }
+        } else if (bcf_header::FLOAT == type) {
+            bcf_put_type(_indiv,BCF_TYPE::FLOAT,max_size);
+            unsigned offset(0);
+            for (unsigned s(0); s<n_sample; ++s) {
+                for (unsigned i(0); i<max_size; ++i) {
+                    bcf_put_uint32(_indiv,(i<_sizes[s]) ? _float_bits[offset+i] : BCF_FLOAT_VECTOR_END_BITS);
+                }
+                offset += _sizes[s];
+            }
+        } else {
+            bcf_put_type(_indiv,BCF_TYPE::CHAR,max_size);
+            for (unsigned s(0); s<n_sample; ++s) {
+                const field_t& val((k < _sample_fields[s].size()) ? _sample_fields[s][k] : missing_field);
+                if (val.b == val.e) {
+                    _indiv.push_back('.');
+                } else {
+                    _indiv.append(val.b,val.size());
+                }
+                _indiv.append(max_size-_sizes[s],'\0');
+            }
+        }
+    }
+    return n_fmt;
+}
+
+
+
+void
+bcf_streambuf::
+close() {
+    if (_is_closed) return;
+    _is_closed=true;
+
+    if (! _line.empty()) {
+        // unterminated final line:
+        _line.push_back('\n');
+        const char* line(_line.c_str());
+        process_line(line,line+_line.size()-1);
+        _line.clear();
+    }
+    if (! _is_header_complete) {
+        throw blt_exception("ERROR: BCF output requires a complete VCF header\n");
+    }
+}
+
+
+
+static
+void
+check_output_type(const char output_type) {
+    if (('v' == output_type) || ('b' == output_type)) return;
+    std::ostringstream oss;
+    oss << "ERROR: unsupported output type: '" << output_type << "'. Expected 'v' (VCF) or 'b' (BCF)\n";
+    throw blt_exception(oss.str().c_str());
+}
+
+
+
+vcf_output_redirect::
+vcf_output_redirect(output_buffer& ob,
+                    const std::string& filename,
+                    const char output_type,
+                    const unsigned worker_count)
+    : _ob(ob)
+{
+    check_output_type(output_type);
+    if ('v' == output_type) {
+        _vcf.reset(new bgzf_output_redirect(ob,filename,worker_count));
+        return;
+    }
+
+    if (filename.empty()) {
+        _bgzf.reset(new bgzf_streambuf(STDOUT_FILENO,worker_count));
+    } else {
+        std::auto_ptr<bgzf_block_index> index(new csi_index_builder());
+        _bgzf.reset(new bgzf_streambuf(filename,worker_count,index));
+    }
+    _bcf.reset(new bcf_streambuf(_bgzf.get()));
+    _ob.set_sink(_bcf.get());
+}
+
+
+
+vcf_output_redirect::
+~vcf_output_redirect() {
+    if (NULL == _bcf.get()) return;
+
+    // detach the output buffer from the BCF encoder before it is destroyed:
+    try {
+        _ob.set_sink(-1);
+    } catch (...) {}
+}
+
+
+
+void
+vcf_output_redirect::
+close() {
+    if (NULL != _vcf.get()) {
+        _vcf->close();
+        return;
+    }
+    _ob.flush();
+    _bcf->close();
+    _bgzf->close();
+}
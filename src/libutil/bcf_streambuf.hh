@@ -0,0 +1,173 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// stream buffer encoding VCF text output as BCF2
+///
+
+#ifndef __BCF_STREAMBUF_HH
+#define __BCF_STREAMBUF_HH
+
+#include "bcf_util.hh"
+#include "bgzf_streambuf.hh"
+#include "output_buffer.hh"
+
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+
+/// std::streambuf which encodes the VCF text written to it as BCF2 on a
+/// sink stream buffer
+///
+/// header lines are collected up to the #CHROM line, after which the BCF2
+/// header is written, and each following line is encoded as one BCF2
+/// record. Every contig, FILTER, INFO and FORMAT ID found in the records
+/// must be declared in the header. Encoding errors are thrown as
+/// blt_exception from the write which completes the offending line.
+///
+struct bcf_streambuf : public std::streambuf {
+
+    explicit
+    bcf_streambuf(std::streambuf* sink);
+
+    /// encode any final unterminated line. Throws if no complete VCF
+    /// header was written
+    void
+    close();
+
+protected:
+    int_type
+    overflow(int_type c);
+
+    std::streamsize
+    xsputn(const char* s,
+           std::streamsize n);
+
+private:
+    bcf_streambuf(const bcf_streambuf&);
+    bcf_streambuf& operator=(const bcf_streambuf&);
+
+    // encode the line in _line, which is terminated by a newline at
+    // line_end and a null after that:
+    void
+    process_line(const char* line,
+                 const char* line_end);
+
+    void
+    encode_record(const char* line,
+                  const char* line_end);
+
+    // returns the number of INFO keys:
+    unsigned
+    encode_info(const char* info,
+                const char* info_end,
+                int& end_pos);
+
+    // returns the number of FORMAT keys:
+    unsigned
+    encode_format(const unsigned n_field);
+
+    void
+    write_sink(const char* s,
+               const size_t size);
+
+    struct field_t {
+        field_t(const char* b_init = NULL,
+                const char* e_init = NULL)
+            : b(b_init), e(e_init) {}
+
+        unsigned
+        size() const { return e-b; }
+
+        bool
+        is_missing() const { return ((b==e) || (((b+1)==e) && ('.' == *b))); }
+
+        const char* b;
+        const char* e;
+    };
+
+    // look up a key in the header string dictionary, throws if undefined:
+    int
+    get_key_index(const field_t& key,
+                  const char* label);
+
+    std::streambuf* _sink;
+    std::string _line;
+    bcf_header _header;
+    bool _is_header_complete;
+    bool _is_closed;
+    unsigned long _line_no;
+
+    // record encoding buffers, kept to avoid reallocation:
+    std::string _shared;
+    std::string _indiv;
+    std::string _name;
+    std::vector<field_t> _fields;
+    std::vector<field_t> _format_keys;
+    std::vector<std::vector<field_t> > _sample_fields;
+    std::vector<int> _ints;
+    std::vector<uint32_t> _float_bits;
+    std::vector<unsigned> _sizes;
+};
+
+
+
+/// redirect an output_buffer for the lifetime of this object according to
+/// the VCF output type:
+///
+/// 'v' -- VCF text, written as by bgzf_output_redirect
+/// 'b' -- BGZF compressed BCF2, written to filename with a CSI index, or
+///        to standard output without an index if filename is empty
+///
+/// any other output type is thrown as blt_exception
+///
+struct vcf_output_redirect {
+
+    vcf_output_redirect(output_buffer& ob,
+                        const std::string& filename,
+                        const char output_type,
+                        const unsigned worker_count);
+
+    ~vcf_output_redirect();
+
+    /// flush the output buffer and complete the output file and index
+    void
+    close();
+
+private:
+    vcf_output_redirect(const vcf_output_redirect&);
+    vcf_output_redirect& operator=(const vcf_output_redirect&);
+
+    output_buffer& _ob;
+    std::auto_ptr<bgzf_output_redirect> _vcf;
+    std::auto_ptr<bgzf_streambuf> _bgzf;
+    std::auto_ptr<bcf_streambuf> _bcf;
+};
+
+#endif
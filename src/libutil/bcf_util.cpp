@@ -0,0 +1,359 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// BCF2 header dictionaries and typed value encoding
+///
+
+#include "bcf_util.hh"
+#include "blt_exception.hh"
+#include "parse_util.hh"
+
+#include <sstream>
+
+
+const char BCF_MAGIC[BCF_MAGIC_SIZE] = { 'B','C','F','\2','\2' };
+
+static const char pass_filter_line[] = "##FILTER=<ID=PASS,Description=\"All filters passed\">";
+
+
+
+// parse the attributes of a structured header line: ##KEY=<A=B,C="D",...>
+//
+static
+void
+parse_header_attributes(const char* line,
+                        std::map<std::string,std::string>& attr) {
+    attr.clear();
+    const char* p(strchr(line,'<'));
+    if (NULL == p) return;
+    p++;
+    while (('\0' != *p) && ('>' != *p)) {
+        const char* key_end(p);
+        while (('\0' != *key_end) && ('=' != *key_end) && (',' != *key_end) && ('>' != *key_end)) key_end++;
+        std::string key(p,key_end);
+        std::string val;
+        p=key_end;
+        if ('=' == *p) {
+            p++;
+            if ('"' == *p) {
+                p++;
+                while (('\0' != *p) && ('"' != *p)) {
+                    if (('\\' == *p) && ('\0' != p[1])) p++;
+                    val.push_back(*p++);
+                }
+                if ('"' == *p) p++;
+            } else {
+                const char* val_end(p);
+                while (('\0' != *val_end) && (',' != *val_end) && ('>' != *val_end)) val_end++;
+                val.assign(p,val_end);
+                p=val_end;
+            }
+        }
+        attr[key]=val;
+        if (',' == *p) p++;
+    }
+}
+
+
+
+static
+bcf_header::value_t
+get_value_type(const std::string& type) {
+    if (type == "Flag") return bcf_header::FLAG;
+    if (type == "Integer") return bcf_header::INTEGER;
+    if (type == "Float") return bcf_header::FLOAT;
+    return bcf_header::STRING;
+}
+
+
+
+void
+bcf_header::
+clear() {
+    _lines.clear();
+    _is_pass_line=false;
+    _key_names.clear();
+    _keys.clear();
+    _key_index.clear();
+    _contigs.clear();
+    _contig_index.clear();
+    _samples.clear();
+
+    add_id("PASS","",_key_index,_key_names);
+    _keys.resize(_key_names.size());
+}
+
+
+
+unsigned
+bcf_header::
+add_id(const std::string& id,
+       const std::string& idx,
+       index_map_t& index_map,
+       std::vector<std::string>& names) {
+
+    const index_map_t::const_iterator i(index_map.find(id));
+    if (i != index_map.end()) return i->second;
+
+    unsigned index(names.size());
+    if (! idx.empty()) {
+        index=parse_unsigned_str(idx);
+        if (index < names.size() && (! names[index].empty())) {
+            std::ostringstream oss;
+            oss << "ERROR: conflicting BCF header dictionary index IDX=" << idx << " for ID '" << id << "'\n";
+            throw blt_exception(oss.str().c_str());
+        }
+    }
+    if (index >= names.size()) names.resize(index+1);
+    names[index]=id;
+    index_map[id]=index;
+    return index;
+}
+
+
+
+void
+bcf_header::
+add_line(const char* line) {
+    _lines.push_back(line);
+
+    if (0 == strncmp(line,"#CHROM",6)) {
+        _samples.clear();
+        unsigned col(0);
+        const char* p(line);
+        while (true) {
+            const char* next(strchr(p,'\t'));
+            if (col >= 9) _samples.push_back(std::string(p,(NULL==next) ? (p+strlen(p)) : next));
+            if (NULL == next) break;
+            p=next+1;
+            col++;
+        }
+        return;
+    }
+
+    const bool is_filter(0 == strncmp(line,"##FILTER=<",10));
+    const bool is_info(0 == strncmp(line,"##INFO=<",8));
+    const bool is_format(0 == strncmp(line,"##FORMAT=<",10));
+    const bool is_contig(0 == strncmp(line,"##contig=<",10));
+    if (! (is_filter || is_info || is_format || is_contig)) return;
+
+    std::map<std::string,std::string> attr;
+    parse_header_attributes(line,attr);
+    const std::string& id(attr["ID"]);
+    if (id.empty()) return;
+    const std::string& idx(attr["IDX"]);
+
+    if (is_contig) {
+        add_id(id,idx,_contig_index,_contigs);
+        return;
+    }
+
+    const unsigned index(add_id(id,idx,_key_index,_key_names));
+    if (index >= _keys.size()) _keys.resize(index+1);
+    if        (is_filter) {
+        if (id == "PASS") _is_pass_line=true;
+    } else if (is_info) {
+        _keys[index].info_type=get_value_type(attr["Type"]);
+    } else {
+        _keys[index].format_type=get_value_type(attr["Type"]);
+    }
+}
+
+
+
+std::string
+bcf_header::
+get_text() const {
+    std::string text;
+    const unsigned ls(_lines.size());
+    for (unsigned i(0); i<ls; ++i) {
+        text += _lines[i];
+        text += '\n';
+    }
+    if (! _is_pass_line) {
+        const std::string pass_line(std::string(pass_filter_line)+'\n');
+        const size_t pos(((! _lines.empty()) && (0 == _lines[0].compare(0,13,"##fileformat="))) ?
+                         (_lines[0].size()+1) : 0);
+        text.insert(pos,pass_line);
+    }
+    return text;
+}
+
+
+
+static
+void
+bad_index(const char* label,
+          const unsigned index) {
+    std::ostringstream oss;
+    oss << "ERROR: BCF " << label << " index " << index << " is not defined in the header\n";
+    throw blt_exception(oss.str().c_str());
+}
+
+
+
+const std::string&
+bcf_header::
+get_contig(const unsigned index) const {
+    if (index >= _contigs.size() || _contigs[index].empty()) bad_index("contig",index);
+    return _contigs[index];
+}
+
+
+
+const std::string&
+bcf_header::
+get_key(const unsigned index) const {
+    if (index >= _key_names.size() || _key_names[index].empty()) bad_index("dictionary",index);
+    return _key_names[index];
+}
+
+
+
+void
+bcf_put_uint32(std::string& buf,
+               const uint32_t val) {
+    const char b[4] = { static_cast<char>(val & 0xff),
+                        static_cast<char>((val >> 8) & 0xff),
+                        static_cast<char>((val >> 16) & 0xff),
+                        static_cast<char>((val >> 24) & 0xff)
+                      };
+    buf.append(b,4);
+}
+
+
+
+void
+bcf_put_float(std::string& buf,
+              const float val) {
+    uint32_t bits;
+    memcpy(&bits,&val,sizeof(bits));
+    bcf_put_uint32(buf,bits);
+}
+
+
+
+void
+bcf_put_type(std::string& buf,
+             const BCF_TYPE::index_t type,
+             const unsigned count) {
+    if (count < BCF_LONG_COUNT) {
+        buf.push_back(static_cast<char>((count << 4) | type));
+    } else {
+        buf.push_back(static_cast<char>((BCF_LONG_COUNT << 4) | type));
+        bcf_put_typed_int(buf,static_cast<int>(count));
+    }
+}
+
+
+
+BCF_TYPE::index_t
+bcf_get_int_type(const int* vals,
+                 const unsigned count) {
+    int min(0), max(0);
+    for (unsigned i(0); i<count; ++i) {
+        const int v(vals[i]);
+        if ((v == BCF_INT_MISSING) || (v == BCF_INT_VECTOR_END)) continue;
+        if (v < min) min=v;
+        if (v > max) max=v;
+    }
+    // the lowest values of each type are reserved:
+    if ((min >= -120) && (max <= 127)) return BCF_TYPE::INT8;
+    if ((min >= -32760) && (max <= 32767)) return BCF_TYPE::INT16;
+    return BCF_TYPE::INT32;
+}
+
+
+
+void
+bcf_put_int_values(std::string& buf,
+                   const BCF_TYPE::index_t type,
+                   const int* vals,
+                   const unsigned count) {
+    for (unsigned i(0); i<count; ++i) {
+        const int v(vals[i]);
+        switch (type) {
+        case BCF_TYPE::INT8: {
+            char c(static_cast<char>(v));
+            if      (v == BCF_INT_MISSING) c=static_cast<char>(0x80);
+            else if (v == BCF_INT_VECTOR_END) c=static_cast<char>(0x81);
+            buf.push_back(c);
+            break;
+        }
+        case BCF_TYPE::INT16: {
+            uint16_t u(static_cast<uint16_t>(v));
+            if      (v == BCF_INT_MISSING) u=0x8000;
+            else if (v == BCF_INT_VECTOR_END) u=0x8001;
+            buf.push_back(static_cast<char>(u & 0xff));
+            buf.push_back(static_cast<char>(u >> 8));
+            break;
+        }
+        default:
+            bcf_put_int32(buf,v);
+        }
+    }
+}
+
+
+
+void
+bcf_put_typed_ints(std::string& buf,
+                   const int* vals,
+                   const unsigned count) {
+    const BCF_TYPE::index_t type(bcf_get_int_type(vals,count));
+    bcf_put_type(buf,type,count);
+    bcf_put_int_values(buf,type,vals,count);
+}
+
+
+
+void
+bcf_put_typed_string(std::string& buf,
+                     const char* s,
+                     const unsigned size) {
+    bcf_put_type(buf,BCF_TYPE::CHAR,size);
+    buf.append(s,size);
+}
+
+
+
+unsigned
+bcf_get_type_size(const unsigned type) {
+    switch (type) {
+    case BCF_TYPE::INT8:
+    case BCF_TYPE::CHAR:
+        return 1;
+    case BCF_TYPE::INT16:
+        return 2;
+    case BCF_TYPE::INT32:
+    case BCF_TYPE::FLOAT:
+        return 4;
+    default:
+        return 0;
+    }
+}
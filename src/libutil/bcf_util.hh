@@ -0,0 +1,330 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// BCF2 header dictionaries and typed value encoding
+///
+
+#ifndef __BCF_UTIL_HH
+#define __BCF_UTIL_HH
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <cstring>
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+/// BCF2 typed value type codes
+namespace BCF_TYPE {
+enum index_t
+{
+    MISSING = 0,
+    INT8 = 1,
+    INT16 = 2,
+    INT32 = 3,
+    FLOAT = 5,
+    CHAR = 7
+};
+}
+
+
+enum {
+    /// missing and vector end values of every BCF2 integer type are
+    /// represented by these int values:
+    BCF_INT_MISSING = (-2147483647-1),
+    BCF_INT_VECTOR_END = (-2147483647),
+
+    /// the count nibble of a type descriptor which is followed by a
+    /// typed integer count:
+    BCF_LONG_COUNT = 15,
+
+    /// size of the BCF2 magic number
+    BCF_MAGIC_SIZE = 5
+};
+
+static const uint32_t BCF_FLOAT_MISSING_BITS = 0x7F800001;
+static const uint32_t BCF_FLOAT_VECTOR_END_BITS = 0x7F800002;
+
+/// BCF 2.2 magic number
+extern const char BCF_MAGIC[BCF_MAGIC_SIZE];
+
+
+/// true if the bytes start with a BCF2 magic number (any minor version)
+inline
+bool
+is_bcf_magic(const char* h,
+             const size_t size) {
+    return ((size >= 4) && (0 == memcmp(h,BCF_MAGIC,4)));
+}
+
+
+
+/// the VCF header of a BCF2 file and the dictionaries derived from it
+///
+/// The string dictionary holds the IDs of all FILTER, INFO and FORMAT
+/// header lines in header order (or at their IDX position if given), with
+/// PASS always at index 0. The contig dictionary holds the IDs of the
+/// contig lines. Samples are taken from the #CHROM line.
+///
+struct bcf_header {
+
+    /// value types of INFO and FORMAT keys, from the header 'Type'
+    /// attribute. Character values are treated as strings
+    enum value_t {
+        FLAG,
+        INTEGER,
+        FLOAT,
+        STRING
+    };
+
+    bcf_header() { clear(); }
+
+    void
+    clear();
+
+    /// add one header line, without any line terminator
+    void
+    add_line(const char* line);
+
+    const std::vector<std::string>&
+    lines() const { return _lines; }
+
+    /// header text as written to a BCF2 file: all lines terminated by
+    /// newlines, with a PASS filter line added if not already present
+    std::string
+    get_text() const;
+
+    /// returns -1 for an unknown contig
+    int
+    get_contig_index(const std::string& name) const {
+        return find_index(_contig_index,name);
+    }
+
+    unsigned
+    contig_count() const { return _contigs.size(); }
+
+    /// throws for an invalid index
+    const std::string&
+    get_contig(const unsigned index) const;
+
+    /// returns -1 for an unknown key
+    int
+    get_key_index(const std::string& name) const {
+        return find_index(_key_index,name);
+    }
+
+    /// throws for an invalid index
+    const std::string&
+    get_key(const unsigned index) const;
+
+    value_t
+    get_info_type(const unsigned index) const {
+        return (index < _keys.size()) ? _keys[index].info_type : STRING;
+    }
+
+    value_t
+    get_format_type(const unsigned index) const {
+        return (index < _keys.size()) ? _keys[index].format_type : STRING;
+    }
+
+    const std::vector<std::string>&
+    samples() const { return _samples; }
+
+private:
+
+    typedef std::map<std::string,unsigned> index_map_t;
+
+    static
+    int
+    find_index(const index_map_t& index_map,
+               const std::string& name) {
+        const index_map_t::const_iterator i(index_map.find(name));
+        return ((i == index_map.end()) ? -1 : static_cast<int>(i->second));
+    }
+
+    static
+    unsigned
+    add_id(const std::string& id,
+           const std::string& idx,
+           index_map_t& index_map,
+           std::vector<std::string>& names);
+
+    struct key_info {
+        key_info()
+            : info_type(STRING)
+            , format_type(STRING)
+        {}
+
+        value_t info_type;
+        value_t format_type;
+    };
+
+    std::vector<std::string> _lines;
+    bool _is_pass_line;
+
+    std::vector<std::string> _key_names;
+    std::vector<key_info> _keys;
+    index_map_t _key_index;
+
+    std::vector<std::string> _contigs;
+    index_map_t _contig_index;
+
+    std::vector<std::string> _samples;
+};
+
+
+
+/// \name BCF2 value encoding
+///
+/// all values are appended to buf in little-endian order
+///
+/// @{
+void
+bcf_put_uint32(std::string& buf,
+               const uint32_t val);
+
+inline
+void
+bcf_put_int32(std::string& buf,
+              const int32_t val) {
+    bcf_put_uint32(buf,static_cast<uint32_t>(val));
+}
+
+void
+bcf_put_float(std::string& buf,
+              const float val);
+
+/// type descriptor for count values of type
+void
+bcf_put_type(std::string& buf,
+             const BCF_TYPE::index_t type,
+             const unsigned count);
+
+/// smallest integer type which holds all values, which may include
+/// BCF_INT_MISSING and BCF_INT_VECTOR_END
+BCF_TYPE::index_t
+bcf_get_int_type(const int* vals,
+                 const unsigned count);
+
+/// integer values without a type descriptor
+void
+bcf_put_int_values(std::string& buf,
+                   const BCF_TYPE::index_t type,
+                   const int* vals,
+                   const unsigned count);
+
+/// typed integer vector, using the smallest integer type
+void
+bcf_put_typed_ints(std::string& buf,
+                   const int* vals,
+                   const unsigned count);
+
+inline
+void
+bcf_put_typed_int(std::string& buf,
+                  const int val) {
+    bcf_put_typed_ints(buf,&val,1);
+}
+
+/// typed char vector
+void
+bcf_put_typed_string(std::string& buf,
+                     const char* s,
+                     const unsigned size);
+/// @}
+
+
+
+/// \name BCF2 value decoding
+///
+/// @{
+inline
+uint32_t
+bcf_get_uint32(const char* p) {
+    const unsigned char* u(reinterpret_cast<const unsigned char*>(p));
+    return (static_cast<uint32_t>(u[0]) |
+            (static_cast<uint32_t>(u[1]) << 8) |
+            (static_cast<uint32_t>(u[2]) << 16) |
+            (static_cast<uint32_t>(u[3]) << 24));
+}
+
+inline
+int32_t
+bcf_get_int32(const char* p) {
+    return static_cast<int32_t>(bcf_get_uint32(p));
+}
+
+/// size in bytes of one value of type, zero for MISSING or unknown types
+unsigned
+bcf_get_type_size(const unsigned type);
+
+/// integer value i of a vector of type, with missing and vector end values
+/// returned as BCF_INT_MISSING and BCF_INT_VECTOR_END
+inline
+int
+bcf_get_int(const char* data,
+            const unsigned type,
+            const unsigned i) {
+    switch (type) {
+    case BCF_TYPE::INT8: {
+        const int8_t v(static_cast<int8_t>(data[i]));
+        if (v > -127) return v;
+        return ((v == -128) ? BCF_INT_MISSING : BCF_INT_VECTOR_END);
+    }
+    case BCF_TYPE::INT16: {
+        const unsigned char* u(reinterpret_cast<const unsigned char*>(data+(i*2)));
+        const int16_t v(static_cast<int16_t>(u[0] | (u[1] << 8)));
+        if (v > -32767) return v;
+        return ((v == -32768) ? BCF_INT_MISSING : BCF_INT_VECTOR_END);
+    }
+    default:
+        return bcf_get_int32(data+(i*4));
+    }
+}
+
+/// float value bits i of a vector
+inline
+uint32_t
+bcf_get_float_bits(const char* data,
+                   const unsigned i) {
+    return bcf_get_uint32(data+(i*4));
+}
+
+inline
+float
+bcf_bits_to_float(const uint32_t bits) {
+    float val;
+    memcpy(&val,&bits,sizeof(val));
+    return val;
+}
+/// @}
+
+#endif
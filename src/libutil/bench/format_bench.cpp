@@ -0,0 +1,130 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+/// \file
+///
+/// microbenchmark of the format_util integer and fixed-precision formatters
+///
+/// usage: format_bench
+///
+/// A fixed pseudo-random mix of small sample values (GQX, DP, MQ) and
+/// chromosome positions is formatted as integers, and values with two
+/// decimal digits as fixed-precision doubles. Each set is formatted
+/// repeatedly by snprintf and by format_util, and the rate is reported in
+/// millions of values per second.
+///
+
+#include "format_util.hh"
+
+#include <sys/time.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <iostream>
+#include <vector>
+
+
+static
+double
+get_time() {
+    timeval tv;
+    gettimeofday(&tv,NULL);
+    return tv.tv_sec+(tv.tv_usec*1e-6);
+}
+
+
+
+struct orig_int {
+    char* operator()(const long val, char* buf) const {
+        return buf+snprintf(buf,MAX_INT_FORMAT_SIZE,"%ld",val);
+    }
+};
+
+struct orig_fixed {
+    char* operator()(const double val, char* buf) const {
+        return buf+snprintf(buf,MAX_FIXED_FORMAT_SIZE,"%.2f",val);
+    }
+};
+
+struct util_int {
+    char* operator()(const long val, char* buf) const {
+        return format_int(val,buf);
+    }
+};
+
+struct util_fixed {
+    char* operator()(const double val, char* buf) const {
+        return format_fixed(val,2,buf);
+    }
+};
+
+
+
+template <typename T, typename F>
+static
+void
+run_bench(const char* label,
+          F formatter,
+          const std::vector<T>& vals,
+          const unsigned repeat) {
+
+    char buf[MAX_FIXED_FORMAT_SIZE];
+    unsigned long sum(0);
+    const double start(get_time());
+    const unsigned n_vals(vals.size());
+    for (unsigned r(0); r<repeat; ++r) {
+        for (unsigned i(0); i<n_vals; ++i) {
+            sum += (formatter(vals[i],buf)-buf);
+        }
+    }
+    const double total_time(get_time()-start);
+    const double mvals((static_cast<double>(n_vals)*repeat)/1e6);
+    std::cout << label << "\t" << (mvals/total_time) << " Mvals/s"
+              << "\ttime: " << total_time << "s\tchecksum: " << sum << "\n";
+}
+
+
+
+int
+main() {
+
+    static const unsigned n_vals(1000000);
+    static const unsigned repeat(50);
+
+    srand(1);
+    std::vector<long> int_vals(n_vals);
+    std::vector<double> fixed_vals(n_vals);
+    for (unsigned i(0); i<n_vals; ++i) {
+        int_vals[i] = (0 == (i%4)) ? (rand() % 250000000) : (rand() % 100);
+        fixed_vals[i] = (rand() % 1000000)/100.;
+    }
+
+    run_bench("snprintf int",orig_int(),int_vals,repeat);
+    run_bench("format_int",util_int(),int_vals,repeat);
+    run_bench("snprintf %.2f",orig_fixed(),fixed_vals,repeat);
+    run_bench("format_fixed",util_fixed(),fixed_vals,repeat);
+}
@@ -0,0 +1,141 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+/// \file
+///
+/// microbenchmark of the fd and istream line splitters
+///
+/// usage: line_splitter_bench file.vcf
+///
+/// file.vcf is split into lines and words repeatedly by each line
+/// splitter, and the throughput of each is reported in MB/s. The file
+/// should fit in the page cache, so that the splitters rather than the
+/// disk are measured.
+///
+
+#include "fd_line_splitter.hh"
+#include "istream_line_splitter.hh"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cstdlib>
+
+#include <fstream>
+#include <iostream>
+
+
+static
+double
+get_time() {
+    timeval tv;
+    gettimeofday(&tv,NULL);
+    return tv.tv_sec+(tv.tv_usec*1e-6);
+}
+
+
+
+static
+unsigned long
+split_all(line_splitter& dparse) {
+    unsigned long word_count(0);
+    while (dparse.parse_line()) word_count += dparse.n_word();
+    return word_count;
+}
+
+
+
+static
+unsigned long
+split_istream(const char* filename) {
+    std::ifstream ifs(filename);
+    istream_line_splitter dparse(ifs);
+    return split_all(dparse);
+}
+
+
+
+static
+unsigned long
+split_fd(const char* filename) {
+    const int fd(open(filename,O_RDONLY));
+    if (fd<0) {
+        std::cerr << "ERROR: can't open file: " << filename << "\n";
+        exit(EXIT_FAILURE);
+    }
+    fd_line_splitter dparse(fd,fd_line_splitter::DEFAULT_CHUNK_SIZE,'\t',0,true);
+    return split_all(dparse);
+}
+
+
+
+static
+void
+run_bench(const char* label,
+          unsigned long (*split)(const char*),
+          const char* filename,
+          const size_t file_size,
+          const unsigned repeat) {
+
+    unsigned long word_count(0);
+    const double start(get_time());
+    for (unsigned r(0); r<repeat; ++r) word_count += split(filename);
+    const double total_time(get_time()-start);
+    const double mbytes((static_cast<double>(file_size)*repeat)/(1024.*1024.));
+    std::cout << label << "\t" << (mbytes/total_time) << " MB/s"
+              << "\ttime: " << total_time << "s\twords: " << word_count << "\n";
+}
+
+
+
+int
+main(int argc,char* argv[]) {
+
+    if (argc != 2) {
+        std::cerr << "usage: " << argv[0] << " file.vcf\n";
+        exit(EXIT_FAILURE);
+    }
+    const char* filename(argv[1]);
+
+    struct stat st;
+    if ((0 != stat(filename,&st)) || (! S_ISREG(st.st_mode)) || (0 == st.st_size)) {
+        std::cerr << "ERROR: input must be a non-empty regular file: " << filename << "\n";
+        exit(EXIT_FAILURE);
+    }
+    const size_t file_size(st.st_size);
+
+    // repeat the input to split approximately 1GB per splitter:
+    const unsigned repeat(1+((1024u*1024u*1024u)/file_size));
+
+    std::cout << "bytes: " << file_size << "\trepeat: " << repeat << "\n";
+
+    // warm the page cache:
+    split_fd(filename);
+
+    run_bench("istream_line_splitter",split_istream,filename,file_size,repeat);
+    run_bench("fd_line_splitter",split_fd,filename,file_size,repeat);
+}
@@ -0,0 +1,184 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+/// \file
+///
+/// microbenchmark of the parse_util numeric parsers
+///
+/// usage: parse_bench [file.vcf]
+///
+/// vcf input is read from file.vcf, or from stdin if no file is given.
+///
+/// POS values are collected from each vcf record as integer input, and
+/// QUAL plus all numeric INFO and SAMPLE values as floating point input.
+/// Each set is parsed repeatedly by the original library calls
+/// (strtoul/boost::spirit) and by parse_util, and the parse rate is
+/// reported in millions of values per second.
+///
+
+#include "parse_util.hh"
+#include "string_util.hh"
+
+#include "boost/spirit/include/qi.hpp"
+
+#include <sys/time.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+static
+double
+get_time() {
+    timeval tv;
+    gettimeofday(&tv,NULL);
+    return tv.tv_sec+(tv.tv_usec*1e-6);
+}
+
+
+
+// collect all values from a delimited vcf field which start like a number:
+static
+void
+add_numeric_values(const std::string& field,
+                   const char* delimiters,
+                   std::vector<std::string>& vals) {
+    size_t start(0);
+    while (start <= field.size()) {
+        size_t end(field.find_first_of(delimiters,start));
+        if (end == std::string::npos) end=field.size();
+        std::string val(field.substr(start,end-start));
+        const size_t eq(val.find('='));
+        if (eq != std::string::npos) val=val.substr(eq+1);
+        if ((! val.empty()) && (isdigit(val[0]) || ((val[0]=='-') && (val.size()>1)))) {
+            vals.push_back(val);
+        }
+        start=end+1;
+    }
+}
+
+
+
+struct orig_unsigned {
+    double operator()(const char* s) const {
+        return strtoul(s,NULL,10);
+    }
+};
+
+struct orig_double {
+    double operator()(const char* s) const {
+        const char* s_end(s+strlen(s));
+        double val(0);
+        boost::spirit::qi::parse(s,s_end,boost::spirit::double_,val);
+        return val;
+    }
+};
+
+struct util_unsigned {
+    double operator()(const char* s) const {
+        return parse_unsigned(s);
+    }
+};
+
+struct util_double {
+    double operator()(const char* s) const {
+        return parse_double(s);
+    }
+};
+
+
+
+template <typename F>
+static
+void
+run_bench(const char* label,
+          F parser,
+          const std::vector<std::string>& vals,
+          const unsigned repeat) {
+
+    double sum(0);
+    const double start(get_time());
+    const unsigned n_vals(vals.size());
+    for (unsigned r(0); r<repeat; ++r) {
+        for (unsigned i(0); i<n_vals; ++i) {
+            sum += parser(vals[i].c_str());
+        }
+    }
+    const double total_time(get_time()-start);
+    const double mvals((static_cast<double>(n_vals)*repeat)/1e6);
+    std::cout << label << "\t" << (mvals/total_time) << " Mvals/s"
+              << "\ttime: " << total_time << "s\tchecksum: " << sum << "\n";
+}
+
+
+
+int
+main(int argc,char* argv[]) {
+
+    std::ifstream ifs;
+    if (argc>1) {
+        ifs.open(argv[1]);
+        if (! ifs) {
+            std::cerr << "ERROR: can't open file: " << argv[1] << "\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+    std::istream& is(argc>1 ? ifs : std::cin);
+
+    std::vector<std::string> int_vals;
+    std::vector<std::string> float_vals;
+    std::string line;
+    std::vector<std::string> word;
+    while (std::getline(is,line)) {
+        if (line.empty() || (line[0] == '#')) continue;
+        split_string(line,'\t',word);
+        if (word.size() < 10) continue;
+        int_vals.push_back(word[1]);
+        add_numeric_values(word[5],"",float_vals);
+        add_numeric_values(word[7],";,",float_vals);
+        add_numeric_values(word[9],":,",float_vals);
+    }
+    if (int_vals.empty()) {
+        std::cerr << "ERROR: no input records\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // repeat the input to parse approximately 100M values of each type:
+    const unsigned int_repeat(1+(100000000u/int_vals.size()));
+    const unsigned float_repeat(1+(100000000u/float_vals.size()));
+
+    std::cout << "integer values: " << int_vals.size() << "\tfloat values: " << float_vals.size() << "\n";
+
+    run_bench("strtoul",orig_unsigned(),int_vals,int_repeat);
+    run_bench("parse_unsigned",util_unsigned(),int_vals,int_repeat);
+    run_bench("spirit double",orig_double(),float_vals,float_repeat);
+    run_bench("parse_double",util_double(),float_vals,float_repeat);
+}
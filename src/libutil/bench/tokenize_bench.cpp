@@ -0,0 +1,185 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+/// \file
+///
+/// microbenchmark of the line tokenizer implementations
+///
+/// usage: tokenize_bench [file.vcf]
+///
+/// vcf input is read from file.vcf, or from stdin if no file is given.
+///
+/// each input line is tokenized repeatedly by the original byte-at-a-time
+/// loop and by each tokenizer implementation supported on this cpu, and
+/// the throughput of each is reported in MB/s.
+///
+
+#include "tokenize_util.hh"
+
+#include <sys/time.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+enum { MAX_WORD = 50 };
+
+
+static
+double
+get_time() {
+    timeval tv;
+    gettimeofday(&tv,NULL);
+    return tv.tv_sec+(tv.tv_usec*1e-6);
+}
+
+
+
+// the tokenizer loop used before tokenize_util was introduced:
+static
+unsigned
+tokenize_line_orig(char* p,
+                   const char sep,
+                   char** word,
+                   const unsigned max_word) {
+    word[0]=p;
+    unsigned i(1);
+    while (i<max_word) {
+        if ((*p == '\n') || (*p == '\0')) break;
+        if (*p == sep) {
+            *p = '\0';
+            word[i++] = p+1;
+        }
+        ++p;
+    }
+    return i;
+}
+
+
+
+struct line_store {
+
+    void
+    add(const std::string& line) {
+        offset.push_back(data.size());
+        data.insert(data.end(),line.begin(),line.end());
+        data.push_back('\0');
+    }
+
+    void
+    reset() {
+        // restore separators removed by the last tokenization:
+        work=data;
+    }
+
+    std::vector<char> data;
+    std::vector<char> work;
+    std::vector<unsigned> offset;
+};
+
+
+
+template <typename F>
+static
+void
+run_bench(const char* label,
+          F tokenizer,
+          line_store& ls,
+          const unsigned repeat) {
+
+    char* word[MAX_WORD];
+    unsigned long word_count(0);
+    double total_time(0);
+    for (unsigned r(0); r<repeat; ++r) {
+        ls.reset();
+        const double start(get_time());
+        const unsigned n_lines(ls.offset.size());
+        for (unsigned i(0); i<n_lines; ++i) {
+            word_count += tokenizer(&(ls.work[ls.offset[i]]),'\t',word,MAX_WORD);
+        }
+        total_time += (get_time()-start);
+    }
+    const double mbytes((static_cast<double>(ls.data.size())*repeat)/(1024.*1024.));
+    std::cout << label << "\t" << (mbytes/total_time) << " MB/s"
+              << "\ttime: " << total_time << "s\twords: " << word_count << "\n";
+}
+
+
+
+struct impl_tokenizer {
+    impl_tokenizer(const tokenize_impl_t impl) : _impl(impl) {}
+
+    unsigned
+    operator()(char* line, const char sep, char** word, const unsigned max_word) const {
+        return tokenize_line(_impl,line,sep,word,max_word);
+    }
+
+private:
+    tokenize_impl_t _impl;
+};
+
+
+
+int
+main(int argc,char* argv[]) {
+
+    std::ifstream ifs;
+    if (argc>1) {
+        ifs.open(argv[1]);
+        if (! ifs) {
+            std::cerr << "ERROR: can't open file: " << argv[1] << "\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+    std::istream& is(argc>1 ? ifs : std::cin);
+
+    line_store ls;
+    std::string line;
+    while (std::getline(is,line)) {
+        ls.add(line);
+    }
+    if (ls.data.empty()) {
+        std::cerr << "ERROR: no input lines\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // repeat the input to tokenize approximately 1GB per implementation:
+    const unsigned repeat(1+((1024u*1024u*1024u)/ls.data.size()));
+
+    std::cout << "lines: " << ls.offset.size() << "\tbytes: " << ls.data.size() << "\trepeat: " << repeat << "\n";
+    std::cout << "selected implementation: " << get_tokenize_impl_label(get_tokenize_impl()) << "\n";
+
+    run_bench("original",tokenize_line_orig,ls,repeat);
+    for (unsigned i(0); i<TOKENIZE_IMPL_SIZE; ++i) {
+        const tokenize_impl_t impl(static_cast<tokenize_impl_t>(i));
+        if (! is_tokenize_impl_supported(impl)) continue;
+        run_bench(get_tokenize_impl_label(impl),impl_tokenizer(impl),ls,repeat);
+    }
+}
@@ -0,0 +1,71 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// interface for indexes built from BGZF blocks as they are written
+///
+
+#ifndef __BGZF_BLOCK_INDEX_HH
+#define __BGZF_BLOCK_INDEX_HH
+
+#include <stdint.h>
+
+#include <string>
+
+
+/// an index built incrementally from the uncompressed contents of each
+/// BGZF block of a file, in file order
+///
+struct bgzf_block_index {
+
+    virtual ~bgzf_block_index() {}
+
+    /// add the uncompressed contents of the next BGZF block
+    ///
+    /// \param block_address file offset of the compressed block
+    /// \param next_block_address file offset of the following block
+    ///
+    virtual
+    void
+    add_block(const char* data,
+              const unsigned size,
+              const uint64_t block_address,
+              const uint64_t next_block_address) = 0;
+
+    /// complete the index after the final block, and write it to the
+    /// (BGZF compressed) index file
+    virtual
+    void
+    write(const std::string& filename) = 0;
+
+    /// suffix added to the indexed file name to form the index file name
+    virtual
+    const char*
+    file_suffix() const = 0;
+};
+
+#endif
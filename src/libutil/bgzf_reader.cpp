@@ -0,0 +1,382 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// compressed input reader with parallel BGZF block decompression
+///
+
+#include "bgzf_reader.hh"
+#include "blt_exception.hh"
+
+#include "bgzf.h"
+#include "zlib.h"
+
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include <algorithm>
+#include <sstream>
+
+
+
+enum {
+    BGZF_HEADER_SIZE = 18,
+    BGZF_FOOTER_SIZE = 8,
+    RAW_BUFFER_SIZE = 4*1024*1024,
+    BLOCKS_PER_WORKER = 8
+};
+
+
+
+static
+unsigned
+unpack_uint16(const unsigned char* b) {
+    return (b[0] | (b[1] << 8));
+}
+
+static
+unsigned
+unpack_uint32(const unsigned char* b) {
+    return (b[0] | (b[1] << 8) | (b[2] << 16) | (static_cast<unsigned>(b[3]) << 24));
+}
+
+
+
+/// a single BGZF block, loaded by the reader and inflated on a pool thread
+///
+struct bgzf_block_task : public thread_task {
+
+    bgzf_block_task()
+        : is_loaded(false)
+        , compressed(BGZF_BLOCK_SIZE)
+        , compressed_size(0)
+        , block_no(0)
+        , data(BGZF_BLOCK_SIZE)
+        , data_size(0)
+    {}
+
+    void
+    run() {
+        const unsigned char* footer(reinterpret_cast<const unsigned char*>(&(compressed[compressed_size-BGZF_FOOTER_SIZE])));
+        const unsigned expect_size(unpack_uint32(footer+4));
+
+        z_stream zs;
+        zs.zalloc = NULL;
+        zs.zfree = NULL;
+        zs.opaque = NULL;
+        zs.next_in = reinterpret_cast<Bytef*>(&(compressed[BGZF_HEADER_SIZE]));
+        zs.avail_in = compressed_size-(BGZF_HEADER_SIZE+BGZF_FOOTER_SIZE);
+        zs.next_out = reinterpret_cast<Bytef*>(&(data[0]));
+        zs.avail_out = data.size();
+
+        if (inflateInit2(&zs,-15) != Z_OK) {
+            throw blt_exception("ERROR: failed to initialize zlib inflate\n");
+        }
+        const int ret(inflate(&zs,Z_FINISH));
+        inflateEnd(&zs);
+        if ((Z_STREAM_END != ret) || (zs.total_out != expect_size)) {
+            std::ostringstream oss;
+            oss << "ERROR: failed to inflate BGZF block number " << block_no << "\n";
+            throw blt_exception(oss.str().c_str());
+        }
+        data_size=zs.total_out;
+    }
+
+    bool is_loaded;
+    std::vector<char> compressed;
+    unsigned compressed_size;
+    unsigned long block_no;
+    std::vector<char> data;
+    unsigned data_size;
+};
+
+
+
+bgzf_reader::
+bgzf_reader(const int fd,
+            const unsigned worker_count,
+            const bool is_close_fd)
+    : _fd(fd)
+    , _is_close_fd(is_close_fd)
+    , _format(PLAIN)
+    , _raw(RAW_BUFFER_SIZE)
+    , _raw_start(0)
+    , _raw_end(0)
+    , _is_raw_eof(false)
+    , _zs(NULL)
+    , _is_gzip_eof(false)
+    , _head(0)
+    , _head_offset(0)
+    , _block_count(0)
+{
+    while ((_raw_end < BGZF_HEADER_SIZE) && fill_raw()) {}
+
+    const unsigned char* h(reinterpret_cast<const unsigned char*>(&(_raw[0])));
+    if (is_bgzf_header(h,_raw_end)) {
+        _format=BGZF;
+        _pool.reset(new thread_pool(worker_count));
+        const unsigned block_count(std::max(2u,worker_count*BLOCKS_PER_WORKER));
+        for (unsigned i(0); i<block_count; ++i) {
+            _blocks.push_back(new bgzf_block_task());
+        }
+        for (unsigned i(0); i<block_count; ++i) {
+            if (! load_block(*_blocks[i])) break;
+        }
+    } else if (is_gzip_header(h,_raw_end)) {
+        _format=GZIP;
+        _zs=new z_stream;
+        _zs->zalloc = NULL;
+        _zs->zfree = NULL;
+        _zs->opaque = NULL;
+        _zs->next_in = NULL;
+        _zs->avail_in = 0;
+        if (inflateInit2(_zs,16+MAX_WBITS) != Z_OK) {
+            throw blt_exception("ERROR: failed to initialize zlib inflate\n");
+        }
+    }
+}
+
+
+
+bgzf_reader::
+~bgzf_reader() {
+    // complete any running inflate tasks before releasing blocks:
+    _pool.reset();
+    for (unsigned i(0); i<_blocks.size(); ++i) {
+        delete _blocks[i];
+    }
+    if (NULL != _zs) {
+        inflateEnd(_zs);
+        delete _zs;
+    }
+    if (_is_close_fd) close(_fd);
+}
+
+
+
+bool
+bgzf_reader::
+is_bgzf_header(const unsigned char* h,
+               const size_t size) {
+    return ((size >= BGZF_HEADER_SIZE) &&
+            (h[0] == 31) && (h[1] == 139) && (h[2] == 8) && ((h[3] & 4) != 0) &&
+            (unpack_uint16(h+10) == 6) &&
+            (h[12] == 'B') && (h[13] == 'C') &&
+            (unpack_uint16(h+14) == 2));
+}
+
+
+
+bool
+bgzf_reader::
+is_gzip_header(const unsigned char* h,
+               const size_t size) {
+    return ((size >= 2) && (h[0] == 31) && (h[1] == 139));
+}
+
+
+
+bool
+bgzf_reader::
+fill_raw() {
+    if (_is_raw_eof) return false;
+
+    if (_raw_start>0) {
+        const size_t len(_raw_end-_raw_start);
+        if (len>0) memmove(&(_raw[0]),&(_raw[_raw_start]),len);
+        _raw_start=0;
+        _raw_end=len;
+    }
+    assert(_raw_end < _raw.size());
+
+    while (true) {
+        const ssize_t ret(::read(_fd,&(_raw[_raw_end]),_raw.size()-_raw_end));
+        if (ret > 0) {
+            _raw_end += ret;
+            return true;
+        }
+        if (0 == ret) break;
+        if (EINTR == errno) continue;
+
+        std::ostringstream oss;
+        oss << "ERROR: unexpected failure while reading input: " << strerror(errno) << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+    _is_raw_eof=true;
+    return false;
+}
+
+
+
+size_t
+bgzf_reader::
+read_raw(char* buf,
+         const size_t size) {
+    size_t total(0);
+    while (total<size) {
+        if ((_raw_start == _raw_end) && (! fill_raw())) break;
+        const size_t len(std::min(size-total,_raw_end-_raw_start));
+        memcpy(buf+total,&(_raw[_raw_start]),len);
+        _raw_start += len;
+        total += len;
+    }
+    return total;
+}
+
+
+
+size_t
+bgzf_reader::
+read(char* buf,
+     const size_t size) {
+    if (BGZF == _format) return read_bgzf(buf,size);
+    if (GZIP == _format) return read_gzip(buf,size);
+
+    if (_raw_start < _raw_end) return read_raw(buf,std::min(size,_raw_end-_raw_start));
+    if (_is_raw_eof) return 0;
+
+    // plain input beyond the format detection bytes is read directly:
+    while (true) {
+        const ssize_t ret(::read(_fd,buf,size));
+        if (ret >= 0) {
+            if (0 == ret) _is_raw_eof=true;
+            return ret;
+        }
+        if (EINTR == errno) continue;
+
+        std::ostringstream oss;
+        oss << "ERROR: unexpected failure while reading input: " << strerror(errno) << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+}
+
+
+
+size_t
+bgzf_reader::
+read_gzip(char* buf,
+          const size_t size) {
+    if (_is_gzip_eof) return 0;
+
+    _zs->next_out = reinterpret_cast<Bytef*>(buf);
+    _zs->avail_out = size;
+    while (_zs->avail_out == size) {
+        if ((_raw_start == _raw_end) && (! fill_raw())) {
+            throw blt_exception("ERROR: unexpected end of gzip compressed input\n");
+        }
+        _zs->next_in = reinterpret_cast<Bytef*>(&(_raw[_raw_start]));
+        _zs->avail_in = _raw_end-_raw_start;
+        const int ret(inflate(_zs,Z_NO_FLUSH));
+        _raw_start = _raw_end-_zs->avail_in;
+
+        if (Z_STREAM_END == ret) {
+            // continue through concatenated gzip members:
+            if ((_raw_start == _raw_end) && (! fill_raw())) {
+                _is_gzip_eof=true;
+                break;
+            }
+            inflateReset(_zs);
+        } else if ((Z_OK != ret) && (Z_BUF_ERROR != ret)) {
+            std::ostringstream oss;
+            oss << "ERROR: failed to inflate gzip compressed input";
+            if (NULL != _zs->msg) oss << ": " << _zs->msg;
+            oss << "\n";
+            throw blt_exception(oss.str().c_str());
+        }
+    }
+    return size-_zs->avail_out;
+}
+
+
+
+bool
+bgzf_reader::
+load_block(bgzf_block_task& block) {
+    assert(! block.is_loaded);
+
+    unsigned char* h(reinterpret_cast<unsigned char*>(&(block.compressed[0])));
+    const size_t header_size(read_raw(&(block.compressed[0]),BGZF_HEADER_SIZE));
+    if (0 == header_size) return false;
+
+    _block_count++;
+    if (! is_bgzf_header(h,header_size)) {
+        std::ostringstream oss;
+        oss << "ERROR: invalid BGZF block header in block number " << _block_count << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+    const unsigned block_size(unpack_uint16(h+16)+1);
+    if (block_size < (BGZF_HEADER_SIZE+BGZF_FOOTER_SIZE)) {
+        std::ostringstream oss;
+        oss << "ERROR: invalid BGZF block size in block number " << _block_count << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+    const size_t remaining(block_size-BGZF_HEADER_SIZE);
+    if (read_raw(&(block.compressed[BGZF_HEADER_SIZE]),remaining) != remaining) {
+        std::ostringstream oss;
+        oss << "ERROR: unexpected end of input in BGZF block number " << _block_count << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+
+    block.compressed_size=block_size;
+    block.block_no=_block_count;
+    block.data_size=0;
+    block.is_loaded=true;
+    _pool->submit(block);
+    return true;
+}
+
+
+
+size_t
+bgzf_reader::
+read_bgzf(char* buf,
+          const size_t size) {
+    size_t total(0);
+    while (total<size) {
+        bgzf_block_task& block(*_blocks[_head]);
+        if (! block.is_loaded) break;
+        block.wait();
+
+        const size_t len(std::min(size-total,block.data_size-_head_offset));
+        memcpy(buf+total,&(block.data[_head_offset]),len);
+        _head_offset += len;
+        total += len;
+
+        if (_head_offset < block.data_size) break;
+
+        // recycle the consumed block for the next input block:
+        block.is_loaded=false;
+        _head_offset=0;
+        const unsigned tail(_head);
+        _head=(_head+1)%_blocks.size();
+        load_block(*_blocks[tail]);
+    }
+    return total;
+}
@@ -0,0 +1,138 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// compressed input reader with parallel BGZF block decompression
+///
+
+#ifndef __BGZF_READER_HH
+#define __BGZF_READER_HH
+
+#include "byte_source.hh"
+#include "thread_util.hh"
+
+#include <memory>
+#include <vector>
+
+
+struct bgzf_block_task;
+struct z_stream_s;
+
+
+/// reads plain, gzip or BGZF compressed input from a file descriptor
+///
+/// The input format is detected from the leading bytes of the input.
+/// BGZF blocks are inflated on a pool of worker threads, several blocks
+/// ahead of the consumer, and returned in input order. Other gzip input
+/// is inflated on the calling thread with zlib, and plain input is passed
+/// through unchanged.
+///
+struct bgzf_reader : public byte_source {
+
+    enum format_t {
+        PLAIN,
+        GZIP,
+        BGZF
+    };
+
+    /// \param worker_count number of BGZF inflate threads, zero to inflate
+    ///                     blocks on the calling thread
+    ///
+    bgzf_reader(const int fd,
+                const unsigned worker_count,
+                const bool is_close_fd = false);
+
+    ~bgzf_reader();
+
+    size_t
+    read(char* buf,
+         const size_t size);
+
+    format_t
+    format() const { return _format; }
+
+    /// true if the bytes start with a BGZF block header
+    static
+    bool
+    is_bgzf_header(const unsigned char* h,
+                   const size_t size);
+
+    /// true if the bytes start with a gzip member header
+    static
+    bool
+    is_gzip_header(const unsigned char* h,
+                   const size_t size);
+
+private:
+    bgzf_reader(const bgzf_reader&);
+    bgzf_reader& operator=(const bgzf_reader&);
+
+    // add input to the raw buffer, returns false at end of file
+    bool
+    fill_raw();
+
+    // copy up to size buffered bytes, refilling the raw buffer as needed
+    size_t
+    read_raw(char* buf,
+             const size_t size);
+
+    size_t
+    read_gzip(char* buf,
+              const size_t size);
+
+    size_t
+    read_bgzf(char* buf,
+              const size_t size);
+
+    // read the next compressed block and submit it for inflation,
+    // returns false at end of input
+    bool
+    load_block(bgzf_block_task& block);
+
+    int _fd;
+    bool _is_close_fd;
+    format_t _format;
+
+    // undecoded input is [_raw_start,_raw_end) in _raw
+    std::vector<char> _raw;
+    size_t _raw_start;
+    size_t _raw_end;
+    bool _is_raw_eof;
+
+    // gzip state:
+    z_stream_s* _zs;
+    bool _is_gzip_eof;
+
+    // bgzf state: ring of blocks loaded in input order starting from _head
+    std::auto_ptr<thread_pool> _pool;
+    std::vector<bgzf_block_task*> _blocks;
+    unsigned _head;
+    size_t _head_offset;
+    unsigned long _block_count;
+};
+
+#endif
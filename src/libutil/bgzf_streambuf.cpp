@@ -0,0 +1,403 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// stream buffer writing BGZF compressed output with parallel block compression
+///
+
+#include "bgzf_streambuf.hh"
+#include "blt_exception.hh"
+#include "tabix_index_builder.hh"
+
+#include "bgzf.h"
+#include "zlib.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+
+
+enum {
+    BGZF_HEADER_SIZE = 18,
+    BGZF_FOOTER_SIZE = 8,
+    BLOCKS_PER_WORKER = 4
+};
+
+// block header as written by the redist tabix bgzf writer, the final two
+// bytes are replaced by the block size:
+static const unsigned char bgzf_magic[BGZF_HEADER_SIZE] = {
+    31, 139, 8, 4, 0, 0, 0, 0, 0, 255, 6, 0, 'B', 'C', 2, 0, 0, 0
+};
+
+
+
+static
+void
+pack_uint16(unsigned char* b,
+            const unsigned x) {
+    b[0] = x & 0xff;
+    b[1] = (x >> 8) & 0xff;
+}
+
+static
+void
+pack_uint32(unsigned char* b,
+            const unsigned x) {
+    b[0] = x & 0xff;
+    b[1] = (x >> 8) & 0xff;
+    b[2] = (x >> 16) & 0xff;
+    b[3] = (x >> 24) & 0xff;
+}
+
+
+
+/// a single block of uncompressed output, deflated on a pool thread
+///
+/// if the data do not compress into a single BGZF block, the input is
+/// reduced by 1k steps as in the tabix bgzf writer and the remainder
+/// is written as additional blocks
+///
+struct bgzf_compress_task : public thread_task {
+
+    bgzf_compress_task()
+        : is_submitted(false)
+        , data(BGZF_BLOCK_SIZE)
+        , size(0)
+    {}
+
+    void
+    run() {
+        compressed.clear();
+        sub_blocks.clear();
+        unsigned pos(0);
+        do {
+            pos += deflate_block(pos);
+        } while (pos<size);
+    }
+
+    bool is_submitted;
+    std::vector<char> data;
+    unsigned size;
+
+    std::vector<unsigned char> compressed;
+
+    // uncompressed and compressed size of each BGZF block in compressed:
+    std::vector<std::pair<unsigned,unsigned> > sub_blocks;
+
+private:
+
+    // deflate one BGZF block from data starting at pos, return the
+    // number of input bytes consumed
+    unsigned
+    deflate_block(const unsigned pos) {
+        const unsigned block_start(compressed.size());
+        compressed.resize(block_start+BGZF_BLOCK_SIZE);
+        unsigned char* buffer(&(compressed[block_start]));
+        memcpy(buffer,bgzf_magic,BGZF_HEADER_SIZE);
+
+        unsigned input_length(size-pos);
+        unsigned compressed_length(0);
+        while (true) {
+            z_stream zs;
+            zs.zalloc = NULL;
+            zs.zfree = NULL;
+            zs.opaque = NULL;
+            zs.next_in = reinterpret_cast<Bytef*>(&(data[pos]));
+            zs.avail_in = input_length;
+            zs.next_out = buffer+BGZF_HEADER_SIZE;
+            zs.avail_out = BGZF_BLOCK_SIZE-(BGZF_HEADER_SIZE+BGZF_FOOTER_SIZE);
+            if (deflateInit2(&zs,Z_DEFAULT_COMPRESSION,Z_DEFLATED,-15,8,Z_DEFAULT_STRATEGY) != Z_OK) {
+                throw blt_exception("ERROR: failed to initialize zlib deflate\n");
+            }
+            const int status(deflate(&zs,Z_FINISH));
+            deflateEnd(&zs);
+            if (Z_STREAM_END == status) {
+                compressed_length = zs.total_out+BGZF_HEADER_SIZE+BGZF_FOOTER_SIZE;
+                break;
+            }
+            if ((Z_OK != status) || (input_length <= 1024)) {
+                throw blt_exception("ERROR: failed to deflate BGZF block\n");
+            }
+            // not compressed enough, reduce the input size and retry:
+            input_length -= 1024;
+        }
+
+        pack_uint16(buffer+16,compressed_length-1);
+        uLong crc(crc32(0L,NULL,0L));
+        crc = crc32(crc,reinterpret_cast<const Bytef*>(&(data[pos])),input_length);
+        pack_uint32(buffer+compressed_length-8,crc);
+        pack_uint32(buffer+compressed_length-4,input_length);
+
+        compressed.resize(block_start+compressed_length);
+        sub_blocks.push_back(std::make_pair(input_length,compressed_length));
+        return input_length;
+    }
+};
+
+
+
+bgzf_streambuf::
+bgzf_streambuf(const std::string& filename,
+               const unsigned worker_count,
+               const bool is_index)
+    : _filename(filename)
+    , _fd(-1)
+    , _is_close_fd(true)
+    , _is_closed(false)
+    , _file_offset(0)
+    , _head(0)
+{
+    if (is_index) _index.reset(new tabix_index_builder());
+    open_file();
+    init_blocks(worker_count);
+}
+
+
+
+bgzf_streambuf::
+bgzf_streambuf(const std::string& filename,
+               const unsigned worker_count,
+               std::auto_ptr<bgzf_block_index> index)
+    : _filename(filename)
+    , _fd(-1)
+    , _is_close_fd(true)
+    , _is_closed(false)
+    , _file_offset(0)
+    , _index(index)
+    , _head(0)
+{
+    open_file();
+    init_blocks(worker_count);
+}
+
+
+
+bgzf_streambuf::
+bgzf_streambuf(const int fd,
+               const unsigned worker_count)
+    : _filename("standard output")
+    , _fd(fd)
+    , _is_close_fd(false)
+    , _is_closed(false)
+    , _file_offset(0)
+    , _head(0)
+{
+    init_blocks(worker_count);
+}
+
+
+
+void
+bgzf_streambuf::
+open_file() {
+    _fd=open(_filename.c_str(),O_WRONLY|O_CREAT|O_TRUNC,0666);
+    if (_fd<0) {
+        std::ostringstream oss;
+        oss << "ERROR: can't open output file: '" << _filename << "': " << strerror(errno) << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+}
+
+
+
+void
+bgzf_streambuf::
+init_blocks(const unsigned worker_count) {
+    _pool.reset(new thread_pool(worker_count));
+    const unsigned block_count(std::max(2u,worker_count*BLOCKS_PER_WORKER));
+    for (unsigned i(0); i<block_count; ++i) {
+        _blocks.push_back(new bgzf_compress_task());
+    }
+    char* buf(&(_blocks[_head]->data[0]));
+    setp(buf,buf+BGZF_BLOCK_SIZE);
+}
+
+
+
+bgzf_streambuf::
+~bgzf_streambuf() {
+    // complete any running deflate tasks before releasing blocks:
+    _pool.reset();
+    for (unsigned i(0); i<_blocks.size(); ++i) {
+        delete _blocks[i];
+    }
+    if ((! _is_closed) && _is_close_fd && (_fd>=0)) ::close(_fd);
+}
+
+
+
+bgzf_streambuf::int_type
+bgzf_streambuf::
+overflow(int_type c) {
+    try {
+        submit_block();
+    } catch (const std::exception& e) {
+        _error=e.what();
+        return traits_type::eof();
+    }
+    if (traits_type::eq_int_type(c,traits_type::eof())) return traits_type::not_eof(c);
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+    return c;
+}
+
+
+
+void
+bgzf_streambuf::
+submit_block() {
+    bgzf_compress_task& block(*_blocks[_head]);
+    block.size=pptr()-pbase();
+    if (block.size>0) {
+        block.is_submitted=true;
+        _pool->submit(block);
+        _head=(_head+1)%_blocks.size();
+    }
+
+    // the next block in the ring is the oldest submitted block:
+    bgzf_compress_task& next(*_blocks[_head]);
+    if (next.is_submitted) write_block(next);
+    char* buf(&(next.data[0]));
+    setp(buf,buf+BGZF_BLOCK_SIZE);
+}
+
+
+
+void
+bgzf_streambuf::
+write_block(bgzf_compress_task& block) {
+    block.wait();
+    block.is_submitted=false;
+
+    write_data(reinterpret_cast<const char*>(&(block.compressed[0])),block.compressed.size());
+
+    unsigned upos(0);
+    for (unsigned i(0); i<block.sub_blocks.size(); ++i) {
+        const unsigned usize(block.sub_blocks[i].first);
+        const unsigned csize(block.sub_blocks[i].second);
+        if (NULL != _index.get()) {
+            _index->add_block(&(block.data[upos]),usize,_file_offset,_file_offset+csize);
+        }
+        upos += usize;
+        _file_offset += csize;
+    }
+}
+
+
+
+void
+bgzf_streambuf::
+write_data(const char* data,
+           const size_t size) {
+    size_t total(0);
+    while (total<size) {
+        const ssize_t ret(::write(_fd,data+total,size-total));
+        if (ret >= 0) {
+            total += ret;
+            continue;
+        }
+        if (EINTR == errno) continue;
+
+        std::ostringstream oss;
+        oss << "ERROR: failed to write output file: '" << _filename << "': " << strerror(errno) << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+}
+
+
+
+void
+bgzf_streambuf::
+close() {
+    if (_is_closed) return;
+    if (! _error.empty()) throw blt_exception(_error.c_str());
+
+    submit_block();
+    const unsigned block_count(_blocks.size());
+    for (unsigned i(0); i<block_count; ++i) {
+        bgzf_compress_task& block(*_blocks[(_head+i)%block_count]);
+        if (block.is_submitted) write_block(block);
+    }
+
+    // write the empty EOF marker block:
+    bgzf_compress_task eof_block;
+    eof_block.run();
+    write_block(eof_block);
+
+    _is_closed=true;
+    if (_is_close_fd && (0 != ::close(_fd))) {
+        std::ostringstream oss;
+        oss << "ERROR: failed to close output file: '" << _filename << "': " << strerror(errno) << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+
+    if (NULL != _index.get()) _index->write(_filename+_index->file_suffix());
+}
+
+
+
+bgzf_output_redirect::
+bgzf_output_redirect(output_buffer& ob,
+                     const std::string& filename,
+                     const unsigned worker_count,
+                     const bool is_index)
+    : _ob(ob)
+{
+    if (filename.empty()) return;
+    _buf.reset(new bgzf_streambuf(filename,worker_count,is_index));
+    _ob.set_sink(_buf.get());
+}
+
+
+
+bgzf_output_redirect::
+~bgzf_output_redirect() {
+    if (NULL == _buf.get()) return;
+
+    // detach the output buffer from the BGZF file before it is destroyed:
+    try {
+        _ob.set_sink(-1);
+    } catch (...) {}
+}
+
+
+
+void
+bgzf_output_redirect::
+close() {
+    _ob.flush();
+    if (NULL == _buf.get()) return;
+    _buf->close();
+}
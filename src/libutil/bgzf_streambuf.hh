@@ -0,0 +1,158 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// stream buffer writing BGZF compressed output with parallel block compression
+///
+
+#ifndef __BGZF_STREAMBUF_HH
+#define __BGZF_STREAMBUF_HH
+
+#include "bgzf_block_index.hh"
+#include "output_buffer.hh"
+#include "thread_util.hh"
+
+#include <stdint.h>
+
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+
+struct bgzf_compress_task;
+
+
+/// std::streambuf writing a BGZF file
+///
+/// Each full 64k block of output is deflated on a pool of worker threads,
+/// and compressed blocks are written to the file in order. Block
+/// boundaries and compression settings follow the redist tabix bgzf
+/// writer, so the output matches 'bgzip' for the same content.
+///
+/// If requested, a VCF tabix index (or any other bgzf_block_index) is
+/// built as each block is written and saved next to the file on close().
+///
+struct bgzf_streambuf : public std::streambuf {
+
+    /// \param worker_count number of deflate threads, zero to deflate
+    ///                     blocks on the calling thread
+    ///
+    bgzf_streambuf(const std::string& filename,
+                   const unsigned worker_count,
+                   const bool is_index = true);
+
+    /// write filename with a custom index, saved to filename plus the
+    /// index file suffix
+    bgzf_streambuf(const std::string& filename,
+                   const unsigned worker_count,
+                   std::auto_ptr<bgzf_block_index> index);
+
+    /// write to an open descriptor without an index. The descriptor is
+    /// not closed by this object
+    bgzf_streambuf(const int fd,
+                   const unsigned worker_count);
+
+    /// an unclosed file is left without an EOF marker or index
+    ~bgzf_streambuf();
+
+    /// write all remaining output, the BGZF EOF marker block and the
+    /// tabix index. Errors are thrown as blt_exception
+    void
+    close();
+
+protected:
+    int_type
+    overflow(int_type c);
+
+    // partial blocks are only written on close():
+    int
+    sync() { return 0; }
+
+private:
+    bgzf_streambuf(const bgzf_streambuf&);
+    bgzf_streambuf& operator=(const bgzf_streambuf&);
+
+    void
+    open_file();
+
+    void
+    init_blocks(const unsigned worker_count);
+
+    // submit the block in the put area and start the next block:
+    void
+    submit_block();
+
+    // wait for a submitted block and write it to the file:
+    void
+    write_block(bgzf_compress_task& block);
+
+    void
+    write_data(const char* data,
+               const size_t size);
+
+    std::string _filename;
+    std::string _error;
+    int _fd;
+    bool _is_close_fd;
+    bool _is_closed;
+    uint64_t _file_offset;
+    std::auto_ptr<bgzf_block_index> _index;
+
+    std::auto_ptr<thread_pool> _pool;
+    std::vector<bgzf_compress_task*> _blocks;
+    unsigned _head;
+};
+
+
+
+/// redirect an output_buffer to a new BGZF file for the lifetime of this object
+///
+/// no redirection is made if filename is empty
+///
+struct bgzf_output_redirect {
+
+    bgzf_output_redirect(output_buffer& ob,
+                         const std::string& filename,
+                         const unsigned worker_count,
+                         const bool is_index = true);
+
+    ~bgzf_output_redirect();
+
+    /// flush the output buffer and complete the BGZF file and index
+    void
+    close();
+
+private:
+    bgzf_output_redirect(const bgzf_output_redirect&);
+    bgzf_output_redirect& operator=(const bgzf_output_redirect&);
+
+    output_buffer& _ob;
+    std::auto_ptr<bgzf_streambuf> _buf;
+};
+
+#endif
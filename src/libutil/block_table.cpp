@@ -0,0 +1,559 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// columnar binary table of the gVCF record fields used by the multi-sample
+/// analysis tools
+///
+
+#include "blt_exception.hh"
+#include "block_table.hh"
+#include "parse_util.hh"
+#include "vcf_util.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+
+const char BLOCK_TABLE_MAGIC[BLOCK_TABLE_MAGIC_SIZE] = { 'G','V','B','T','\1','\0','\0','\0' };
+
+// the footer ends with the footer offset and a short magic:
+enum { TAIL_MAGIC_SIZE = 4,
+       TAIL_SIZE = 8+TAIL_MAGIC_SIZE
+     };
+
+
+
+static
+void
+check_byte_order() {
+    const uint32_t val(1);
+    if (1 != *reinterpret_cast<const unsigned char*>(&val)) {
+        throw blt_exception("ERROR: block tables are only supported on little-endian hosts\n");
+    }
+}
+
+
+
+// size of a column of n values of size elt, padded to 8 bytes:
+static
+uint64_t
+column_size(const uint64_t n,
+            const unsigned elt) {
+    return ((n*elt)+7) & ~static_cast<uint64_t>(7);
+}
+
+
+
+bool
+is_block_table_file(const std::string& filename) {
+    const int fd(open(filename.c_str(),O_RDONLY));
+    if (fd < 0) return false;
+    char h[BLOCK_TABLE_MAGIC_SIZE];
+    const ssize_t n(pread(fd,h,BLOCK_TABLE_MAGIC_SIZE,0));
+    close(fd);
+    return ((n == BLOCK_TABLE_MAGIC_SIZE) && (0 == memcmp(h,BLOCK_TABLE_MAGIC,TAIL_MAGIC_SIZE)));
+}
+
+
+
+// extract the END value from the vcf info field:
+static
+bool
+get_info_end(const char* info,
+             unsigned& val) {
+    while (true) {
+        if (0 == strncmp(info,"END=",4)) {
+            const char* s(info+4);
+            val=parse_unsigned(s);
+            return true;
+        }
+        info=strchr(info,';');
+        if (NULL == info) return false;
+        info++;
+    }
+}
+
+
+
+// return the FORMAT value for key, or NULL if it is absent or missing:
+static
+const char*
+get_format_value(const char* const* word,
+                 const char* key) {
+    const char* str(get_format_string_nocopy(word,key));
+    if ((NULL == str) || ('\0' == *str) || (':' == *str)) return NULL;
+    if (('.' == *str) && (('\0' == str[1]) || (':' == str[1]))) return NULL;
+    return str;
+}
+
+
+
+block_table_writer::
+block_table_writer(const std::string& filename)
+    : _filename(filename)
+    , _is_closed(false)
+    , _offset(0)
+    , _sample_name("UNKNOWN")
+{
+    check_byte_order();
+    _ofs.open(filename.c_str(),std::ios::binary);
+    if (! _ofs) {
+        std::ostringstream oss;
+        oss << "ERROR: can't open block table output file: '" << filename << "'\n";
+        throw blt_exception(oss.str().c_str());
+    }
+    write_bytes(BLOCK_TABLE_MAGIC,BLOCK_TABLE_MAGIC_SIZE);
+}
+
+
+
+block_table_writer::
+~block_table_writer() {}
+
+
+
+void
+block_table_writer::
+add_header_line(const char* const* word,
+                const unsigned n_word) {
+    if ((n_word > VCFID::SAMPLE) && (0 == strcmp(word[VCFID::CHROM],"#CHROM"))) {
+        _sample_name=word[VCFID::SAMPLE];
+    }
+}
+
+
+
+void
+block_table_writer::
+add_record(const char* const* word,
+           const unsigned n_word) {
+
+    if (n_word <= VCFID::SAMPLE) {
+        std::ostringstream oss;
+        oss << "ERROR: block table input record has " << n_word << " column(s) but expecting at least " << (VCFID::SAMPLE+1) << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+
+    if (is_indel_record(word)) return;
+
+    const char* chrom(word[VCFID::CHROM]);
+    if (_contigs.empty() || (_contigs.back().name != chrom)) {
+        if (! _contigs.empty()) write_contig();
+        if (_contig_index.count(chrom)) {
+            std::ostringstream oss;
+            oss << "ERROR: records for contig '" << chrom << "' are not contiguous in block table input\n";
+            throw blt_exception(oss.str().c_str());
+        }
+        _contig_index[chrom]=_contigs.size();
+        _contigs.push_back(contig_info());
+        _contigs.back().name=chrom;
+    }
+
+    const char* s(word[VCFID::POS]);
+    const int pos(parse_int(s));
+    if ((pos < 1) || ((! _start.empty()) && (pos < _start.back()))) {
+        std::ostringstream oss;
+        oss << "ERROR: unexpected position order in block table input. contig: " << chrom << " position: " << pos << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+
+    // an invalid END is treated as a single position record, as it is
+    // in the text record crawler:
+    const int reflen(strlen(word[VCFID::REF]));
+    int end(pos+reflen-1);
+    unsigned iend;
+    if (get_info_end(word[VCFID::INFO],iend)) {
+        end=pos;
+        if ((static_cast<int>(iend) >= pos) && (reflen <= ((static_cast<int>(iend)+1)-pos))) {
+            end=iend;
+        }
+    }
+    end=std::max(end,pos);
+
+    const unsigned filter(get_filter_index(word[VCFID::FILT]));
+
+    float gqx(std::numeric_limits<float>::quiet_NaN());
+    const char* gqx_str(get_format_value(word,"GQX"));
+    if (NULL != gqx_str) gqx=parse_double(gqx_str);
+
+    unsigned dp(0);
+    const char* dp_str(get_format_value(word,"DP"));
+    if (NULL != dp_str) dp=parse_unsigned(dp_str);
+
+    bool is_gt(false);
+    bool is_nonref(false);
+    const char* gt_str(get_format_string_nocopy(word,"GT"));
+    if (NULL != gt_str) {
+        parse_gt(gt_str,_gtcode,true);
+        is_gt=((_gtcode.size() == 2) && (_gtcode[0] >= 0) && (_gtcode[1] >= 0));
+        is_nonref=(is_gt && ((_gtcode[0] > 0) || (_gtcode[1] > 0)));
+    }
+
+    if (! is_nonref) {
+        add_row(pos,end,gqx,dp,filter,(is_gt ? 0 : BLOCK_TABLE_NO_GT));
+        return;
+    }
+
+    // non-reference alleles are taken from the ALT base at each offset
+    // of the record:
+    for (int offset(0); offset<=(end-pos); ++offset) {
+        unsigned gt(0);
+        for (unsigned i(0); i<2; ++i) {
+            const int allele(_gtcode[i]);
+            if (0 == allele) continue;
+
+            const char* alt(word[VCFID::ALT]);
+            for (int ai(0); (ai+1)<allele; alt++) {
+                if (! *alt) break;
+                if ((*alt)==',') ai++;
+            }
+            if (! *alt) {
+                gt=BLOCK_TABLE_NO_GT;
+                break;
+            }
+            unsigned char base(alt[offset]);
+            if ((0 == base) || (0xff == base)) base='N';
+            gt |= (base << (i*8));
+        }
+        add_row(pos+offset,pos+offset,gqx,dp,filter,gt);
+    }
+}
+
+
+
+void
+block_table_writer::
+add_row(const int start,
+        const int end,
+        const float gqx,
+        const unsigned dp,
+        const unsigned filter,
+        const unsigned gt) {
+    _start.push_back(start);
+    _end.push_back(end);
+    _gqx.push_back(gqx);
+    _dp.push_back(dp);
+    _filter.push_back(filter);
+    _gt.push_back(gt);
+}
+
+
+
+unsigned
+block_table_writer::
+get_filter_index(const char* filter) {
+    const std::map<std::string,unsigned>::const_iterator i(_filter_index.find(filter));
+    if (i != _filter_index.end()) return i->second;
+
+    const unsigned index(_filters.size());
+    if (index >= BLOCK_TABLE_NO_GT) {
+        throw blt_exception("ERROR: too many distinct FILTER values for block table output\n");
+    }
+    _filter_index[filter]=index;
+    _filters.push_back(filter);
+    return index;
+}
+
+
+
+void
+block_table_writer::
+write_bytes(const void* p,
+            const size_t size) {
+    _ofs.write(static_cast<const char*>(p),size);
+    if (! _ofs) {
+        std::ostringstream oss;
+        oss << "ERROR: failed to write block table output file: '" << _filename << "'\n";
+        throw blt_exception(oss.str().c_str());
+    }
+    _offset += size;
+}
+
+
+
+template <typename T>
+void
+block_table_writer::
+write_column(const std::vector<T>& col) {
+    static const char pad[8] = { 0,0,0,0,0,0,0,0 };
+    const size_t size(col.size()*sizeof(T));
+    if (size) write_bytes(&(col[0]),size);
+    write_bytes(pad,column_size(col.size(),sizeof(T))-size);
+}
+
+
+
+void
+block_table_writer::
+write_string(const std::string& s) {
+    const uint32_t size(s.size());
+    write_bytes(&size,sizeof(size));
+    write_bytes(s.data(),size);
+}
+
+
+
+void
+block_table_writer::
+write_contig() {
+    contig_info& ci(_contigs.back());
+    ci.offset=_offset;
+    ci.size=_start.size();
+
+    write_column(_start);
+    write_column(_end);
+    write_column(_gqx);
+    write_column(_dp);
+    write_column(_filter);
+    write_column(_gt);
+
+    _start.clear();
+    _end.clear();
+    _gqx.clear();
+    _dp.clear();
+    _filter.clear();
+    _gt.clear();
+}
+
+
+
+void
+block_table_writer::
+close() {
+    if (_is_closed) return;
+    _is_closed=true;
+
+    if (! _contigs.empty()) write_contig();
+
+    const uint64_t footer_offset(_offset);
+    write_string(_sample_name);
+
+    uint32_t count(_filters.size());
+    write_bytes(&count,sizeof(count));
+    for (unsigned i(0); i<count; ++i) {
+        write_string(_filters[i]);
+    }
+
+    count=_contigs.size();
+    write_bytes(&count,sizeof(count));
+    for (unsigned i(0); i<count; ++i) {
+        write_string(_contigs[i].name);
+        write_bytes(&(_contigs[i].offset),sizeof(uint64_t));
+        write_bytes(&(_contigs[i].size),sizeof(uint32_t));
+    }
+
+    write_bytes(&footer_offset,sizeof(footer_offset));
+    write_bytes(BLOCK_TABLE_MAGIC,TAIL_MAGIC_SIZE);
+
+    _ofs.close();
+    if (! _ofs) {
+        std::ostringstream oss;
+        oss << "ERROR: failed to close block table output file: '" << _filename << "'\n";
+        throw blt_exception(oss.str().c_str());
+    }
+}
+
+
+
+unsigned
+block_table_contig::
+get_first_row(const int pos) const {
+    unsigned i(std::lower_bound(start,start+size,pos)-start);
+    while ((i>0) && (end[i-1] >= pos)) i--;
+    return i;
+}
+
+
+
+static
+void
+throw_format_error(const std::string& filename) {
+    std::ostringstream oss;
+    oss << "ERROR: unexpected block table format in file: '" << filename << "'\n";
+    throw blt_exception(oss.str().c_str());
+}
+
+
+
+block_table::
+block_table(const std::string& filename)
+    : _filename(filename)
+    , _map(NULL)
+    , _map_size(0)
+{
+    check_byte_order();
+
+    const int fd(open(filename.c_str(),O_RDONLY));
+    if (fd < 0) {
+        std::ostringstream oss;
+        oss << "ERROR: can't open block table file: '" << filename << "': " << strerror(errno) << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+    struct stat st;
+    if ((0 != fstat(fd,&st)) ||
+        (st.st_size < static_cast<off_t>(BLOCK_TABLE_MAGIC_SIZE+TAIL_SIZE))) {
+        ::close(fd);
+        throw_format_error(filename);
+    }
+    _map_size=st.st_size;
+    void* map(mmap(NULL,_map_size,PROT_READ,MAP_SHARED,fd,0));
+    ::close(fd);
+    if (MAP_FAILED == map) {
+        std::ostringstream oss;
+        oss << "ERROR: can't map block table file: '" << filename << "': " << strerror(errno) << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+    _map=static_cast<char*>(map);
+
+    try {
+        read_footer();
+    } catch (...) {
+        munmap(_map,_map_size);
+        throw;
+    }
+}
+
+
+
+block_table::
+~block_table() {
+    munmap(_map,_map_size);
+}
+
+
+
+void
+block_table::
+read_footer() {
+    if (0 != memcmp(_map,BLOCK_TABLE_MAGIC,BLOCK_TABLE_MAGIC_SIZE)) throw_format_error(_filename);
+
+    const char* tail(_map+_map_size-TAIL_SIZE);
+    if (0 != memcmp(tail+8,BLOCK_TABLE_MAGIC,TAIL_MAGIC_SIZE)) throw_format_error(_filename);
+
+    uint64_t footer_offset;
+    memcpy(&footer_offset,tail,sizeof(footer_offset));
+    if ((footer_offset < BLOCK_TABLE_MAGIC_SIZE) ||
+        (footer_offset > (_map_size-TAIL_SIZE))) throw_format_error(_filename);
+
+    // bounds checked footer reads:
+    const char* p(_map+footer_offset);
+    const char* p_end(tail);
+
+    struct footer_reader {
+        footer_reader(const char*& p_init, const char* p_end_init, const std::string& filename)
+            : p(p_init), p_end(p_end_init), fname(filename) {}
+
+        void
+        get(void* val, const size_t size) {
+            if (static_cast<size_t>(p_end-p) < size) throw_format_error(fname);
+            memcpy(val,p,size);
+            p += size;
+        }
+
+        uint32_t
+        get_uint32() {
+            uint32_t val;
+            get(&val,sizeof(val));
+            return val;
+        }
+
+        void
+        get_string(std::string& s) {
+            const uint32_t size(get_uint32());
+            if (static_cast<size_t>(p_end-p) < size) throw_format_error(fname);
+            s.assign(p,size);
+            p += size;
+        }
+
+        const char*& p;
+        const char* p_end;
+        const std::string& fname;
+    } fr(p,p_end,_filename);
+
+    fr.get_string(_sample_name);
+
+    const uint32_t filter_count(fr.get_uint32());
+    _filters.resize(filter_count);
+    _is_pass.resize(filter_count);
+    for (unsigned i(0); i<filter_count; ++i) {
+        fr.get_string(_filters[i]);
+        _is_pass[i]=(_filters[i] == "PASS");
+    }
+
+    const uint32_t contig_count(fr.get_uint32());
+    _contigs.resize(contig_count);
+    for (unsigned i(0); i<contig_count; ++i) {
+        block_table_contig& ctg(_contigs[i]);
+        fr.get_string(ctg.name);
+        uint64_t offset;
+        fr.get(&offset,sizeof(offset));
+        ctg.size=fr.get_uint32();
+
+        const uint64_t n(ctg.size);
+        const uint64_t size(column_size(n,4)*4 + column_size(n,2)*2);
+        if ((0 != (offset%8)) || (offset < BLOCK_TABLE_MAGIC_SIZE) ||
+            (offset > footer_offset) || (size > (footer_offset-offset))) throw_format_error(_filename);
+
+        const char* col(_map+offset);
+        ctg.start=reinterpret_cast<const int32_t*>(col);
+        col += column_size(n,4);
+        ctg.end=reinterpret_cast<const int32_t*>(col);
+        col += column_size(n,4);
+        ctg.gqx=reinterpret_cast<const float*>(col);
+        col += column_size(n,4);
+        ctg.dp=reinterpret_cast<const uint32_t*>(col);
+        col += column_size(n,4);
+        ctg.filter=reinterpret_cast<const uint16_t*>(col);
+        col += column_size(n,2);
+        ctg.gt=reinterpret_cast<const uint16_t*>(col);
+
+        for (unsigned j(0); j<ctg.size; ++j) {
+            if (ctg.filter[j] >= filter_count) throw_format_error(_filename);
+        }
+        _contig_index[ctg.name]=i;
+    }
+}
+
+
+
+const block_table_contig*
+block_table::
+get_contig(const std::string& name) const {
+    const std::map<std::string,unsigned>::const_iterator i(_contig_index.find(name));
+    if (i == _contig_index.end()) return NULL;
+    return &(_contigs[i->second]);
+}
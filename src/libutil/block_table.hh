@@ -0,0 +1,254 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// columnar binary table of the gVCF record fields used by the multi-sample
+/// analysis tools
+///
+
+#ifndef __BLOCK_TABLE_HH
+#define __BLOCK_TABLE_HH
+
+#include "vcf_genotype.hh"
+
+#include <stdint.h>
+
+#include <cstddef>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+
+/// gVCF block table file layout
+///
+/// The table holds, for each non-indel record of a single sample gVCF, the
+/// record range, genotype, filter set, GQX and DP. All values are stored
+/// little-endian and each column is padded to a multiple of 8 bytes, so
+/// that a mapped file can be read in place:
+///
+///   "GVBT" 1 0 0 0                      magic and format version
+///   for each contig, in input order:
+///     int32  start[n]                   1-indexed first position
+///     int32  end[n]                     1-indexed last position
+///     float  gqx[n]                     NaN if missing
+///     uint32 dp[n]                      0 if missing
+///     uint16 filter[n]                  index into the filter set list
+///     uint16 gt[n]                      genotype code, see below
+///   footer:
+///     uint32 size, char[size]           sample name
+///     uint32 count                      filter set count
+///       uint32 size, char[size]         FILTER value, eg. "PASS"
+///     uint32 count                      contig count
+///       uint32 size, char[size]         contig name
+///       uint64 offset                   file offset of the start column
+///       uint32 n                        record count
+///   uint64 offset                       file offset of the footer
+///   "GVBT"
+///
+/// The low and high bytes of a genotype code are the first and second
+/// diploid alleles. Each is zero for the reference base at the position,
+/// or the ALT base otherwise. BLOCK_TABLE_NO_GT is stored for records
+/// without a fully called diploid genotype. Multi-base records with a
+/// non-reference genotype are stored one row per position, so that the
+/// code of a row applies to every position from start to end.
+///
+enum {
+    BLOCK_TABLE_MAGIC_SIZE = 8,
+    BLOCK_TABLE_NO_GT = 0xffff
+};
+
+extern const char BLOCK_TABLE_MAGIC[BLOCK_TABLE_MAGIC_SIZE];
+
+
+/// true if the first bytes of filename are the block table magic
+bool
+is_block_table_file(const std::string& filename);
+
+
+
+/// writes a block table from VCF header and record words
+///
+/// records of each contig must be contiguous in the input, and indel
+/// records are skipped. Errors are thrown as blt_exception
+///
+struct block_table_writer {
+
+    explicit
+    block_table_writer(const std::string& filename);
+
+    ~block_table_writer();
+
+    /// add a header line split into n_word words. Only the sample name is
+    /// taken from the #CHROM line, all other header lines are ignored
+    void
+    add_header_line(const char* const* word,
+                    const unsigned n_word);
+
+    /// add the record split into n_word VCF words
+    void
+    add_record(const char* const* word,
+               const unsigned n_word);
+
+    /// write the final contig and the footer
+    void
+    close();
+
+private:
+    block_table_writer(const block_table_writer&);
+    block_table_writer& operator=(const block_table_writer&);
+
+    void
+    add_row(const int start,
+            const int end,
+            const float gqx,
+            const unsigned dp,
+            const unsigned filter,
+            const unsigned gt);
+
+    unsigned
+    get_filter_index(const char* filter);
+
+    // write the buffered columns of the current contig:
+    void
+    write_contig();
+
+    void
+    write_bytes(const void* p,
+                const size_t size);
+
+    template <typename T>
+    void
+    write_column(const std::vector<T>& col);
+
+    void
+    write_string(const std::string& s);
+
+    std::string _filename;
+    std::ofstream _ofs;
+    bool _is_closed;
+    uint64_t _offset;
+
+    std::string _sample_name;
+    std::vector<std::string> _filters;
+    std::map<std::string,unsigned> _filter_index;
+
+    struct contig_info {
+        std::string name;
+        uint64_t offset;
+        uint32_t size;
+    };
+    std::vector<contig_info> _contigs;
+    std::map<std::string,unsigned> _contig_index;
+
+    // columns of the current contig:
+    std::vector<int32_t> _start;
+    std::vector<int32_t> _end;
+    std::vector<float> _gqx;
+    std::vector<uint32_t> _dp;
+    std::vector<uint16_t> _filter;
+    std::vector<uint16_t> _gt;
+
+    // cache this to avoid malloc cost:
+    vcf_genotype _gtcode;
+};
+
+
+
+/// columns of one contig in a block table, rows are ordered by start
+struct block_table_contig {
+
+    block_table_contig()
+        : size(0), start(NULL), end(NULL), gqx(NULL), dp(NULL), filter(NULL), gt(NULL)
+    {}
+
+    /// index of the first row which may overlap pos, which is the first
+    /// row ending at or after pos, or size if there are none
+    unsigned
+    get_first_row(const int pos) const;
+
+    std::string name;
+    unsigned size;
+    const int32_t* start;
+    const int32_t* end;
+    const float* gqx;
+    const uint32_t* dp;
+    const uint16_t* filter;
+    const uint16_t* gt;
+};
+
+
+
+/// read-only memory mapped block table
+///
+/// column pointers refer directly into the mapping, which is held for the
+/// lifetime of this object. Errors are thrown as blt_exception
+///
+struct block_table {
+
+    explicit
+    block_table(const std::string& filename);
+
+    ~block_table();
+
+    const std::string&
+    sample_name() const { return _sample_name; }
+
+    unsigned
+    filter_count() const { return _filters.size(); }
+
+    const std::string&
+    get_filter(const unsigned index) const { return _filters[index]; }
+
+    /// true if filter set index is "PASS"
+    bool
+    is_pass(const unsigned index) const { return _is_pass[index]; }
+
+    /// returns NULL if the table has no records for the contig
+    const block_table_contig*
+    get_contig(const std::string& name) const;
+
+private:
+    block_table(const block_table&);
+    block_table& operator=(const block_table&);
+
+    void
+    read_footer();
+
+    std::string _filename;
+    char* _map;
+    size_t _map_size;
+
+    std::string _sample_name;
+    std::vector<std::string> _filters;
+    std::vector<bool> _is_pass;
+    std::vector<block_table_contig> _contigs;
+    std::map<std::string,unsigned> _contig_index;
+};
+
+#endif
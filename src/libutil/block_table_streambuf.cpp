@@ -0,0 +1,137 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// stream buffer writing a block table from VCF text output
+///
+
+#include "block_table_streambuf.hh"
+#include "tokenize_util.hh"
+
+#include <cstring>
+
+
+
+block_table_streambuf::
+block_table_streambuf(const std::string& filename)
+    : _writer(filename)
+{}
+
+
+
+block_table_streambuf::int_type
+block_table_streambuf::
+overflow(int_type c) {
+    if (traits_type::eq_int_type(c,traits_type::eof())) return traits_type::not_eof(c);
+    const char ch(traits_type::to_char_type(c));
+    xsputn(&ch,1);
+    return c;
+}
+
+
+
+std::streamsize
+block_table_streambuf::
+xsputn(const char* s,
+       std::streamsize n) {
+    const char* p(s);
+    const char* end(s+n);
+    while (p<end) {
+        const char* nl(static_cast<const char*>(memchr(p,'\n',end-p)));
+        if (NULL == nl) {
+            _line.append(p,end-p);
+            break;
+        }
+        _line.append(p,nl-p);
+        process_line();
+        _line.clear();
+        p=nl+1;
+    }
+    return n;
+}
+
+
+
+void
+block_table_streambuf::
+process_line() {
+    if (_line.empty()) return;
+
+    const bool is_header('#' == _line[0]);
+    const unsigned n_word(tokenize_line(&(_line[0]),'\t',_word,MAX_WORD));
+    if (is_header) {
+        _writer.add_header_line(_word,n_word);
+    } else {
+        _writer.add_record(_word,n_word);
+    }
+}
+
+
+
+void
+block_table_streambuf::
+close() {
+    if (! _line.empty()) {
+        process_line();
+        _line.clear();
+    }
+    _writer.close();
+}
+
+
+
+block_table_output::
+block_table_output(output_buffer& ob,
+                   const std::string& filename)
+    : _ob(ob)
+{
+    if (filename.empty()) return;
+    _table.reset(new block_table_streambuf(filename));
+    _ob.set_tee(_table.get());
+}
+
+
+
+block_table_output::
+~block_table_output() {
+    if (NULL == _table.get()) return;
+
+    // detach the output buffer from the table before it is destroyed:
+    try {
+        _ob.set_tee(NULL);
+    } catch (...) {}
+}
+
+
+
+void
+block_table_output::
+close() {
+    if (NULL == _table.get()) return;
+    _ob.set_tee(NULL);
+    _table->close();
+}
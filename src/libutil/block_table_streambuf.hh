@@ -0,0 +1,105 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// stream buffer writing a block table from VCF text output
+///
+
+#ifndef __BLOCK_TABLE_STREAMBUF_HH
+#define __BLOCK_TABLE_STREAMBUF_HH
+
+#include "block_table.hh"
+#include "output_buffer.hh"
+
+#include <memory>
+#include <streambuf>
+#include <string>
+
+
+/// std::streambuf which adds each line of the VCF text written to it to a
+/// block table file
+///
+/// errors are thrown as blt_exception from the write which completes the
+/// offending line
+///
+struct block_table_streambuf : public std::streambuf {
+
+    explicit
+    block_table_streambuf(const std::string& filename);
+
+    /// add any final unterminated line and complete the table file
+    void
+    close();
+
+protected:
+    int_type
+    overflow(int_type c);
+
+    std::streamsize
+    xsputn(const char* s,
+           std::streamsize n);
+
+private:
+    block_table_streambuf(const block_table_streambuf&);
+    block_table_streambuf& operator=(const block_table_streambuf&);
+
+    // add the line in _line, without its newline:
+    void
+    process_line();
+
+    enum { MAX_WORD = 50 };
+
+    block_table_writer _writer;
+    std::string _line;
+    char* _word[MAX_WORD];
+};
+
+
+
+/// copy the VCF text output of an output_buffer to a block table file
+/// for the lifetime of this object, if filename is not empty
+///
+struct block_table_output {
+
+    block_table_output(output_buffer& ob,
+                       const std::string& filename);
+
+    ~block_table_output();
+
+    /// flush the output buffer and complete the table file
+    void
+    close();
+
+private:
+    block_table_output(const block_table_output&);
+    block_table_output& operator=(const block_table_output&);
+
+    output_buffer& _ob;
+    std::auto_ptr<block_table_streambuf> _table;
+};
+
+#endif
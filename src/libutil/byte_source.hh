@@ -0,0 +1,93 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// interface for sequential input byte streams
+///
+
+#ifndef __BYTE_SOURCE_HH
+#define __BYTE_SOURCE_HH
+
+#include <cstddef>
+#include <cstring>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+
+/// sequential source of input bytes, used to feed line splitters from
+/// input which must be decoded before parsing
+///
+struct byte_source {
+
+    virtual ~byte_source() {}
+
+    /// read up to size bytes into buf
+    ///
+    /// \returns the number of bytes read, 0 only at the end of input. Read
+    /// errors are thrown as blt_exception
+    ///
+    virtual
+    size_t
+    read(char* buf,
+         const size_t size) = 0;
+};
+
+
+
+/// returns bytes which were already read from a source to detect its
+/// format, followed by the remainder of the source
+///
+struct prefix_byte_source : public byte_source {
+
+    prefix_byte_source(const std::string& prefix,
+                       std::auto_ptr<byte_source> src)
+        : _prefix(prefix)
+        , _offset(0)
+        , _src(src)
+    {}
+
+    size_t
+    read(char* buf,
+         const size_t size) {
+        if (_offset < _prefix.size()) {
+            const size_t n(std::min(size,_prefix.size()-_offset));
+            memcpy(buf,_prefix.data()+_offset,n);
+            _offset += n;
+            return n;
+        }
+        return _src->read(buf,size);
+    }
+
+private:
+    const std::string _prefix;
+    size_t _offset;
+    std::auto_ptr<byte_source> _src;
+};
+
+#endif
@@ -0,0 +1,297 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// incremental CSI index construction for BCF data written in BGZF blocks
+///
+
+#include "bcf_util.hh"
+#include "blt_exception.hh"
+#include "csi_index_builder.hh"
+
+#include "bgzf.h"
+
+#include <sstream>
+
+
+
+// CSI bin numbering for the given min_shift and depth, as hts_reg2bin:
+//
+static
+unsigned
+reg2bin(const int64_t beg,
+        int64_t end) {
+    int l(csi_index_builder::DEPTH);
+    int s(csi_index_builder::MIN_SHIFT);
+    int t(((1<<(3*l))-1)/7);
+    for (--end; l > 0; --l, s += 3, t -= 1<<(3*l)) {
+        if ((beg>>s) == (end>>s)) return t + (beg>>s);
+    }
+    return 0;
+}
+
+
+
+// first position covered by bin:
+static
+int64_t
+bin_begin(const unsigned bin) {
+    int l(0);
+    unsigned t(0);
+    while ((l < csi_index_builder::DEPTH) && (bin >= (t + (1u<<(3*l))))) {
+        t += 1u<<(3*l);
+        l++;
+    }
+    const int s(csi_index_builder::MIN_SHIFT + 3*(csi_index_builder::DEPTH-l));
+    return static_cast<int64_t>(bin-t) << s;
+}
+
+
+
+csi_index_builder::
+csi_index_builder()
+    : _is_header_done(false)
+    , _head_size(0)
+    , _skip(0)
+    , _record_count(0)
+    , _last_tid(-1)
+    , _last_bin(0xffffffffu)
+    , _last_coor(-1)
+    , _save_tid(-1)
+    , _save_bin(0xffffffffu)
+    , _save_off(0)
+    , _last_off(0)
+{}
+
+
+
+void
+csi_index_builder::
+add_block(const char* data,
+          const unsigned size,
+          const uint64_t block_address,
+          const uint64_t next_block_address) {
+
+    unsigned pos(0);
+    while (pos<size) {
+        if (_skip>0) {
+            const unsigned n((_skip < (size-pos)) ? _skip : (size-pos));
+            pos += n;
+            _skip -= n;
+            if (_skip>0) break;
+        } else {
+            const unsigned head_target(_is_header_done ? 20 : (BCF_MAGIC_SIZE+4));
+            while ((_head_size < head_target) && (pos<size)) {
+                _head[_head_size++]=data[pos++];
+            }
+            if (_head_size < head_target) break;
+
+            if (! _is_header_done) {
+                if (! is_bcf_magic(_head,BCF_MAGIC_SIZE)) {
+                    throw blt_exception("ERROR: can't build CSI index: output is not in BCF format\n");
+                }
+                _skip=bcf_get_uint32(_head+BCF_MAGIC_SIZE);
+            } else {
+                const uint64_t l_shared(bcf_get_uint32(_head));
+                const uint64_t l_indiv(bcf_get_uint32(_head+4));
+                if (l_shared < 12) {
+                    std::ostringstream oss;
+                    oss << "ERROR: can't build CSI index: invalid BCF record " << (_record_count+1) << "\n";
+                    throw blt_exception(oss.str().c_str());
+                }
+                _skip=(l_shared+l_indiv)-12;
+            }
+            if (_skip>0) continue;
+        }
+
+        // the header or a record is complete. The offset following a
+        // block-terminal record is reported at the start of the next block:
+        const uint64_t end_offset((pos<size) ? ((block_address<<16) | pos) : (next_block_address<<16));
+        if (_is_header_done) {
+            process_record(end_offset);
+        } else {
+            _is_header_done=true;
+            _last_off=end_offset;
+        }
+        _head_size=0;
+    }
+}
+
+
+
+// index the record in _head, which ends at end_offset:
+void
+csi_index_builder::
+process_record(const uint64_t end_offset) {
+
+    _record_count++;
+
+    const int tid(bcf_get_int32(_head+8));
+    const int beg(bcf_get_int32(_head+12));
+    int end(beg+bcf_get_int32(_head+16));
+    if (end <= beg) end=beg+1;
+
+    if ((tid < 0) || (beg < 0)) {
+        std::ostringstream oss;
+        oss << "ERROR: can't build CSI index: unexpected record position in BCF record " << _record_count << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+
+    if (_last_tid != tid) {
+        if (_last_tid > tid) {
+            std::ostringstream oss;
+            oss << "ERROR: can't build CSI index: chromosome blocks are not continuous at BCF record " << _record_count << "\n";
+            throw blt_exception(oss.str().c_str());
+        }
+        _last_tid = tid;
+        _last_bin = 0xffffffffu;
+    } else if (_last_coor > beg) {
+        std::ostringstream oss;
+        oss << "ERROR: can't build CSI index: output is out of order at BCF record " << _record_count << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+
+    if (static_cast<int>(_index.size()) <= tid) _index.resize(tid+1);
+    contig_index& ci(_index[tid]);
+
+    // linear offsets are only kept to find the offset of each bin:
+    const unsigned lbeg(beg >> MIN_SHIFT);
+    const unsigned lend((end - 1) >> MIN_SHIFT);
+    if (ci.linear.size() < (lend+1)) ci.linear.resize(lend+1,0);
+    for (unsigned i(lbeg); i<=lend; ++i) {
+        if (0 == ci.linear[i]) ci.linear[i] = _last_off;
+    }
+
+    const unsigned bin(reg2bin(beg,end));
+    if (bin != _last_bin) {
+        if (_save_bin != 0xffffffffu) {
+            _index[_save_tid].bins[_save_bin].push_back(std::make_pair(_save_off,_last_off));
+        }
+        _save_off = _last_off;
+        _save_bin = _last_bin = bin;
+        _save_tid = tid;
+    }
+    _last_off = end_offset;
+    _last_coor = beg;
+}
+
+
+
+void
+csi_index_builder::
+finish() {
+    if ((_head_size > 0) || (_skip > 0) || (! _is_header_done)) {
+        throw blt_exception("ERROR: can't build CSI index: BCF output ends in an incomplete record\n");
+    }
+
+    if (_save_tid >= 0) {
+        _index[_save_tid].bins[_save_bin].push_back(std::make_pair(_save_off,_last_off));
+    }
+
+    const unsigned n_contig(_index.size());
+    for (unsigned tid(0); tid<n_contig; ++tid) {
+        contig_index& ci(_index[tid]);
+
+        // merge chunks:
+        bin_index_t::iterator i(ci.bins.begin()), i_end(ci.bins.end());
+        for (; i!=i_end; ++i) {
+            std::vector<chunk_t>& p(i->second);
+            unsigned m(0);
+            for (unsigned l(1); l<p.size(); ++l) {
+                if ((p[m].second>>16) == (p[l].first>>16)) p[m].second = p[l].second;
+                else p[++m] = p[l];
+            }
+            p.resize(m+1);
+        }
+
+        // fill missing:
+        for (unsigned j(1); j<ci.linear.size(); ++j) {
+            if (0 == ci.linear[j]) ci.linear[j] = ci.linear[j-1];
+        }
+    }
+}
+
+
+
+static
+void
+write_int32(BGZF* fp,
+            const int32_t x) {
+    bgzf_write(fp,&x,4);
+}
+
+
+
+void
+csi_index_builder::
+write(const std::string& filename) {
+
+    finish();
+
+    BGZF* fp(bgzf_open(filename.c_str(),"w"));
+    if (NULL == fp) {
+        std::ostringstream oss;
+        oss << "ERROR: can't create CSI index file: '" << filename << "'\n";
+        throw blt_exception(oss.str().c_str());
+    }
+
+    // values are written in host byte order, which matches hts_idx_save
+    // on little-endian hosts:
+    bgzf_write(fp,"CSI\1",4);
+    write_int32(fp,MIN_SHIFT);
+    write_int32(fp,DEPTH);
+    write_int32(fp,0);
+    const unsigned n_contig(_index.size());
+    write_int32(fp,n_contig);
+
+    for (unsigned tid(0); tid<n_contig; ++tid) {
+        const contig_index& ci(_index[tid]);
+        write_int32(fp,ci.bins.size());
+        bin_index_t::const_iterator i(ci.bins.begin()), i_end(ci.bins.end());
+        for (; i!=i_end; ++i) {
+            const unsigned bin(i->first);
+            const uint64_t lpos(bin_begin(bin) >> MIN_SHIFT);
+            const uint64_t loffset((lpos < ci.linear.size()) ? ci.linear[lpos] : 0);
+            const std::vector<chunk_t>& p(i->second);
+            bgzf_write(fp,&bin,4);
+            bgzf_write(fp,&loffset,8);
+            write_int32(fp,p.size());
+            for (unsigned j(0); j<p.size(); ++j) {
+                bgzf_write(fp,&(p[j].first),8);
+                bgzf_write(fp,&(p[j].second),8);
+            }
+        }
+    }
+    const uint64_t n_no_coor(0);
+    bgzf_write(fp,&n_no_coor,8);
+
+    if (0 != bgzf_close(fp)) {
+        std::ostringstream oss;
+        oss << "ERROR: failed to write CSI index file: '" << filename << "'\n";
+        throw blt_exception(oss.str().c_str());
+    }
+}
@@ -0,0 +1,107 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// incremental CSI index construction for BCF data written in BGZF blocks
+///
+
+#ifndef __CSI_INDEX_BUILDER_HH
+#define __CSI_INDEX_BUILDER_HH
+
+#include "bgzf_block_index.hh"
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+/// builds a CSI index of a BCF2 file from BGZF blocks as they are written
+///
+/// the index uses the 'bcftools index' defaults (min_shift 14, depth 5),
+/// with chunks and bin offsets built as in the htslib indexer, so that
+/// it can be used by any CSI aware reader.
+///
+struct csi_index_builder : public bgzf_block_index {
+
+    enum {
+        MIN_SHIFT = 14,
+        DEPTH = 5
+    };
+
+    csi_index_builder();
+
+    void
+    add_block(const char* data,
+              const unsigned size,
+              const uint64_t block_address,
+              const uint64_t next_block_address);
+
+    void
+    write(const std::string& filename);
+
+    const char*
+    file_suffix() const { return ".csi"; }
+
+private:
+
+    typedef std::pair<uint64_t,uint64_t> chunk_t;
+    typedef std::map<unsigned, std::vector<chunk_t> > bin_index_t;
+
+    struct contig_index {
+        bin_index_t bins;
+        std::vector<uint64_t> linear;
+    };
+
+    void
+    process_record(const uint64_t end_offset);
+
+    void
+    finish();
+
+    // parse state: the BCF magic, header size and the leading fields of
+    // each record are collected in _head, and everything else skipped:
+    bool _is_header_done;
+    char _head[20];
+    unsigned _head_size;
+    uint64_t _skip;
+    uint64_t _record_count;
+
+    std::vector<contig_index> _index;
+
+    // indexing state, named as in ti_index_core:
+    int _last_tid;
+    unsigned _last_bin;
+    int _last_coor;
+    int _save_tid;
+    unsigned _save_bin;
+    uint64_t _save_off;
+    uint64_t _last_off;
+};
+
+#endif
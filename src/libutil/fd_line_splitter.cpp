@@ -0,0 +1,248 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// line splitter reading directly from a file descriptor
+///
+
+#include "bcf_line_splitter.hh"
+#include "bgzf_reader.hh"
+#include "blt_exception.hh"
+#include "fd_line_splitter.hh"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include <sstream>
+
+
+
+fd_line_splitter::
+fd_line_splitter(const int fd,
+                 const unsigned chunk_size,
+                 const char word_seperator,
+                 const unsigned max_word,
+                 const bool is_close_fd)
+    : line_splitter(word_seperator,max_word)
+    , _fd(fd)
+    , _is_close_fd(is_close_fd)
+    , _is_eof(false)
+    , _buf(NULL)
+    , _buf_size(chunk_size)
+    , _start(0)
+    , _end(0)
+{
+    assert(_buf_size>0);
+    _buf=new char[_buf_size+1];
+}
+
+
+
+fd_line_splitter::
+fd_line_splitter(std::auto_ptr<byte_source> src,
+                 const unsigned chunk_size,
+                 const char word_seperator,
+                 const unsigned max_word,
+                 const bool is_prefetch)
+    : line_splitter(word_seperator,max_word)
+    , _fd(-1)
+    , _is_close_fd(false)
+    , _batch_reader(new line_batch_reader(src,chunk_size,is_prefetch))
+    , _is_eof(false)
+    , _buf(NULL)
+    , _buf_size(chunk_size)
+    , _start(0)
+    , _end(0)
+{
+    assert(_buf_size>0);
+}
+
+
+
+fd_line_splitter::
+~fd_line_splitter() {
+    if (NULL == _batch_reader.get()) delete [] _buf;
+    if (_is_close_fd) close(_fd);
+}
+
+
+
+bool
+fd_line_splitter::
+read_chunk() {
+    if (NULL != _batch_reader.get()) {
+        // only the final batch can end with a partial line:
+        if (_start != _end) {
+            _is_eof=true;
+            return false;
+        }
+        line_batch* batch(_batch_reader->next_batch());
+        if (NULL == batch) {
+            _is_eof=true;
+            return false;
+        }
+        _buf=batch->data();
+        _buf_size=batch->capacity();
+        _start=0;
+        _end=batch->size;
+        return true;
+    }
+
+    // shift the partial line to the front of the buffer:
+    if (_start>0) {
+        const size_t len(_end-_start);
+        if (len>0) memmove(_buf,_buf+_start,len);
+        _start=0;
+        _end=len;
+    }
+
+    // grow the buffer for long lines:
+    if (_end == _buf_size) {
+        const size_t old_buf_size(_buf_size);
+        char* old_buf(_buf);
+        _buf_size *= 2;
+        _buf=new char[_buf_size+1];
+        memcpy(_buf,old_buf,old_buf_size);
+        delete [] old_buf;
+    }
+
+    while (true) {
+        const ssize_t ret(read(_fd,_buf+_end,_buf_size-_end));
+        if (ret > 0) {
+            _end += ret;
+            return true;
+        }
+        if (0 == ret) break;
+        if (EINTR == errno) continue;
+
+        std::ostringstream oss;
+        oss << "ERROR: unexpected failure while attempting to read line " << (_line_no+1)
+            << ": " << strerror(errno) << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+    _is_eof=true;
+    return false;
+}
+
+
+
+bool
+fd_line_splitter::
+parse_line() {
+    _n_word=0;
+
+    char* line(NULL);
+    while (true) {
+        char* nl((_start<_end) ? static_cast<char*>(memchr(_buf+_start,'\n',_end-_start)) : NULL);
+        if (NULL != nl) {
+            *nl='\0';
+            line=_buf+_start;
+            _start=(nl-_buf)+1;
+            break;
+        }
+        if (_is_eof || (! read_chunk())) {
+            // normal eof:
+            if (_start == _end) return false;
+
+            // final line is not newline terminated:
+            _buf[_end]='\0';
+            line=_buf+_start;
+            _start=_end;
+            break;
+        }
+    }
+
+    _line_no++;
+    split_line(line);
+    return true;
+}
+
+
+
+void
+fd_line_splitter::
+report_input_stats(std::ostream& os) const {
+    if (NULL == _batch_reader.get()) return;
+    _batch_reader->get_stats().report(os);
+}
+
+
+
+std::auto_ptr<line_splitter>
+open_fd_line_splitter(const std::string& filename,
+                      const unsigned worker_count) {
+
+    const bool is_stdin(filename.empty() || (filename == "-"));
+    int fd(STDIN_FILENO);
+    if (! is_stdin) {
+        fd=open(filename.c_str(),O_RDONLY);
+        if (fd<0) {
+            std::ostringstream oss;
+            oss << "ERROR: can't open input file: '" << filename << "': " << strerror(errno) << "\n";
+            throw blt_exception(oss.str().c_str());
+        }
+    }
+
+    // plain text regular files are read directly from the descriptor,
+    // format detection does not consume any input:
+    bool is_plain_file(false);
+    struct stat st;
+    if ((0 == fstat(fd,&st)) && S_ISREG(st.st_mode)) {
+        const off_t offset(lseek(fd,0,SEEK_CUR));
+        char h[BCF_MAGIC_SIZE];
+        const ssize_t hsize((offset<0) ? -1 : pread(fd,h,sizeof(h),offset));
+        is_plain_file=((hsize >= 0) &&
+                       (! bgzf_reader::is_gzip_header(reinterpret_cast<unsigned char*>(h),hsize)) &&
+                       (! is_bcf_magic(h,hsize)));
+    }
+
+    if (is_plain_file) {
+        return std::auto_ptr<line_splitter>(new fd_line_splitter(fd,fd_line_splitter::DEFAULT_CHUNK_SIZE,'\t',0,(! is_stdin)));
+    }
+
+    // detect BCF from the leading decoded bytes, which are then replayed
+    // to the splitter:
+    std::auto_ptr<byte_source> reader(new bgzf_reader(fd,worker_count,(! is_stdin)));
+    char h[BCF_MAGIC_SIZE];
+    size_t hsize(0);
+    while (hsize < BCF_MAGIC_SIZE) {
+        const size_t n(reader->read(h+hsize,BCF_MAGIC_SIZE-hsize));
+        if (0 == n) break;
+        hsize += n;
+    }
+    std::auto_ptr<byte_source> src(new prefix_byte_source(std::string(h,hsize),reader));
+    if (is_bcf_magic(h,hsize)) {
+        return std::auto_ptr<line_splitter>(new bcf_line_splitter(src));
+    } else {
+        return std::auto_ptr<line_splitter>(new fd_line_splitter(src,fd_line_splitter::DEFAULT_CHUNK_SIZE,'\t',0,(worker_count>0)));
+    }
+}
@@ -0,0 +1,123 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// line splitter reading directly from a file descriptor
+///
+
+#ifndef FD_LINE_SPLITTER_HH__
+#define FD_LINE_SPLITTER_HH__
+
+#include "byte_source.hh"
+#include "line_batch_reader.hh"
+#include "line_splitter.hh"
+
+#include <cstddef>
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+
+/// split lines read from a file descriptor without any stream overhead
+///
+/// Input is read in large chunks with read() into a reused buffer, and
+/// lines are split in place in the buffer. word[] points directly into
+/// the buffer, and no per-line copy is made.
+///
+/// Input may alternatively be read in batches of complete lines from any
+/// byte_source, which is owned by this object. If prefetch is requested the
+/// source is read on a separate thread ahead of the parser.
+///
+struct fd_line_splitter : public line_splitter {
+
+    /// the descriptor is closed by this object only if is_close_fd is set
+    explicit
+    fd_line_splitter(const int fd,
+                     const unsigned chunk_size=DEFAULT_CHUNK_SIZE,
+                     const char word_seperator='\t',
+                     const unsigned max_word=0,
+                     const bool is_close_fd=false);
+
+    explicit
+    fd_line_splitter(std::auto_ptr<byte_source> src,
+                     const unsigned chunk_size=DEFAULT_CHUNK_SIZE,
+                     const char word_seperator='\t',
+                     const unsigned max_word=0,
+                     const bool is_prefetch=false);
+
+    ~fd_line_splitter();
+
+    /// returns false for regular end of input:
+    bool
+    parse_line();
+
+    /// write input queue statistics for byte_source input, or nothing for
+    /// input read directly from the file descriptor
+    void
+    report_input_stats(std::ostream& os) const;
+
+    enum { DEFAULT_CHUNK_SIZE = 4*1024*1024 };
+
+private:
+
+    // read the next chunk of input, return false at eof
+    bool
+    read_chunk();
+
+    int _fd;
+    bool _is_close_fd;
+    std::auto_ptr<line_batch_reader> _batch_reader;
+    bool _is_eof;
+
+    // unparsed input is [_buf+_start,_buf+_end). The buffer always
+    // has one byte beyond _buf_size for the final line terminator. For
+    // byte_source input the buffer is the current line batch
+    char* _buf;
+    size_t _buf_size;
+    size_t _start;
+    size_t _end;
+};
+
+
+
+/// open a line splitter for tool input
+///
+/// input is read from stdin if filename is empty or "-". Plain text files
+/// are read directly from the descriptor. gzip and BGZF compressed input
+/// is detected from the leading bytes and decompressed, BGZF input is
+/// inflated on worker_count threads. Other text input is read on a
+/// separate prefetch thread if worker_count is non-zero. BCF2 input (plain
+/// or compressed) is detected from the decoded leading bytes and read with
+/// bcf_line_splitter.
+///
+std::auto_ptr<line_splitter>
+open_fd_line_splitter(const std::string& filename,
+                      const unsigned worker_count);
+
+
+#endif
@@ -0,0 +1,248 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+
+
+#include "compat_util.hh"
+#include "format_util.hh"
+
+#include <stdint.h>
+
+#include <cassert>
+#include <cctype>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <limits>
+
+
+
+// two digit strings for 0-99, so that integers are written two digits
+// per division:
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// every power of ten up to 1e22 is exact as a double:
+static const double pow10_table[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+
+
+static
+unsigned
+count_digits(uint64_t val) {
+    unsigned n(1);
+    while (true) {
+        if (val < 10) return n;
+        if (val < 100) return n+1;
+        if (val < 1000) return n+2;
+        if (val < 10000) return n+3;
+        val /= 10000;
+        n += 4;
+    }
+}
+
+
+
+// write the lowest n_digits digits of val, zero-padded on the left:
+static
+char*
+write_digits(uint64_t val,
+             const unsigned n_digits,
+             char* buf) {
+    char* p(buf+n_digits);
+    while ((p-buf) >= 2) {
+        const unsigned pair(static_cast<unsigned>(val % 100)*2);
+        val /= 100;
+        *(--p) = digit_pairs[pair+1];
+        *(--p) = digit_pairs[pair];
+    }
+    if (p != buf) *(--p) = static_cast<char>('0'+(val % 10));
+    return buf+n_digits;
+}
+
+
+
+char*
+format_uint(unsigned long val,
+            char* buf) {
+    return write_digits(val,count_digits(val),buf);
+}
+
+
+
+char*
+format_int(const long val,
+           char* buf) {
+    if (val<0) {
+        *(buf++) = '-';
+        return format_uint(-static_cast<unsigned long>(val),buf);
+    }
+    return format_uint(val,buf);
+}
+
+
+
+// the only char in printf "%f" or "%g" output which can depend on the
+// locale is the decimal point, which is always the first char after the
+// leading sign and digits which is not an exponent:
+static
+char*
+normalize_decimal_point(char* buf,
+                        char* end) {
+    char* p(buf + (('-'==*buf) ? 1 : 0));
+    while ((p != end) && isdigit(static_cast<unsigned char>(*p))) ++p;
+    if ((p == end) || ('e' == *p)) return end;
+
+    char* tail(p+1);
+    while ((tail != end) && (! isdigit(static_cast<unsigned char>(*tail)))) ++tail;
+    *(p++) = '.';
+    const size_t tail_size(end-tail);
+    memmove(p,tail,tail_size);
+    return p+tail_size;
+}
+
+
+
+// printf handles the values which the fast path can't format exactly:
+static
+char*
+format_fixed_general(const double val,
+                     const unsigned precision,
+                     char* buf) {
+    const int write_size(snprintf(buf,MAX_FIXED_FORMAT_SIZE,"%.*f",static_cast<int>(precision),val));
+    assert((write_size>0) && (write_size<MAX_FIXED_FORMAT_SIZE));
+    return normalize_decimal_point(buf,buf+write_size);
+}
+
+
+
+char*
+format_fixed(const double val,
+             const unsigned precision,
+             char* buf) {
+
+    assert(precision <= MAX_FIXED_PRECISION);
+
+    if (val != val) {
+        memcpy(buf,"nan",3);
+        return buf+3;
+    }
+
+    // test the sign bit, so that -0 is written as "-0.0..", as in printf:
+    const bool is_neg((val < 0.) || ((val == 0.) && ((1./val) < 0.)));
+    char* p(buf);
+    if (is_neg) *(p++) = '-';
+
+    const double aval(is_neg ? -val : val);
+    if (aval == std::numeric_limits<double>::infinity()) {
+        memcpy(p,"inf",3);
+        return p+3;
+    }
+
+    // above 2**53 not every integer is exact in a double:
+    static const double max_exact(9007199254740992.);
+    const double scaled(aval*pow10_table[precision]);
+    if (scaled >= max_exact) return format_fixed_general(val,precision,buf);
+
+    const double base(std::floor(scaled));
+    const double frac(scaled-base);
+    bool is_round_up;
+    if (0 == precision) {
+        // scaled is exact, so ties are real and round to even as in printf:
+        is_round_up = ((frac > 0.5) || ((frac == 0.5) && (0. != std::fmod(base,2.))));
+    } else {
+        // scaled may differ from the exact product by half an ulp, which
+        // can only change the rounding direction within an ulp of the tie:
+        if (std::fabs(frac-0.5) <= (scaled*DBL_EPSILON)) {
+            return format_fixed_general(val,precision,buf);
+        }
+        is_round_up = (frac > 0.5);
+    }
+
+    const uint64_t scale(static_cast<uint64_t>(pow10_table[precision]));
+    const uint64_t n(static_cast<uint64_t>(base) + (is_round_up ? 1 : 0));
+    const uint64_t ipart(n/scale);
+    p=write_digits(ipart,count_digits(ipart),p);
+    if (precision) {
+        *(p++) = '.';
+        p=write_digits(n % scale,precision,p);
+    }
+    return p;
+}
+
+
+
+char*
+format_general(const double val,
+               char* buf) {
+
+    // in [1e-4,1e5) "%g" is "%f" with 6 significant digits and trailing
+    // zeros removed, rounding into the next decade only adds a zero:
+    const double aval(std::fabs(val));
+    if ((aval >= 1e-4) && (aval < 1e5)) {
+        // each of these literals rounds up from the exact power of ten, so
+        // the comparison gives the decimal exponent of the exact value:
+        static const double decade_table[] = {
+            1e-4, 1e-3, 1e-2, 1e-1, 1e0, 1e1, 1e2, 1e3, 1e4
+        };
+        int exponent(4);
+        while (aval < decade_table[exponent+4]) exponent--;
+        char* end(format_fixed(val,static_cast<unsigned>(5-exponent),buf));
+        while ('0' == *(end-1)) end--;
+        if ('.' == *(end-1)) end--;
+        return end;
+    }
+
+    if (val != val) {
+        memcpy(buf,"nan",3);
+        return buf+3;
+    }
+    if (aval == std::numeric_limits<double>::infinity()) {
+        char* p(buf);
+        if (val < 0.) *(p++) = '-';
+        memcpy(p,"inf",3);
+        return p+3;
+    }
+
+    const int write_size(snprintf(buf,MAX_GENERAL_FORMAT_SIZE,"%g",val));
+    assert((write_size>0) && (write_size<MAX_GENERAL_FORMAT_SIZE));
+    return normalize_decimal_point(buf,buf+write_size);
+}
@@ -0,0 +1,89 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// locale-independent integer and fixed-precision double formatting
+///
+
+#ifndef __FORMAT_UTIL_HH
+#define __FORMAT_UTIL_HH
+
+
+enum {
+    /// buffer size sufficient for any format_int/format_uint output
+    MAX_INT_FORMAT_SIZE = 24,
+    /// largest precision accepted by format_fixed
+    MAX_FIXED_PRECISION = 15,
+    /// buffer size sufficient for any format_fixed output
+    MAX_FIXED_FORMAT_SIZE = 336,
+    /// buffer size sufficient for any format_general output
+    MAX_GENERAL_FORMAT_SIZE = 24
+};
+
+
+/// write the decimal representation of val to buf, and return a pointer
+/// one past the last char written. No null terminator is written.
+///
+/// buf must hold at least MAX_INT_FORMAT_SIZE chars
+///
+char*
+format_uint(unsigned long val,
+            char* buf);
+
+char*
+format_int(const long val,
+           char* buf);
+
+
+/// write val with precision digits after the decimal point to buf, and
+/// return a pointer one past the last char written. No null terminator is
+/// written.
+///
+/// output is identical to printf("%.*f") in the "C" locale for all finite
+/// values, except that non-finite values are always written as "inf",
+/// "-inf" or "nan".
+///
+/// precision must not exceed MAX_FIXED_PRECISION, buf must hold at least
+/// MAX_FIXED_FORMAT_SIZE chars
+///
+char*
+format_fixed(const double val,
+             const unsigned precision,
+             char* buf);
+
+
+/// write val to buf as printf("%g") would in the "C" locale, and return a
+/// pointer one past the last char written. No null terminator is written.
+///
+/// non-finite values are written as for format_fixed. buf must hold at
+/// least MAX_GENERAL_FORMAT_SIZE chars
+///
+char*
+format_general(const double val,
+               char* buf);
+
+#endif
@@ -36,6 +36,7 @@
 #include "blt_exception.hh"
 
 
+#include <deque>
 #include <map>
 #include <vector>
 
@@ -43,6 +44,8 @@
 /// \brief Provides something like a set, but with sequential id numbers
 /// assigned to each key starting from 0
 ///
+/// References returned by get_key() remain valid as new keys are inserted
+///
 template <typename K>
 struct id_set {
 
@@ -90,7 +93,7 @@ private:
     typedef std::map<K,unsigned> k2id_t;
 
     k2id_t _k2id;
-    std::vector<K> _id2k;
+    std::deque<K> _id2k;
 };
 
 
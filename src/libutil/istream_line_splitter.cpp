@@ -43,28 +43,6 @@
 
 
 
-void
-istream_line_splitter::
-write_line(std::ostream& os) const {
-    for (unsigned i(0); i<_n_word; ++i) {
-        if (i) os << _sep;
-        os << word[i];
-    }
-    os << "\n";
-}
-
-
-
-void
-istream_line_splitter::
-dump(std::ostream& os) const {
-    os << "\tline_no: " << _line_no << "\n";
-    os << "\tline: ";
-    write_line(os);
-}
-
-
-
 void
 istream_line_splitter::
 increase_buffer_size() {
@@ -136,20 +114,6 @@ parse_line() {
     if (NULL == _buf) return false;
     assert(buflen);
 
-    // do a low-level separator parse:
-    {
-        char* p(_buf);
-        word[0]=p;
-        unsigned i(1);
-        while (i<_max_word) {
-            if ((*p == '\n') || (*p == '\0')) break;
-            if (*p == _sep) {
-                *p = '\0';
-                word[i++] = p+1;
-            }
-            ++p;
-        }
-        _n_word=i;
-    }
+    split_line(_buf);
     return true;
 }
@@ -0,0 +1,236 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// input stage which reads complete line batches ahead of the parser
+///
+
+#include "blt_exception.hh"
+#include "line_batch_reader.hh"
+
+#include <cassert>
+#include <cstring>
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+
+
+void
+line_batch_stats::
+report(std::ostream& os) const {
+    os << "INPUT_BATCH_COUNT: " << batch_count << "\n";
+    os << "INPUT_READER_STALL_COUNT: " << reader_stall_count << "\n";
+    os << "INPUT_PARSER_STALL_COUNT: " << parser_stall_count << "\n";
+}
+
+
+
+struct line_batch_read_task : public thread_task {
+
+    explicit
+    line_batch_read_task(line_batch_reader& reader)
+        : _reader(reader)
+    {}
+
+    void
+    run() { _reader.read_batches(); }
+
+private:
+    line_batch_reader& _reader;
+};
+
+
+
+line_batch_reader::
+line_batch_reader(std::auto_ptr<byte_source> src,
+                  const size_t batch_size,
+                  const bool is_threaded,
+                  const unsigned batch_count)
+    : _src(src)
+    , _is_src_eof(false)
+    , _batches(std::max(batch_count,2u))
+    , _current(NULL)
+    , _is_reader_done(false)
+    , _is_stop(false)
+{
+    assert(NULL != _src.get());
+    assert(batch_size>0);
+
+    const unsigned bs(_batches.size());
+    for (unsigned i(0); i<bs; ++i) {
+        _batches[i].buf.resize(batch_size+1);
+        _batches[i].size=0;
+        _free.push_back(&(_batches[i]));
+    }
+
+    if (! is_threaded) return;
+    _task.reset(new line_batch_read_task(*this));
+    _pool.reset(new thread_pool(1));
+    _pool->submit(*_task);
+}
+
+
+
+line_batch_reader::
+~line_batch_reader() {
+    if (NULL == _pool.get()) return;
+    {
+        thread_lock lock(_mutex);
+        _is_stop=true;
+        _free_cond.signal();
+    }
+    _pool.reset();
+}
+
+
+
+bool
+line_batch_reader::
+fill_batch(line_batch& batch) {
+    size_t filled(_carry.size());
+    if (filled > batch.capacity()) batch.buf.resize(filled+1);
+    if (filled>0) memcpy(batch.data(),&(_carry[0]),filled);
+    _carry.clear();
+
+    while (true) {
+        while ((! _is_src_eof) && (filled < batch.capacity())) {
+            const size_t ret(_src->read(batch.data()+filled,batch.capacity()-filled));
+            if (0 == ret) {
+                _is_src_eof=true;
+            } else {
+                filled += ret;
+            }
+        }
+
+        if (_is_src_eof) {
+            batch.size=filled;
+            return (filled>0);
+        }
+
+        const void* nl(memrchr(batch.data(),'\n',filled));
+        if (NULL != nl) {
+            batch.size=(static_cast<const char*>(nl)-batch.data())+1;
+            _carry.assign(batch.data()+batch.size,batch.data()+filled);
+            return true;
+        }
+
+        // no complete line in a full batch, so grow the batch:
+        batch.buf.resize(batch.capacity()*2+1);
+    }
+}
+
+
+
+void
+line_batch_reader::
+read_batches() {
+    try {
+        while (true) {
+            line_batch* batch(NULL);
+            {
+                thread_lock lock(_mutex);
+                if (_free.empty() && (! _is_stop)) {
+                    _stats.reader_stall_count++;
+                    while (_free.empty() && (! _is_stop)) _free_cond.wait(_mutex);
+                }
+                if (_is_stop) return;
+                batch=_free.front();
+                _free.pop_front();
+            }
+
+            const bool is_data(fill_batch(*batch));
+
+            thread_lock lock(_mutex);
+            if (is_data) {
+                _full.push_back(batch);
+            } else {
+                _free.push_back(batch);
+            }
+            if (_is_src_eof) _is_reader_done=true;
+            _full_cond.signal();
+            if (_is_reader_done) return;
+        }
+    } catch (const std::exception& e) {
+        thread_lock lock(_mutex);
+        _error=e.what();
+        _is_reader_done=true;
+        _full_cond.signal();
+    } catch (...) {
+        thread_lock lock(_mutex);
+        _error="ERROR: unknown exception in input reader thread\n";
+        _is_reader_done=true;
+        _full_cond.signal();
+    }
+}
+
+
+
+line_batch*
+line_batch_reader::
+next_batch() {
+    if (NULL == _pool.get()) {
+        // read on the calling thread:
+        if (NULL != _current) _free.push_back(_current);
+        _current=_free.front();
+        _free.pop_front();
+        if (fill_batch(*_current)) {
+            _stats.batch_count++;
+            return _current;
+        }
+        return NULL;
+    }
+
+    thread_lock lock(_mutex);
+    if (NULL != _current) {
+        _free.push_back(_current);
+        _current=NULL;
+        _free_cond.signal();
+    }
+    if (_full.empty() && (! _is_reader_done)) {
+        _stats.parser_stall_count++;
+        while (_full.empty() && (! _is_reader_done)) _full_cond.wait(_mutex);
+    }
+    if (! _full.empty()) {
+        _current=_full.front();
+        _full.pop_front();
+        _stats.batch_count++;
+        return _current;
+    }
+    if (! _error.empty()) throw blt_exception(_error.c_str());
+    return NULL;
+}
+
+
+
+line_batch_stats
+line_batch_reader::
+get_stats() const {
+    thread_lock lock(_mutex);
+    return _stats;
+}
@@ -0,0 +1,164 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// input stage which reads complete line batches ahead of the parser
+///
+
+#ifndef __LINE_BATCH_READER_HH
+#define __LINE_BATCH_READER_HH
+
+#include "byte_source.hh"
+#include "thread_util.hh"
+
+#include <cstddef>
+
+#include <deque>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/// buffer holding a run of complete input lines
+///
+/// data[size] is always writable, so that the final line of the input can
+/// be terminated in place even when it lacks a newline
+///
+struct line_batch {
+
+    char*
+    data() { return &(buf[0]); }
+
+    // capacity of the buffer, excluding the terminator byte:
+    size_t
+    capacity() const { return buf.size()-1; }
+
+    std::vector<char> buf;
+    size_t size;
+};
+
+
+
+/// queue counters used to tell whether input or parsing limits throughput
+struct line_batch_stats {
+
+    line_batch_stats()
+        : batch_count(0)
+        , reader_stall_count(0)
+        , parser_stall_count(0)
+    {}
+
+    void
+    report(std::ostream& os) const;
+
+    /// number of batches passed to the parser
+    unsigned long batch_count;
+
+    /// number of times the reader waited for the parser to release a
+    /// batch (parser bound)
+    unsigned long reader_stall_count;
+
+    /// number of times the parser waited for the reader to fill a batch
+    /// (input bound)
+    unsigned long parser_stall_count;
+};
+
+
+
+/// reads a byte_source into batches of complete lines
+///
+/// If threaded, input is read on a separate thread which fills up to
+/// batch_count batches ahead of the parser, and batches are handed to the
+/// parser in input order through a bounded queue. Otherwise each batch is
+/// read on request on the calling thread.
+///
+/// Each batch ends on a newline except for the last batch of the input.
+/// The unterminated tail of each read is carried over to the start of the
+/// next batch, and batches grow as required to hold lines which are longer
+/// than the batch size.
+///
+struct line_batch_reader {
+
+    enum { DEFAULT_BATCH_COUNT = 4 };
+
+    line_batch_reader(std::auto_ptr<byte_source> src,
+                      const size_t batch_size,
+                      const bool is_threaded,
+                      const unsigned batch_count = DEFAULT_BATCH_COUNT);
+
+    /// stops the reader thread without reading the remaining input
+    ~line_batch_reader();
+
+    /// get the next batch of input, and release the previous batch back to
+    /// the reader
+    ///
+    /// \returns NULL at the end of input. Read errors are thrown as blt_exception
+    ///
+    line_batch*
+    next_batch();
+
+    line_batch_stats
+    get_stats() const;
+
+private:
+    line_batch_reader(const line_batch_reader&);
+    line_batch_reader& operator=(const line_batch_reader&);
+
+    friend struct line_batch_read_task;
+
+    // reader thread loop:
+    void
+    read_batches();
+
+    // fill batch with the carried tail and new input, returns false if the
+    // batch is empty at the end of input
+    bool
+    fill_batch(line_batch& batch);
+
+    std::auto_ptr<byte_source> _src;
+    bool _is_src_eof;
+    std::vector<char> _carry;
+
+    std::vector<line_batch> _batches;
+    line_batch* _current;
+
+    mutable thread_mutex _mutex;
+    thread_condition _free_cond;
+    thread_condition _full_cond;
+    std::deque<line_batch*> _free;
+    std::deque<line_batch*> _full;
+    bool _is_reader_done;
+    bool _is_stop;
+    std::string _error;
+    line_batch_stats _stats;
+
+    std::auto_ptr<thread_task> _task;
+    std::auto_ptr<thread_pool> _pool;
+};
+
+#endif
@@ -0,0 +1,78 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// common interface for the in-place line/word splitters
+///
+
+#include "line_splitter.hh"
+#include "output_buffer.hh"
+#include "tokenize_util.hh"
+
+#include <iostream>
+
+
+
+void
+line_splitter::
+write_line(std::ostream& os) const {
+    for (unsigned i(0); i<_n_word; ++i) {
+        if (i) os << _sep;
+        os << word[i];
+    }
+    os << "\n";
+}
+
+
+
+void
+line_splitter::
+write_line(output_buffer& ob) const {
+    for (unsigned i(0); i<_n_word; ++i) {
+        if (i) ob.append(_sep);
+        ob.append(word[i]);
+    }
+    ob.append('\n');
+}
+
+
+
+void
+line_splitter::
+dump(std::ostream& os) const {
+    os << "\tline_no: " << _line_no << "\n";
+    os << "\tline: ";
+    write_line(os);
+}
+
+
+
+void
+line_splitter::
+split_line(char* p) {
+    _n_word=tokenize_line(p,_sep,word,_max_word);
+}
@@ -0,0 +1,108 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// common interface for the in-place line/word splitters
+///
+
+#ifndef LINE_SPLITTER_HH__
+#define LINE_SPLITTER_HH__
+
+#include <iosfwd>
+
+
+struct output_buffer;
+
+
+/// base class for all objects which read a line of input and split it
+/// into words in place
+///
+/// word[] pointers refer directly into the splitter's input buffer, and
+/// are only valid until the next call to parse_line()
+///
+struct line_splitter {
+
+    line_splitter(const char word_seperator='\t',
+                  const unsigned max_word=0)
+        : _line_no(0)
+        , _n_word(0)
+        , _sep(word_seperator)
+        , _max_word(max_word)
+    {
+        if ((0==_max_word) || (MAX_WORD_COUNT < _max_word)) {
+            _max_word=MAX_WORD_COUNT;
+        }
+    }
+
+    virtual ~line_splitter() {}
+
+    unsigned
+    n_word() const { return _n_word; }
+
+    /// input line number of the current line
+    unsigned
+    line_no() const { return _line_no; }
+
+    /// returns false for regular end of input:
+    virtual
+    bool
+    parse_line() = 0;
+
+    /// write input statistics, for splitters which collect any
+    virtual
+    void
+    report_input_stats(std::ostream& /*os*/) const {}
+
+    // recreates the line before parsing
+    void
+    write_line(std::ostream& os) const;
+
+    void
+    write_line(output_buffer& ob) const;
+
+    // debug output, which provides line number and other info before calling write_line
+    void
+    dump(std::ostream& os) const;
+
+
+    enum { MAX_WORD_COUNT = 50 };
+    char* word[MAX_WORD_COUNT];
+
+protected:
+
+    // low-level separator parse of a null-terminated line
+    void
+    split_line(char* line);
+
+    unsigned _line_no;
+    unsigned _n_word;
+    char _sep;
+    unsigned _max_word;
+};
+
+
+#endif
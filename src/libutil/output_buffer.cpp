@@ -0,0 +1,252 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// buffered output sink for record writers
+///
+
+#include "blt_exception.hh"
+#include "output_buffer.hh"
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+
+#include <algorithm>
+#include <sstream>
+
+
+
+output_buffer::
+output_buffer(const int fd,
+              const size_t buffer_size)
+    : _fd(fd)
+    , _sink(NULL)
+    , _tee(NULL)
+{
+    init_buffer(buffer_size);
+}
+
+
+
+output_buffer::
+output_buffer(std::streambuf* sink,
+              const size_t buffer_size)
+    : _fd(-1)
+    , _sink(sink)
+    , _tee(NULL)
+{
+    assert(NULL != sink);
+    init_buffer(buffer_size);
+}
+
+
+
+output_buffer::
+~output_buffer() {
+    try {
+        flush();
+    } catch (...) {}
+}
+
+
+
+void
+output_buffer::
+init_buffer(const size_t buffer_size) {
+    _buf.resize(std::max(buffer_size,static_cast<size_t>(MAX_INT_FORMAT_SIZE)));
+    setp(&(_buf[0]),&(_buf[0])+_buf.size());
+}
+
+
+
+void
+output_buffer::
+flush() {
+    write_sink(NULL,0);
+}
+
+
+
+void
+output_buffer::
+set_sink(const int fd) {
+    flush();
+    _fd=fd;
+    _sink=NULL;
+}
+
+
+
+void
+output_buffer::
+set_sink(std::streambuf* sink) {
+    assert(NULL != sink);
+    flush();
+    _fd=-1;
+    _sink=sink;
+}
+
+
+
+void
+output_buffer::
+set_tee(std::streambuf* tee) {
+    // replace the tee even if the flush fails, so that it is never left
+    // pointing to a destroyed stream:
+    try {
+        flush();
+    } catch (...) {
+        _tee=tee;
+        throw;
+    }
+    _tee=tee;
+}
+
+
+
+void
+output_buffer::
+append_large(const char* s,
+             const size_t size) {
+    if (size < _buf.size()) {
+        flush();
+        memcpy(pptr(),s,size);
+        pbump(static_cast<int>(size));
+    } else {
+        // skip the copy for anything as large as the buffer itself:
+        write_sink(s,size);
+    }
+}
+
+
+
+void
+output_buffer::
+write_sink(const char* s,
+           const size_t size) {
+
+    const size_t buffer_size(pptr()-pbase());
+    if ((0 == buffer_size) && (0 == size)) return;
+
+    // reset the put area first so that no output is repeated after an error:
+    setp(&(_buf[0]),&(_buf[0])+_buf.size());
+
+    if (NULL != _tee) {
+        if ((static_cast<std::streamsize>(buffer_size) != _tee->sputn(&(_buf[0]),buffer_size)) ||
+            (static_cast<std::streamsize>(size) != _tee->sputn(s,size))) {
+            throw blt_exception("ERROR: failed to write output copy\n");
+        }
+    }
+
+    if (NULL != _sink) {
+        if ((static_cast<std::streamsize>(buffer_size) != _sink->sputn(&(_buf[0]),buffer_size)) ||
+            (static_cast<std::streamsize>(size) != _sink->sputn(s,size))) {
+            throw blt_exception("ERROR: failed to write output\n");
+        }
+        return;
+    }
+
+    struct iovec iov[2];
+    iov[0].iov_base = &(_buf[0]);
+    iov[0].iov_len = buffer_size;
+    iov[1].iov_base = const_cast<char*>(s);
+    iov[1].iov_len = size;
+
+    struct iovec* iovp(iov);
+    int iovcnt(2);
+    while (iovcnt) {
+        if (0 == iovp->iov_len) {
+            iovp++;
+            iovcnt--;
+            continue;
+        }
+        const ssize_t nw(writev(_fd,iovp,iovcnt));
+        if (nw < 0) {
+            if (errno == EINTR) continue;
+            std::ostringstream oss;
+            oss << "ERROR: failed to write output: " << strerror(errno) << "\n";
+            throw blt_exception(oss.str().c_str());
+        }
+        size_t left(nw);
+        while (iovcnt && (left >= iovp->iov_len)) {
+            left -= iovp->iov_len;
+            iovp++;
+            iovcnt--;
+        }
+        if (left) {
+            iovp->iov_base = static_cast<char*>(iovp->iov_base)+left;
+            iovp->iov_len -= left;
+        }
+    }
+}
+
+
+
+output_buffer::int_type
+output_buffer::
+overflow(int_type c) {
+    try {
+        flush();
+    } catch (...) {
+        return traits_type::eof();
+    }
+    if (! traits_type::eq_int_type(c,traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+
+
+std::streamsize
+output_buffer::
+xsputn(const char* s,
+       std::streamsize n) {
+    try {
+        append(s,n);
+    } catch (...) {
+        return 0;
+    }
+    return n;
+}
+
+
+
+int
+output_buffer::
+sync() {
+    try {
+        flush();
+    } catch (...) {
+        return -1;
+    }
+    return 0;
+}
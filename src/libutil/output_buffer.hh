@@ -0,0 +1,175 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// buffered output sink for record writers
+///
+
+#ifndef __OUTPUT_BUFFER_HH
+#define __OUTPUT_BUFFER_HH
+
+#include "format_util.hh"
+
+#include <cstddef>
+#include <cstring>
+
+#include <streambuf>
+#include <string>
+#include <vector>
+
+
+/// output sink which appends bytes and numbers to a large contiguous
+/// buffer, and only writes output when the buffer is full or on flush()
+///
+/// output goes either to a file descriptor, using write()/writev()
+/// directly, or to another streambuf (eg. a bgzf_streambuf). The object is
+/// itself a std::streambuf, so an ostream may be attached to it for
+/// formatted header output, which is ordered with appended record output.
+/// Output may also be copied to a second streambuf with set_tee().
+///
+/// write errors are thrown as blt_exception
+///
+struct output_buffer : public std::streambuf {
+
+    enum { DEFAULT_BUFFER_SIZE = 1024*1024 };
+
+    explicit
+    output_buffer(const int fd,
+                  const size_t buffer_size = DEFAULT_BUFFER_SIZE);
+
+    explicit
+    output_buffer(std::streambuf* sink,
+                  const size_t buffer_size = DEFAULT_BUFFER_SIZE);
+
+    /// remaining output is flushed, but write errors are ignored
+    ~output_buffer();
+
+    void
+    append(const char* s,
+           const size_t size) {
+        if (size <= static_cast<size_t>(epptr()-pptr())) {
+            memcpy(pptr(),s,size);
+            pbump(static_cast<int>(size));
+        } else {
+            append_large(s,size);
+        }
+    }
+
+    void
+    append(const char* s) { append(s,strlen(s)); }
+
+    void
+    append(const std::string& s) { append(s.data(),s.size()); }
+
+    void
+    append(const char c) {
+        if (pptr() == epptr()) flush();
+        *pptr() = c;
+        pbump(1);
+    }
+
+    // integers are formatted directly into the buffer when there is room:
+    void
+    append_uint(const unsigned long val) {
+        if (static_cast<size_t>(epptr()-pptr()) >= MAX_INT_FORMAT_SIZE) {
+            pbump(static_cast<int>(format_uint(val,pptr())-pptr()));
+        } else {
+            char tmp[MAX_INT_FORMAT_SIZE];
+            append(tmp,format_uint(val,tmp)-tmp);
+        }
+    }
+
+    void
+    append_int(const long val) {
+        if (static_cast<size_t>(epptr()-pptr()) >= MAX_INT_FORMAT_SIZE) {
+            pbump(static_cast<int>(format_int(val,pptr())-pptr()));
+        } else {
+            char tmp[MAX_INT_FORMAT_SIZE];
+            append(tmp,format_int(val,tmp)-tmp);
+        }
+    }
+
+    /// append val with precision digits after the decimal point, see
+    /// format_fixed
+    void
+    append_fixed(const double val,
+                 const unsigned precision) {
+        char tmp[MAX_FIXED_FORMAT_SIZE];
+        append(tmp,format_fixed(val,precision,tmp)-tmp);
+    }
+
+    /// write all buffered output to the sink
+    void
+    flush();
+
+    /// flush buffered output and direct all further output to sink
+    void
+    set_sink(const int fd);
+
+    void
+    set_sink(std::streambuf* sink);
+
+    /// flush buffered output and copy all further output to tee as well as
+    /// the sink. A NULL tee stops the copy
+    void
+    set_tee(std::streambuf* tee);
+
+protected:
+    int_type
+    overflow(int_type c);
+
+    std::streamsize
+    xsputn(const char* s,
+           std::streamsize n);
+
+    int
+    sync();
+
+private:
+    output_buffer(const output_buffer&);
+    output_buffer& operator=(const output_buffer&);
+
+    void
+    init_buffer(const size_t buffer_size);
+
+    // append data which does not fit in the remaining buffer space:
+    void
+    append_large(const char* s,
+                 const size_t size);
+
+    // write buffered output followed by (s,size) to the sink:
+    void
+    write_sink(const char* s,
+               const size_t size);
+
+    int _fd;
+    std::streambuf* _sink;
+    std::streambuf* _tee;
+    std::vector<char> _buf;
+};
+
+#endif
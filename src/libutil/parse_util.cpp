@@ -54,8 +54,47 @@ parse_exception(const char* type_label,
 
 
 
+// value of a decimal digit, or a value greater than 9 for any other char:
+static
+inline
 unsigned
-parse_unsigned(const char*& s) {
+digit_value(const char c) {
+    return static_cast<unsigned>(static_cast<unsigned char>(c))-static_cast<unsigned>('0');
+}
+
+
+
+// The fast paths below handle plain decimal input which is short enough
+// that it can't overflow (or for doubles, lose exactness), and leave
+// everything else (signs, whitespace, exponents, very long values and
+// all error reporting) to the general parsers.
+//
+// each returns false if the input was not handled:
+//
+template <typename T>
+static
+bool
+fast_parse_decimal(const char*& s,
+                   const unsigned max_digits,
+                   T& val) {
+    const char* p(s);
+    unsigned digit(digit_value(*p));
+    if (digit > 9) return false;
+    val=0;
+    do {
+        if (static_cast<unsigned>(p-s) >= max_digits) return false;
+        val = (val*10) + digit;
+        digit = digit_value(*(++p));
+    } while (digit <= 9);
+    s=p;
+    return true;
+}
+
+
+
+static
+unsigned
+parse_unsigned_general(const char*& s) {
 
     static const int base(10);
 
@@ -79,6 +118,16 @@ parse_unsigned(const char*& s) {
 
 
 
+unsigned
+parse_unsigned(const char*& s) {
+    // 9 digits always fit in 32 bits:
+    unsigned val;
+    if (fast_parse_decimal(s,9,val)) return val;
+    return parse_unsigned_general(s);
+}
+
+
+
 unsigned
 parse_unsigned_str(const std::string& s) {
     const char* s2(s.c_str());
@@ -120,8 +169,9 @@ parse_int_str(const std::string& s) {
 
 
 
+static
 long
-parse_long(const char*& s) {
+parse_long_general(const char*& s) {
 
     static const int base(10);
 
@@ -141,6 +191,23 @@ parse_long(const char*& s) {
 
 
 
+long
+parse_long(const char*& s) {
+    // 18 digits always fit in 64 bits, for 32 bit long defer to
+    // strtol for anything longer than 9 digits:
+    static const unsigned max_digits((sizeof(long) >= 8) ? 18 : 9);
+
+    const char* p(s);
+    const bool is_neg('-' == *p);
+    if (is_neg) ++p;
+    long val;
+    if (! fast_parse_decimal(p,max_digits,val)) return parse_long_general(s);
+    s=p;
+    return (is_neg ? -val : val);
+}
+
+
+
 long
 parse_long_str(const std::string& s) {
     const char* s2(s.c_str());
@@ -153,8 +220,63 @@ parse_long_str(const std::string& s) {
 
 
 
+// fast path for short decimal doubles such as '37.25': up to 15
+// significant digits are accumulated exactly into an integer, and a
+// single division by an exact power of ten then gives the correctly
+// rounded result.
+//
+bool
+fast_parse_double(const char*& s,
+                  const char* s_end,
+                  double& val) {
+    static const unsigned max_digits(15);
+    static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+                                    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+                                  };
+
+    // s_end is NULL for null-terminated input, in which case p
+    // never reaches it and the terminator stops the parse:
+    const char* p(s);
+    if (p == s_end) return false;
+    const bool is_neg('-' == *p);
+    if (is_neg) ++p;
+
+    unsigned long long mant(0);
+    unsigned n_digit(0);
+    unsigned n_frac(0);
+    unsigned digit;
+    while ((p != s_end) && ((digit=digit_value(*p)) <= 9)) {
+        if (n_digit >= max_digits) return false;
+        mant = (mant*10) + digit;
+        n_digit++;
+        ++p;
+    }
+    if (0 == n_digit) return false;
+
+    if ((p != s_end) && ('.' == *p)) {
+        ++p;
+        while ((p != s_end) && ((digit=digit_value(*p)) <= 9)) {
+            if (n_digit >= max_digits) return false;
+            mant = (mant*10) + digit;
+            n_digit++;
+            n_frac++;
+            ++p;
+        }
+    }
+
+    // leave exponents to the general parser:
+    if ((p != s_end) && (('e' == *p) || ('E' == *p))) return false;
+
+    val = static_cast<double>(mant)/pow10[n_frac];
+    if (is_neg) val = -val;
+    s=p;
+    return true;
+}
+
+
+
 double
-parse_double(
+parse_double_general(
         const char*& s,
         const char* s_end)
 {
@@ -175,6 +297,18 @@ parse_double(
 
 
 
+double
+parse_double(
+        const char*& s,
+        const char* s_end)
+{
+    double val;
+    if (fast_parse_double(s,s_end,val)) return val;
+    return parse_double_general(s,s_end);
+}
+
+
+
 double
 parse_double_str(
     const std::string& s)
@@ -56,6 +56,27 @@ parse_double(
 
 
 
+/// the two halves of parse_double, exposed so that they can be compared
+/// in tests:
+///
+/// fast_parse_double handles short plain decimal input only, and returns
+/// false without advancing s for any other input
+///
+bool
+fast_parse_double(
+    const char*& s,
+    const char* s_end,
+    double& val);
+
+/// parse_double_general accepts any input accepted by parse_double
+///
+double
+parse_double_general(
+    const char*& s,
+    const char* s_end = NULL);
+
+
+
 /// std::string version of above, no ptr advance obviously. explicit rename
 /// of functions gaurds against unexpected std::string temporaries
 ///
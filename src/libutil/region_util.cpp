@@ -30,14 +30,16 @@
 ///
 
 
+#include "blt_exception.hh"
+#include "parse_util.hh"
 #include "region_util.hh"
 
 #include <cstdlib>
+#include <cstring>
 
 #include <algorithm>
 #include <fstream>
 #include <iostream>
-#include <limits>
 
 namespace region_util {
 
@@ -60,33 +62,43 @@ parse_bedfile_regions(const std::string& region_file,
     unsigned line_no(0);
     bool is_parse_fail(false);
 
+    static const char* whitespace(" \t\r");
+    std::string line;
     std::string bed_chrom;
-    unsigned bed_begin(0),bed_end(0);
 
-    while (! region_is.eof()) {
+    while (std::getline(region_is,line)) {
         ++line_no;
 
-        region_is >> bed_chrom;
-        if (region_is.fail()) {
-            if (! region_is.eof()) is_parse_fail=true;
-            break;
-        }
-
-        if (bed_chrom != "track" && bed_chrom != "browser") {
-
-            region_is >> bed_begin >> bed_end;
-            if (region_is.fail() || (bed_end<bed_begin)) {
+        const size_t chrom_start(line.find_first_not_of(whitespace));
+        if (chrom_start == std::string::npos) continue;
+        const size_t chrom_end(line.find_first_of(whitespace,chrom_start));
+        bed_chrom.assign(line,chrom_start,chrom_end-chrom_start);
+
+        if (bed_chrom == "track" || bed_chrom == "browser") continue;
+
+        // parse the begin and end columns, each must be followed by
+        // whitespace or the end of the line:
+        unsigned bed_pos[2];
+        const char* s(line.c_str()+((chrom_end == std::string::npos) ? line.size() : chrom_end));
+        for (unsigned i(0); i<2; ++i) {
+            s += strspn(s,whitespace);
+            try {
+                bed_pos[i]=parse_unsigned(s);
+            } catch (const blt_exception&) {
                 is_parse_fail=true;
                 break;
             }
-
-            if (regions.find(bed_chrom) == regions.end()) {
-                regions[bed_chrom] = interval_group_t();
+            if (('\0' != *s) && (NULL == strchr(whitespace,*s))) {
+                is_parse_fail=true;
+                break;
             }
-            regions[bed_chrom].push_back(std::make_pair(bed_begin,bed_end));
+        }
+        if (is_parse_fail || (bed_pos[1]<bed_pos[0])) {
+            is_parse_fail=true;
+            break;
         }
 
-        region_is.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        regions[bed_chrom].push_back(std::make_pair(bed_pos[0],bed_pos[1]));
     }
 
     if (is_parse_fail) {
@@ -153,4 +165,44 @@ get_regions(const std::string& region_file,
 }
 
 
+
+
+
+bool
+parse_region_string(const std::string& region,
+                    std::string& chrom,
+                    int& begin,
+                    int& end) {
+
+    begin=0;
+    end=MAX_REGION_END;
+
+    const size_t colon(region.rfind(':'));
+    chrom.assign(region,0,colon);
+    if (chrom.empty()) return false;
+    if (colon == std::string::npos) return true;
+
+    // remove position digit separators:
+    std::string pos_str;
+    for (size_t i(colon+1); i<region.size(); ++i) {
+        if (',' != region[i]) pos_str.push_back(region[i]);
+    }
+    if (pos_str.empty()) return true;
+
+    const char* s(pos_str.c_str());
+    try {
+        begin=static_cast<int>(parse_unsigned(s))-1;
+        if ('-' == *s) {
+            s++;
+            if ('\0' != *s) end=static_cast<int>(parse_unsigned(s));
+        }
+    } catch (const blt_exception&) {
+        return false;
+    }
+    if ('\0' != *s) return false;
+    if (begin<0) begin=0;
+    return (begin < end);
+}
+
+
 }
@@ -48,6 +48,22 @@ typedef std::map<std::string,interval_group_t> region_t;
 void
 get_regions(const std::string& region_file,
             region_t& regions);
+
+
+/// end position used for a region string without an end position
+enum { MAX_REGION_END = (1<<29) };
+
+/// parse a samtools style region string, 'chrom', 'chrom:begin' or
+/// 'chrom:begin-end', with 1-indexed inclusive positions which may contain
+/// commas. begin and end are set to the zero-indexed half-open interval
+///
+/// returns false for a malformed region string
+///
+bool
+parse_region_string(const std::string& region,
+                    std::string& chrom,
+                    int& begin,
+                    int& end);
 }
 
 #endif
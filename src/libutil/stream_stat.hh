@@ -66,6 +66,26 @@ struct stream_stat {
         Q_+=delta*(x-M_);
     }
 
+    /// combine with statistics accumulated over a disjoint set of values,
+    /// using the pairwise update of Chan, Golub & LeVeque
+    void merge(const stream_stat& rhs) {
+        if (rhs.k_==0) return;
+        if (k_==0) {
+            *this = rhs;
+            return;
+        }
+        if (rhs.max_>max_) max_=rhs.max_;
+        if (rhs.min_<min_) min_=rhs.min_;
+
+        const double n1(k_);
+        const double n2(rhs.k_);
+        const double n(n1+n2);
+        const double delta(rhs.M_-M_);
+        M_+=delta*(n2/n);
+        Q_+=rhs.Q_+delta*delta*(n1*n2/n);
+        k_+=rhs.k_;
+    }
+
     int size() const { return k_; }
     bool empty() const { return (k_==0); }
 
@@ -43,16 +43,22 @@ split_string(const char* str,
              const char delimiter,
              std::vector<std::string>& v) {
 
-    v.clear();
+    // assign into the existing elements of v to reuse their storage:
+    unsigned n(0);
     while (true) {
         const char* next(strchr(str,delimiter));
-        if ((NULL == next) || (delimiter == '\0')) {
-            v.push_back(std::string(str));
-            return;
+        const bool is_last((NULL == next) || (delimiter == '\0'));
+        const size_t len(is_last ? strlen(str) : (next-str));
+        if (n < v.size()) {
+            v[n].assign(str,len);
+        } else {
+            v.push_back(std::string(str,len));
         }
-        v.push_back(std::string(str,next-str));
+        n++;
+        if (is_last) break;
         str = next+1;
     }
+    v.resize(n);
 }
 
 
@@ -35,6 +35,7 @@
 #include <vector>
 
 
+/// split str into v, storage of any existing elements in v is reused
 void
 split_string(const char* str,
              const char delimiter,
@@ -43,14 +43,3 @@ type_error(const char* tiname) {
     oss << "ERROR: Can't initialize stringer object for type: "  << tiname << "\n";
     throw blt_exception(oss.str().c_str());
 }
-
-
-
-void
-stringer_base::
-get32_error(const int write_size) const {
-    _buff32[31]='\0';
-    std::ostringstream oss;
-    oss << "ERROR: stringer.get32 failed to convert type to string. write_size: '" << write_size << " buffer: " << _buff32 << "'\n";
-    throw blt_exception(oss.str().c_str());
-}
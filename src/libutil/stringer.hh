@@ -32,11 +32,9 @@
 #ifndef __STRINGER_HH
 #define __STRINGER_HH
 
-#include "compat_util.hh"
+#include "format_util.hh"
 #include "scan_string.hh"
 
-#include <cstdio>
-
 #include <typeinfo>
 
 
@@ -50,7 +48,6 @@ struct stringer_base {
 protected:
     static
     void type_error(const char* tiname);
-    void get32_error(const int write_size) const;
 
     mutable char _buff32[32];
     const char* _scanstr;
@@ -59,6 +56,9 @@ protected:
 
 /// String conversion utility which is harder-to-use but faster than stringstream/lexical_cast
 ///
+/// This is a thin wrapper over format_int, which can be used directly to
+/// format into a caller's buffer
+///
 /// Safety notes:
 /// 1) client must create one object for each thread
 /// 2) The string pointer returned will be invalid at the next conversion call to stringer
@@ -75,11 +75,7 @@ struct stringer : public stringer_base {
 
     const char*
     get32(const T val) const {
-        static const unsigned buff_size(32);
-        const int write_size(snprintf(_buff32,buff_size,_scanstr,val));
-        if ((write_size<0) || (write_size >= static_cast<int>(buff_size))) {
-            get32_error(write_size);
-        }
+        *format_int(val,_buff32) = '\0';
         return _buff32;
     }
 };
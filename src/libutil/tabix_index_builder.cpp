@@ -0,0 +1,349 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// incremental tabix index construction for VCF data written in BGZF blocks
+///
+
+#include "blt_exception.hh"
+#include "tabix_index_builder.hh"
+
+#include "bgzf.h"
+#include "tabix.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#include <sstream>
+
+
+
+enum {
+    TAD_LIDX_SHIFT = 14
+};
+
+
+
+static
+unsigned
+reg2bin(const uint32_t beg,
+        uint32_t end) {
+    --end;
+    if (beg>>14 == end>>14) return 4681 + (beg>>14);
+    if (beg>>17 == end>>17) return  585 + (beg>>17);
+    if (beg>>20 == end>>20) return   73 + (beg>>20);
+    if (beg>>23 == end>>23) return    9 + (beg>>23);
+    if (beg>>26 == end>>26) return    1 + (beg>>26);
+    return 0;
+}
+
+
+
+tabix_index_builder::
+tabix_index_builder()
+    : _line_no(0)
+    , _last_tid(-1)
+    , _last_bin(0xffffffffu)
+    , _last_coor(-1)
+    , _save_tid(-1)
+    , _save_bin(0xffffffffu)
+    , _save_off(0)
+    , _last_off(0)
+    , _offset0(static_cast<uint64_t>(-1))
+{}
+
+
+
+void
+tabix_index_builder::
+add_block(const char* data,
+          const unsigned size,
+          const uint64_t block_address,
+          const uint64_t next_block_address) {
+
+    unsigned start(0);
+    while (start<size) {
+        const char* nl(static_cast<const char*>(memchr(data+start,'\n',size-start)));
+        if (NULL == nl) {
+            _partial_line.append(data+start,size-start);
+            break;
+        }
+        const unsigned line_end(nl-data);
+        const unsigned next(line_end+1);
+
+        // tabix reports the offset following a block-terminal newline at the start of the next block:
+        const uint64_t end_offset((next<size) ?
+                                  ((block_address<<16) | next) :
+                                  (next_block_address<<16));
+        if (_partial_line.empty()) {
+            process_line(data+start,line_end-start,end_offset);
+        } else {
+            _partial_line.append(data+start,line_end-start);
+            process_line(_partial_line.c_str(),_partial_line.size(),end_offset);
+            _partial_line.clear();
+        }
+        start=next;
+    }
+}
+
+
+
+int
+tabix_index_builder::
+get_tid(const char* name,
+        const unsigned len) {
+    const std::string key(name,len);
+    std::map<std::string,int>::const_iterator i(_name_map.find(key));
+    if (i != _name_map.end()) return i->second;
+
+    const int tid(_names.size());
+    _names.push_back(key);
+    _name_map[key]=tid;
+    _index.push_back(contig_index());
+    return tid;
+}
+
+
+
+uint64_t
+tabix_index_builder::
+insert_linear(contig_index& ci,
+              const int _beg,
+              const int _end) {
+    const unsigned beg(_beg >> TAD_LIDX_SHIFT);
+    const unsigned end((_end - 1) >> TAD_LIDX_SHIFT);
+    if (ci.linear.size() < (end+1)) ci.linear.resize(end+1,0);
+    for (unsigned i(beg); i<=end; ++i) {
+        if (0 == ci.linear[i]) ci.linear[i] = _last_off;
+    }
+    return (static_cast<uint64_t>(beg)<<32 | end);
+}
+
+
+
+// parse the interval as in ti_get_intv with the VCF preset:
+//
+void
+tabix_index_builder::
+process_line(const char* line,
+             const unsigned len,
+             const uint64_t end_offset) {
+
+    _line_no++;
+    if ((len>0) && (line[0] == '#')) {
+        _last_off = end_offset;
+        return;
+    }
+
+    const char* chrom(NULL);
+    unsigned chrom_len(0);
+    int beg(-1);
+    int end(-1);
+
+    unsigned col(1);
+    unsigned b(0);
+    for (unsigned i(0); i<=len; ++i) {
+        if ((i<len) && (line[i] != '\t')) continue;
+        if (1 == col) {
+            chrom=line+b;
+            chrom_len=i-b;
+        } else if (2 == col) {
+            beg = end = strtol(line+b,NULL,0);
+            --beg;
+            if (beg<0) beg=0;
+            if (end<1) end=1;
+        } else if (4 == col) {
+            if (b<i) end = beg + (i-b);
+        } else if (8 == col) {
+            const std::string info(line+b,i-b);
+            const char* s(strstr(info.c_str(),"END="));
+            if (s == info.c_str()) {
+                s += 4;
+            } else if (NULL != s) {
+                s = strstr(info.c_str(),";END=");
+                if (NULL != s) s += 5;
+            }
+            if (NULL != s) end = strtol(s,NULL,0);
+        }
+        b=i+1;
+        ++col;
+    }
+
+    if ((NULL == chrom) || (beg<0) || (end<0)) {
+        std::ostringstream oss;
+        oss << "ERROR: can't parse tabix interval from output line " << _line_no << ": '" << std::string(line,len) << "'\n";
+        throw blt_exception(oss.str().c_str());
+    }
+
+    const int tid(get_tid(chrom,chrom_len));
+    if (_last_tid != tid) {
+        if (_last_tid > tid) {
+            std::ostringstream oss;
+            oss << "ERROR: can't build tabix index: chromosome blocks are not continuous at output line " << _line_no << "\n";
+            throw blt_exception(oss.str().c_str());
+        }
+        _last_tid = tid;
+        _last_bin = 0xffffffffu;
+    } else if (_last_coor > beg) {
+        std::ostringstream oss;
+        oss << "ERROR: can't build tabix index: output is out of order at line " << _line_no << "\n";
+        throw blt_exception(oss.str().c_str());
+    }
+
+    const uint64_t tmp(insert_linear(_index[tid],beg,end));
+    if (0 == _last_off) _offset0 = tmp;
+
+    const unsigned bin(reg2bin(beg,end));
+    if (bin != _last_bin) {
+        if (_save_bin != 0xffffffffu) {
+            _index[_save_tid].bins[_save_bin].push_back(std::make_pair(_save_off,_last_off));
+        }
+        _save_off = _last_off;
+        _save_bin = _last_bin = bin;
+        _save_tid = tid;
+    }
+    _last_off = end_offset;
+    _last_coor = beg;
+}
+
+
+
+void
+tabix_index_builder::
+finish() {
+    if (! _partial_line.empty()) {
+        // unterminated final line:
+        const std::string line(_partial_line);
+        _partial_line.clear();
+        process_line(line.c_str(),line.size(),_last_off);
+    }
+
+    if (_save_tid >= 0) {
+        _index[_save_tid].bins[_save_bin].push_back(std::make_pair(_save_off,_last_off));
+    }
+
+    const unsigned n_contig(_index.size());
+    for (unsigned tid(0); tid<n_contig; ++tid) {
+        contig_index& ci(_index[tid]);
+
+        // merge chunks:
+        bin_index_t::iterator i(ci.bins.begin()), i_end(ci.bins.end());
+        for (; i!=i_end; ++i) {
+            std::vector<chunk_t>& p(i->second);
+            unsigned m(0);
+            for (unsigned l(1); l<p.size(); ++l) {
+                if ((p[m].second>>16) == (p[l].first>>16)) p[m].second = p[l].second;
+                else p[++m] = p[l];
+            }
+            p.resize(m+1);
+        }
+
+        // fill missing:
+        for (unsigned j(1); j<ci.linear.size(); ++j) {
+            if (0 == ci.linear[j]) ci.linear[j] = ci.linear[j-1];
+        }
+    }
+
+    if ((_offset0 != static_cast<uint64_t>(-1)) && (n_contig>0)) {
+        const unsigned beg(_offset0>>32);
+        const unsigned end(_offset0&0xffffffffu);
+        std::vector<uint64_t>& linear(_index[0].linear);
+        for (unsigned j(beg); (j<=end) && (j<linear.size()); ++j) linear[j] = 0;
+    }
+}
+
+
+
+static
+void
+write_int32(BGZF* fp,
+            const int32_t x) {
+    bgzf_write(fp,&x,4);
+}
+
+
+
+void
+tabix_index_builder::
+write(const std::string& filename) {
+
+    finish();
+
+    BGZF* fp(bgzf_open(filename.c_str(),"w"));
+    if (NULL == fp) {
+        std::ostringstream oss;
+        oss << "ERROR: can't create tabix index file: '" << filename << "'\n";
+        throw blt_exception(oss.str().c_str());
+    }
+
+    // values are written in host byte order, which matches ti_index_save
+    // on little-endian hosts:
+    bgzf_write(fp,"TBI\1",4);
+    const unsigned n_contig(_index.size());
+    write_int32(fp,n_contig);
+    write_int32(fp,ti_conf_vcf.preset);
+    write_int32(fp,ti_conf_vcf.sc);
+    write_int32(fp,ti_conf_vcf.bc);
+    write_int32(fp,ti_conf_vcf.ec);
+    write_int32(fp,ti_conf_vcf.meta_char);
+    write_int32(fp,ti_conf_vcf.line_skip);
+
+    int32_t name_len(0);
+    for (unsigned tid(0); tid<n_contig; ++tid) {
+        name_len += _names[tid].size()+1;
+    }
+    write_int32(fp,name_len);
+    for (unsigned tid(0); tid<n_contig; ++tid) {
+        bgzf_write(fp,_names[tid].c_str(),_names[tid].size()+1);
+    }
+
+    for (unsigned tid(0); tid<n_contig; ++tid) {
+        const contig_index& ci(_index[tid]);
+        write_int32(fp,ci.bins.size());
+        bin_index_t::const_iterator i(ci.bins.begin()), i_end(ci.bins.end());
+        for (; i!=i_end; ++i) {
+            const std::vector<chunk_t>& p(i->second);
+            write_int32(fp,i->first);
+            write_int32(fp,p.size());
+            for (unsigned j(0); j<p.size(); ++j) {
+                bgzf_write(fp,&(p[j].first),8);
+                bgzf_write(fp,&(p[j].second),8);
+            }
+        }
+        write_int32(fp,ci.linear.size());
+        if (! ci.linear.empty()) {
+            bgzf_write(fp,&(ci.linear[0]),8*ci.linear.size());
+        }
+    }
+
+    if (0 != bgzf_close(fp)) {
+        std::ostringstream oss;
+        oss << "ERROR: failed to write tabix index file: '" << filename << "'\n";
+        throw blt_exception(oss.str().c_str());
+    }
+}
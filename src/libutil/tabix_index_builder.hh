@@ -0,0 +1,111 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// incremental tabix index construction for VCF data written in BGZF blocks
+///
+
+#ifndef __TABIX_INDEX_BUILDER_HH
+#define __TABIX_INDEX_BUILDER_HH
+
+#include "bgzf_block_index.hh"
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+/// builds a VCF tabix index from BGZF blocks as they are written
+///
+/// the index follows the binning and linear index construction of
+/// ti_index_core in the redist tabix library, so that the result is
+/// equivalent to running 'tabix -p vcf' on the completed file.
+///
+struct tabix_index_builder : public bgzf_block_index {
+
+    tabix_index_builder();
+
+    void
+    add_block(const char* data,
+              const unsigned size,
+              const uint64_t block_address,
+              const uint64_t next_block_address);
+
+    void
+    write(const std::string& filename);
+
+    const char*
+    file_suffix() const { return ".tbi"; }
+
+private:
+
+    typedef std::pair<uint64_t,uint64_t> chunk_t;
+    typedef std::map<unsigned, std::vector<chunk_t> > bin_index_t;
+
+    struct contig_index {
+        bin_index_t bins;
+        std::vector<uint64_t> linear;
+    };
+
+    void
+    process_line(const char* line,
+                 const unsigned len,
+                 const uint64_t end_offset);
+
+    int
+    get_tid(const char* name,
+            const unsigned len);
+
+    uint64_t
+    insert_linear(contig_index& ci,
+                  const int beg,
+                  const int end);
+
+    void
+    finish();
+
+    std::vector<std::string> _names;
+    std::map<std::string,int> _name_map;
+    std::vector<contig_index> _index;
+
+    std::string _partial_line;
+    uint64_t _line_no;
+
+    // indexing state, named as in ti_index_core:
+    int _last_tid;
+    unsigned _last_bin;
+    int _last_coor;
+    int _save_tid;
+    unsigned _save_bin;
+    uint64_t _save_off;
+    uint64_t _last_off;
+    uint64_t _offset0;
+};
+
+#endif
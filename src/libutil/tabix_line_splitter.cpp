@@ -0,0 +1,180 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// line splitter reading selected regions of a tabix indexed file
+///
+
+#include "bcf_line_splitter.hh"
+#include "blt_exception.hh"
+#include "fd_line_splitter.hh"
+#include "parse_util.hh"
+#include "region_util.hh"
+#include "tabix_line_splitter.hh"
+
+#include <cstring>
+
+#include <algorithm>
+#include <sstream>
+
+
+
+tabix_line_splitter::
+tabix_line_splitter(const std::string& filename,
+                    const std::vector<std::string>& regions,
+                    const std::string& region_file,
+                    const char word_seperator,
+                    const unsigned max_word)
+    : line_splitter(word_seperator,max_word)
+    , _tfile(filename.c_str())
+    , _header_index(0)
+    , _region_index(0)
+    , _batch_index(0)
+    , _last_tid(-1)
+    , _last_pos(0)
+    , _skip_pos(0)
+{
+    const ti_index_t* idx(_tfile.tfp()->idx);
+
+    std::vector<query_region> qr;
+    query_region r;
+    const unsigned rs(regions.size());
+    for (unsigned i(0); i<rs; ++i) {
+        if (0 != ti_parse_region(idx,regions[i].c_str(),&r.tid,&r.begin,&r.end)) continue;
+        qr.push_back(r);
+    }
+
+    region_util::region_t bed_regions;
+    region_util::get_regions(region_file,bed_regions);
+    region_util::region_t::const_iterator i(bed_regions.begin()), i_end(bed_regions.end());
+    for (; i!=i_end; ++i) {
+        r.tid=ti_get_tid(idx,i->first.c_str());
+        if (r.tid < 0) continue;
+        const region_util::interval_group_t& ig(i->second);
+        const unsigned is(ig.size());
+        for (unsigned j(0); j<is; ++j) {
+            r.begin=ig[j].first;
+            r.end=ig[j].second;
+            qr.push_back(r);
+        }
+    }
+
+    // sort and merge overlapping regions:
+    std::sort(qr.begin(),qr.end());
+    const unsigned qs(qr.size());
+    for (unsigned j(0); j<qs; ++j) {
+        if (_regions.empty() ||
+            (_regions.back().tid != qr[j].tid) ||
+            (_regions.back().end < qr[j].begin)) {
+            _regions.push_back(qr[j]);
+        } else {
+            _regions.back().end=std::max(_regions.back().end,qr[j].end);
+        }
+    }
+}
+
+
+
+bool
+tabix_line_splitter::
+next_region() {
+    if (_region_index >= _regions.size()) return false;
+
+    const query_region& r(_regions[_region_index++]);
+    if (r.tid != _last_tid) {
+        _last_tid=r.tid;
+        _last_pos=0;
+    }
+    _skip_pos=_last_pos;
+    _tabs.reset(new tabix_streamer(_tfile,r.tid,r.begin,r.end));
+    _batch_index=0;
+    return true;
+}
+
+
+
+bool
+tabix_line_splitter::
+parse_line() {
+    _line_no++;
+
+    const std::vector<std::string>& header(_tfile.header());
+    if (_header_index < header.size()) {
+        const std::string& hline(header[_header_index++]);
+        _header_line.assign(hline.begin(),hline.end());
+        _header_line.push_back('\0');
+        split_line(&(_header_line[0]));
+        return true;
+    }
+
+    while (true) {
+        if ((NULL == _tabs.get()) || (_batch_index >= _tabs->batch_size())) {
+            if ((NULL != _tabs.get()) && (_tabs->next_batch(RECORD_BATCH_SIZE) > 0)) {
+                _batch_index=0;
+            } else {
+                if (! next_region()) return false;
+                continue;
+            }
+        }
+
+        char* line(_tabs->batch_line(_batch_index++));
+        const char* pos_str(strchr(line,_sep));
+        if (NULL == pos_str) {
+            std::ostringstream oss;
+            oss << "ERROR: unexpected record format in tabix input file: '" << _tfile.name() << "'\n";
+            throw blt_exception(oss.str().c_str());
+        }
+        pos_str++;
+        const int pos(parse_int(pos_str));
+        if (pos <= _skip_pos) continue;
+        _last_pos=pos;
+
+        split_line(line);
+        return true;
+    }
+}
+
+
+
+std::auto_ptr<line_splitter>
+open_vcf_line_splitter(const std::string& filename,
+                       const std::vector<std::string>& regions,
+                       const std::string& region_file,
+                       const unsigned worker_count) {
+
+    if (regions.empty() && region_file.empty()) {
+        return open_fd_line_splitter(filename,worker_count);
+    }
+
+    if (filename.empty() || (filename == "-")) {
+        throw blt_exception("ERROR: region input requires a tabix or CSI indexed input file\n");
+    }
+    if (is_bcf_file(filename)) {
+        return std::auto_ptr<line_splitter>(new bcf_line_splitter(filename,regions,region_file,worker_count));
+    }
+    return std::auto_ptr<line_splitter>(new tabix_line_splitter(filename,regions,region_file));
+}
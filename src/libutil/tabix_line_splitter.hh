@@ -0,0 +1,116 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// line splitter reading selected regions of a tabix indexed file
+///
+
+#ifndef TABIX_LINE_SPLITTER_HH__
+#define TABIX_LINE_SPLITTER_HH__
+
+#include "line_splitter.hh"
+#include "tabix_streamer.hh"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/// reads the header and then all records overlapping a set of regions
+/// from a bgzip compressed, tabix indexed file
+///
+/// Regions are given as samtools style region strings and/or a bed
+/// file. They are merged and queried in index order, so that the file is
+/// read front to back. A record overlapping more than one region is
+/// returned once. Regions on sequences which are not in the index are
+/// ignored.
+///
+struct tabix_line_splitter : public line_splitter {
+
+    tabix_line_splitter(const std::string& filename,
+                        const std::vector<std::string>& regions,
+                        const std::string& region_file,
+                        const char word_seperator='\t',
+                        const unsigned max_word=0);
+
+    bool
+    parse_line();
+
+private:
+    // start the query for the next region, returns false after the last
+    // region
+    bool
+    next_region();
+
+    struct query_region {
+
+        bool
+        operator<(const query_region& rhs) const {
+            if (tid != rhs.tid) return (tid < rhs.tid);
+            return (begin < rhs.begin);
+        }
+
+        int tid;
+        int begin;
+        int end;
+    };
+
+    enum { RECORD_BATCH_SIZE=256 };
+
+    tabix_file _tfile;
+    unsigned _header_index;
+    std::vector<char> _header_line;
+
+    std::vector<query_region> _regions;
+    unsigned _region_index;
+    std::auto_ptr<tabix_streamer> _tabs;
+    unsigned _batch_index;
+
+    // records in the current region at or before _skip_pos were already
+    // returned for a previous region on the same sequence:
+    int _last_tid;
+    int _last_pos;
+    int _skip_pos;
+};
+
+
+
+/// open a line splitter for tool input
+///
+/// If any regions or a region file are given, input is read from the
+/// tabix indexed file with tabix_line_splitter (or the CSI indexed BCF2
+/// file with bcf_line_splitter), otherwise the whole input is read with
+/// open_fd_line_splitter.
+///
+std::auto_ptr<line_splitter>
+open_vcf_line_splitter(const std::string& filename,
+                       const std::vector<std::string>& regions,
+                       const std::string& region_file,
+                       const unsigned worker_count);
+
+
+#endif
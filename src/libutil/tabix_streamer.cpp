@@ -36,6 +36,7 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
 #include <iostream>
 #include <set>
 #include <string>
@@ -106,16 +107,10 @@ next() {
 
 
 
-tabix_streamer::
-tabix_streamer(const char* filename,
-               const char* region)
-    : _is_record_set(false)
-    , _is_stream_end(false)
-    , _record_no(0)
-    , _stream_name(filename)
-    , _tfp(NULL)
-    , _titer(NULL)
-    , _linebuf(NULL)
+tabix_file::
+tabix_file(const char* filename)
+    : _tfp(NULL)
+    , _is_index_current(false)
 {
 
     if (NULL == filename) {
@@ -126,6 +121,7 @@ tabix_streamer(const char* filename,
         throw blt_exception("vcf filename is empty string");
     }
 
+    _filename=filename;
     _tfp = ti_open(filename, 0);
 
     if (NULL == _tfp) {
@@ -133,19 +129,100 @@ tabix_streamer(const char* filename,
         exit(EXIT_FAILURE);
     }
 
-    // read from a specific region:
     if (ti_lazy_index_load(_tfp) < 0) {
         log_os << "ERROR: Failed to load index for vcf file: '" << filename << "'\n";
         exit(EXIT_FAILURE);
     }
+    _is_index_current=is_tabix_index(filename);
+
+    // the header is read once here, streamers always seek to their
+    // region before reading:
+    ti_iter_t titer(ti_query(_tfp, 0, 0, 0));
+    int len;
+    const char* line;
+    while (NULL != (line = ti_read(_tfp, titer, &len))) {
+        if ((len<1) || (line[0] != '#')) break;
+        _header.push_back(std::string(line,len));
+    }
+    ti_iter_destroy(titer);
+}
+
+
+
+tabix_file::
+~tabix_file() {
+    if (NULL != _tfp) ti_close(_tfp);
+}
+
+
+
+tabix_streamer::
+tabix_streamer(const char* filename,
+               const char* region)
+    : _is_record_set(false)
+    , _is_stream_end(false)
+    , _record_no(0)
+    , _stream_name((NULL == filename) ? "" : filename)
+    , _own_file(new tabix_file(filename))
+    , _tfile(*_own_file)
+    , _tfp(_tfile.tfp())
+    , _titer(NULL)
+    , _linebuf(NULL)
+{
+    init(region);
+}
+
+
+
+tabix_streamer::
+tabix_streamer(tabix_file& tfile,
+               const char* region)
+    : _is_record_set(false)
+    , _is_stream_end(false)
+    , _record_no(0)
+    , _stream_name(tfile.name())
+    , _tfile(tfile)
+    , _tfp(_tfile.tfp())
+    , _titer(NULL)
+    , _linebuf(NULL)
+{
+    init(region);
+}
+
+
+
+tabix_streamer::
+tabix_streamer(tabix_file& tfile,
+               const int tid,
+               const int begin,
+               const int end)
+    : _is_record_set(false)
+    , _is_stream_end(false)
+    , _record_no(0)
+    , _stream_name(tfile.name())
+    , _tfile(tfile)
+    , _tfp(_tfile.tfp())
+    , _titer(NULL)
+    , _linebuf(NULL)
+{
+    if (! _tfile.is_index_current()) enforce_tabix_index(_tfile.name());
+    _titer = ti_queryi(_tfp, tid, begin, end);
+}
+
+
+
+void
+tabix_streamer::
+init(const char* region) {
 
     if (NULL == region) {
         // read the whole VCF file:
+        bgzf_seek(_tfp->fp, 0, SEEK_SET);
         _titer = ti_query(_tfp, 0, 0, 0);
         return;
     }
 
-    enforce_tabix_index(filename);
+    if (! _tfile.is_index_current()) enforce_tabix_index(_tfile.name());
 
     int tid,beg,end;
     if (ti_parse_region(_tfp->idx, region, &tid, &beg, &end) == 0) {
@@ -160,7 +237,6 @@ tabix_streamer(const char* filename,
 tabix_streamer::
 ~tabix_streamer() {
     if (NULL != _titer) ti_iter_destroy(_titer);
-    if (NULL != _tfp) ti_close(_tfp);
 }
 
 
@@ -182,6 +258,46 @@ next() {
 
 
 
+unsigned
+tabix_streamer::
+next_batch(const unsigned max_count) {
+    _batch_line.clear();
+    _batch_line_size.clear();
+    _is_record_set=false;
+    if (_is_stream_end || (NULL==_tfp) || (NULL==_titer)) return 0;
+
+    // ti_read reuses its line buffer, so each record is copied into the
+    // arena, and line pointers are set once the arena stops growing:
+    size_t arena_size(0);
+    while (_batch_line_size.size() < max_count) {
+        int len;
+        const char* line((const char*) ti_read(_tfp, _titer, &len));
+        if (NULL == line) {
+            _is_stream_end=true;
+            break;
+        }
+        _record_no++;
+        if ((len>0) && (line[0] == '#')) continue;
+
+        const size_t line_end(arena_size+len+1);
+        if (line_end > _arena.size()) _arena.resize(std::max(line_end,_arena.size()*2));
+        memcpy(&(_arena[arena_size]),line,len+1);
+        _batch_line_size.push_back(len);
+        arena_size=line_end;
+    }
+
+    const unsigned bsize(_batch_line_size.size());
+    _batch_line.resize(bsize);
+    size_t offset(0);
+    for (unsigned i(0); i<bsize; ++i) {
+        _batch_line[i]=&(_arena[offset]);
+        offset += _batch_line_size[i]+1;
+    }
+    return bsize;
+}
+
+
+
 void
 tabix_streamer::
 report_state(std::ostream& os) const {
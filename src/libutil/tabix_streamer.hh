@@ -41,7 +41,9 @@ extern "C" {
 }
 
 #include <iosfwd>
+#include <memory>
 #include <string>
+#include <vector>
 
 struct tabix_header_streamer {
 
@@ -68,6 +70,40 @@ private:
 };
 
 
+/// open tabix file with its index and header loaded
+///
+/// The file can be kept open for a whole run and read one region at a
+/// time by a series of tabix_streamers, so that each new region only
+/// requires an index query. Only one streamer may read the file at a time.
+///
+struct tabix_file {
+
+    explicit
+    tabix_file(const char* filename);
+
+    ~tabix_file();
+
+    const char* name() const { return _filename.c_str(); }
+
+    /// all header lines, without line terminators
+    const std::vector<std::string>& header() const { return _header; }
+
+    bool is_index_current() const { return _is_index_current; }
+
+    tabix_t* tfp() const { return _tfp; }
+
+private:
+    tabix_file(const tabix_file&);
+    tabix_file& operator=(const tabix_file&);
+
+    std::string _filename;
+    tabix_t* _tfp;
+    bool _is_index_current;
+    std::vector<std::string> _header;
+};
+
+
+
 struct tabix_streamer {
 
     //
@@ -75,6 +111,18 @@ struct tabix_streamer {
     tabix_streamer(const char* filename,
                    const char* region = NULL);
 
+    // read from a file which is not owned by the streamer:
+    explicit
+    tabix_streamer(tabix_file& tfile,
+                   const char* region = NULL);
+
+    // read the zero-indexed half-open range [begin,end) of sequence tid
+    // from a file which is not owned by the streamer:
+    tabix_streamer(tabix_file& tfile,
+                   const int tid,
+                   const int begin,
+                   const int end);
+
     ~tabix_streamer();
 
     bool next();
@@ -85,6 +133,20 @@ struct tabix_streamer {
         else               return NULL;
     }
 
+    /// read up to max_count data records into an internal arena which is
+    /// reused by the next call to next() or next_batch(). Header lines are
+    /// skipped. Batch lines are null terminated and may be modified in place.
+    ///
+    /// \returns the number of records in the batch, 0 at the end of the stream
+    ///
+    unsigned next_batch(const unsigned max_count);
+
+    unsigned batch_size() const { return _batch_line.size(); }
+
+    char* batch_line(const unsigned i) const { return _batch_line[i]; }
+
+    unsigned batch_line_size(const unsigned i) const { return _batch_line_size[i]; }
+
     const char* name() const { return _stream_name.c_str(); }
 
     unsigned record_no() const { return _record_no; }
@@ -92,15 +154,23 @@ struct tabix_streamer {
     void report_state(std::ostream& os) const;
 
 private:
+    void init(const char* region);
+
     bool _is_record_set;
     bool _is_stream_end;
     unsigned _record_no;
     std::string _stream_name;
 
+    std::auto_ptr<tabix_file> _own_file;
+    tabix_file& _tfile;
     tabix_t* _tfp;
     ti_iter_t _titer;
 
     char* _linebuf;
+
+    std::vector<char> _arena;
+    std::vector<char*> _batch_line;
+    std::vector<unsigned> _batch_line_size;
 };
 
 
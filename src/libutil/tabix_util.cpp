@@ -66,8 +66,8 @@ is_tabix_index(const char* f) {
     idx += ".tbi";
 
     struct stat stat_f,stat_idx;
-    stat(f, &stat_f);
-    stat(idx.c_str(), &stat_idx);
+    if (0 != stat(f, &stat_f)) return false;
+    if (0 != stat(idx.c_str(), &stat_idx)) return false;
     return ( stat_f.st_mtime <= stat_idx.st_mtime );
 }
 
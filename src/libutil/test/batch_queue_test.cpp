@@ -0,0 +1,100 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+
+#include "boost/test/unit_test.hpp"
+
+#include "batch_queue.hh"
+#include "thread_util.hh"
+
+#include <vector>
+
+
+BOOST_AUTO_TEST_SUITE( batch_queue_test )
+
+
+struct push_task : public thread_task {
+
+    push_task(batch_queue<int>& queue,
+              std::vector<int>& vals)
+        : _queue(queue)
+        , _vals(vals)
+    {}
+
+    void
+    run() {
+        for (unsigned i(0); i<_vals.size(); ++i) {
+            if (! _queue.push(&(_vals[i]))) return;
+        }
+        _queue.close();
+    }
+
+private:
+    batch_queue<int>& _queue;
+    std::vector<int>& _vals;
+};
+
+
+
+BOOST_AUTO_TEST_CASE( test_batch_queue_order ) {
+
+    static const unsigned n_val(1000);
+    std::vector<int> vals;
+    for (unsigned i(0); i<n_val; ++i) vals.push_back(i);
+
+    batch_queue<int> queue(2);
+    push_task task(queue,vals);
+    thread_pool pool(1);
+    pool.submit(task);
+
+    unsigned n_pop(0);
+    while (int* val = queue.pop()) {
+        BOOST_CHECK_EQUAL(*val,static_cast<int>(n_pop));
+        n_pop++;
+    }
+    task.wait();
+    BOOST_CHECK_EQUAL(n_pop,n_val);
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_batch_queue_abort ) {
+
+    std::vector<int> vals(10,0);
+
+    batch_queue<int> queue(2);
+    push_task task(queue,vals);
+    thread_pool pool(1);
+    pool.submit(task);
+
+    BOOST_CHECK(NULL != queue.pop());
+    queue.abort();
+    task.wait();
+    BOOST_CHECK(NULL == queue.pop());
+    BOOST_CHECK(! queue.push(&(vals[0])));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,169 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include "boost/test/unit_test.hpp"
+
+#include "bcf_line_splitter.hh"
+#include "bcf_streambuf.hh"
+#include "bcf_util.hh"
+#include "blt_exception.hh"
+
+#include <algorithm>
+#include <cstring>
+
+#include <sstream>
+#include <string>
+
+
+BOOST_AUTO_TEST_SUITE( bcf_util_test )
+
+
+// byte source reading from a string in small pieces:
+struct string_byte_source : public byte_source {
+
+    string_byte_source(const std::string& s)
+        : _s(s), _offset(0) {}
+
+    size_t
+    read(char* buf,
+         const size_t size) {
+        const size_t n(std::min(std::min(size,static_cast<size_t>(7)),_s.size()-_offset));
+        memcpy(buf,_s.data()+_offset,n);
+        _offset += n;
+        return n;
+    }
+
+private:
+    const std::string _s;
+    size_t _offset;
+};
+
+
+static const char test_header[] =
+    "##fileformat=VCFv4.1\n"
+    "##FILTER=<ID=PASS,Description=\"All filters passed\">\n"
+    "##FILTER=<ID=LowQ,Description=\"low quality\">\n"
+    "##INFO=<ID=END,Number=1,Type=Integer,Description=\"block end\">\n"
+    "##INFO=<ID=DB,Number=0,Type=Flag,Description=\"dbsnp\">\n"
+    "##INFO=<ID=MQ,Number=1,Type=Float,Description=\"mapping quality\">\n"
+    "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"genotype\">\n"
+    "##FORMAT=<ID=AD,Number=.,Type=Integer,Description=\"allele depth\">\n"
+    "##FORMAT=<ID=GQ,Number=1,Type=Float,Description=\"genotype quality\">\n"
+    "##contig=<ID=chr1,length=100000>\n"
+    "##contig=<ID=chr2,length=100000>\n"
+    "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tS1\tS2\n";
+
+static const char test_records[] =
+    "chr1\t100\t.\tA\t.\t.\tPASS\tEND=150\tGT:AD:GQ\t0/0:12:30\t0/0:9:24.5\n"
+    "chr1\t200\trs1\tAC\tA,ACC\t41.25\tLowQ\tDB;MQ=59.5\tGT:AD\t0/1:3,4,0\t1|2:0,2,300\n"
+    "chr2\t5\t.\tG\tT\t.\t.\t.\tGT:AD:GQ\t./.:.:.\t1:7,1000:99\n";
+
+
+static
+std::string
+encode_bcf(const std::string& vcf) {
+    std::stringbuf sink;
+    bcf_streambuf bcf(&sink);
+    std::ostream os(&bcf);
+    os << vcf;
+    os.flush();
+    bcf.close();
+    return sink.str();
+}
+
+
+static
+std::string
+decode_bcf(const std::string& bcf) {
+    std::auto_ptr<byte_source> src(new string_byte_source(bcf));
+    bcf_line_splitter bparse(src);
+    std::ostringstream oss;
+    while (bparse.parse_line()) {
+        bparse.write_line(oss);
+    }
+    return oss.str();
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_bcf_round_trip ) {
+
+    const std::string vcf(std::string(test_header)+test_records);
+    const std::string bcf(encode_bcf(vcf));
+
+    BOOST_REQUIRE(bcf.size() > BCF_MAGIC_SIZE);
+    BOOST_CHECK(is_bcf_magic(bcf.data(),bcf.size()));
+    BOOST_CHECK_EQUAL(decode_bcf(bcf),vcf);
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_bcf_unterminated_record ) {
+
+    std::string vcf(std::string(test_header)+test_records);
+    const std::string bcf(encode_bcf(vcf.substr(0,vcf.size()-1)));
+    BOOST_CHECK_EQUAL(decode_bcf(bcf),vcf);
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_bcf_undeclared_contig ) {
+
+    const std::string vcf(std::string(test_header)+
+                          "chr3\t5\t.\tG\tT\t.\t.\t.\tGT\t0/1\t0/0\n");
+    BOOST_CHECK_THROW(encode_bcf(vcf),blt_exception);
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_bcf_typed_ints ) {
+
+    static const int vals[] = { 1, -120, 127, 300, -40000, 70000 };
+    static const BCF_TYPE::index_t types[] = { BCF_TYPE::INT8, BCF_TYPE::INT8, BCF_TYPE::INT8,
+                                               BCF_TYPE::INT16, BCF_TYPE::INT32, BCF_TYPE::INT32 };
+    for (unsigned i(0); i<6; ++i) {
+        BOOST_CHECK_EQUAL(bcf_get_int_type(vals+i,1),types[i]);
+
+        std::string buf;
+        bcf_put_typed_int(buf,vals[i]);
+        const unsigned type(static_cast<unsigned char>(buf[0]) & 0xf);
+        BOOST_CHECK_EQUAL(type,static_cast<unsigned>(types[i]));
+        BOOST_CHECK_EQUAL(buf.size(),1+bcf_get_type_size(type));
+        BOOST_CHECK_EQUAL(bcf_get_int(buf.data()+1,type,0),vals[i]);
+    }
+
+    // missing and vector end values are mapped back from each type:
+    static const int sentinel_vals[] = { 5, BCF_INT_MISSING, BCF_INT_VECTOR_END };
+    std::string buf;
+    bcf_put_typed_ints(buf,sentinel_vals,3);
+    BOOST_CHECK_EQUAL(static_cast<unsigned char>(buf[0]),(3<<4)|BCF_TYPE::INT8);
+    for (unsigned i(0); i<3; ++i) {
+        BOOST_CHECK_EQUAL(bcf_get_int(buf.data()+1,BCF_TYPE::INT8,i),sentinel_vals[i]);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
@@ -0,0 +1,183 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "boost/test/unit_test.hpp"
+
+#include "bgzf_reader.hh"
+
+#include "bgzf.h"
+#include "zlib.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sstream>
+#include <string>
+
+
+BOOST_AUTO_TEST_SUITE( bgzf_reader_test )
+
+
+static
+std::string
+get_test_text() {
+    std::ostringstream oss;
+    for (unsigned i(0); i<50000; ++i) {
+        oss << "chr1\t" << (i+1) << "\t.\tA\t.\t.\tPASS\t.\tGT:DP\t0/0:" << (i%97) << "\n";
+    }
+    return oss.str();
+}
+
+
+
+static
+std::string
+get_temp_filename() {
+    char name[] = "/tmp/bgzf_reader_test.XXXXXX";
+    const int fd(mkstemp(name));
+    BOOST_REQUIRE(fd>=0);
+    close(fd);
+    return name;
+}
+
+
+
+static
+std::string
+gzip_compress(const std::string& text) {
+    z_stream zs;
+    zs.zalloc = NULL;
+    zs.zfree = NULL;
+    zs.opaque = NULL;
+    BOOST_REQUIRE_EQUAL(deflateInit2(&zs,Z_DEFAULT_COMPRESSION,Z_DEFLATED,16+MAX_WBITS,8,Z_DEFAULT_STRATEGY),Z_OK);
+    std::string out(deflateBound(&zs,text.size()),'\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text.c_str()));
+    zs.avail_in = text.size();
+    zs.next_out = reinterpret_cast<Bytef*>(&(out[0]));
+    zs.avail_out = out.size();
+    BOOST_REQUIRE_EQUAL(deflate(&zs,Z_FINISH),Z_STREAM_END);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+
+
+
+static
+void
+write_file(const std::string& filename,
+           const std::string& data) {
+    FILE* fp(fopen(filename.c_str(),"wb"));
+    BOOST_REQUIRE(NULL != fp);
+    BOOST_REQUIRE_EQUAL(fwrite(data.c_str(),1,data.size(),fp),data.size());
+    fclose(fp);
+}
+
+
+
+static
+void
+write_bgzf_file(const std::string& filename,
+                const std::string& text) {
+    BGZF* fp(bgzf_open(filename.c_str(),"w"));
+    BOOST_REQUIRE(NULL != fp);
+    BOOST_REQUIRE_EQUAL(bgzf_write(fp,text.c_str(),text.size()),static_cast<ssize_t>(text.size()));
+    BOOST_REQUIRE_EQUAL(bgzf_close(fp),0);
+}
+
+
+
+// read everything from the file in small, irregular pieces:
+static
+void
+check_read(const std::string& filename,
+           const unsigned worker_count,
+           const bgzf_reader::format_t expect_format,
+           const std::string& expect_text) {
+
+    const int fd(open(filename.c_str(),O_RDONLY));
+    BOOST_REQUIRE(fd>=0);
+    bgzf_reader reader(fd,worker_count,true);
+    BOOST_REQUIRE_EQUAL(reader.format(),expect_format);
+
+    std::string result;
+    char buf[10000];
+    unsigned size(1);
+    while (true) {
+        const size_t ret(reader.read(buf,size));
+        if (0 == ret) break;
+        result.append(buf,ret);
+        size=(size*7)%sizeof(buf)+1;
+    }
+    BOOST_REQUIRE_EQUAL(result.size(),expect_text.size());
+    BOOST_REQUIRE(result == expect_text);
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_bgzf_reader_formats )
+{
+    const std::string text(get_test_text());
+    const std::string filename(get_temp_filename());
+
+    write_file(filename,text);
+    check_read(filename,0,bgzf_reader::PLAIN,text);
+
+    // concatenated gzip members:
+    write_file(filename,gzip_compress(text)+gzip_compress(text));
+    check_read(filename,0,bgzf_reader::GZIP,text+text);
+
+    write_bgzf_file(filename,text);
+    check_read(filename,0,bgzf_reader::BGZF,text);
+    check_read(filename,1,bgzf_reader::BGZF,text);
+    check_read(filename,4,bgzf_reader::BGZF,text);
+
+    write_file(filename,"");
+    check_read(filename,2,bgzf_reader::PLAIN,"");
+
+    unlink(filename.c_str());
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_bgzf_reader_truncated )
+{
+    const std::string text(get_test_text());
+    const std::string filename(get_temp_filename());
+
+    write_bgzf_file(filename,text);
+    BOOST_REQUIRE_EQUAL(truncate(filename.c_str(),1000),0);
+    BOOST_REQUIRE_THROW(check_read(filename,2,bgzf_reader::BGZF,text),std::exception);
+
+    unlink(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
+
@@ -0,0 +1,163 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "boost/test/unit_test.hpp"
+
+#include "bgzf_streambuf.hh"
+
+#include "bgzf.h"
+#include "tabix.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+
+BOOST_AUTO_TEST_SUITE( bgzf_streambuf_test )
+
+
+static
+std::string
+get_test_vcf() {
+    std::ostringstream oss;
+    oss << "##fileformat=VCFv4.1\n";
+    oss << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tSAMPLE\n";
+    static const char* chroms[] = { "chr1", "chr2", "chrM" };
+    for (unsigned c(0); c<3; ++c) {
+        unsigned pos(1);
+        for (unsigned i(0); i<40000; ++i) {
+            if (i%5) {
+                oss << chroms[c] << "\t" << pos << "\t.\tA\t.\t.\tPASS\t.\tGT:DP\t0/0:" << (i%31) << "\n";
+                pos += 1;
+            } else {
+                const unsigned end(pos+(i%600));
+                oss << chroms[c] << "\t" << pos << "\t.\tAC\t.\t.\tPASS\tEND=" << end << ";BLOCKAVG=1\tGT:DP\t0/0:" << (i%31) << "\n";
+                pos = end+1+(i%1000);
+            }
+        }
+    }
+    return oss.str();
+}
+
+
+
+static
+std::string
+read_file(const std::string& filename) {
+    std::ifstream ifs(filename.c_str(),std::ios::binary);
+    std::ostringstream oss;
+    oss << ifs.rdbuf();
+    return oss.str();
+}
+
+
+
+// concatenate the results of a set of region queries:
+static
+std::string
+query_regions(const std::string& filename,
+              const std::string& index_filename) {
+    tabix_t* t(ti_open(filename.c_str(),index_filename.c_str()));
+    BOOST_REQUIRE(NULL != t);
+    BOOST_REQUIRE_EQUAL(ti_lazy_index_load(t),0);
+
+    std::string result;
+    static const char* chroms[] = { "chr1", "chr2", "chrM", "chrX" };
+    for (unsigned c(0); c<4; ++c) {
+        for (int beg(0); beg<30000000; beg+=1234567) {
+            ti_iter_t iter(ti_query(t,chroms[c],beg,beg+(beg%500000)+1));
+            if (NULL == iter) continue;
+            const char* s;
+            int len;
+            while ((s = ti_read(t,iter,&len)) != NULL) {
+                result.append(s,len);
+                result += '\n';
+            }
+            ti_iter_destroy(iter);
+        }
+    }
+    ti_close(t);
+    return result;
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_bgzf_streambuf_matches_tabix )
+{
+    const std::string text(get_test_vcf());
+
+    char name[] = "/tmp/bgzf_streambuf_test.XXXXXX";
+    const int fd(mkstemp(name));
+    BOOST_REQUIRE(fd>=0);
+    close(fd);
+    const std::string expect_file(std::string(name)+".expect.gz");
+    const std::string test_file(std::string(name)+".gz");
+
+    // reference output from the tabix library:
+    {
+        BGZF* fp(bgzf_open(expect_file.c_str(),"w"));
+        BOOST_REQUIRE(NULL != fp);
+        BOOST_REQUIRE_EQUAL(bgzf_write(fp,text.c_str(),text.size()),static_cast<ssize_t>(text.size()));
+        BOOST_REQUIRE_EQUAL(bgzf_close(fp),0);
+        BOOST_REQUIRE_EQUAL(ti_index_build(expect_file.c_str(),&ti_conf_vcf),0);
+    }
+    const std::string expect_data(read_file(expect_file));
+    const std::string expect_query(query_regions(expect_file,expect_file+".tbi"));
+    BOOST_REQUIRE(! expect_query.empty());
+
+    static const unsigned worker_counts[] = { 0, 3 };
+    for (unsigned i(0); i<2; ++i) {
+        {
+            output_buffer ob(-1,4000);
+            bgzf_output_redirect output(ob,test_file,worker_counts[i]);
+            // write in uneven pieces:
+            for (unsigned pos(0); pos<text.size(); pos+=1000) {
+                ob.append(text.substr(pos,1000));
+            }
+            output.close();
+        }
+        BOOST_REQUIRE(read_file(test_file) == expect_data);
+
+        // the index bin order may differ from the tabix hash order, so
+        // check the index by querying:
+        BOOST_REQUIRE(query_regions(expect_file,test_file+".tbi") == expect_query);
+    }
+
+    unlink(name);
+    unlink(expect_file.c_str());
+    unlink((expect_file+".tbi").c_str());
+    unlink(test_file.c_str());
+    unlink((test_file+".tbi").c_str());
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
+
@@ -0,0 +1,158 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include "boost/test/unit_test.hpp"
+
+#include "block_table.hh"
+#include "block_table_streambuf.hh"
+#include "blt_exception.hh"
+#include "output_buffer.hh"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <string>
+
+
+BOOST_AUTO_TEST_SUITE( block_table_test )
+
+
+static const char test_vcf[] =
+    "##fileformat=VCFv4.1\n"
+    "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tNA12878\n"
+    "chr1\t100\t.\tA\t.\t.\tPASS\tEND=150\tGT:GQX:DP\t0/0:30:12\n"
+    "chr1\t151\t.\tC\tT\t40\tLowGQX\t.\tGT:GQX:DP\t0/1:.:.\n"
+    "chr1\t152\t.\tCA\tC\t40\tPASS\t.\tGT:GQX:DP\t0/1:40:10\n"
+    "chr1\t160\t.\tG\tA,C\t40\tPASS\t.\tGT:GQX:DP\t1/2:40:9\n"
+    "chr1\t170\t.\tG\t.\t.\tPASS\t.\tGT:DP\t./.:3\n"
+    "chr2\t5\t.\tT\tG\t40\tLowGQX\t.\tGT:GQX:DP\t1/1:2.5:7\n";
+
+
+
+static
+std::string
+get_temp_name() {
+    char name[] = "/tmp/block_table_test.XXXXXX";
+    const int fd(mkstemp(name));
+    BOOST_REQUIRE(fd>=0);
+    close(fd);
+    return name;
+}
+
+
+
+static
+void
+check_table(const std::string& filename) {
+
+    BOOST_CHECK(is_block_table_file(filename));
+
+    const block_table table(filename);
+    BOOST_CHECK_EQUAL(table.sample_name(),"NA12878");
+    BOOST_REQUIRE_EQUAL(table.filter_count(),2u);
+    BOOST_CHECK(table.is_pass(0));
+    BOOST_CHECK(! table.is_pass(1));
+    BOOST_CHECK(NULL == table.get_contig("chr3"));
+
+    const block_table_contig* ctg(table.get_contig("chr1"));
+    BOOST_REQUIRE(NULL != ctg);
+
+    // the indel is skipped:
+    static const int start[] = { 100, 151, 160, 170 };
+    static const int end[] = { 150, 151, 160, 170 };
+    static const unsigned dp[] = { 12, 0, 9, 3 };
+    static const unsigned filter[] = { 0, 1, 0, 0 };
+    static const unsigned gt[] = { 0, ('T' << 8), ('A' | ('C' << 8)), BLOCK_TABLE_NO_GT };
+    BOOST_REQUIRE_EQUAL(ctg->size,4u);
+    for (unsigned i(0); i<4; ++i) {
+        BOOST_CHECK_EQUAL(ctg->start[i],start[i]);
+        BOOST_CHECK_EQUAL(ctg->end[i],end[i]);
+        BOOST_CHECK_EQUAL(ctg->dp[i],dp[i]);
+        BOOST_CHECK_EQUAL(ctg->filter[i],filter[i]);
+        BOOST_CHECK_EQUAL(ctg->gt[i],gt[i]);
+    }
+    BOOST_CHECK_EQUAL(ctg->gqx[0],30.f);
+    BOOST_CHECK(ctg->gqx[1] != ctg->gqx[1]);
+
+    BOOST_CHECK_EQUAL(ctg->get_first_row(1),0u);
+    BOOST_CHECK_EQUAL(ctg->get_first_row(120),0u);
+    BOOST_CHECK_EQUAL(ctg->get_first_row(151),1u);
+    BOOST_CHECK_EQUAL(ctg->get_first_row(155),2u);
+    BOOST_CHECK_EQUAL(ctg->get_first_row(171),4u);
+
+    const block_table_contig* ctg2(table.get_contig("chr2"));
+    BOOST_REQUIRE(NULL != ctg2);
+    BOOST_REQUIRE_EQUAL(ctg2->size,1u);
+    BOOST_CHECK_EQUAL(ctg2->gt[0],('G' | ('G' << 8)));
+    BOOST_CHECK_EQUAL(ctg2->gqx[0],2.5f);
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_block_table_output ) {
+
+    const std::string filename(get_temp_name());
+    {
+        output_buffer ob(-1,64);
+        std::stringbuf sink;
+        ob.set_sink(&sink);
+        block_table_output table(ob,filename);
+        ob.append(test_vcf);
+        table.close();
+        BOOST_CHECK_EQUAL(sink.str(),test_vcf);
+    }
+    check_table(filename);
+    remove(filename.c_str());
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_block_table_contig_order ) {
+
+    const std::string filename(get_temp_name());
+    block_table_streambuf sb(filename);
+    const std::string text("chr1\t5\t.\tA\t.\t.\tPASS\t.\tGT\t0/0\n"
+                           "chr2\t5\t.\tA\t.\t.\tPASS\t.\tGT\t0/0\n");
+    sb.sputn(text.c_str(),text.size());
+    const std::string bad("chr1\t8\t.\tA\t.\t.\tPASS\t.\tGT\t0/0\n");
+    BOOST_CHECK_THROW(sb.sputn(bad.c_str(),bad.size()),blt_exception);
+    remove(filename.c_str());
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_block_table_bad_file ) {
+
+    const std::string filename(get_temp_name());
+    BOOST_CHECK(! is_block_table_file(filename));
+    BOOST_CHECK_THROW(block_table table(filename),blt_exception);
+    remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
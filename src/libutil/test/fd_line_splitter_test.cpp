@@ -0,0 +1,133 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include "boost/test/unit_test.hpp"
+
+#include "fd_line_splitter.hh"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <string>
+
+
+BOOST_AUTO_TEST_SUITE( fd_line_splitter_test )
+
+
+// write test input to a temporary file and return a descriptor opened at the start of the file:
+static
+int
+get_file_fd(const std::string& test_input) {
+    FILE* fp(tmpfile());
+    BOOST_REQUIRE(NULL != fp);
+    const int fd(dup(fileno(fp)));
+    BOOST_REQUIRE_EQUAL(write(fd,test_input.c_str(),test_input.size()),static_cast<ssize_t>(test_input.size()));
+    lseek(fd,0,SEEK_SET);
+    fclose(fp);
+    return fd;
+}
+
+
+// write test input into a pipe and return the read end:
+static
+int
+get_pipe_fd(const std::string& test_input) {
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(pipe(fds),0);
+    BOOST_REQUIRE_EQUAL(write(fds[1],test_input.c_str(),test_input.size()),static_cast<ssize_t>(test_input.size()));
+    close(fds[1]);
+    return fds[0];
+}
+
+
+static
+void
+check_lines(const int fd,
+            const unsigned chunk_size = 4*1024*1024) {
+
+    fd_line_splitter dparse(fd,chunk_size);
+
+    int line_no(0);
+    while (dparse.parse_line()) {
+        line_no++;
+        static const unsigned expected_col_count(4);
+        BOOST_CHECK_EQUAL(dparse.n_word(),expected_col_count);
+        if       (1==line_no) {
+            BOOST_CHECK_EQUAL(std::string(dparse.word[0]),std::string("1ABCDEFGHIJKLMNOPQRSTUVWXYZ"));
+            BOOST_CHECK_EQUAL(std::string(dparse.word[3]),std::string("4ABCDEFG"));
+        } else if (2==line_no) {
+            BOOST_CHECK_EQUAL(std::string(dparse.word[2]),std::string("33"));
+            BOOST_CHECK_EQUAL(std::string(dparse.word[3]),std::string("44XYZ"));
+        }
+    }
+    BOOST_CHECK_EQUAL(line_no,2);
+    close(fd);
+}
+
+
+static const std::string test_input("1ABCDEFGHIJKLMNOPQRSTUVWXYZ\t2\t3\t4ABCDEFG\n11\t22\t33\t44XYZ\n");
+
+
+BOOST_AUTO_TEST_CASE( test_fd_line_splitter_file )
+{
+    check_lines(get_file_fd(test_input));
+    check_lines(get_file_fd(test_input),5);
+}
+
+
+BOOST_AUTO_TEST_CASE( test_fd_line_splitter_pipe )
+{
+    check_lines(get_pipe_fd(test_input));
+
+    // check lines which are longer than the chunk buffer:
+    check_lines(get_pipe_fd(test_input),2);
+    check_lines(get_pipe_fd(test_input),41);
+}
+
+
+BOOST_AUTO_TEST_CASE( test_fd_line_splitter_no_final_newline )
+{
+    const std::string test_input2(test_input.substr(0,test_input.size()-1));
+    check_lines(get_file_fd(test_input2));
+    check_lines(get_file_fd(test_input2),3);
+    check_lines(get_pipe_fd(test_input2));
+    check_lines(get_pipe_fd(test_input2),3);
+}
+
+
+BOOST_AUTO_TEST_CASE( test_fd_line_splitter_offset )
+{
+    // the reader should start from the current file offset:
+    const int fd(get_file_fd("skip\n"+test_input));
+    lseek(fd,5,SEEK_SET);
+    check_lines(fd);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
@@ -0,0 +1,139 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "boost/test/unit_test.hpp"
+
+#include "format_util.hh"
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+
+#include <limits>
+#include <string>
+
+BOOST_AUTO_TEST_SUITE( format_util )
+
+
+static
+std::string
+fixed_str(const double val,
+          const unsigned precision) {
+    char buf[MAX_FIXED_FORMAT_SIZE];
+    return std::string(buf,format_fixed(val,precision,buf));
+}
+
+
+static
+std::string
+printf_str(const char* scan,
+           const double val,
+           const unsigned precision) {
+    char buf[MAX_FIXED_FORMAT_SIZE];
+    snprintf(buf,MAX_FIXED_FORMAT_SIZE,scan,static_cast<int>(precision),val);
+    return std::string(buf);
+}
+
+
+BOOST_AUTO_TEST_CASE( test_format_int )
+{
+    static const long vals[] = { 0, 1, -1, 9, 10, 99, 100, -100, 12345, 1000000000, LONG_MIN, LONG_MAX };
+    static const unsigned n_vals(sizeof(vals)/sizeof(long));
+    char buf[MAX_INT_FORMAT_SIZE];
+    char expect[MAX_INT_FORMAT_SIZE];
+    for (unsigned i(0); i<n_vals; ++i) {
+        snprintf(expect,MAX_INT_FORMAT_SIZE,"%ld",vals[i]);
+        BOOST_REQUIRE_EQUAL(std::string(buf,format_int(vals[i],buf)), std::string(expect));
+    }
+    snprintf(expect,MAX_INT_FORMAT_SIZE,"%lu",ULONG_MAX);
+    BOOST_REQUIRE_EQUAL(std::string(buf,format_uint(ULONG_MAX,buf)), std::string(expect));
+
+    // every digit count:
+    unsigned long val(7);
+    for (unsigned i(0); i<19; ++i) {
+        snprintf(expect,MAX_INT_FORMAT_SIZE,"%lu",val);
+        BOOST_REQUIRE_EQUAL(std::string(buf,format_uint(val,buf)), std::string(expect));
+        val = (val*10)+3;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( test_format_fixed )
+{
+    BOOST_REQUIRE_EQUAL(fixed_str(37.25,2), std::string("37.25"));
+    BOOST_REQUIRE_EQUAL(fixed_str(0.,3), std::string("0.000"));
+    BOOST_REQUIRE_EQUAL(fixed_str(-0.001,2), std::string("-0.00"));
+    BOOST_REQUIRE_EQUAL(fixed_str(9.996,2), std::string("10.00"));
+    BOOST_REQUIRE_EQUAL(fixed_str(-2.5,0), std::string("-2"));
+    BOOST_REQUIRE_EQUAL(fixed_str(3.5,0), std::string("4"));
+    BOOST_REQUIRE_EQUAL(fixed_str(std::numeric_limits<double>::infinity(),1), std::string("inf"));
+    BOOST_REQUIRE_EQUAL(fixed_str(-std::numeric_limits<double>::infinity(),1), std::string("-inf"));
+}
+
+
+BOOST_AUTO_TEST_CASE( test_format_fixed_printf )
+{
+    // output should match printf, including exact and near rounding ties,
+    // and values too large for the fast path:
+    static const double vals[] = { 0.125, 0.375, 1.005, 2.675, 0.285, 1e-20, 0.5, 1.5,
+                                   123456.785, 4503599627370495.5, 1e16, 1.7976931348623157e308,
+                                   -0., -1.25, 99.995, 1234567.0123456789 };
+    static const unsigned n_vals(sizeof(vals)/sizeof(double));
+    for (unsigned p(0); p<=MAX_FIXED_PRECISION; ++p) {
+        for (unsigned i(0); i<n_vals; ++i) {
+            BOOST_REQUIRE_EQUAL(fixed_str(vals[i],p), printf_str("%.*f",vals[i],p));
+        }
+    }
+
+    srand(17);
+    for (unsigned i(0); i<100000; ++i) {
+        const double val(((static_cast<double>(rand())/RAND_MAX)-0.5)*2000.);
+        const unsigned p(i % 8);
+        BOOST_REQUIRE_EQUAL(fixed_str(val,p), printf_str("%.*f",val,p));
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_format_general )
+{
+    static const double vals[] = { 0., -0., 37.25, 60., 0.1, 1e-4, 9.99999e-5, 0.000123456789, 99999.95,
+                                   99999.949, 123456.7, 1e100, -3.5e-7, 1.5, 2.5e-3, 1000., 999999.5,
+                                   1234.5678, 0.30000001192092896 };
+    static const unsigned n_vals(sizeof(vals)/sizeof(double));
+    char buf[MAX_GENERAL_FORMAT_SIZE];
+    for (unsigned i(0); i<n_vals; ++i) {
+        BOOST_REQUIRE_EQUAL(std::string(buf,format_general(vals[i],buf)), printf_str("%.*g",vals[i],6));
+    }
+
+    srand(23);
+    for (unsigned i(0); i<100000; ++i) {
+        const double scale(vals[i % n_vals]);
+        const double val((static_cast<double>(rand())/RAND_MAX)*scale);
+        BOOST_REQUIRE_EQUAL(std::string(buf,format_general(val,buf)), printf_str("%.*g",val,6));
+        const float fval(static_cast<float>(val));
+        BOOST_REQUIRE_EQUAL(std::string(buf,format_general(fval,buf)), printf_str("%.*g",fval,6));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
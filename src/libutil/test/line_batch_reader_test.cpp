@@ -0,0 +1,158 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include "boost/test/unit_test.hpp"
+
+#include "blt_exception.hh"
+#include "fd_line_splitter.hh"
+#include "line_batch_reader.hh"
+
+#include <cstring>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+
+BOOST_AUTO_TEST_SUITE( line_batch_reader_test )
+
+
+// byte_source returning a string in short reads of varying size:
+struct string_source : public byte_source {
+
+    string_source(const std::string& data,
+                  const bool is_fail = false)
+        : _data(data)
+        , _pos(0)
+        , _n_read(0)
+        , _is_fail(is_fail)
+    {}
+
+    size_t
+    read(char* buf,
+         const size_t size) {
+        if (_pos == _data.size()) {
+            if (_is_fail) throw blt_exception("test read failure");
+            return 0;
+        }
+        const size_t len(std::min(std::min(size,static_cast<size_t>(1+(_n_read++%13))),_data.size()-_pos));
+        memcpy(buf,_data.c_str()+_pos,len);
+        _pos += len;
+        return len;
+    }
+
+private:
+    std::string _data;
+    size_t _pos;
+    unsigned _n_read;
+    bool _is_fail;
+};
+
+
+
+static
+std::string
+get_test_input(const bool is_final_newline) {
+    std::ostringstream oss;
+    for (unsigned i(0); i<500; ++i) {
+        oss << "line" << i << '\t' << std::string(i%41,'x') << '\t' << i;
+        if (is_final_newline || (i != 499)) oss << '\n';
+    }
+    return oss.str();
+}
+
+
+
+static
+void
+check_batches(const bool is_threaded,
+              const bool is_final_newline) {
+    const std::string input(get_test_input(is_final_newline));
+    std::auto_ptr<byte_source> src(new string_source(input));
+    line_batch_reader reader(src,16,is_threaded,3);
+
+    std::string result;
+    bool is_last(false);
+    while (true) {
+        line_batch* batch(reader.next_batch());
+        if (NULL == batch) break;
+        BOOST_REQUIRE(! is_last);
+        BOOST_REQUIRE(batch->size > 0);
+        if ('\n' != batch->data()[batch->size-1]) is_last=true;
+        result.append(batch->data(),batch->size);
+    }
+    BOOST_REQUIRE(result == input);
+    BOOST_REQUIRE_EQUAL(is_last,(! is_final_newline));
+
+    const line_batch_stats stats(reader.get_stats());
+    BOOST_REQUIRE(stats.batch_count > 0);
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_line_batch_reader )
+{
+    for (unsigned i(0); i<2; ++i) {
+        check_batches((i==1),true);
+        check_batches((i==1),false);
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_line_batch_reader_error )
+{
+    for (unsigned i(0); i<2; ++i) {
+        std::auto_ptr<byte_source> src(new string_source("a\nb\n",true));
+        line_batch_reader reader(src,1024,(i==1));
+        BOOST_CHECK_THROW(while (reader.next_batch()) {},blt_exception);
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_fd_line_splitter_prefetch )
+{
+    const std::string input(get_test_input(false));
+    for (unsigned i(0); i<2; ++i) {
+        std::auto_ptr<byte_source> src(new string_source(input));
+        fd_line_splitter dparse(src,32,'\t',0,(i==1));
+
+        unsigned line_no(0);
+        while (dparse.parse_line()) {
+            BOOST_REQUIRE_EQUAL(dparse.n_word(),3u);
+            std::ostringstream oss;
+            oss << "line" << line_no;
+            BOOST_REQUIRE_EQUAL(std::string(dparse.word[0]),oss.str());
+            BOOST_REQUIRE_EQUAL(std::string(dparse.word[1]),std::string(line_no%41,'x'));
+            line_no++;
+        }
+        BOOST_REQUIRE_EQUAL(line_no,500u);
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
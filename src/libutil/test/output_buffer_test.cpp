@@ -0,0 +1,137 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+#include "boost/test/unit_test.hpp"
+
+#include "output_buffer.hh"
+
+#include <unistd.h>
+
+#include <climits>
+#include <cstdio>
+
+#include <ostream>
+#include <sstream>
+#include <string>
+
+
+BOOST_AUTO_TEST_SUITE( output_buffer_test )
+
+
+// write a fixed mix of appended and formatted output:
+static
+void
+write_test_output(output_buffer& ob) {
+    std::ostream os(&ob);
+    os << "##header=" << 3.25 << "\n";
+    const std::string big(10000,'x');
+    for (unsigned i(0); i<200; ++i) {
+        ob.append("chr1\t");
+        ob.append_int(static_cast<int>(i)-100);
+        ob.append('\t');
+        ob.append_uint(i*1000003u);
+        ob.append('\t');
+        if (0 == (i%50)) ob.append(big);
+        ob.append(std::string("field"));
+        os << '\t' << i << '\n';
+    }
+    ob.append_int(LONG_MIN);
+    ob.append('\t');
+    ob.append_int(LONG_MAX);
+    ob.append('\t');
+    ob.append_uint(0);
+    ob.append('\t');
+    ob.append_fixed(37.25,2);
+    ob.append('\n');
+}
+
+
+static
+std::string
+get_expected_output() {
+    std::ostringstream os;
+    os << "##header=" << 3.25 << "\n";
+    const std::string big(10000,'x');
+    for (unsigned i(0); i<200; ++i) {
+        os << "chr1\t" << (static_cast<int>(i)-100) << '\t' << (i*1000003u) << '\t';
+        if (0 == (i%50)) os << big;
+        os << "field" << '\t' << i << '\n';
+    }
+    os << LONG_MIN << '\t' << LONG_MAX << '\t' << 0 << '\t' << "37.25" << '\n';
+    return os.str();
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_output_buffer_fd ) {
+
+    static const size_t buffer_sizes[] = { 1, 100, 4096, output_buffer::DEFAULT_BUFFER_SIZE };
+    for (unsigned i(0); i<4; ++i) {
+        FILE* fp(tmpfile());
+        BOOST_REQUIRE(NULL != fp);
+        {
+            output_buffer ob(fileno(fp),buffer_sizes[i]);
+            write_test_output(ob);
+        }
+
+        const std::string expect(get_expected_output());
+        std::string result(expect.size()+1,'\0');
+        lseek(fileno(fp),0,SEEK_SET);
+        size_t nread(0);
+        while (true) {
+            const ssize_t n(read(fileno(fp),&(result[nread]),result.size()-nread));
+            BOOST_REQUIRE(n >= 0);
+            if (0 == n) break;
+            nread += n;
+        }
+        fclose(fp);
+        result.resize(nread);
+        BOOST_REQUIRE(result == expect);
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_output_buffer_streambuf ) {
+
+    std::stringbuf sb;
+    output_buffer ob(&sb,4096);
+    write_test_output(ob);
+    ob.flush();
+    BOOST_REQUIRE(sb.str() == get_expected_output());
+
+    // switching sinks writes pending output to the old sink first:
+    std::stringbuf sb2;
+    ob.append("a");
+    ob.set_sink(&sb2);
+    ob.append("b");
+    ob.flush();
+    BOOST_CHECK_EQUAL(sb.str().substr(sb.str().size()-1),std::string("a"));
+    BOOST_CHECK_EQUAL(sb2.str(),std::string("b"));
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -28,6 +28,8 @@
 #include "parse_util.hh"
 
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 
 BOOST_AUTO_TEST_SUITE( parse_util )
@@ -213,5 +215,196 @@ BOOST_AUTO_TEST_CASE( test_parse_double_str_bad_input2 )
     BOOST_REQUIRE_THROW(parse_double_str(junk), std::exception);
 }
 
+BOOST_AUTO_TEST_CASE( test_parse_double_exact )
+{
+    // short decimal values must match strtod exactly, and consume the
+    // same input:
+    static const char* vals[] = { "0", "-0", "37.25", "-37.25", "0.1", "3.", "123456789012345",
+                                  "1234567890.12345", "0.00000000000001", "99.99;", "12:34"
+                                };
+    static const unsigned n_vals(sizeof(vals)/sizeof(char*));
+    for (unsigned i(0); i<n_vals; ++i) {
+        const char* s(vals[i]);
+        char* endptr;
+        const double expect(strtod(s,&endptr));
+        const double val(parse_double(s));
+        BOOST_REQUIRE_EQUAL(val, expect);
+        BOOST_REQUIRE(s == endptr);
+        BOOST_REQUIRE_EQUAL(std::signbit(val), std::signbit(expect));
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_parse_double_general )
+{
+    // input outside of the fast path:
+    static const char* vals[] = { "1.0e-3", "1234567890123456", "0.000000000000001", "-.5", "+2.5" };
+    static const unsigned n_vals(sizeof(vals)/sizeof(char*));
+    for (unsigned i(0); i<n_vals; ++i) {
+        const char* s(vals[i]);
+        char* endptr;
+        const double expect(strtod(s,&endptr));
+        const double val(parse_double(s));
+        BOOST_REQUIRE_CLOSE(val, expect, tol);
+        BOOST_REQUIRE(s == endptr);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_parse_double_end )
+{
+    const char* val_str = "37.25";
+    const char* s(val_str);
+    const double val(parse_double(s,val_str+4));
+    BOOST_REQUIRE_EQUAL(val, 37.2);
+    BOOST_REQUIRE(s == (val_str+4));
+}
+
+// parse str with the fast path, the general parser and parse_double,
+// fast path results must match the general parser exactly, and
+// parse_double must match the general parser for all input:
+static
+void
+check_fast_parse_double(const char* str,
+                        const char* str_end) {
+    bool is_general(true);
+    double general_val(0);
+    const char* general_end(str);
+    try {
+        general_val=parse_double_general(general_end,str_end);
+    } catch (...) {
+        is_general=false;
+    }
+
+    double fast_val(0);
+    const char* fast_end(str);
+    if (fast_parse_double(fast_end,str_end,fast_val)) {
+        BOOST_REQUIRE_MESSAGE(is_general, "fast path accepts '" << str << "'");
+        BOOST_REQUIRE_MESSAGE((fast_val == general_val) &&
+                              (std::signbit(fast_val) == std::signbit(general_val)),
+                              "fast path value differs for '" << str << "'");
+        BOOST_REQUIRE(fast_end == general_end);
+    } else {
+        BOOST_REQUIRE(fast_end == str);
+    }
+
+    const char* end(str);
+    if (! is_general) {
+        BOOST_REQUIRE_THROW(parse_double(end,str_end), std::exception);
+        return;
+    }
+    const double val(parse_double(end,str_end));
+    if (std::isnan(general_val)) {
+        BOOST_REQUIRE(std::isnan(val));
+    } else {
+        BOOST_REQUIRE_MESSAGE((val == general_val) &&
+                              (std::signbit(val) == std::signbit(general_val)),
+                              "parse_double value differs for '" << str << "'");
+    }
+    BOOST_REQUIRE(end == general_end);
+}
+
+
+
+static
+void
+check_fast_parse_double(const std::string& str) {
+    check_fast_parse_double(str.c_str(),NULL);
+    check_fast_parse_double(str.c_str(),str.c_str()+str.size());
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_fast_parse_double_edge )
+{
+    static const char* vals[] = { "", "-", "+", ".", ".5", "-.5", "5.", "-0", "-0.0", "+2.5", "+0",
+                                  "1e5", "1E5", "1.5e", "1.5e+", "2.0e-3x", "1.5E+300",
+                                  "123456789012345", "1234567890123456", "12345678901234567890",
+                                  "1234567890.12345", "1234567890.123456", "0.1234567890123456789",
+                                  "00000000000000000001.5", "0.000000000000001", "9007199254740993",
+                                  "inf", "-inf", "+inf", "Inf", "INF", "infinity", "Infinity", "-Infinity",
+                                  "nan", "NaN", "-nan", "NAN", "nanx", "1.0inf", " 1.5", "1.5 ", "37.25;", "12:34"
+                                };
+    static const unsigned n_vals(sizeof(vals)/sizeof(char*));
+    for (unsigned i(0); i<n_vals; ++i) {
+        check_fast_parse_double(std::string(vals[i]));
+    }
+
+    // these are always left to the general parser:
+    static const char* general_vals[] = { "+2.5", "1e5", "1234567890123456", "inf", "nan", "Infinity", "-nan", ".5" };
+    static const unsigned n_general_vals(sizeof(general_vals)/sizeof(char*));
+    for (unsigned i(0); i<n_general_vals; ++i) {
+        const char* s(general_vals[i]);
+        double val;
+        BOOST_REQUIRE(! fast_parse_double(s,NULL,val));
+    }
+}
+
+
+
+// random decimal input with a random sign, integer and fraction length,
+// exponent and suffix:
+static
+std::string
+random_double_str() {
+    static const char* signs[] = { "", "", "-", "+" };
+    static const char* suffixes[] = { "", "", ";", ":", ",", "\t", "x" };
+    std::string s(signs[rand()%4]);
+    const unsigned n_int(rand()%12);
+    for (unsigned i(0); i<n_int; ++i) s += static_cast<char>('0'+(rand()%10));
+    if (rand()%4) {
+        s += '.';
+        const unsigned n_frac(rand()%12);
+        for (unsigned i(0); i<n_frac; ++i) s += static_cast<char>('0'+(rand()%10));
+    }
+    if (0 == (rand()%8)) {
+        s += ((rand()%2) ? 'e' : 'E');
+        if (rand()%2) s += ((rand()%2) ? '-' : '+');
+        const unsigned n_exp(rand()%4);
+        for (unsigned i(0); i<n_exp; ++i) s += static_cast<char>('0'+(rand()%10));
+    }
+    s += suffixes[rand()%7];
+    return s;
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_fast_parse_double_random )
+{
+    srand(41);
+    for (unsigned i(0); i<200000; ++i) {
+        check_fast_parse_double(random_double_str());
+    }
+}
+
+BOOST_AUTO_TEST_CASE( test_parse_double_neg_empty )
+{
+    const char* neg = "-";
+    BOOST_REQUIRE_THROW(parse_double(neg), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE( test_parse_int_neg )
+{
+    const char* neg = "-123:";
+    const int val(parse_int(neg));
+    BOOST_REQUIRE_EQUAL(val, -123);
+    BOOST_REQUIRE_EQUAL(*neg, ':');
+}
+
+BOOST_AUTO_TEST_CASE( test_parse_integer_general )
+{
+    // input outside of the fast path should match strtol/strtoul:
+    static const char* vals[] = { "  12", "+12", "0000000000012", "4294967295", "-9223372036854775807" };
+    static const unsigned n_vals(sizeof(vals)/sizeof(char*));
+    for (unsigned i(0); i<n_vals; ++i) {
+        const char* s(vals[i]);
+        const long val(parse_long(s));
+        BOOST_REQUIRE_EQUAL(val, strtol(vals[i],NULL,10));
+        BOOST_REQUIRE(s == (vals[i]+strlen(vals[i])));
+    }
+    const char* umax = "4294967295";
+    BOOST_REQUIRE_EQUAL(parse_unsigned(umax), 4294967295u);
+    const char* ubig = "4294967296";
+    BOOST_REQUIRE_THROW(parse_unsigned(ubig), std::exception);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
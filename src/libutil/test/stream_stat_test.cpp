@@ -0,0 +1,59 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+
+#include "boost/test/unit_test.hpp"
+
+#include "stream_stat.hh"
+
+
+BOOST_AUTO_TEST_SUITE( stream_stat_test )
+
+
+BOOST_AUTO_TEST_CASE( test_stream_stat_merge ) {
+
+    static const double eps(0.00001);
+    static const double val[] = {3.,9.,1.,4.,12.,7.,2.,8.};
+    static const unsigned n_val(sizeof(val)/sizeof(double));
+
+    for (unsigned split(0); split<=n_val; ++split) {
+        stream_stat all,a,b;
+        for (unsigned i(0); i<n_val; ++i) {
+            all.add(val[i]);
+            if (i<split) a.add(val[i]);
+            else         b.add(val[i]);
+        }
+        a.merge(b);
+        BOOST_CHECK_EQUAL(a.size(), all.size());
+        BOOST_CHECK_CLOSE(a.mean(), all.mean(), eps);
+        BOOST_CHECK_CLOSE(a.variance(), all.variance(), eps);
+        BOOST_CHECK_EQUAL(a.min(), all.min());
+        BOOST_CHECK_EQUAL(a.max(), all.max());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
@@ -0,0 +1,121 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "boost/test/unit_test.hpp"
+
+#include "tokenize_util.hh"
+
+#include <cstring>
+
+#include <string>
+#include <vector>
+
+
+BOOST_AUTO_TEST_SUITE( tokenize_util )
+
+
+static
+void
+check_tokenize(const tokenize_impl_t impl,
+               const std::string& line,
+               const unsigned max_word) {
+
+    static const unsigned MAX_OFFSET(64);
+    std::vector<char> expect_buf(line.size()+1+MAX_OFFSET);
+    std::vector<char> test_buf(line.size()+1+MAX_OFFSET);
+    std::vector<char*> expect_word(max_word);
+    std::vector<char*> test_word(max_word);
+
+    // check each alignment of the line start:
+    for (unsigned offset(0); offset<MAX_OFFSET; ++offset) {
+        char* expect_line(&(expect_buf[offset]));
+        char* test_line(&(test_buf[offset]));
+        strcpy(expect_line,line.c_str());
+        strcpy(test_line,line.c_str());
+
+        const unsigned expect_n_word(tokenize_line(TOKENIZE_SCALAR,expect_line,'\t',&(expect_word[0]),max_word));
+        const unsigned test_n_word(tokenize_line(impl,test_line,'\t',&(test_word[0]),max_word));
+
+        BOOST_REQUIRE_EQUAL(test_n_word,expect_n_word);
+        for (unsigned i(0); i<test_n_word; ++i) {
+            BOOST_REQUIRE_EQUAL(test_word[i]-test_line,expect_word[i]-expect_line);
+        }
+        BOOST_REQUIRE(0 == memcmp(test_line,expect_line,line.size()+1));
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_tokenize_scalar )
+{
+    char line[] = "chr1\t100\t.\tA\t.\n\tX";
+    char* word[10];
+    BOOST_REQUIRE_EQUAL(tokenize_line(TOKENIZE_SCALAR,line,'\t',word,10),5u);
+    BOOST_REQUIRE_EQUAL(std::string(word[0]),std::string("chr1"));
+    BOOST_REQUIRE_EQUAL(std::string(word[3]),std::string("A"));
+    BOOST_REQUIRE_EQUAL(std::string(word[4]),std::string(".\n\tX"));
+
+    char line2[] = "a\tb\tc\td";
+    BOOST_REQUIRE_EQUAL(tokenize_line(TOKENIZE_SCALAR,line2,'\t',word,3),3u);
+    BOOST_REQUIRE_EQUAL(std::string(word[2]),std::string("c\td"));
+}
+
+
+
+BOOST_AUTO_TEST_CASE( test_tokenize_impl_match )
+{
+    std::vector<std::string> lines;
+    lines.push_back("");
+    lines.push_back("\t");
+    lines.push_back("\t\t\t");
+    lines.push_back("\n");
+    lines.push_back("a\tb\n\tc");
+    lines.push_back("chr20\t10000117\t.\tC\tT\t1230.77\tPASS\tAC=1;AF=0.500;AN=2;DP=62\tGT:AD:DP:GQ:PL\t0/1:31,31:62:99:1259,0,1262");
+    lines.push_back("chr20\t10000118\t.\tA\t.\t.\tLowQual\tAN=2;DP=61;MQ=60.00;MQ0=0\tGT:DP\t0/0:61\n");
+
+    std::string long_line;
+    for (unsigned i(0); i<80; ++i) {
+        long_line += std::string(i%7,'x');
+        long_line += '\t';
+    }
+    lines.push_back(long_line);
+
+    static const unsigned max_words[] = { 1, 2, 3, 10, 50 };
+    static const unsigned max_words_size(sizeof(max_words)/sizeof(unsigned));
+
+    for (unsigned impl(0); impl<TOKENIZE_IMPL_SIZE; ++impl) {
+        const tokenize_impl_t timpl(static_cast<tokenize_impl_t>(impl));
+        if (! is_tokenize_impl_supported(timpl)) continue;
+        for (unsigned i(0); i<lines.size(); ++i) {
+            for (unsigned j(0); j<max_words_size; ++j) {
+                check_tokenize(timpl,lines[i],max_words[j]);
+            }
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
+
@@ -0,0 +1,94 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "boost/test/unit_test.hpp"
+
+#include "vcf_util.hh"
+
+#include <exception>
+
+BOOST_AUTO_TEST_SUITE( vcf_util )
+
+
+BOOST_AUTO_TEST_CASE( test_parse_gt )
+{
+    vcf_genotype gt;
+    parse_gt("0/1",gt);
+    BOOST_REQUIRE_EQUAL(gt.size(), 2u);
+    BOOST_REQUIRE_EQUAL(gt[0], 0);
+    BOOST_REQUIRE_EQUAL(gt[1], 1);
+    BOOST_REQUIRE(! gt.is_phased());
+    BOOST_REQUIRE(gt.is_het());
+    BOOST_REQUIRE(gt.is_any_alt());
+    BOOST_REQUIRE(! gt.is_hom_ref());
+
+    parse_gt("0|0",gt);
+    BOOST_REQUIRE(gt.is_phased());
+    BOOST_REQUIRE(gt.is_hom_ref());
+    BOOST_REQUIRE(! gt.is_het());
+    BOOST_REQUIRE(! gt.is_any_alt());
+
+    parse_gt("12",gt);
+    BOOST_REQUIRE_EQUAL(gt.size(), 1u);
+    BOOST_REQUIRE_EQUAL(gt[0], 12);
+    BOOST_REQUIRE(! gt.is_phased());
+
+    parse_gt("./1",gt);
+    BOOST_REQUIRE_EQUAL(gt[0], -1);
+    BOOST_REQUIRE(! gt.is_known());
+    BOOST_REQUIRE(! gt.is_het());
+    BOOST_REQUIRE(gt.is_any_alt());
+
+    parse_gt("0/1:",gt,true);
+    BOOST_REQUIRE_EQUAL(gt.size(), 2u);
+
+    BOOST_REQUIRE_THROW(parse_gt("0/1:",gt), std::exception);
+    BOOST_REQUIRE_THROW(parse_gt("x",gt), std::exception);
+}
+
+
+BOOST_AUTO_TEST_CASE( test_parse_gt_polyploid )
+{
+    vcf_genotype gt;
+    parse_gt("0|1|2/.",gt);
+    BOOST_REQUIRE_EQUAL(gt.size(), 4u);
+    static const int expect[] = { 0, 1, 2, -1 };
+    BOOST_REQUIRE_EQUAL_COLLECTIONS(gt.begin(), gt.end(), expect, expect+4);
+    BOOST_REQUIRE(! gt.is_phased());
+
+    // storage returns to inline values after clear:
+    vcf_genotype gt2(gt);
+    parse_gt("1/1",gt);
+    BOOST_REQUIRE_EQUAL(gt.size(), 2u);
+    BOOST_REQUIRE(! gt.is_het());
+    BOOST_REQUIRE(gt.is_any_alt());
+
+    gt.swap(gt2);
+    BOOST_REQUIRE_EQUAL(gt.size(), 4u);
+    BOOST_REQUIRE_EQUAL(gt[2], 2);
+    BOOST_REQUIRE_EQUAL(gt2[0], 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,200 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// minimal pthread wrappers: mutex, condition variable and a task pool
+///
+
+#include "blt_exception.hh"
+#include "thread_util.hh"
+
+#include <unistd.h>
+
+#include <cassert>
+#include <cstring>
+#include <ctime>
+
+#include <algorithm>
+#include <exception>
+#include <sstream>
+
+
+
+void
+thread_task::
+wait() {
+    if (NULL == _pool) return;
+    {
+        thread_lock lock(_pool->_mutex);
+        while (! _is_done) _pool->_done_cond.wait(_pool->_mutex);
+    }
+    _pool=NULL;
+    if (! _error.empty()) {
+        const std::string msg(_error);
+        _error.clear();
+        throw blt_exception(msg.c_str());
+    }
+}
+
+
+
+bool
+thread_task::
+is_done() const {
+    if (NULL == _pool) return true;
+    thread_lock lock(_pool->_mutex);
+    return _is_done;
+}
+
+
+
+thread_pool::
+thread_pool(const unsigned thread_count)
+    : _is_shutdown(false)
+{
+    for (unsigned i(0); i<thread_count; ++i) {
+        pthread_t thread;
+        const int ret(pthread_create(&thread,NULL,worker_main,this));
+        if (0 != ret) {
+            std::ostringstream oss;
+            oss << "ERROR: failed to create worker thread: " << strerror(ret) << "\n";
+            throw blt_exception(oss.str().c_str());
+        }
+        _threads.push_back(thread);
+    }
+}
+
+
+
+thread_pool::
+~thread_pool() {
+    {
+        thread_lock lock(_mutex);
+        _is_shutdown=true;
+        _work_cond.broadcast();
+    }
+    for (unsigned i(0); i<_threads.size(); ++i) {
+        pthread_join(_threads[i],NULL);
+    }
+}
+
+
+
+void
+thread_pool::
+submit(thread_task& task) {
+    assert(task._is_done);
+    task._pool=this;
+    task._error.clear();
+    if (_threads.empty()) {
+        task._is_done=false;
+        run_task(task);
+        task._is_done=true;
+        return;
+    }
+
+    thread_lock lock(_mutex);
+    task._is_done=false;
+    _queue.push_back(&task);
+    _work_cond.signal();
+}
+
+
+
+void*
+thread_pool::
+worker_main(void* arg) {
+    static_cast<thread_pool*>(arg)->worker();
+    return NULL;
+}
+
+
+
+void
+thread_pool::
+worker() {
+    while (true) {
+        thread_task* task(NULL);
+        {
+            thread_lock lock(_mutex);
+            while (_queue.empty() && (! _is_shutdown)) _work_cond.wait(_mutex);
+            if (_queue.empty()) return;
+            task=_queue.front();
+            _queue.pop_front();
+        }
+
+        run_task(*task);
+
+        {
+            thread_lock lock(_mutex);
+            task->_is_done=true;
+            _done_cond.broadcast();
+        }
+    }
+}
+
+
+
+void
+thread_pool::
+run_task(thread_task& task) {
+    try {
+        task.run();
+    } catch (const std::exception& e) {
+        task._error=e.what();
+    } catch (...) {
+        task._error="unknown exception in worker thread";
+    }
+}
+
+
+
+unsigned
+get_cpu_count() {
+    const long count(sysconf(_SC_NPROCESSORS_ONLN));
+    if (count<1) return 1;
+    return count;
+}
+
+
+
+unsigned
+get_default_worker_count() {
+    static const unsigned max_worker_count(16);
+    const unsigned count(get_cpu_count());
+    if (count<=1) return 0;
+    return std::min(count,max_worker_count);
+}
+
+
+
+double
+get_monotonic_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec+(ts.tv_nsec*1e-9);
+}
@@ -0,0 +1,191 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// minimal pthread wrappers: mutex, condition variable and a task pool
+///
+
+#ifndef __THREAD_UTIL_HH
+#define __THREAD_UTIL_HH
+
+#include <pthread.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+
+struct thread_mutex {
+
+    thread_mutex() { pthread_mutex_init(&_mutex,NULL); }
+    ~thread_mutex() { pthread_mutex_destroy(&_mutex); }
+
+    void lock() { pthread_mutex_lock(&_mutex); }
+    void unlock() { pthread_mutex_unlock(&_mutex); }
+
+private:
+    friend struct thread_condition;
+
+    thread_mutex(const thread_mutex&);
+    thread_mutex& operator=(const thread_mutex&);
+
+    pthread_mutex_t _mutex;
+};
+
+
+
+/// holds the mutex lock for the lifetime of the object
+struct thread_lock {
+
+    explicit
+    thread_lock(thread_mutex& m) : _m(m) { _m.lock(); }
+    ~thread_lock() { _m.unlock(); }
+
+private:
+    thread_lock(const thread_lock&);
+    thread_lock& operator=(const thread_lock&);
+
+    thread_mutex& _m;
+};
+
+
+
+struct thread_condition {
+
+    thread_condition() { pthread_cond_init(&_cond,NULL); }
+    ~thread_condition() { pthread_cond_destroy(&_cond); }
+
+    /// the mutex must be locked by the caller
+    void wait(thread_mutex& m) { pthread_cond_wait(&_cond,&(m._mutex)); }
+    void signal() { pthread_cond_signal(&_cond); }
+    void broadcast() { pthread_cond_broadcast(&_cond); }
+
+private:
+    thread_condition(const thread_condition&);
+    thread_condition& operator=(const thread_condition&);
+
+    pthread_cond_t _cond;
+};
+
+
+
+struct thread_pool;
+
+
+/// unit of work for thread_pool
+///
+/// a task may be resubmitted after wait() has returned
+///
+struct thread_task {
+
+    thread_task() : _pool(NULL), _is_done(true) {}
+
+    virtual ~thread_task() {}
+
+    /// executed on a pool thread. Any exception is caught and
+    /// rethrown from wait()
+    virtual
+    void
+    run() = 0;
+
+    /// block until the task has completed
+    void
+    wait();
+
+    /// true if the task is not queued or running
+    bool
+    is_done() const;
+
+private:
+    friend struct thread_pool;
+
+    thread_pool* _pool;
+    bool _is_done;
+    std::string _error;
+};
+
+
+
+/// fixed set of worker threads executing thread_task objects in submission order
+///
+/// with a thread count of zero tasks are run immediately on the submitting
+/// thread, so that callers need no separate serial code path
+///
+struct thread_pool {
+
+    explicit
+    thread_pool(const unsigned thread_count);
+
+    /// completes all submitted tasks before returning
+    ~thread_pool();
+
+    void
+    submit(thread_task& task);
+
+    unsigned
+    size() const { return _threads.size(); }
+
+private:
+    friend struct thread_task;
+
+    thread_pool(const thread_pool&);
+    thread_pool& operator=(const thread_pool&);
+
+    static void* worker_main(void* arg);
+
+    void
+    worker();
+
+    static void
+    run_task(thread_task& task);
+
+    thread_mutex _mutex;
+    thread_condition _work_cond;
+    thread_condition _done_cond;
+    std::deque<thread_task*> _queue;
+    std::vector<pthread_t> _threads;
+    bool _is_shutdown;
+};
+
+
+
+/// number of online processors, or 1 if this can't be determined
+unsigned
+get_cpu_count();
+
+
+/// default pool size for work which is offloaded from a single consumer
+/// thread: zero (run inline) on a single processor machine
+unsigned
+get_default_worker_count();
+
+
+/// seconds on a monotonic clock, for measuring elapsed time
+double
+get_monotonic_seconds();
+
+#endif
@@ -0,0 +1,263 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// in-place tab/newline word tokenizer shared by all line parsers
+///
+
+#include "tokenize_util.hh"
+
+#include <cassert>
+#include <cstddef>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define TOKENIZE_X86
+#include <immintrin.h>
+#endif
+
+#if defined(TOKENIZE_X86) && defined(__SSE2__)
+#define TOKENIZE_USE_SSE2
+#endif
+
+// avx2 is compiled via the function target attribute so that the
+// remainder of the build does not require -mavx2:
+#if defined(TOKENIZE_X86) && (defined(__clang__) || (__GNUC__ >= 5))
+#define TOKENIZE_USE_AVX2
+#endif
+
+
+
+typedef unsigned (*tokenize_func_t)(char*,const char,char**,const unsigned);
+
+
+
+static
+unsigned
+tokenize_line_scalar(char* p,
+                     const char sep,
+                     char** word,
+                     const unsigned max_word) {
+    word[0]=p;
+    unsigned n_word(1);
+    if (n_word >= max_word) return n_word;
+    while (true) {
+        if ((*p == '\n') || (*p == '\0')) break;
+        if (*p == sep) {
+            *p = '\0';
+            word[n_word++] = p+1;
+            if (n_word >= max_word) break;
+        }
+        ++p;
+    }
+    return n_word;
+}
+
+
+
+// the vector versions below only use aligned loads, so that the scan
+// never reads across a page boundary beyond the line terminator. Bytes
+// in the first block which precede the line start are masked out.
+//
+// each match in the mask is a separator, newline or null. The mask
+// remains valid when a separator byte is nulled because later bit
+// positions are unaffected.
+//
+#ifdef TOKENIZE_USE_SSE2
+static
+unsigned
+tokenize_line_sse2(char* line,
+                   const char sep,
+                   char** word,
+                   const unsigned max_word) {
+    word[0]=line;
+    unsigned n_word(1);
+    if (n_word >= max_word) return n_word;
+
+    static const unsigned BLOCK(16);
+    const __m128i vsep(_mm_set1_epi8(sep));
+    const __m128i vnl(_mm_set1_epi8('\n'));
+    const __m128i vnull(_mm_setzero_si128());
+
+    const unsigned offset(reinterpret_cast<size_t>(line) & (BLOCK-1));
+    char* block(line-offset);
+    unsigned mask(~0u << offset);
+    while (true) {
+        const __m128i v(_mm_load_si128(reinterpret_cast<const __m128i*>(block)));
+        const __m128i m(_mm_or_si128(_mm_cmpeq_epi8(v,vsep),
+                                     _mm_or_si128(_mm_cmpeq_epi8(v,vnl),
+                                                  _mm_cmpeq_epi8(v,vnull))));
+        mask &= static_cast<unsigned>(_mm_movemask_epi8(m));
+        while (mask) {
+            char* p(block+__builtin_ctz(mask));
+            if (*p != sep) return n_word;
+            *p = '\0';
+            word[n_word++] = p+1;
+            if (n_word >= max_word) return n_word;
+            mask &= (mask-1);
+        }
+        block += BLOCK;
+        mask = ~0u;
+    }
+}
+#endif
+
+
+
+#ifdef TOKENIZE_USE_AVX2
+__attribute__((target("avx2")))
+static
+unsigned
+tokenize_line_avx2(char* line,
+                   const char sep,
+                   char** word,
+                   const unsigned max_word) {
+    word[0]=line;
+    unsigned n_word(1);
+    if (n_word >= max_word) return n_word;
+
+    static const unsigned BLOCK(32);
+    const __m256i vsep(_mm256_set1_epi8(sep));
+    const __m256i vnl(_mm256_set1_epi8('\n'));
+    const __m256i vnull(_mm256_setzero_si256());
+
+    const unsigned offset(reinterpret_cast<size_t>(line) & (BLOCK-1));
+    char* block(line-offset);
+    unsigned mask(~0u << offset);
+    while (true) {
+        const __m256i v(_mm256_load_si256(reinterpret_cast<const __m256i*>(block)));
+        const __m256i m(_mm256_or_si256(_mm256_cmpeq_epi8(v,vsep),
+                                        _mm256_or_si256(_mm256_cmpeq_epi8(v,vnl),
+                                                        _mm256_cmpeq_epi8(v,vnull))));
+        mask &= static_cast<unsigned>(_mm256_movemask_epi8(m));
+        while (mask) {
+            char* p(block+__builtin_ctz(mask));
+            if (*p != sep) return n_word;
+            *p = '\0';
+            word[n_word++] = p+1;
+            if (n_word >= max_word) return n_word;
+            mask &= (mask-1);
+        }
+        block += BLOCK;
+        mask = ~0u;
+    }
+}
+#endif
+
+
+
+bool
+is_tokenize_impl_supported(const tokenize_impl_t impl) {
+    switch (impl) {
+    case TOKENIZE_SCALAR:
+        return true;
+#ifdef TOKENIZE_USE_SSE2
+    case TOKENIZE_SSE2:
+        return true;
+#endif
+#ifdef TOKENIZE_USE_AVX2
+    case TOKENIZE_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+
+
+static
+tokenize_func_t
+get_tokenize_func(const tokenize_impl_t impl) {
+    switch (impl) {
+#ifdef TOKENIZE_USE_SSE2
+    case TOKENIZE_SSE2:
+        return tokenize_line_sse2;
+#endif
+#ifdef TOKENIZE_USE_AVX2
+    case TOKENIZE_AVX2:
+        return tokenize_line_avx2;
+#endif
+    default:
+        return tokenize_line_scalar;
+    }
+}
+
+
+
+static
+tokenize_impl_t
+select_tokenize_impl() {
+    if (is_tokenize_impl_supported(TOKENIZE_AVX2)) return TOKENIZE_AVX2;
+    if (is_tokenize_impl_supported(TOKENIZE_SSE2)) return TOKENIZE_SSE2;
+    return TOKENIZE_SCALAR;
+}
+
+
+
+unsigned
+tokenize_line(char* line,
+              const char sep,
+              char** word,
+              const unsigned max_word) {
+    assert(max_word>0);
+    static const tokenize_func_t func(get_tokenize_func(get_tokenize_impl()));
+    return func(line,sep,word,max_word);
+}
+
+
+
+unsigned
+tokenize_line(const tokenize_impl_t impl,
+              char* line,
+              const char sep,
+              char** word,
+              const unsigned max_word) {
+    assert(max_word>0);
+    assert(is_tokenize_impl_supported(impl));
+    return get_tokenize_func(impl)(line,sep,word,max_word);
+}
+
+
+
+tokenize_impl_t
+get_tokenize_impl() {
+    static const tokenize_impl_t impl(select_tokenize_impl());
+    return impl;
+}
+
+
+
+const char*
+get_tokenize_impl_label(const tokenize_impl_t impl) {
+    switch (impl) {
+    case TOKENIZE_SCALAR: return "scalar";
+    case TOKENIZE_SSE2:   return "sse2";
+    case TOKENIZE_AVX2:   return "avx2";
+    default:              return "unknown";
+    }
+}
@@ -0,0 +1,94 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// in-place tab/newline word tokenizer shared by all line parsers
+///
+
+#ifndef __TOKENIZE_UTIL_HH
+#define __TOKENIZE_UTIL_HH
+
+
+/// tokenizer implementations which can be selected at runtime
+///
+enum tokenize_impl_t {
+    TOKENIZE_SCALAR,
+    TOKENIZE_SSE2,
+    TOKENIZE_AVX2,
+    TOKENIZE_IMPL_SIZE
+};
+
+
+/// split a line in place into words separated by sep
+///
+/// each separator is replaced with a null and the start of each word is
+/// stored in word[]. The scan stops at the first newline or null, or after
+/// max_word words have been found -- in this case the final word contains
+/// the unsplit remainder of the line. The newline (if any) is left in
+/// place.
+///
+/// word must have space for at least max_word pointers, max_word must be
+/// at least 1.
+///
+/// \returns the number of words found
+///
+/// the fastest implementation supported by the current cpu is used
+///
+unsigned
+tokenize_line(char* line,
+              const char sep,
+              char** word,
+              const unsigned max_word);
+
+
+/// as above, but use a specific implementation. Intended for unit tests
+/// and benchmarks.
+///
+unsigned
+tokenize_line(const tokenize_impl_t impl,
+              char* line,
+              const char sep,
+              char** word,
+              const unsigned max_word);
+
+
+/// true if the tokenizer implementation is supported on the current cpu
+///
+bool
+is_tokenize_impl_supported(const tokenize_impl_t impl);
+
+
+/// implementation selected for tokenize_line()
+///
+tokenize_impl_t
+get_tokenize_impl();
+
+
+const char*
+get_tokenize_impl_label(const tokenize_impl_t impl);
+
+#endif
@@ -0,0 +1,152 @@
+// -*- mode: c++; indent-tabs-mode: nil; -*-
+//
+// Copyright (c) 2009-2012 Illumina, Inc.
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//
+
+/// \file
+///
+/// compact genotype type filled by parse_gt
+///
+
+#ifndef __VCF_GENOTYPE_HH
+#define __VCF_GENOTYPE_HH
+
+#include <algorithm>
+#include <vector>
+
+
+/// allele indices of a vcf GT value, with -1 for unknown ('.') alleles
+///
+/// ploidy up to INLINE_PLOIDY is stored inline, so that haploid and
+/// diploid genotypes are parsed without allocation. For higher ploidy all
+/// alleles are moved to heap storage, which is kept for reuse when the
+/// object is cleared.
+///
+struct vcf_genotype {
+
+    enum { INLINE_PLOIDY = 2 };
+
+    typedef const int* const_iterator;
+    typedef const_iterator iterator;
+
+    vcf_genotype()
+        : _size(0)
+        , _is_phased(false)
+    {
+        std::fill(_inline,_inline+INLINE_PLOIDY,0);
+    }
+
+    void
+    clear() {
+        _size=0;
+        _is_phased=false;
+        _overflow.clear();
+    }
+
+    void
+    push_back(const int allele) {
+        if (_size < INLINE_PLOIDY) {
+            _inline[_size]=allele;
+        } else {
+            if (_size == INLINE_PLOIDY) {
+                _overflow.assign(_inline,_inline+INLINE_PLOIDY);
+            }
+            _overflow.push_back(allele);
+        }
+        _size++;
+    }
+
+    void
+    set_phased(const bool is_phased) { _is_phased=is_phased; }
+
+    unsigned size() const { return _size; }
+    bool empty() const { return (0 == _size); }
+
+    /// true if all alleles are separated by '|'
+    bool is_phased() const { return _is_phased; }
+
+    int operator[](const unsigned i) const { return begin()[i]; }
+
+    const_iterator
+    begin() const {
+        return ((_size <= INLINE_PLOIDY) ? _inline : &(_overflow[0]));
+    }
+
+    const_iterator end() const { return begin()+_size; }
+
+    /// true if there are no unknown alleles
+    bool
+    is_known() const {
+        for (const_iterator i(begin()); i!=end(); ++i) {
+            if (*i < 0) return false;
+        }
+        return (! empty());
+    }
+
+    bool
+    is_hom_ref() const {
+        for (const_iterator i(begin()); i!=end(); ++i) {
+            if (*i != 0) return false;
+        }
+        return (! empty());
+    }
+
+    /// true if all alleles are known and at least two differ
+    bool
+    is_het() const {
+        if (! is_known()) return false;
+        const int first(*begin());
+        for (const_iterator i(begin()+1); i!=end(); ++i) {
+            if (*i != first) return true;
+        }
+        return false;
+    }
+
+    /// true if any allele is non-reference
+    bool
+    is_any_alt() const {
+        for (const_iterator i(begin()); i!=end(); ++i) {
+            if (*i > 0) return true;
+        }
+        return false;
+    }
+
+    void
+    swap(vcf_genotype& rhs) {
+        for (unsigned i(0); i<INLINE_PLOIDY; ++i) {
+            std::swap(_inline[i],rhs._inline[i]);
+        }
+        std::swap(_size,rhs._size);
+        std::swap(_is_phased,rhs._is_phased);
+        _overflow.swap(rhs._overflow);
+    }
+
+private:
+    int _inline[INLINE_PLOIDY];
+    unsigned _size;
+    bool _is_phased;
+    std::vector<int> _overflow;
+};
+
+#endif
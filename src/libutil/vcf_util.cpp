@@ -33,8 +33,6 @@
 #include "parse_util.hh"
 #include "vcf_util.hh"
 
-#include "boost/foreach.hpp"
-
 #include <cassert>
 #include <cctype>
 
@@ -48,9 +46,10 @@ struct gt_parse_helper {
     static
     bool
     start(const char* gt,
-          std::vector<int>& gti,
+          vcf_genotype& gti,
           const bool is_badend) {
         gti.clear();
+        gti.set_phased(true);
         if (isdigit(*gt)) return digit(gt,gti,is_badend);
 
         switch (*gt) {
@@ -64,7 +63,7 @@ private:
     static
     bool
     unknown(const char* gt,
-            std::vector<int>& gti,
+            vcf_genotype& gti,
             const bool is_badend) {
         gt++;
         gti.push_back(-1);
@@ -79,8 +78,9 @@ private:
     static
     bool
     sep(const char* gt,
-        std::vector<int>& gti,
+        vcf_genotype& gti,
         const bool is_badend) {
+        if (*gt != '|') gti.set_phased(false);
         gt++;
         if (isdigit(*gt)) return digit(gt,gti,is_badend);
         switch (*gt) {
@@ -92,7 +92,7 @@ private:
     static
     bool
     digit(const char* gt,
-          std::vector<int>& gti,
+          vcf_genotype& gti,
           const bool is_badend) {
         int val(0);
         while (isdigit(*gt)) {
@@ -115,12 +115,14 @@ private:
 
 void
 parse_gt(const char* gt,
-         std::vector<int>& gti,
+         vcf_genotype& gti,
          const bool is_allow_bad_end_char) {
 
     assert(NULL != gt);
 
-    if (! gt_parse_helper::start(gt,gti,is_allow_bad_end_char)) {
+    const bool is_valid(gt_parse_helper::start(gt,gti,is_allow_bad_end_char));
+    if (gti.size() < 2) gti.set_phased(false);
+    if (! is_valid) {
         std::ostringstream oss;
         oss << "ERROR: can't parse genotype string: '" << gt << "'\n";
         throw blt_exception(oss.str().c_str());
@@ -132,17 +134,14 @@ parse_gt(const char* gt,
 bool
 is_variant_record(
     const char* const* word,
-    std::vector<int>& gtparse) {
+    vcf_genotype& gtparse) {
 
     const char* altstr(word[VCFID::ALT]);
     if (0==strcmp(".",altstr)) return false;
 
     parse_gt(get_format_string_nocopy(word,"GT"),gtparse,true);
 
-    BOOST_FOREACH(const int allele, gtparse) {
-        if (allele>0) return true;
-    }
-    return false;
+    return gtparse.is_any_alt();
 }
 
 
@@ -172,6 +171,29 @@ get_vcf_end_record_range(
 
 
 
+bool
+is_indel_record(const char* const* word) {
+    const char* alt(word[VCFID::ALT]);
+    const char* tmp_ptr;
+    // no alternate:
+    if (0==strcmp(alt,".")) return false;
+    // breakend:
+    if (NULL != (tmp_ptr=strchr(alt,'.'))) return true;
+    const unsigned reflen(strlen(word[VCFID::REF]));
+    // if alt is not '.' and reflen > 1, then this must be some sort of indel/subst:
+    // pathological case is alt=".,." ... don't worry about that one.
+    if (reflen>1) return true;
+    // after the above test, we're essentially just looking for an alt with
+    // length greater than one, indicating an insertion:
+    while (NULL != (tmp_ptr=strchr(alt,','))) {
+        if ((tmp_ptr-alt)!=static_cast<int>(reflen)) return true;
+        alt = tmp_ptr+1;
+    }
+    return (strlen(alt)!=reflen);
+}
+
+
+
 void
 get_vcf_record_range(
     const char* const* word,
@@ -29,8 +29,9 @@
 
 #pragma once
 
+#include "vcf_genotype.hh"
+
 #include <cstring>
-#include <vector>
 
 
 namespace VCFID {
@@ -92,7 +93,7 @@ get_format_string_nocopy(const char* const* word,
 // returns -1 for '.' alleles
 void
 parse_gt(const char* gt,
-         std::vector<int>& gti,
+         vcf_genotype& gti,
          const bool is_allow_bad_end_char=false);
 
 
@@ -103,7 +104,15 @@ parse_gt(const char* gt,
 bool
 is_variant_record(
     const char* const* word,
-    std::vector<int>& gti);
+    vcf_genotype& gti);
+
+
+/// \brief determine if the vcf record is an indel
+///
+/// this detects both indels and unequal or equal length 'block-substitutions'
+///
+bool
+is_indel_record(const char* const* word);
 
 
 /// get range (1-indexed, closed) of the vcf record based on an optional END tag
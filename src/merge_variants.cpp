@@ -30,16 +30,18 @@
 
 #include "gvcftools.hh"
 #include "id_map.hh"
+#include "output_buffer.hh"
 #include "related_sample_util.hh"
 #include "ref_util.hh"
 #include "string_util.hh"
-#include "tabix_util.hh"
 #include "trio_option_util.hh"
 
 #include "boost/foreach.hpp"
 #include "boost/program_options.hpp"
 #include "boost/shared_ptr.hpp"
 
+#include <unistd.h>
+
 #include <ctime>
 
 #include <iostream>
@@ -56,8 +58,9 @@ std::string cmdline;
 
 struct merge_reporter {
 
-    merge_reporter(std::ostream& os)
-        : _os(os),
+    merge_reporter(output_buffer& ob)
+        : _ob(ob),
+          _os(&ob),
           _is_header_output(false)
     {}
 
@@ -74,7 +77,10 @@ struct merge_reporter {
 
 private:
 
-    std::ostream& _os;
+    output_buffer& _ob;
+
+    // formatted header output, written through _ob:
+    std::ostream _os;
     bool _is_header_output;
 
     // not persistent, just used to reduce allocation:
@@ -91,22 +97,23 @@ template <typename T>
 void
 refAltWriter(
     const id_set<T>& alleles,
-    std::ostream& os)
+    output_buffer& ob)
 {
     const unsigned n_alleles(alleles.size());
     assert(0 != n_alleles);
 
-    os << '\t' << alleles.get_key(0);  // REF
+    ob.append('\t');
+    ob.append(alleles.get_key(0));  // REF
 
     // ALT:
-    os << '\t';
+    ob.append('\t');
     if (n_alleles>1) {
         for (unsigned i(1); i<n_alleles; ++i) {
-            if (i>1) os << ",";
-            os << alleles.get_key(i);
+            if (i>1) ob.append(',');
+            ob.append(alleles.get_key(i));
         }
     } else {
-        os << '.';
+        ob.append('.');
     }
 }
 
@@ -173,9 +180,10 @@ print_locus(
         }
     }
 
-    _os << sa[0]->chrom()      // CHROM
-        << '\t' << low_pos.pos // POS
-        << '\t' << '.';        // ID
+    _ob.append(sa[0]->chrom());  // CHROM
+    _ob.append('\t');
+    _ob.append_int(low_pos.pos); // POS
+    _ob.append("\t.");           // ID
 
 
     std::vector<std::string> genotypes;
@@ -218,7 +226,7 @@ print_locus(
             }
         }
 
-        refAltWriter(alleles,_os);
+        refAltWriter(alleles,_ob);
     }
     else
     {   //indel case:
@@ -273,38 +281,38 @@ print_locus(
             }
         }
 
-        refAltWriter(alleles,_os);
+        refAltWriter(alleles,_ob);
     }
 
     assert(genotypes.size() == n_samples);
 
 
-    _os << '\t' << '.'; // QUAL
+    _ob.append("\t."); // QUAL
 
     // FILT:
-    _os << '\t';
+    _ob.append('\t');
     const unsigned n_filters(merged_filters.size());
     if (n_filters) {
         for (unsigned filter_index(0); filter_index<n_filters; ++filter_index) {
-            if (filter_index) _os << filter_delim;
-            _os << merged_filters.get_key(filter_index);
+            if (filter_index) _ob.append(filter_delim);
+            _ob.append(merged_filters.get_key(filter_index));
         }
     } else {
-        _os << "PASS";
+        _ob.append("PASS");
     }
 
-    _os << '\t' << '.'; // INFO
+    _ob.append("\t."); // INFO
 
     // FORMAT:
-    _os << '\t';
+    _ob.append('\t');
     const unsigned n_keys(merged_keys.size());
     if (n_keys) {
         for (unsigned i(0); i<n_keys; ++i) {
-            if (i) _os << format_delim;
-            _os << merged_keys.get_key(i);
+            if (i) _ob.append(format_delim);
+            _ob.append(merged_keys.get_key(i));
         }
     } else {
-        _os << '.';
+        _ob.append('.');
     }
 
     for (unsigned st(0); st<n_samples; ++st) {
@@ -326,27 +334,27 @@ print_locus(
         }
 
         // print out values in merged order:
-        _os << '\t';
+        _ob.append('\t');
         if (n_keys && (low_pos == sample.vpos())) {
             for (unsigned key_index(0); key_index<n_keys; ++key_index) {
-                if (key_index) _os << format_delim;
+                if (key_index) _ob.append(format_delim);
                 const std::string& key(merged_keys.get_key(key_index));
                 if (sample_key.test_key(key)) {
                     if (key == "GT") {
-                        _os << genotypes[st];
+                        _ob.append(genotypes[st]);
                     } else {
-                        _os << words[sample_key.get_id(key)];
+                        _ob.append(words[sample_key.get_id(key)]);
                     }
                 } else {
-                    _os << '.';
+                    _ob.append('.');
                 }
             }
         } else {
-            _os << '.';
+            _ob.append('.');
         }
     }
 
-    _os << '\n';
+    _ob.append('\n');
 
 #if 0
     for (unsigned i(0); i<sample_size; ++i) {
@@ -417,7 +425,7 @@ disallow_option(const boost::program_options::variables_map& vm,
 
 static
 void
-merge_variants(const std::vector<std::string>& input_files,
+merge_variants(const std::vector<sample_info>& samples,
                const shared_crawler_options& opt,
                const std::string& ref_seq_file,
                const char* region,
@@ -439,13 +447,11 @@ merge_variants(const std::vector<std::string>& input_files,
 
     // setup locus crawlers:
     std::vector<boost::shared_ptr<site_crawler> > sa;
-    const unsigned n_samples(input_files.size());
+    const unsigned n_samples(samples.size());
     for (unsigned i(0); i<n_samples; ++i) {
         static const bool is_return_indels(true);
         const bool is_store_header(i==0);
-        sample_info tmp;
-        tmp.file=input_files[i];
-        sa.push_back(boost::shared_ptr<site_crawler>(new site_crawler(tmp, i, opt, region, ref_seg, is_store_header, is_return_indels)));
+        sa.push_back(boost::shared_ptr<site_crawler>(new site_crawler(samples[i], i, opt, region, ref_seg, is_store_header, is_return_indels)));
     }
 
     while (true) {
@@ -504,7 +510,7 @@ try_main(int argc,char* argv[]) {
     ("ref", po::value(&ref_seq_file),"samtools reference sequence (required)")
     ("region", po::value(&opt.region), "samtools reference region (optional)")
     ("exclude", po::value<std::vector<std::string> >(&exclude_list), "name of chromosome to skip over (argument may be specified multiple times). Exclusions will be ignored if a region argument is provided")
-    ("input", po::value<std::vector<std::string> >(&input_files)->multitoken(), "merge files (can be specified multiple times)")
+    ("input", po::value<std::vector<std::string> >(&input_files)->multitoken(), "merge files, either tabix indexed VCF or CSI indexed BCF (can be specified multiple times)")
     ("murdock", po::value(&opt.is_murdock_mode)->zero_tokens(),
      "If true, don't stop because of any out-of-order position conflicts. Any out of order positions are ignored. In case of an overlap the first observation is used and subsequent repeats are ignored.")
     ;
@@ -556,17 +562,25 @@ try_main(int argc,char* argv[]) {
         exit(2);
     }
 
+    // keep each input file open across all chromosomes:
+    std::vector<sample_info> samples(input_files.size());
+    for (unsigned i(0); i<input_files.size(); ++i) {
+        samples[i].file=input_files[i];
+        samples[i].open_file();
+    }
+
     if (opt.is_region()) {
-        parse_tabix_region(input_files[0].c_str(),opt.region.c_str(),opt.region_begin,opt.region_end);
+        samples[0].parse_region(opt.region.c_str(),opt.region_begin,opt.region_end);
         opt.region_begin+=1;
     }
 
-    merge_reporter mr(std::cout);
+    output_buffer outbuf(STDOUT_FILENO);
+    merge_reporter mr(outbuf);
 //    pos_reporters pr(conflict_pos_file,allhet_pos_file,hethethom_pos_file);
 //    site_stats ss;
 
     if (opt.is_region()) {
-        merge_variants(input_files,opt,ref_seq_file,opt.region.c_str(),mr);
+        merge_variants(samples,opt,ref_seq_file,opt.region.c_str(),mr);
     } else {
         fasta_chrom_list fcl(ref_seq_file.c_str());
         while (true) {
@@ -584,11 +598,12 @@ try_main(int argc,char* argv[]) {
                 log_os << "skipping chromosome: '" << chrom << "'\n";
             } else {
                 log_os << "processing chromosome: '" << chrom << "'\n";
-                merge_variants(input_files,opt,ref_seq_file,chrom,mr);
+                merge_variants(samples,opt,ref_seq_file,chrom,mr);
             }
         }
 
     }
+    outbuf.flush();
 //    report(ss,start_time,is_variable_metadata);
 }
 
@@ -29,22 +29,28 @@
 /// \author Chris Saunders and Subramanian Shankar Ajay
 ///
 
+#include "bcf_streambuf.hh"
 #include "blt_exception.hh"
 #include "compat_util.hh"
 #include "gvcftools.hh"
+#include "output_buffer.hh"
 #include "parse_util.hh"
 #include "ref_util.hh"
 #include "RegionVcfRecordHandler.hh"
 #include "stringer.hh"
+#include "tabix_line_splitter.hh"
+#include "thread_util.hh"
 #include "VcfHeaderHandler.hh"
 #include "VcfRecord.hh"
 
 
 #include "boost/program_options.hpp"
 
+#include <cstdio>
 #include <unistd.h>
 
 #include <iostream>
+#include <memory>
 #include <string>
 
 
@@ -60,8 +66,9 @@ std::string cmdline;
 //
 struct RemoveVcfRecordHandler : public RegionVcfRecordHandler {
 
-    RemoveVcfRecordHandler(const RegionVcfOptions& opt)
-        : RegionVcfRecordHandler(opt)
+    RemoveVcfRecordHandler(const RegionVcfOptions& opt,
+                           VcfKeyDictionary& keys)
+        : RegionVcfRecordHandler(opt,keys)
     {}
 
 private:
@@ -74,9 +81,9 @@ private:
         if (! is_in_region) {
 
             if (end>vcfr.GetPos()) {
-                vcfr.SetInfoVal("END",_intstr.get32(end));
+                vcfr.SetInfoVal(VCF_INFO_KEY::END,_intstr.get32(end));
             } else {
-                vcfr.DeleteInfoKeyVal("END");
+                vcfr.DeleteInfoKeyVal(VCF_INFO_KEY::END);
             }
             vcfr.WriteUnaltered(_opt.outfp);
         }
@@ -90,12 +97,17 @@ private:
 static
 void
 process_vcf_input(const RegionVcfOptions& opt,
-                  std::istream& infp) {
+                  const std::string& input_file,
+                  const std::vector<std::string>& input_regions,
+                  const std::string& input_region_file) {
 
+    VcfKeyDictionary keys;
     VcfHeaderHandler header(opt.outfp,gvcftools_version(),cmdline.c_str());
-    RemoveVcfRecordHandler rec(opt);
+    header.set_key_dictionary(keys);
+    RemoveVcfRecordHandler rec(opt,keys);
 
-    istream_line_splitter vparse(infp);
+    std::auto_ptr<line_splitter> vparse_ptr(open_vcf_line_splitter(input_file,input_regions,input_region_file,get_default_worker_count()));
+    line_splitter& vparse(*vparse_ptr);
 
     while (vparse.parse_line()) {
         if (header.process_line(vparse)) continue;
@@ -120,13 +132,28 @@ try_main(int argc,char* argv[]) {
         cmdline += argv[i];
     }
 
-    std::istream& infp(std::cin);
-    RegionVcfOptions opt;
+    std::string input_file;
+    std::vector<std::string> input_regions;
+    std::string input_region_file;
+    std::string output_file;
+    char output_type('v');
+    output_buffer outbuf(STDOUT_FILENO);
+    RegionVcfOptions opt(outbuf);
     std::string region_file;
 
     namespace po = boost::program_options;
     po::options_description req("configuration");
     req.add_options()
+    ("input", po::value(&input_file),
+     "Read input from the named file instead of stdin. Plain text, gzip and BGZF compressed VCF and BCF input are accepted")
+    ("input-region", po::value<std::vector<std::string> >(&input_regions),
+     "Read only records overlapping the samtools style region from the tabix indexed VCF or CSI indexed BCF input file (may be specified multiple times)")
+    ("input-regions-file", po::value(&input_region_file),
+     "Read only records overlapping the regions in the bed file from the tabix indexed VCF or CSI indexed BCF input file")
+    ("output", po::value(&output_file),
+     "Write BGZF compressed output to the named file instead of stdout, and index the output with tabix (VCF) or a CSI index (BCF)")
+    ("output-type", po::value(&output_type)->default_value(output_type),
+     "Output format: 'v' for VCF or 'b' for BGZF compressed BCF2")
     ("region-file",po::value(&region_file),"A bed file specifying regions which should be excluded from the gVCF. Any records contained in the excluded region will be removed, and any boundary non-refernece blocks will be altered to remove segments overlapping the excluded region (required)")
     ("ref", po::value(&opt.refSeqFile),"samtools reference sequence (required)");
 
@@ -149,7 +176,7 @@ try_main(int argc,char* argv[]) {
 
     const bool isStdinTerminal(isatty(fileno(stdin)));
 
-    if ((argc<=1) || (vm.count("help")) || po_parse_fail || isStdinTerminal) {
+    if ((argc<=1) || (vm.count("help")) || po_parse_fail || (isStdinTerminal && input_file.empty())) {
         log_os << "\n" << progname << " removes variant call information from specified regions\n\n";
         log_os << "version: " << gvcftools_version() << "\n\n";
         log_os << "usage: " << progname << " [options] < (g)VCF > region_removed_(g)VCF\n\n";
@@ -168,7 +195,9 @@ try_main(int argc,char* argv[]) {
     }
 
     region_util::get_regions(region_file,opt.regions);
-    process_vcf_input(opt,infp);
+    vcf_output_redirect output(opt.outfp,output_file,output_type,get_default_worker_count());
+    process_vcf_input(opt,input_file,input_regions,input_region_file);
+    output.close();
 }
 
 
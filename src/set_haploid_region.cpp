@@ -29,21 +29,27 @@
 /// \author Chris Saunders
 ///
 
+#include "bcf_streambuf.hh"
 #include "blt_exception.hh"
 #include "compat_util.hh"
 #include "gvcftools.hh"
+#include "output_buffer.hh"
 #include "parse_util.hh"
 #include "ref_util.hh"
 #include "RegionVcfRecordHandler.hh"
 #include "stringer.hh"
+#include "tabix_line_splitter.hh"
+#include "thread_util.hh"
 #include "VcfHeaderHandler.hh"
 #include "VcfRecord.hh"
 
 #include "boost/program_options.hpp"
 
+#include <cstdio>
 #include <unistd.h>
 
 #include <iostream>
+#include <memory>
 #include <string>
 
 
@@ -56,8 +62,10 @@ std::string cmdline;
 
 struct SetHapOptions : public RegionVcfOptions {
 
-    SetHapOptions()
-        : haploid_conflict_label("HAPLOID_CONFLICT")
+    explicit
+    SetHapOptions(output_buffer& out)
+        : RegionVcfOptions(out)
+        , haploid_conflict_label("HAPLOID_CONFLICT")
         , orig_pl_tag("OPL")
     {}
 
@@ -81,7 +89,7 @@ struct SetHapVcfHeaderHandler : public VcfHeaderHandler {
 
 private:
     bool
-    is_skip_header_line(const istream_line_splitter& vparse) {
+    is_skip_header_line(const line_splitter& vparse) {
         if (0 == strncmp(vparse.word[0],_haploid_filter_prefix.c_str(),_haploid_filter_prefix.size())) {
             _is_add_filter_tag=false;
         }
@@ -109,8 +117,9 @@ private:
 //
 struct SetHapVcfRecordHandler : public RegionVcfRecordHandler {
 
-    SetHapVcfRecordHandler(const SetHapOptions& opt)
-        : RegionVcfRecordHandler(opt)
+    SetHapVcfRecordHandler(const SetHapOptions& opt,
+                           VcfKeyDictionary& keys)
+        : RegionVcfRecordHandler(opt,keys)
         , _shopt(opt)
     {}
 
@@ -122,9 +131,9 @@ private:
                   VcfRecord& vcfr) const {
 
         if (end>vcfr.GetPos()) {
-            vcfr.SetInfoVal("END",_intstr.get32(end));
+            vcfr.SetInfoVal(VCF_INFO_KEY::END,_intstr.get32(end));
         } else {
-            vcfr.DeleteInfoKeyVal("END");
+            vcfr.DeleteInfoKeyVal(VCF_INFO_KEY::END);
         }
         if (is_in_region) make_record_haploid(vcfr);
         vcfr.WriteUnaltered(_opt.outfp);
@@ -132,7 +141,7 @@ private:
 
     void
     make_record_haploid(VcfRecord& vcfr) const {
-        const char* gt(vcfr.GetSampleVal("GT"));
+        const char* gt(vcfr.GetSampleVal(VCF_FORMAT_KEY::GT));
         if (NULL == gt)  return;
         parse_gt(gt,_gti);
 
@@ -144,13 +153,13 @@ private:
                 if (_gti[0]>=0) {
                     val=_intstr.get32(_gti[0]);
                 }
-                vcfr.SetSampleVal("GT",val);
+                vcfr.SetSampleVal(VCF_FORMAT_KEY::GT,val);
 
                 // move PL field to 'backup' OPL field:
-                const char* pl(vcfr.GetSampleVal("PL"));
+                const char* pl(vcfr.GetSampleVal(VCF_FORMAT_KEY::PL));
                 if (NULL != pl) {
                     vcfr.SetSampleVal(_shopt.orig_pl_tag.c_str(),pl);
-                    vcfr.DeleteSampleKeyVal("PL");
+                    vcfr.DeleteSampleKeyVal(VCF_FORMAT_KEY::PL);
                 }
             } else {
                 vcfr.AppendFilter(_shopt.haploid_conflict_label.c_str());
@@ -159,7 +168,7 @@ private:
     }
 
     const SetHapOptions& _shopt;
-    mutable std::vector<int> _gti; // cache gt parse
+    mutable vcf_genotype _gti; // cache gt parse
     stringer<int> _intstr; // fast int->str util
 };
 
@@ -168,12 +177,17 @@ private:
 static
 void
 process_vcf_input(const SetHapOptions& opt,
-                  std::istream& infp) {
+                  const std::string& input_file,
+                  const std::vector<std::string>& input_regions,
+                  const std::string& input_region_file) {
 
+    VcfKeyDictionary keys;
     SetHapVcfHeaderHandler header(opt,gvcftools_version(),cmdline.c_str());
-    SetHapVcfRecordHandler rec(opt);
+    header.set_key_dictionary(keys);
+    SetHapVcfRecordHandler rec(opt,keys);
 
-    istream_line_splitter vparse(infp);
+    std::auto_ptr<line_splitter> vparse_ptr(open_vcf_line_splitter(input_file,input_regions,input_region_file,get_default_worker_count()));
+    line_splitter& vparse(*vparse_ptr);
 
     while (vparse.parse_line()) {
         if (header.process_line(vparse)) continue;
@@ -195,13 +209,28 @@ try_main(int argc,char* argv[]) {
         cmdline += argv[i];
     }
 
-    std::istream& infp(std::cin);
-    SetHapOptions opt;
+    std::string input_file;
+    std::vector<std::string> input_regions;
+    std::string input_region_file;
+    std::string output_file;
+    char output_type('v');
+    output_buffer outbuf(STDOUT_FILENO);
+    SetHapOptions opt(outbuf);
     std::string region_file;
 
     namespace po = boost::program_options;
     po::options_description req("configuration");
     req.add_options()
+    ("input", po::value(&input_file),
+     "Read input from the named file instead of stdin. Plain text, gzip and BGZF compressed VCF and BCF input are accepted")
+    ("input-region", po::value<std::vector<std::string> >(&input_regions),
+     "Read only records overlapping the samtools style region from the tabix indexed VCF or CSI indexed BCF input file (may be specified multiple times)")
+    ("input-regions-file", po::value(&input_region_file),
+     "Read only records overlapping the regions in the bed file from the tabix indexed VCF or CSI indexed BCF input file")
+    ("output", po::value(&output_file),
+     "Write BGZF compressed output to the named file instead of stdout, and index the output with tabix (VCF) or a CSI index (BCF)")
+    ("output-type", po::value(&output_type)->default_value(output_type),
+     "Output format: 'v' for VCF or 'b' for BGZF compressed BCF2")
     ("region-file",po::value(&region_file),"A bed file specifying the regions to be converted (required)")
     ("ref", po::value(&opt.refSeqFile),"samtools reference sequence (required)");
 
@@ -224,7 +253,7 @@ try_main(int argc,char* argv[]) {
 
     const bool isStdinTerminal(isatty(fileno(stdin)));
 
-    if ((argc<=1) || (vm.count("help")) || po_parse_fail || isStdinTerminal) {
+    if ((argc<=1) || (vm.count("help")) || po_parse_fail || (isStdinTerminal && input_file.empty())) {
         log_os << "\n" << progname << " converts regions of a gVCF or VCF from diploid to haploid\n\n";
         log_os << "version: " << gvcftools_version() << "\n\n";
         log_os << "usage: " << progname << " [options] < (g)VCF > haploid_region_(g)VCF\n\n";
@@ -243,7 +272,9 @@ try_main(int argc,char* argv[]) {
     }
 
     region_util::get_regions(region_file,opt.regions);
-    process_vcf_input(opt,infp);
+    vcf_output_redirect output(opt.outfp,output_file,output_type,get_default_worker_count());
+    process_vcf_input(opt,input_file,input_regions,input_region_file);
+    output.close();
 }
 
 
@@ -32,7 +32,6 @@
 #include "gvcftools.hh"
 #include "related_sample_util.hh"
 #include "ref_util.hh"
-#include "tabix_util.hh"
 #include "trio_option_util.hh"
 
 #include "boost/program_options.hpp"
@@ -443,11 +442,11 @@ try_main(int argc,char* argv[]) {
     ("region", po::value(&opt.region), "samtools reference region (optional)")
     ("exclude", po::value<std::vector<std::string> >(&exclude_list), "name of chromosome to skip over (argument may be specified multiple times). Exclusions will be ignored if a region argument is provided")
     ("mother", po::value(&si[MOTHER].file),
-     "mother gvcf file")
+     "mother gvcf file or block table")
     ("father", po::value(&si[FATHER].file),
-     "father gvcf file")
+     "father gvcf file or block table")
     ("child", po::value(&si[CHILD].file),
-     "child gvcf file")
+     "child gvcf file or block table")
     ("conflict-file", po::value(&conflict_pos_file), "Write all conflict positions to the specified file")
     ("same-het-file", po::value(&allhet_pos_file), "Write matching triple het-snp positions to the specified file")
     ("hethet-hom-file", po::value(&hethethom_pos_file), "Write positions with parents same het, child minor hom to the specified file")
@@ -531,8 +530,13 @@ try_main(int argc,char* argv[]) {
         }
     }
 
+    // keep each gvcf file open across all chromosomes:
+    for (unsigned st(0); st<SAMPLE_SIZE; ++st) {
+        si[st].open_file();
+    }
+
     if (opt.is_region()) {
-        parse_tabix_region(si[MOTHER].file.c_str(),opt.region.c_str(),opt.region_begin,opt.region_end);
+        si[MOTHER].parse_region(opt.region.c_str(),opt.region_begin,opt.region_end);
         opt.region_begin+=1;
     }
 
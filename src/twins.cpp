@@ -32,7 +32,6 @@
 #include "gvcftools.hh"
 #include "related_sample_util.hh"
 #include "ref_util.hh"
-#include "tabix_util.hh"
 #include "trio_option_util.hh"
 
 #include "boost/program_options.hpp"
@@ -349,9 +348,9 @@ try_main(int argc,char* argv[]) {
     ("region", po::value(&opt.region), "samtools reference region (optional)")
     ("exclude", po::value<std::vector<std::string> >(&exclude_list), "name of chromosome to skip over (argument may be specified multiple times). Exclusions will be ignored if a region argument is provided")
     ("twin1", po::value(&si[TWIN1].file),
-     "twin/replicate 1 gvcf file")
+     "twin/replicate 1 gvcf file or block table")
     ("twin2", po::value(&si[TWIN2].file),
-     "twin/replicate 2 gvcf file")
+     "twin/replicate 2 gvcf file or block table")
     ("conflict-file", po::value(&conflict_pos_file), "Write all conflict positions to the specified file")
     ("no-variable-metadata",
      "Remove timestamp and any other metadata from output during validation testing")
@@ -425,8 +424,13 @@ try_main(int argc,char* argv[]) {
         }
     }
 
+    // keep each gvcf file open across all chromosomes:
+    for (unsigned st(0); st<SAMPLE_SIZE; ++st) {
+        si[st].open_file();
+    }
+
     if (opt.is_region()) {
-        parse_tabix_region(si[TWIN1].file.c_str(),opt.region.c_str(),opt.region_begin,opt.region_end);
+        si[TWIN1].parse_region(opt.region.c_str(),opt.region_begin,opt.region_end);
         opt.region_begin+=1;
     }
 